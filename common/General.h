@@ -16,6 +16,7 @@
 #pragma once
 
 #include <atomic>
+#include <cstdio>
 #include <map>
 #include <memory>
 #include <string>
@@ -116,6 +117,17 @@ static __fi PageProtectionMode PageAccess_Any()
 	return PageProtectionMode().All();
 }
 
+// --------------------------------------------------------------------------------------
+//  HugePageMode
+// --------------------------------------------------------------------------------------
+enum class HugePageMode : u8
+{
+	Disabled,
+	Transparent, // Asks the kernel to use transparent huge pages where it can (madvise).
+	Explicit, // Maps private reservations with MAP_HUGETLB/MEM_LARGE_PAGES, falls back to transparent.
+	MaxCount
+};
+
 struct PageFaultInfo
 {
 	uptr pc;
@@ -138,6 +150,18 @@ namespace HostSys
 
 	extern void MemProtect(void* baseaddr, size_t size, const PageProtectionMode& mode);
 
+	// Returns the size of the pages used by MmapHugePages(), or zero if the host has none.
+	extern size_t GetHugePageSize();
+
+	// Maps a block of memory backed by explicit huge pages. size must be a multiple of GetHugePageSize(),
+	// and base (if any) aligned to it. The protection of the block can only be changed as a whole.
+	// Returns NULL if no huge pages could be reserved, the caller should fall back to Mmap().
+	extern void* MmapHugePages(void* base, size_t size, const PageProtectionMode& mode);
+
+	// Asks the kernel to back a block with transparent huge pages where it can.
+	// Returns false if the host doesn't support it, the block is left as it was.
+	extern bool AdviseHugePages(void* base, size_t size);
+
 	template <uint size>
 	void MemProtectStatic(u8 (&arr)[size], const PageProtectionMode& mode)
 	{
@@ -150,6 +174,19 @@ namespace HostSys
 	extern void* MapSharedMemory(void* handle, size_t offset, void* baseaddr, size_t size, const PageProtectionMode& mode);
 	extern void UnmapSharedMemory(void* baseaddr, size_t size);
 
+	// Maps a whole existing file into memory, writes go back to the file when writable is set.
+	// Returns NULL on failure or if the file is empty, size receives the length of the file.
+	extern void* MapFile(const char* path, bool writable, size_t* size);
+
+	// Maps the whole of an already open file. The mapping doesn't depend on the file staying open,
+	// but keeping it open holds on to any sharing restrictions it was opened with.
+	extern void* MapFile(std::FILE* fp, bool writable, size_t* size);
+	extern void UnmapFile(void* baseaddr, size_t size);
+
+	// Starts writing modified pages of a file mapping in the given range back to the file, without
+	// waiting for the write to complete. The range does not need to be page aligned.
+	extern void FlushMappedFile(void* baseaddr, size_t size);
+
 	/// Installs the specified page fault handler. Only one handler can be active at once.
 	bool InstallPageFaultHandler(PageFaultHandler handler);
 
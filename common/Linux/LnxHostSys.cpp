@@ -40,6 +40,7 @@
 #include <cerrno>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #ifndef __APPLE__
@@ -226,6 +227,73 @@ void HostSys::MemProtect(void* baseaddr, size_t size, const PageProtectionMode&
 		pxFail("mprotect() failed");
 }
 
+size_t HostSys::GetHugePageSize()
+{
+#ifdef __linux__
+	static const size_t huge_page_size = []() -> size_t {
+		std::FILE* fp = std::fopen("/proc/meminfo", "r");
+		if (!fp)
+			return 0;
+
+		size_t size_kb = 0;
+		char line[128];
+		while (std::fgets(line, sizeof(line), fp))
+		{
+			if (std::sscanf(line, "Hugepagesize: %zu kB", &size_kb) == 1)
+				break;
+		}
+		std::fclose(fp);
+		return size_kb * 1024;
+	}();
+	return huge_page_size;
+#else
+	return 0;
+#endif
+}
+
+void* HostSys::MmapHugePages(void* base, size_t size, const PageProtectionMode& mode)
+{
+#ifdef __linux__
+	const size_t huge_page_size = GetHugePageSize();
+	if (huge_page_size == 0 || mode.IsNone())
+		return nullptr;
+
+	pxAssertDev((size & (huge_page_size - 1)) == 0, "Size is huge page aligned");
+	pxAssertDev((reinterpret_cast<uptr>(base) & (huge_page_size - 1)) == 0, "Base is huge page aligned");
+
+	// The size is rounded up to a huge page, so never clobber whatever follows the requested area.
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_FIXED_NOREPLACE
+	if (base)
+		flags |= MAP_FIXED_NOREPLACE;
+#endif
+
+	void* res = mmap(base, size, LinuxProt(mode), flags, -1, 0);
+	if (res == MAP_FAILED)
+		return nullptr;
+
+	// Kernels before 4.17 treat MAP_FIXED_NOREPLACE as a hint.
+	if (base && res != base)
+	{
+		munmap(res, size);
+		return nullptr;
+	}
+
+	return res;
+#else
+	return nullptr;
+#endif
+}
+
+bool HostSys::AdviseHugePages(void* base, size_t size)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	return (madvise(base, size, MADV_HUGEPAGE) == 0);
+#else
+	return false;
+#endif
+}
+
 std::string HostSys::GetFileMappingName(const char* prefix)
 {
 	const unsigned pid = static_cast<unsigned>(getpid());
@@ -286,6 +354,50 @@ void HostSys::UnmapSharedMemory(void* baseaddr, size_t size)
 		pxFailRel("Failed to unmap shared memory");
 }
 
+static void* MapFileDescriptor(int fd, bool writable, size_t* size)
+{
+	struct stat sd;
+	if (fstat(fd, &sd) != 0 || sd.st_size <= 0)
+		return nullptr;
+
+	void* ptr = mmap(nullptr, static_cast<size_t>(sd.st_size), writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+		MAP_SHARED, fd, 0);
+	if (ptr == MAP_FAILED)
+		return nullptr;
+
+	*size = static_cast<size_t>(sd.st_size);
+	return ptr;
+}
+
+void* HostSys::MapFile(const char* path, bool writable, size_t* size)
+{
+	const int fd = open(path, (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+	if (fd < 0)
+		return nullptr;
+
+	// The mapping keeps its own reference to the file.
+	void* ptr = MapFileDescriptor(fd, writable, size);
+	close(fd);
+	return ptr;
+}
+
+void* HostSys::MapFile(std::FILE* fp, bool writable, size_t* size)
+{
+	return MapFileDescriptor(fileno(fp), writable, size);
+}
+
+void HostSys::UnmapFile(void* baseaddr, size_t size)
+{
+	munmap(baseaddr, size);
+}
+
+void HostSys::FlushMappedFile(void* baseaddr, size_t size)
+{
+	const uptr start = Common::AlignDownPow2(reinterpret_cast<uptr>(baseaddr), __pagesize);
+	const uptr end = reinterpret_cast<uptr>(baseaddr) + size;
+	msync(reinterpret_cast<void*>(start), end - start, MS_ASYNC);
+}
+
 SharedMemoryMappingArea::SharedMemoryMappingArea(u8* base_ptr, size_t size, size_t num_pages)
 	: m_base_ptr(base_ptr)
 	, m_size(size)
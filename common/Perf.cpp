@@ -18,6 +18,10 @@
 #ifdef __unix__
 #include <unistd.h>
 #endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
 #ifdef ENABLE_VTUNE
 #include "jitprofiling.h"
 
@@ -208,4 +212,90 @@ namespace Perf
 	void dump_and_reset() {}
 
 #endif
+
+	////////////////////////////////////////////////////////////////////////////////
+	// Implementation of the TLBMissCounter object
+	////////////////////////////////////////////////////////////////////////////////
+
+	TLBMissCounter::TLBMissCounter()
+	{
+		for (int& fd : m_fds)
+			fd = -1;
+	}
+
+	TLBMissCounter::~TLBMissCounter()
+	{
+		Close();
+	}
+
+#ifdef __linux__
+
+	static int OpenCacheEvent(u64 cache, u64 op)
+	{
+		perf_event_attr attr = {};
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.size = sizeof(attr);
+		attr.config = cache | (op << 8) | (static_cast<u64>(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+
+		// Calling thread, any CPU.
+		return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+	}
+
+	bool TLBMissCounter::Open()
+	{
+		Close();
+
+		m_fds[DataLoad] = OpenCacheEvent(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ);
+		if (m_fds[DataLoad] < 0)
+			return false;
+
+		// Not every CPU has these, the load misses alone are still meaningful.
+		m_fds[DataStore] = OpenCacheEvent(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_WRITE);
+		m_fds[Instruction] = OpenCacheEvent(PERF_COUNT_HW_CACHE_ITLB, PERF_COUNT_HW_CACHE_OP_READ);
+		return true;
+	}
+
+	void TLBMissCounter::Close()
+	{
+		for (int& fd : m_fds)
+		{
+			if (fd >= 0)
+				close(fd);
+			fd = -1;
+		}
+	}
+
+	u64 TLBMissCounter::ReadEvent(u32 event) const
+	{
+		u64 value;
+		if (m_fds[event] < 0 || read(m_fds[event], &value, sizeof(value)) != sizeof(value))
+			return 0;
+
+		return value;
+	}
+
+#else
+
+	bool TLBMissCounter::Open() { return false; }
+	void TLBMissCounter::Close() {}
+	u64 TLBMissCounter::ReadEvent(u32 event) const { return 0; }
+
+#endif
+
+	bool TLBMissCounter::IsOpen() const
+	{
+		return (m_fds[DataLoad] >= 0);
+	}
+
+	u64 TLBMissCounter::ReadDataMisses() const
+	{
+		return ReadEvent(DataLoad) + ReadEvent(DataStore);
+	}
+
+	u64 TLBMissCounter::ReadInstructionMisses() const
+	{
+		return ReadEvent(Instruction);
+	}
 } // namespace Perf
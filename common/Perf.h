@@ -51,6 +51,40 @@ namespace Perf
 		void reset();
 	};
 
+	/// Counts the user mode TLB misses of the thread which opened it, through perf events.
+	/// Only available on Linux, and only if perf_event_paranoid allows per-thread counters.
+	class TLBMissCounter
+	{
+	public:
+		TLBMissCounter();
+		~TLBMissCounter();
+
+		/// Starts counting for the calling thread, closing any previous counters.
+		bool Open();
+		void Close();
+
+		bool IsOpen() const;
+
+		/// Data TLB load and store misses since Open(). Stores are left out on CPUs without a counter for them.
+		u64 ReadDataMisses() const;
+
+		/// Instruction TLB misses since Open(), zero if the CPU has no counter for them.
+		u64 ReadInstructionMisses() const;
+
+	private:
+		enum : u32
+		{
+			DataLoad,
+			DataStore,
+			Instruction,
+			EventCount
+		};
+
+		u64 ReadEvent(u32 event) const;
+
+		int m_fds[EventCount];
+	};
+
 	void dump();
 	void dump_and_reset();
 
@@ -27,6 +27,7 @@
 #include "fmt/core.h"
 #include "fmt/format.h"
 
+#include <io.h>
 #include <mutex>
 
 static std::recursive_mutex s_exception_handler_mutex;
@@ -134,6 +135,51 @@ void HostSys::MemProtect(void* baseaddr, size_t size, const PageProtectionMode&
 		pxFail("VirtualProtect() failed");
 }
 
+size_t HostSys::GetHugePageSize()
+{
+	return GetLargePageMinimum();
+}
+
+// Large pages can only be allocated by processes holding SeLockMemoryPrivilege, which is granted to the
+// user by policy but still has to be enabled in the process token.
+static bool EnableLockMemoryPrivilege()
+{
+	HANDLE token;
+	if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+		return false;
+
+	TOKEN_PRIVILEGES tp = {};
+	tp.PrivilegeCount = 1;
+	tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+	bool result = false;
+	if (LookupPrivilegeValueW(nullptr, SE_LOCK_MEMORY_NAME, &tp.Privileges[0].Luid))
+	{
+		// AdjustTokenPrivileges() succeeds even if the privilege wasn't granted.
+		result = AdjustTokenPrivileges(token, FALSE, &tp, 0, nullptr, nullptr) && GetLastError() == ERROR_SUCCESS;
+	}
+
+	CloseHandle(token);
+	return result;
+}
+
+void* HostSys::MmapHugePages(void* base, size_t size, const PageProtectionMode& mode)
+{
+	static const bool has_privilege = EnableLockMemoryPrivilege();
+	if (!has_privilege || GetHugePageSize() == 0 || mode.IsNone())
+		return nullptr;
+
+	pxAssert((size & (GetHugePageSize() - 1)) == 0);
+
+	return VirtualAlloc(base, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, ConvertToWinApi(mode));
+}
+
+bool HostSys::AdviseHugePages(void* base, size_t size)
+{
+	// Windows has no transparent huge pages.
+	return false;
+}
+
 std::string HostSys::GetFileMappingName(const char* prefix)
 {
 	const unsigned pid = GetCurrentProcessId();
@@ -174,6 +220,58 @@ void HostSys::UnmapSharedMemory(void* baseaddr, size_t size)
 		pxFail("Failed to unmap shared memory");
 }
 
+static void* MapFileHandle(HANDLE file, bool writable, size_t* size)
+{
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0)
+		return nullptr;
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+		return nullptr;
+
+	// The view keeps its own reference to the mapping and file.
+	void* ptr = MapViewOfFile(mapping, writable ? (FILE_MAP_READ | FILE_MAP_WRITE) : FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!ptr)
+		return nullptr;
+
+	*size = static_cast<size_t>(file_size.QuadPart);
+	return ptr;
+}
+
+void* HostSys::MapFile(const char* path, bool writable, size_t* size)
+{
+	const HANDLE file = CreateFileW(StringUtil::UTF8StringToWideString(path).c_str(),
+		writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	void* ptr = MapFileHandle(file, writable, size);
+	CloseHandle(file);
+	return ptr;
+}
+
+void* HostSys::MapFile(std::FILE* fp, bool writable, size_t* size)
+{
+	const HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(fp)));
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	return MapFileHandle(file, writable, size);
+}
+
+void HostSys::UnmapFile(void* baseaddr, size_t size)
+{
+	UnmapViewOfFile(baseaddr);
+}
+
+void HostSys::FlushMappedFile(void* baseaddr, size_t size)
+{
+	FlushViewOfFile(baseaddr, size);
+}
+
 SharedMemoryMappingArea::SharedMemoryMappingArea(u8* base_ptr, size_t size, size_t num_pages)
 	: m_base_ptr(base_ptr)
 	, m_size(size)
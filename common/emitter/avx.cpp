@@ -65,6 +65,7 @@ namespace x86Emitter
 	const xImplAVX_ThreeArgYMM xVPANDN = {0x66, 0xDF};
 	const xImplAVX_ThreeArgYMM xVPOR = {0x66, 0xEB};
 	const xImplAVX_ThreeArgYMM xVPXOR = {0x66, 0xEF};
+	const xImplAVX_ThreeArgYMM xVPADDD = {0x66, 0xFE};
 	const xImplAVX_CmpInt xVPCMP = {
 		{0x66, 0x74}, // VPCMPEQB
 		{0x66, 0x75}, // VPCMPEQW
@@ -74,6 +75,74 @@ namespace x86Emitter
 		{0x66, 0x66}, // VPCMPGTD
 	};
 
+	const xImplAVX_PMove xVPMOVSX = {0x20};
+	const xImplAVX_PMove xVPMOVZX = {0x30};
+
+	void xImplAVX_PMove::BD(const xRegisterSSE& to, const xRegisterSSE& from) const
+	{
+		xOpWriteC4(0x66, 0x38, OpcodeBase + 1, to, xRegisterSSE(), from, 0);
+	}
+
+	void xImplAVX_PMove::BD(const xRegisterSSE& to, const xIndirectVoid& from) const
+	{
+		xOpWriteC4(0x66, 0x38, OpcodeBase + 1, to, xRegisterSSE(), from, 0);
+	}
+
+	void xImplAVX_PMove::WD(const xRegisterSSE& to, const xRegisterSSE& from) const
+	{
+		xOpWriteC4(0x66, 0x38, OpcodeBase + 3, to, xRegisterSSE(), from, 0);
+	}
+
+	void xImplAVX_PMove::WD(const xRegisterSSE& to, const xIndirectVoid& from) const
+	{
+		xOpWriteC4(0x66, 0x38, OpcodeBase + 3, to, xRegisterSSE(), from, 0);
+	}
+
+	void xVPBLENDD(const xRegisterSSE& to, const xRegisterSSE& from1, const xRegisterSSE& from2, u8 imm)
+	{
+		xOpWriteC4(0x66, 0x3A, 0x02, to, from1, from2, 0, 1);
+		xWrite8(imm);
+	}
+
+	void xVPBLENDD(const xRegisterSSE& to, const xRegisterSSE& from1, const xIndirectVoid& from2, u8 imm)
+	{
+		xOpWriteC4(0x66, 0x3A, 0x02, to, from1, from2, 0, 1);
+		xWrite8(imm);
+	}
+
+	void xVPERMD(const xRegisterSSE& to, const xRegisterSSE& index, const xRegisterSSE& from)
+	{
+		pxAssert(to.IsWideSIMD());
+		xOpWriteC4(0x66, 0x38, 0x36, to, index, from, 0);
+	}
+
+	void xVPERMQ(const xRegisterSSE& to, const xRegisterSSE& from, u8 imm)
+	{
+		pxAssert(to.IsWideSIMD());
+		xOpWriteC4(0x66, 0x3A, 0x00, to, xRegisterSSE(), from, 1, 1);
+		xWrite8(imm);
+	}
+
+	void xVINSERTI128(const xRegisterSSE& to, const xRegisterSSE& from1, const xRegisterSSE& from2, u8 imm)
+	{
+		pxAssert(to.IsWideSIMD());
+		xOpWriteC4(0x66, 0x3A, 0x38, to, from1, from2, 0, 1);
+		xWrite8(imm);
+	}
+
+	void xVINSERTI128(const xRegisterSSE& to, const xRegisterSSE& from1, const xIndirectVoid& from2, u8 imm)
+	{
+		pxAssert(to.IsWideSIMD());
+		xOpWriteC4(0x66, 0x3A, 0x38, to, from1, from2, 0, 1);
+		xWrite8(imm);
+	}
+
+	void xVBROADCASTI128(const xRegisterSSE& to, const xIndirectVoid& from)
+	{
+		pxAssert(to.IsWideSIMD());
+		xOpWriteC4(0x66, 0x38, 0x5A, to, xRegisterSSE(), from, 0);
+	}
+
 	void xVPMOVMSKB(const xRegister32& to, const xRegisterSSE& from)
 	{
 		xOpWriteC5(0x66, 0xd7, to, xRegister32(), from);
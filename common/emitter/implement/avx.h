@@ -43,6 +43,17 @@ namespace x86Emitter
 		void operator()(const xRegisterSSE& to, const xRegisterSSE& from1, const xIndirectVoid& from2) const;
 	};
 
+	// Sign/zero extension of packed integers, the source is half (WD) or a quarter (BD) of the destination width.
+	struct xImplAVX_PMove
+	{
+		u8 OpcodeBase;
+
+		void BD(const xRegisterSSE& to, const xRegisterSSE& from) const;
+		void BD(const xRegisterSSE& to, const xIndirectVoid& from) const;
+		void WD(const xRegisterSSE& to, const xRegisterSSE& from) const;
+		void WD(const xRegisterSSE& to, const xIndirectVoid& from) const;
+	};
+
 	struct xImplAVX_ArithFloat
 	{
 		xImplAVX_ThreeArgYMM PS;
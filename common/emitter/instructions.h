@@ -636,7 +636,19 @@ namespace x86Emitter
 	extern const xImplAVX_ThreeArgYMM xVPANDN;
 	extern const xImplAVX_ThreeArgYMM xVPOR;
 	extern const xImplAVX_ThreeArgYMM xVPXOR;
+	extern const xImplAVX_ThreeArgYMM xVPADDD;
 	extern const xImplAVX_CmpInt xVPCMP;
+	extern const xImplAVX_PMove xVPMOVSX;
+	extern const xImplAVX_PMove xVPMOVZX;
+
+	// AVX2 lane crossing and blending, destination is a ymm register unless noted.
+	extern void xVPBLENDD(const xRegisterSSE& to, const xRegisterSSE& from1, const xRegisterSSE& from2, u8 imm);
+	extern void xVPBLENDD(const xRegisterSSE& to, const xRegisterSSE& from1, const xIndirectVoid& from2, u8 imm);
+	extern void xVPERMD(const xRegisterSSE& to, const xRegisterSSE& index, const xRegisterSSE& from);
+	extern void xVPERMQ(const xRegisterSSE& to, const xRegisterSSE& from, u8 imm);
+	extern void xVINSERTI128(const xRegisterSSE& to, const xRegisterSSE& from1, const xRegisterSSE& from2, u8 imm);
+	extern void xVINSERTI128(const xRegisterSSE& to, const xRegisterSSE& from1, const xIndirectVoid& from2, u8 imm);
+	extern void xVBROADCASTI128(const xRegisterSSE& to, const xIndirectVoid& from);
 
 	extern void xVPMOVMSKB(const xRegister32& to, const xRegisterSSE& from);
 	extern void xVMOVMSKPS(const xRegister32& to, const xRegisterSSE& from);
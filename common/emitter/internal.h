@@ -149,22 +149,34 @@ namespace x86Emitter
 	}
 
 	// VEX 3 Bytes Prefix
+	// extraRIPOffset is the size of any immediate following the ModRM/SIB, see EmitSibMagic.
 	template <typename T1, typename T2, typename T3>
-	__emitinline void xOpWriteC4(u8 prefix, u8 mb_prefix, u8 opcode, const T1& param1, const T2& param2, const T3& param3, int w = -1)
+	__emitinline void xOpWriteC4(u8 prefix, u8 mb_prefix, u8 opcode, const T1& param1, const T2& param2, const T3& param3, int w = -1, int extraRIPOffset = 0)
 	{
 		pxAssert(prefix == 0 || prefix == 0x66 || prefix == 0xF3 || prefix == 0xF2);
 		pxAssert(mb_prefix == 0x0F || mb_prefix == 0x38 || mb_prefix == 0x3A);
 
-		const xRegisterInt& reg = param1.IsReg() ? param1 : param2;
+		const xRegisterBase& reg = param1.IsReg() ? param1 : param2;
 
 		u8 nR = reg.IsExtended() ? 0x00 : 0x80;
-		u8 nB = param3.IsExtended() ? 0x00 : 0x20;
-		u8 nX = 0x40; // likely unused so hardwired to disabled
+		u8 nB, nX;
+		if constexpr (std::is_same_v<T3, xIndirectVoid>)
+		{
+			// A lone register is kept in Index and encoded without a SIB, see EmitRex.
+			const bool sib = !param3.Index.IsEmpty() && (param3.Scale != 0 || !param3.Base.IsEmpty());
+			nB = (sib ? param3.Base : param3.Index).IsExtended() ? 0x00 : 0x20;
+			nX = (sib && param3.Index.IsExtended()) ? 0x00 : 0x40;
+		}
+		else
+		{
+			nB = param3.IsExtended() ? 0x00 : 0x20;
+			nX = 0x40;
+		}
 		u8 L = reg.IsWideSIMD() ? 4 : 0;
 		u8 W = (w == -1) ? (reg.GetOperandSize() == 8 ? 0x80 : 0) : // autodetect the size
                            0x80 * w; // take directly the W value
 
-		u8 nv = (~param2.GetId() & 0xF) << 3;
+		u8 nv = (param2.IsEmpty() ? 0xF : (~param2.GetId() & 0xF)) << 3;
 
 		u8 p =
 			prefix == 0xF2 ? 3 :
@@ -181,6 +193,6 @@ namespace x86Emitter
 		xWrite8(nR | nX | nB | m);
 		xWrite8(W | nv | L | p);
 		xWrite8(opcode);
-		EmitSibMagic(param1, param3);
+		EmitSibMagic(param1, param3, extraRIPOffset);
 	}
 } // namespace x86Emitter
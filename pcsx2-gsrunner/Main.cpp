@@ -50,6 +50,8 @@
 #include "pcsx2/INISettingsInterface.h"
 #include "pcsx2/PAD/Host/PAD.h"
 #include "pcsx2/PerformanceMetrics.h"
+#include "pcsx2/Recording/InputRecording.h"
+#include "pcsx2/Recording/ReplayVerifier.h"
 #include "pcsx2/VMManager.h"
 
 #ifdef ENABLE_ACHIEVEMENTS
@@ -63,6 +65,7 @@ namespace GSRunner
 	static void InitializeConsole();
 	static bool InitializeConfig();
 	static bool ParseCommandLineArgs(int argc, char* argv[], VMBootParameters& params);
+	static bool RunReplay();
 
 	static bool CreatePlatformWindow();
 	static void DestroyPlatformWindow();
@@ -81,6 +84,13 @@ static s32 s_loop_count = 1;
 static std::optional<bool> s_use_window;
 static bool s_no_console = false;
 
+// Input recording replay, instead of a GS dump.
+static std::string s_replay_path;
+static std::string s_hash_log_path;
+static std::string s_golden_path;
+static u32 s_hash_interval = 60;
+static u32 s_hash_sources = ReplayVerifier::HASH_EE_RAM;
+
 // Owned by the GS thread.
 static u32 s_dump_frame_number = 0;
 static u32 s_loop_number = s_loop_count;
@@ -403,6 +413,14 @@ static void PrintCommandLineHelp(const char* progname)
 	std::fprintf(stderr, "  -surfaceless: Disables showing a window.\n");
 	std::fprintf(stderr, "  -logfile <filename>: Writes emu log to filename.\n");
 	std::fprintf(stderr, "  -noshadercache: Disables the shader cache (useful for parallel runs).\n");
+	std::fprintf(stderr, "  -replay <recording>: Boots filename as a game and plays back the input recording\n"
+						 "    instead of a GS dump, stopping at the end of the recording.\n");
+	std::fprintf(stderr, "  -hashlog <filename>: Writes state hashes and frame times during -replay to filename.\n");
+	std::fprintf(stderr, "  -golden <filename>: Compares the hashes during -replay against a previous hash log,\n"
+						 "    stopping and failing at the first frame which differs.\n");
+	std::fprintf(stderr, "  -hashinterval <frames>: Hashes every N frames during -replay. Defaults to 60.\n");
+	std::fprintf(stderr, "  -hash <ram|fb|both>: Hashes EE RAM, the framebuffer, or both. Defaults to ram.\n"
+						 "    Framebuffer hashes are only reproducible with the software renderer.\n");
 	std::fprintf(stderr, "  --: Signals that no more arguments will follow and the remaining\n"
 						 "    parameters make up the filename. Use when the filename contains\n"
 						 "    spaces or starts with a dash.\n");
@@ -553,6 +571,49 @@ bool GSRunner::ParseCommandLineArgs(int argc, char* argv[], VMBootParameters& pa
 				s_settings_interface.SetBoolValue("EmuCore/GS", "disable_shader_cache", true);
 				continue;
 			}
+			else if (CHECK_ARG_PARAM("-replay"))
+			{
+				s_replay_path = argv[++i];
+				continue;
+			}
+			else if (CHECK_ARG_PARAM("-hashlog"))
+			{
+				s_hash_log_path = argv[++i];
+				continue;
+			}
+			else if (CHECK_ARG_PARAM("-golden"))
+			{
+				s_golden_path = argv[++i];
+				continue;
+			}
+			else if (CHECK_ARG_PARAM("-hashinterval"))
+			{
+				s_hash_interval = StringUtil::FromChars<u32>(argv[++i]).value_or(0);
+				if (s_hash_interval == 0)
+				{
+					Console.Error("Invalid hash interval");
+					return false;
+				}
+
+				continue;
+			}
+			else if (CHECK_ARG_PARAM("-hash"))
+			{
+				const char* sources = argv[++i];
+				if (StringUtil::Strcasecmp(sources, "ram") == 0)
+					s_hash_sources = ReplayVerifier::HASH_EE_RAM;
+				else if (StringUtil::Strcasecmp(sources, "fb") == 0)
+					s_hash_sources = ReplayVerifier::HASH_FRAMEBUFFER;
+				else if (StringUtil::Strcasecmp(sources, "both") == 0)
+					s_hash_sources = ReplayVerifier::HASH_EE_RAM | ReplayVerifier::HASH_FRAMEBUFFER;
+				else
+				{
+					Console.Error("Unknown hash source '%s'", sources);
+					return false;
+				}
+
+				continue;
+			}
 			else if (CHECK_ARG("-window"))
 			{
 				Console.WriteLn("Creating window");
@@ -591,6 +652,18 @@ bool GSRunner::ParseCommandLineArgs(int argc, char* argv[], VMBootParameters& pa
 		return false;
 	}
 
+	if (!s_replay_path.empty())
+	{
+		if (VMManager::IsGSDumpFileName(params.filename))
+		{
+			Console.Error("Input recordings can't be replayed on a GS dump.");
+			return false;
+		}
+
+		s_settings_interface.SetBoolValue("EmuCore", "EnableRecordingTools", true);
+		return true;
+	}
+
 	if (!VMManager::IsGSDumpFileName(params.filename))
 	{
 		Console.Error("Provided filename is not a GS dump.");
@@ -643,15 +716,27 @@ int main(int argc, char* argv[])
 	VMManager::ApplySettings();
 	GSDumpReplayer::SetIsDumpRunner(true);
 
+	bool result = true;
 	if (VMManager::Initialize(params))
 	{
-		// run until end
-		GSDumpReplayer::SetLoopCount(s_loop_count);
-		VMManager::SetState(VMState::Running);
-		while (VMManager::GetState() == VMState::Running)
-			VMManager::Execute();
+		if (!s_replay_path.empty())
+		{
+			result = GSRunner::RunReplay();
+		}
+		else
+		{
+			// run until end
+			GSDumpReplayer::SetLoopCount(s_loop_count);
+			VMManager::SetState(VMState::Running);
+			while (VMManager::GetState() == VMState::Running)
+				VMManager::Execute();
+		}
 		VMManager::Shutdown(false);
 	}
+	else
+	{
+		result = s_replay_path.empty();
+	}
 
 	InputManager::CloseSources();
 	VMManager::Internal::ReleaseMemory();
@@ -659,11 +744,41 @@ int main(int argc, char* argv[])
 	PerformanceMetrics::SetCPUThread(Threading::ThreadHandle());
 	GSRunner::DestroyPlatformWindow();
 
-	return EXIT_SUCCESS;
+	return result ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+bool GSRunner::RunReplay()
+{
+	if (!ReplayVerifier::Initialize(s_hash_log_path, s_golden_path, s_hash_interval, s_hash_sources))
+		return false;
+
+	if (!g_InputRecording.play(s_replay_path))
+	{
+		Console.Error(fmt::format("Failed to play input recording '{}'", s_replay_path));
+		ReplayVerifier::Shutdown();
+		return false;
+	}
+
+	// the recording pauses the VM on its last frame, and so does the verifier when it sees a divergence
+	VMManager::SetState(VMState::Running);
+	while (VMManager::GetState() == VMState::Running)
+		VMManager::Execute();
+
+	g_InputRecording.stop();
+	return ReplayVerifier::Shutdown();
 }
 
 void Host::CPUThreadVSync()
 {
+	if (!s_replay_path.empty())
+	{
+		if (g_InputRecording.isActive() && !ReplayVerifier::OnVSync(static_cast<u32>(g_InputRecording.getFrameCounter())))
+			VMManager::SetPaused(true);
+
+		GSRunner::PumpPlatformMessages();
+		return;
+	}
+
 	// update GS thread copy of frame number
 	GetMTGS().RunOnGSThread([frame_number = GSDumpReplayer::GetFrameNumber()]() { s_dump_frame_number = frame_number; });
 	GetMTGS().RunOnGSThread([loop_number = GSDumpReplayer::GetLoopCount()]() { s_loop_number = loop_number; });
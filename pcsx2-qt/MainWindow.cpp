@@ -21,15 +21,18 @@
 #include <QtWidgets/QInputDialog>
 #include <QtWidgets/QMessageBox>
 #include <QtWidgets/QProgressBar>
+#include <QtWidgets/QProgressDialog>
 #include <QtWidgets/QStyle>
 #include <QtWidgets/QStyleFactory>
 
 #include "common/Assertions.h"
 #include "common/CocoaTools.h"
 #include "common/FileSystem.h"
+#include "common/StringUtil.h"
 
 #include "pcsx2/CDVD/CDVDcommon.h"
 #include "pcsx2/CDVD/CDVDdiscReader.h"
+#include "pcsx2/CDVD/CsoFileWriter.h"
 #include "pcsx2/Frontend/GameList.h"
 #include "pcsx2/Frontend/LogSink.h"
 #include "pcsx2/GS.h"
@@ -48,6 +51,7 @@
 #include "GameList/GameListWidget.h"
 #include "MainWindow.h"
 #include "QtHost.h"
+#include "QtProgressCallback.h"
 #include "QtUtils.h"
 #include "Settings/ControllerSettingsDialog.h"
 #include "Settings/GameListSettingsWidget.h"
@@ -1097,6 +1101,20 @@ void MainWindow::onGameListEntryContextMenuRequested(const QPoint& point)
 
 		connect(menu.addAction(tr("Reset Play Time")), &QAction::triggered, [this, entry]() { clearGameListEntryPlayTime(entry); });
 
+		if (entry->type == GameList::EntryType::PS2Disc)
+		{
+			if (StringUtil::EndsWithNoCase(entry->path, ".cso"))
+			{
+				connect(menu.addAction(tr("Verify Compressed Image")), &QAction::triggered, [this, entry]() { verifyGameListEntry(entry); });
+			}
+			else
+			{
+				connect(menu.addAction(tr("Compress to CSO...")), &QAction::triggered, [this, entry]() { compressGameListEntry(entry, false); });
+				connect(menu.addAction(tr("Compress to CSO (Zstandard)...")), &QAction::triggered,
+					[this, entry]() { compressGameListEntry(entry, true); });
+			}
+		}
+
 		menu.addSeparator();
 
 		if (!s_vm_valid)
@@ -2218,6 +2236,139 @@ void MainWindow::clearGameListEntryPlayTime(const GameList::Entry* entry)
 	m_game_list_widget->refresh(false);
 }
 
+namespace
+{
+	/// Compresses (when a source is given) and then verifies a CSO image, off the UI thread.
+	class CsoImageWorker final : public QtAsyncProgressThread
+	{
+	public:
+		enum class Result
+		{
+			Success,
+			CompressFailed,
+			VerifyFailed,
+		};
+
+		CsoImageWorker(QWidget* parent, std::string src_path, std::string dst_path, const CsoFileWriter::Options& options)
+			: QtAsyncProgressThread(parent)
+			, m_src_path(std::move(src_path))
+			, m_dst_path(std::move(dst_path))
+			, m_options(options)
+		{
+		}
+
+		Result GetResult() const { return m_result; }
+		u32 GetCRC() const { return m_crc; }
+
+	protected:
+		void runAsync() override
+		{
+			u32 src_crc = 0;
+			if (!m_src_path.empty() && !CsoFileWriter::Compress(m_src_path, m_dst_path, m_options, this, &src_crc))
+			{
+				m_result = Result::CompressFailed;
+				return;
+			}
+
+			// Decompress everything we just wrote, so a bad image is caught now rather than mid-game.
+			if (!CsoFileWriter::Verify(m_dst_path, m_options.threads, this, &m_crc) || (!m_src_path.empty() && src_crc != m_crc))
+			{
+				m_result = Result::VerifyFailed;
+				return;
+			}
+
+			m_result = Result::Success;
+		}
+
+	private:
+		std::string m_src_path;
+		std::string m_dst_path;
+		CsoFileWriter::Options m_options;
+		Result m_result = Result::VerifyFailed;
+		u32 m_crc = 0;
+	};
+} // namespace
+
+/// Runs the worker behind a progress dialog, the UI keeps processing events until it finishes or is cancelled.
+/// Returns false if the user cancelled.
+static bool runCsoImageWorker(QWidget* parent, CsoImageWorker& worker, const QString& title)
+{
+	QProgressDialog dialog(parent);
+	dialog.setWindowTitle(title);
+	dialog.setMinimumSize(QSize(500, 0));
+	dialog.setWindowModality(Qt::WindowModal);
+	dialog.setAutoClose(false);
+	dialog.setAutoReset(false);
+
+	// The worker lives on its own thread while it runs, so the dialog is the receiver for everything.
+	QObject::connect(&worker, &QtAsyncProgressThread::statusUpdated, &dialog, &QProgressDialog::setLabelText);
+	QObject::connect(&worker, &QtAsyncProgressThread::progressUpdated, &dialog, [&dialog](int value, int range) {
+		dialog.setRange(0, range);
+		dialog.setValue(value);
+	});
+	QObject::connect(&worker, &QtAsyncProgressThread::threadFinished, &dialog, &QProgressDialog::accept);
+	QObject::connect(&dialog, &QProgressDialog::canceled, &dialog, [&worker]() { worker.requestInterruption(); });
+
+	worker.start();
+	dialog.exec();
+	worker.join();
+	return !dialog.wasCanceled();
+}
+
+void MainWindow::compressGameListEntry(const GameList::Entry* entry, bool zstd)
+{
+	const QString src_path(QString::fromStdString(entry->path));
+	const QFileInfo fi(src_path);
+	const QString dst_path(QFileDialog::getSaveFileName(this, tr("Select Compressed Image Location"),
+		fi.absoluteDir().filePath(fi.completeBaseName() + QStringLiteral(".cso")), tr("Compressed ISO Images (*.cso)")));
+	if (dst_path.isEmpty())
+		return;
+
+	CsoFileWriter::Options options;
+	options.method = zstd ? CsoFileWriter::Method::Zstd : CsoFileWriter::Method::Deflate;
+
+	CsoImageWorker worker(this, entry->path, dst_path.toStdString(), options);
+	if (!runCsoImageWorker(this, worker, tr("Compressing Image")))
+		return;
+
+	switch (worker.GetResult())
+	{
+		case CsoImageWorker::Result::CompressFailed:
+			QMessageBox::critical(this, tr("Compression Failed"), tr("Failed to compress '%1'. Check the log for details.").arg(src_path));
+			return;
+
+		case CsoImageWorker::Result::VerifyFailed:
+			QMessageBox::critical(this, tr("Compression Failed"),
+				tr("The compressed image '%1' does not match the original. It should not be used.").arg(dst_path));
+			return;
+
+		case CsoImageWorker::Result::Success:
+			break;
+	}
+
+	QMessageBox::information(this, tr("Compression Complete"),
+		tr("'%1' was compressed successfully.\n\nCRC32: %2").arg(dst_path).arg(worker.GetCRC(), 8, 16, QChar('0')));
+	refreshGameList(false);
+}
+
+void MainWindow::verifyGameListEntry(const GameList::Entry* entry)
+{
+	const QString path(QString::fromStdString(entry->path));
+
+	CsoImageWorker worker(this, std::string(), entry->path, CsoFileWriter::Options());
+	if (!runCsoImageWorker(this, worker, tr("Verifying Image")))
+		return;
+
+	if (worker.GetResult() != CsoImageWorker::Result::Success)
+	{
+		QMessageBox::critical(this, tr("Verification Failed"), tr("'%1' is corrupted. Check the log for details.").arg(path));
+		return;
+	}
+
+	QMessageBox::information(this, tr("Verification Complete"),
+		tr("All frames of '%1' decompressed successfully.\n\nCRC32: %2").arg(path).arg(worker.GetCRC(), 8, 16, QChar('0')));
+}
+
 std::optional<bool> MainWindow::promptForResumeState(const QString& save_state_path)
 {
 	if (save_state_path.isEmpty())
@@ -25,6 +25,8 @@
 #include <memory>
 #include <string>
 
+class DiscAccessTrace;
+
 class AsyncFileReader
 {
 protected:
@@ -53,6 +55,11 @@ public:
 	virtual void SetBlockSize(uint bytes) {}
 	virtual void SetDataOffset(int bytes) {}
 
+	// Provides a trace of a previous session's reads, which readers with expensive
+	// decompression can use to prepare chunks before the guest requests them.
+	virtual void SetPrefetchTrace(std::shared_ptr<const DiscAccessTrace> trace) {}
+	virtual bool SupportsPrefetchTrace() const { return false; }
+
 	uint GetBlockSize() const { return m_blocksize; }
 
 	const std::string& GetFilename() const
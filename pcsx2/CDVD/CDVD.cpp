@@ -45,6 +45,9 @@
 // this string will be empty.
 std::string DiscSerial;
 
+// Software version from SYSTEM.CNF (e.g. 1.01), empty if the disc doesn't specify one.
+std::string DiscVersion;
+
 cdvdStruct cdvd;
 
 s64 PSXCLK = 36864000;
@@ -387,16 +390,8 @@ s32 cdvdWriteConfig(const u8* config)
 	return 0;
 }
 
-// Sets ElfCRC to the CRC of the game bound to the CDVD source.
-static __fi ElfObject* loadElf(std::string filename, bool isPSXElf)
+static ElfObject* loadIsoElf(SectorSource& isofs, std::string filename, bool isPSXElf)
 {
-	if (StringUtil::StartsWith(filename, "host:"))
-	{
-		std::string host_filename(filename.substr(5));
-		s64 host_size = FileSystem::GetPathFileSize(host_filename.c_str());
-		return new ElfObject(std::move(host_filename), static_cast<u32>(std::max<s64>(host_size, 0)), isPSXElf);
-	}
-
 	// Mimic PS2 behavior!
 	// Much trial-and-error with changing the ISOFS and BOOT2 contents of an image have shown that
 	// the PS2 BIOS performs the peculiar task of *ignoring* the version info from the parsed BOOT2
@@ -419,11 +414,24 @@ static __fi ElfObject* loadElf(std::string filename, bool isPSXElf)
 		filename += ";1";
 	}
 
-	IsoFSCDVD isofs;
 	IsoFile file(isofs, filename);
 	return new ElfObject(std::move(filename), file, isPSXElf);
 }
 
+// Sets ElfCRC to the CRC of the game bound to the CDVD source.
+static __fi ElfObject* loadElf(std::string filename, bool isPSXElf)
+{
+	if (StringUtil::StartsWith(filename, "host:"))
+	{
+		std::string host_filename(filename.substr(5));
+		s64 host_size = FileSystem::GetPathFileSize(host_filename.c_str());
+		return new ElfObject(std::move(host_filename), static_cast<u32>(std::max<s64>(host_size, 0)), isPSXElf);
+	}
+
+	IsoFSCDVD isofs;
+	return loadIsoElf(isofs, std::move(filename), isPSXElf);
+}
+
 static __fi void _reloadElfInfo(std::string elfpath)
 {
 	// Now's a good time to reload the ELF info...
@@ -523,7 +531,8 @@ void cdvdReloadElfInfo(std::string elfoverride)
 	try
 	{
 		std::string elfpath;
-		u32 discType = GetPS2ElfName(elfpath);
+		DiscVersion.clear();
+		u32 discType = GetPS2ElfName(elfpath, &DiscVersion);
 		DiscSerial = ExecutablePathToSerial(elfpath);
 
 		// Use the serial from the disc (if any), and the ELF CRC of the override.
@@ -553,6 +562,7 @@ void cdvdReloadElfInfo(std::string elfoverride)
 		Console.Error("Failed to load ELF info");
 		LastELF.clear();
 		DiscSerial.clear();
+		DiscVersion.clear();
 		ElfCRC = 0;
 		ElfEntry = 0;
 		ElfTextRange = {};
@@ -560,6 +570,39 @@ void cdvdReloadElfInfo(std::string elfoverride)
 	}
 }
 
+bool cdvdProbeIsoFile(const std::string& path, s32* disc_type, std::string* serial, u32* crc)
+{
+	// Everything here reads through our own copy of the image, so probes can run on several threads.
+	std::unique_ptr<InputIsoFile> iso(std::make_unique<InputIsoFile>());
+	if (!iso->Open(path))
+		return false;
+
+	IsoFSInputIsoFile isofs(*iso);
+	*disc_type = DetectIsoDiskType(isofs);
+
+	std::string elfpath;
+	const int elftype = GetPS2ElfName(isofs, elfpath);
+	*serial = ExecutablePathToSerial(elfpath);
+	*crc = 0;
+
+	// Same as cdvdReloadElfInfo(), only PS2 discs get a CRC.
+	if (elftype != 2)
+		return true;
+
+	try
+	{
+		std::unique_ptr<ElfObject> elfptr(loadIsoElf(isofs, std::move(elfpath), false));
+		*crc = elfptr->getCRC();
+	}
+	catch (Exception::BaseException& ex)
+	{
+		Console.Error("Failed to load ELF info from '%s': %s", path.c_str(), ex.FormatDiagnosticMessage().c_str());
+		serial->clear();
+	}
+
+	return true;
+}
+
 void cdvdReadKey(u8, u16, u32 arg2, u8* key)
 {
 	s32 numbers = 0, letters = 0;
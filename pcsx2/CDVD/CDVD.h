@@ -178,7 +178,9 @@ extern void cdvdWrite(u8 key, u8 rt);
 
 extern void cdvdReloadElfInfo(std::string elfoverride = std::string());
 extern u32 cdvdGetElfCRC(const std::string& path);
+extern bool cdvdProbeIsoFile(const std::string& path, s32* disc_type, std::string* serial, u32* crc);
 extern s32 cdvdCtrlTrayOpen();
 extern s32 cdvdCtrlTrayClose();
 
 extern std::string DiscSerial;
+extern std::string DiscVersion;
@@ -70,9 +70,8 @@ static void CheckNullCDVD()
 //////////////////////////////////////////////////////////////////////////////////////////
 // Disk Type detection stuff (from cdvdGigaherz)
 //
-static int CheckDiskTypeFS(int baseType)
+static int CheckDiskTypeFS(SectorSource& isofs, int baseType)
 {
-	IsoFSCDVD isofs;
 	try
 	{
 		IsoDirectory rootdir(isofs);
@@ -139,6 +138,27 @@ static int CheckDiskTypeFS(int baseType)
 	return CDVD_TYPE_ILLEGAL; // << Only for discs which aren't ps2 at all.
 }
 
+static int FindSingleTrackMediaType(SectorSource& isofs, int mType)
+{
+	if (isofs.getNumSectors() > 452849)
+		return CDVD_TYPE_DETCTDVDS;
+
+	u8 bleh[CD_FRAMESIZE_RAW];
+	if (!isofs.readSector(bleh, 16))
+		return mType;
+
+	//const cdVolDesc& volDesc = (cdVolDesc&)bleh;
+	//if(volDesc.rootToc.tocSize == 2048)
+
+	//Horrible hack! in CD images position 166 and 171 have block size but not DVD's
+	//It's not always 2048 however (can be 4096)
+	//Test Impossible Mission if thia is changed.
+	if (*(u16*)(bleh + 166) == *(u16*)(bleh + 171))
+		return CDVD_TYPE_DETCTCD;
+	else
+		return CDVD_TYPE_DETCTDVDS;
+}
+
 static int FindDiskType(int mType)
 {
 	int dataTracks = 0;
@@ -154,30 +174,8 @@ static int FindDiskType(int mType)
 	}
 	else if (mType < 0)
 	{
-		static u8 bleh[CD_FRAMESIZE_RAW];
-		cdvdTD td;
-
-		CDVD->getTD(0, &td);
-		if (td.lsn > 452849)
-		{
-			iCDType = CDVD_TYPE_DETCTDVDS;
-		}
-		else
-		{
-			if (DoCDVDreadSector(bleh, 16, CDVD_MODE_2048) == 0)
-			{
-				//const cdVolDesc& volDesc = (cdVolDesc&)bleh;
-				//if(volDesc.rootToc.tocSize == 2048)
-
-				//Horrible hack! in CD images position 166 and 171 have block size but not DVD's
-				//It's not always 2048 however (can be 4096)
-				//Test Impossible Mission if thia is changed.
-				if (*(u16*)(bleh + 166) == *(u16*)(bleh + 171))
-					iCDType = CDVD_TYPE_DETCTCD;
-				else
-					iCDType = CDVD_TYPE_DETCTDVDS;
-			}
-		}
+		IsoFSCDVD isofs;
+		iCDType = FindSingleTrackMediaType(isofs, mType);
 	}
 
 	if (iCDType == CDVD_TYPE_DETCTDVDS)
@@ -235,7 +233,8 @@ static int FindDiskType(int mType)
 
 	if (dataTracks > 0)
 	{
-		iCDType = CheckDiskTypeFS(iCDType);
+		IsoFSCDVD isofs;
+		iCDType = CheckDiskTypeFS(isofs, iCDType);
 	}
 
 	if (audioTracks > 0)
@@ -552,11 +551,25 @@ s32 DoCDVDdetectDiskType()
 	return diskTypeCached;
 }
 
+s32 DetectIsoDiskType(SectorSource& isofs)
+{
+	// Images are always a single data track, so this is what FindDiskType() ends up doing for them.
+	return CheckDiskTypeFS(isofs, FindSingleTrackMediaType(isofs, -1));
+}
+
 void DoCDVDresetDiskTypeCache()
 {
 	diskTypeCached = -1;
 }
 
+void DoCDVDsetAccessTraceSerial(const std::string& serial)
+{
+	CheckNullCDVD();
+	// Clearing the serial stops recording, so turning the option off takes effect straight away.
+	if (CDVD->setAccessTraceSerial)
+		CDVD->setAccessTraceSerial(EmuConfig.CdvdPrefetchTrace ? serial.c_str() : "");
+}
+
 ////////////////////////////////////////////////////////
 //
 // CDVD null interface for Run BIOS menu
@@ -650,4 +663,5 @@ CDVD_API CDVDapi_NoDisc =
 
 		NODISCreadSector,
 		NODISCgetDualInfo,
+		nullptr, // setAccessTraceSerial
 };
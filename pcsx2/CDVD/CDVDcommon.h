@@ -16,6 +16,8 @@
 #pragma once
 #include <string>
 
+class SectorSource;
+
 typedef struct _cdvdSubQ
 {
 	u8 ctrl : 4;   // control and mode bits
@@ -113,6 +115,10 @@ typedef s32(CALLBACK* _CDVDgetDualInfo)(s32* dualType, u32* _layer1start);
 
 typedef void(CALLBACK* _CDVDnewDiskCB)(void (*callback)());
 
+// Starts recording the sector reads of the specified serial, and replays the
+// reads recorded for it in a previous session as prefetch hints.
+typedef void(CALLBACK* _CDVDsetAccessTraceSerial)(const char* serial);
+
 enum class CDVD_SourceType : uint8_t
 {
 	Iso,    // use built in ISO api
@@ -142,6 +148,7 @@ struct CDVD_API
 	// special functions, not in external interface yet
 	_CDVDreadSector readSector;
 	_CDVDgetDualInfo getDualInfo;
+	_CDVDsetAccessTraceSerial setAccessTraceSerial;
 };
 
 // ----------------------------------------------------------------------------
@@ -165,4 +172,7 @@ extern s32 DoCDVDreadSector(u8* buffer, u32 lsn, int mode);
 extern s32 DoCDVDreadTrack(u32 lsn, int mode);
 extern s32 DoCDVDgetBuffer(u8* buffer);
 extern s32 DoCDVDdetectDiskType();
+// Detects the type of an image read through isofs, without using the global CDVD state.
+extern s32 DetectIsoDiskType(SectorSource& isofs);
 extern void DoCDVDresetDiskTypeCache();
+extern void DoCDVDsetAccessTraceSerial(const std::string& serial);
@@ -570,4 +570,5 @@ CDVD_API CDVDapi_Disc =
 
 		DISCreadSector,
 		DISCgetDualInfo,
+		nullptr, // setAccessTraceSerial
 };
@@ -401,6 +401,11 @@ s32 CALLBACK ISOgetBuffer(u8* buffer)
 //	return pbuffer;
 //}
 
+void CALLBACK ISOsetAccessTraceSerial(const char* serial)
+{
+	iso.SetAccessTraceSerial(serial);
+}
+
 s32 CALLBACK ISOgetTrayStatus()
 {
 	return CDVD_TRAY_CLOSE;
@@ -444,4 +449,5 @@ CDVD_API CDVDapi_Iso =
 
 		ISOreadSector,
 		ISOgetDualInfo,
+		ISOsetAccessTraceSerial,
 };
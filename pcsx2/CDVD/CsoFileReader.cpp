@@ -24,19 +24,7 @@
 #else
 #include <zlib/zlib.h>
 #endif
-
-// Implementation of CSO compressed ISO reading, based on:
-// https://github.com/unknownbrackets/maxcso/blob/master/README_CSO.md
-struct CsoHeader
-{
-	u8 magic[4];
-	u32 header_size;
-	u64 total_bytes;
-	u32 frame_size;
-	u8 ver;
-	u8 align;
-	u8 reserved[2];
-};
+#include <zstd.h>
 
 static const u32 CSO_READ_BUFFER_SIZE = 256 * 1024;
 
@@ -61,7 +49,7 @@ bool CsoFileReader::CanHandle(const std::string& fileName, const std::string& di
 
 bool CsoFileReader::ValidateHeader(const CsoHeader& hdr)
 {
-	if (hdr.magic[0] != 'C' || hdr.magic[1] != 'I' || hdr.magic[2] != 'S' || hdr.magic[3] != 'O')
+	if (std::memcmp(hdr.magic, CSO_MAGIC, sizeof(hdr.magic)) != 0 && std::memcmp(hdr.magic, ZCSO_MAGIC, sizeof(hdr.magic)) != 0)
 	{
 		// Invalid magic, definitely a bad file.
 		return false;
@@ -134,6 +122,16 @@ bool CsoFileReader::ReadFileHeader()
 	m_indexShift = hdr.align;
 	m_totalSize = hdr.total_bytes;
 
+	if (std::memcmp(hdr.magic, ZCSO_MAGIC, sizeof(hdr.magic)) == 0)
+	{
+		m_zstd_stream = ZSTD_createDCtx();
+		if (!m_zstd_stream)
+		{
+			Console.Error("Unable to initialize zstd for CSO decompression.");
+			return false;
+		}
+	}
+
 	return true;
 }
 
@@ -187,6 +185,11 @@ void CsoFileReader::Close2()
 		inflateEnd(m_z_stream);
 		m_z_stream = NULL;
 	}
+	if (m_zstd_stream)
+	{
+		ZSTD_freeDCtx(m_zstd_stream);
+		m_zstd_stream = NULL;
+	}
 
 	if (m_readBuffer)
 	{
@@ -253,6 +256,19 @@ int CsoFileReader::ReadChunk(void *dst, s64 chunkID)
 		// This is because the index positions must be aligned.
 		const u32 readRawBytes = fread(m_readBuffer, 1, frameRawSize, m_src);
 
+		if (m_zstd_stream)
+		{
+			// Don't feed the index alignment padding to zstd, it would be parsed as another frame.
+			const size_t frameBytes = ZSTD_findFrameCompressedSize(m_readBuffer, readRawBytes);
+			const size_t size = ZSTD_isError(frameBytes) ? frameBytes :
+				ZSTD_decompressDCtx(m_zstd_stream, dst, m_frameSize, m_readBuffer, frameBytes);
+			const bool success = !ZSTD_isError(size) && size == m_frameSize;
+			if (!success)
+				Console.Error("Unable to decompress CSO frame using zstd.");
+
+			return success ? m_frameSize : 0;
+		}
+
 		m_z_stream->next_in = m_readBuffer;
 		m_z_stream->avail_in = readRawBytes;
 		m_z_stream->next_out = static_cast<Bytef*>(dst);
@@ -28,8 +28,28 @@
 #include "ChunksCache.h"
 #include <zlib.h>
 
-struct CsoHeader;
 typedef struct z_stream_s z_stream;
+typedef struct ZSTD_DCtx_s ZSTD_DCtx;
+
+// Implementation of CSO compressed ISO reading, based on:
+// https://github.com/unknownbrackets/maxcso/blob/master/README_CSO.md
+// Frames of "ZCSO" images use the same layout but are compressed with zstd instead of deflate.
+struct CsoHeader
+{
+	u8 magic[4];
+	u32 header_size;
+	u64 total_bytes;
+	u32 frame_size;
+	u8 ver;
+	u8 align;
+	u8 reserved[2];
+};
+
+static constexpr u8 CSO_MAGIC[4] = {'C', 'I', 'S', 'O'};
+static constexpr u8 ZCSO_MAGIC[4] = {'Z', 'C', 'S', 'O'};
+
+// Set in an index entry when the frame is stored uncompressed.
+static constexpr u32 CSO_INDEX_UNCOMPRESSED = 0x80000000;
 
 static const uint CSO_CHUNKCACHE_SIZE_MB = 200;
 
@@ -47,6 +67,7 @@ public:
 		, m_totalSize(0)
 		, m_src(0)
 		, m_z_stream(0)
+		, m_zstd_stream(0)
 	{
 		m_blocksize = 2048;
 	};
@@ -83,4 +104,6 @@ private:
 	// The actual source cso file handle.
 	FILE* m_src;
 	z_stream* m_z_stream;
+	// Only created for ZCSO images.
+	ZSTD_DCtx* m_zstd_stream;
 };
@@ -0,0 +1,527 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+
+#include "CDVD/CsoFileWriter.h"
+#include "CDVD/CsoFileReader.h"
+#include "CDVD/IsoFileFormats.h"
+
+#include "common/Console.h"
+#include "common/FileSystem.h"
+#include "common/ProgressCallback.h"
+#include "common/ScopedGuard.h"
+#include "common/ThreadPool.h"
+#include "common/Timer.h"
+
+#ifdef __POSIX__
+#include <zlib.h>
+#else
+#include <zlib/zlib.h>
+#endif
+#include <zstd.h>
+
+#include <deque>
+#include <future>
+
+// User data of a sector, what CsoFileReader serves with its fixed 2048 byte block size.
+static constexpr u32 SECTOR_SIZE = 2048;
+
+// Offset of the user data in the buffer filled by InputIsoFile::ReadSync(), same as CDVD_MODE_2048.
+static constexpr u32 SECTOR_DATA_OFFSET = 24;
+
+// Amount of uncompressed data handed to a worker at once.
+static constexpr u32 BATCH_SIZE = 1024 * 1024;
+
+static constexpr int DEFAULT_DEFLATE_LEVEL = 9;
+static constexpr int DEFAULT_ZSTD_LEVEL = 19;
+
+namespace
+{
+	struct FrameBatch
+	{
+		u32 first_frame;
+		u32 num_frames;
+		u32 crc;
+		u64 crc_length;
+
+		/// Frame data, back to back. Uncompressed input for Compress(), compressed input for Verify().
+		std::vector<u8> data;
+
+		/// Size of each frame in data, with CSO_INDEX_UNCOMPRESSED set for frames which are stored.
+		std::vector<u32> sizes;
+
+		bool ok = true;
+	};
+} // namespace
+
+static u32 GetThreadCount(u32 threads)
+{
+	return threads ? threads : std::max(cb::ThreadPool::GetNumLogicalCores(), 1u);
+}
+
+// Pushes batches through the pool, keeping a bounded number in flight. Batches are produced and
+// consumed on the calling thread in order, so file I/O stays sequential while (de)compression scales.
+template <typename ProduceT, typename ProcessT, typename ConsumeT>
+static bool RunOrderedBatches(u32 num_batches, u32 threads, ProgressCallback* progress,
+	const ProduceT& produce, const ProcessT& process, const ConsumeT& consume)
+{
+	cb::ThreadPool pool(static_cast<int>(threads));
+	std::deque<std::future<std::shared_ptr<FrameBatch>>> in_flight;
+	const size_t max_in_flight = static_cast<size_t>(threads) * 2;
+
+	bool ok = true;
+	u32 next_batch = 0;
+	while (ok && (next_batch < num_batches || !in_flight.empty()))
+	{
+		while (next_batch < num_batches && in_flight.size() < max_in_flight)
+		{
+			std::shared_ptr<FrameBatch> batch = std::make_shared<FrameBatch>();
+			if (!produce(next_batch++, *batch))
+			{
+				ok = false;
+				break;
+			}
+
+			in_flight.push_back(pool.ScheduleAndGetFuture([&process, batch]() {
+				process(*batch);
+				return batch;
+			}));
+		}
+
+		if (in_flight.empty())
+			break;
+
+		std::shared_ptr<FrameBatch> batch = in_flight.front().get();
+		in_flight.pop_front();
+		ok = ok && batch->ok && consume(*batch) && !progress->IsCancelled();
+	}
+
+	// Don't leave workers referencing batches after we return.
+	for (auto& future : in_flight)
+		future.wait();
+
+	return ok;
+}
+
+static void CompressBatch(FrameBatch& batch, CsoFileWriter::Method method, u32 frame_size, int level, u32 align_mask)
+{
+	std::vector<u8> input(std::move(batch.data));
+	batch.crc = crc32(0, input.data(), static_cast<uInt>(batch.crc_length));
+	batch.data.reserve(input.size());
+	batch.sizes.reserve(batch.num_frames);
+
+	z_stream zs = {};
+	ZSTD_CCtx* zcctx = nullptr;
+	if (method == CsoFileWriter::Method::Zstd)
+	{
+		zcctx = ZSTD_createCCtx();
+		batch.ok = (zcctx != nullptr);
+	}
+	else
+	{
+		batch.ok = (deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+	}
+	if (!batch.ok)
+		return;
+
+	const size_t bound = (method == CsoFileWriter::Method::Zstd) ? ZSTD_compressBound(frame_size) : deflateBound(&zs, frame_size);
+	std::vector<u8> scratch(bound);
+
+	for (u32 i = 0; i < batch.num_frames; i++)
+	{
+		const u8* frame = input.data() + static_cast<size_t>(i) * frame_size;
+		size_t compressed_size;
+		if (method == CsoFileWriter::Method::Zstd)
+		{
+			compressed_size = ZSTD_compressCCtx(zcctx, scratch.data(), scratch.size(), frame, frame_size, level);
+			if (ZSTD_isError(compressed_size))
+			{
+				batch.ok = false;
+				break;
+			}
+		}
+		else
+		{
+			deflateReset(&zs);
+			zs.next_in = const_cast<Bytef*>(frame);
+			zs.avail_in = frame_size;
+			zs.next_out = scratch.data();
+			zs.avail_out = static_cast<uInt>(scratch.size());
+			if (deflate(&zs, Z_FINISH) != Z_STREAM_END)
+			{
+				batch.ok = false;
+				break;
+			}
+			compressed_size = zs.total_out;
+		}
+
+		// Frames which don't shrink once padded to the index alignment are stored as-is.
+		if (((compressed_size + align_mask) & ~static_cast<size_t>(align_mask)) >= frame_size)
+		{
+			batch.data.insert(batch.data.end(), frame, frame + frame_size);
+			batch.sizes.push_back(frame_size | CSO_INDEX_UNCOMPRESSED);
+		}
+		else
+		{
+			batch.data.insert(batch.data.end(), scratch.data(), scratch.data() + compressed_size);
+			batch.sizes.push_back(static_cast<u32>(compressed_size));
+		}
+	}
+
+	if (zcctx)
+		ZSTD_freeCCtx(zcctx);
+	else
+		deflateEnd(&zs);
+}
+
+static void DecompressBatch(FrameBatch& batch, bool zstd, u32 frame_size, u64 total_bytes)
+{
+	z_stream zs = {};
+	ZSTD_DCtx* zdctx = nullptr;
+	if (zstd)
+	{
+		zdctx = ZSTD_createDCtx();
+		batch.ok = (zdctx != nullptr);
+	}
+	else
+	{
+		batch.ok = (inflateInit2(&zs, -15) == Z_OK);
+	}
+	if (!batch.ok)
+		return;
+
+	std::vector<u8> frame(frame_size);
+	const u8* src = batch.data.data();
+	batch.crc = crc32(0, nullptr, 0);
+	batch.crc_length = 0;
+
+	u32 i = 0;
+	for (; i < batch.num_frames; i++)
+	{
+		const u32 size = batch.sizes[i] & ~CSO_INDEX_UNCOMPRESSED;
+		if (batch.sizes[i] & CSO_INDEX_UNCOMPRESSED)
+		{
+			if (size < frame_size)
+			{
+				batch.ok = false;
+				break;
+			}
+			std::memcpy(frame.data(), src, frame_size);
+		}
+		else if (zstd)
+		{
+			const size_t frame_bytes = ZSTD_findFrameCompressedSize(src, size);
+			const size_t res = ZSTD_isError(frame_bytes) ? frame_bytes :
+				ZSTD_decompressDCtx(zdctx, frame.data(), frame_size, src, frame_bytes);
+			if (ZSTD_isError(res) || res != frame_size)
+			{
+				batch.ok = false;
+				break;
+			}
+		}
+		else
+		{
+			inflateReset(&zs);
+			zs.next_in = const_cast<Bytef*>(src);
+			zs.avail_in = size;
+			zs.next_out = frame.data();
+			zs.avail_out = frame_size;
+			if (inflate(&zs, Z_FINISH) != Z_STREAM_END || zs.total_out != frame_size)
+			{
+				batch.ok = false;
+				break;
+			}
+		}
+
+		// The last frame is padded, only the image contents count towards the CRC.
+		const u64 frame_start = static_cast<u64>(batch.first_frame + i) * frame_size;
+		const u32 crc_bytes = static_cast<u32>(std::min<u64>(frame_size, total_bytes - frame_start));
+		batch.crc = crc32(batch.crc, frame.data(), crc_bytes);
+		batch.crc_length += crc_bytes;
+		src += size;
+	}
+
+	if (!batch.ok)
+		Console.Error("(CsoFileWriter) Frame %u failed to decompress.", batch.first_frame + i);
+
+	if (zdctx)
+		ZSTD_freeDCtx(zdctx);
+	else
+		inflateEnd(&zs);
+}
+
+bool CsoFileWriter::Compress(const std::string& src_path, const std::string& dst_path, const Options& options,
+	ProgressCallback* progress, u32* out_crc)
+{
+	if (!progress)
+		progress = ProgressCallback::NullProgressCallback;
+
+	const u32 frame_size = options.frame_size;
+	if (frame_size < SECTOR_SIZE || (frame_size & (frame_size - 1)) != 0 || frame_size > BATCH_SIZE)
+	{
+		progress->DisplayFormattedError("Invalid CSO frame size %u.", frame_size);
+		return false;
+	}
+
+	InputIsoFile src;
+	if (!src.Open(src_path))
+	{
+		progress->DisplayFormattedError("Failed to open '%s'.", src_path.c_str());
+		return false;
+	}
+
+	const u64 total_bytes = static_cast<u64>(src.GetBlockCount()) * SECTOR_SIZE;
+	const u32 num_frames = static_cast<u32>((total_bytes + frame_size - 1) / frame_size);
+	const u32 frames_per_batch = BATCH_SIZE / frame_size;
+	const u32 num_batches = (num_frames + frames_per_batch - 1) / frames_per_batch;
+	const u64 index_bytes = (static_cast<u64>(num_frames) + 1) * sizeof(u32);
+	const u64 data_start = sizeof(CsoHeader) + index_bytes;
+
+	// Index entries are 31-bit positions shifted by the alignment, pick the smallest alignment which
+	// can address a worst-case (all frames stored, plus padding) image.
+	u8 align = 0;
+	while (((data_start + static_cast<u64>(num_frames) * (frame_size + (1u << align))) >> align) >= CSO_INDEX_UNCOMPRESSED)
+		align++;
+	const u32 align_mask = (1u << align) - 1;
+
+	const CsoFileWriter::Method method = options.method;
+	const int level = options.level ? options.level : ((method == Method::Zstd) ? DEFAULT_ZSTD_LEVEL : DEFAULT_DEFLATE_LEVEL);
+	const u32 threads = GetThreadCount(options.threads);
+
+	auto fp = FileSystem::OpenManagedCFile(dst_path.c_str(), "wb");
+	if (!fp)
+	{
+		progress->DisplayFormattedError("Failed to open '%s' for writing.", dst_path.c_str());
+		return false;
+	}
+
+	CsoHeader hdr = {};
+	std::memcpy(hdr.magic, (method == Method::Zstd) ? ZCSO_MAGIC : CSO_MAGIC, sizeof(hdr.magic));
+	hdr.header_size = sizeof(CsoHeader);
+	hdr.total_bytes = total_bytes;
+	hdr.frame_size = frame_size;
+	hdr.ver = 1;
+	hdr.align = align;
+
+	// Index is filled in as frames are written, and rewritten at the end.
+	std::vector<u32> index(num_frames + 1);
+	if (std::fwrite(&hdr, sizeof(hdr), 1, fp.get()) != 1 ||
+		std::fwrite(index.data(), sizeof(u32), index.size(), fp.get()) != index.size())
+	{
+		progress->DisplayFormattedError("Failed to write to '%s'.", dst_path.c_str());
+		return false;
+	}
+
+	ScopedGuard delete_on_failure([&fp, &dst_path]() {
+		fp.reset();
+		FileSystem::DeleteFilePath(dst_path.c_str());
+	});
+
+	progress->SetStatusText("Compressing disc image...");
+	progress->SetProgressRange(num_batches);
+	progress->SetProgressValue(0);
+
+	Common::Timer timer;
+	u8 sector[CD_FRAMESIZE_RAW];
+	const u32 sectors_per_frame = frame_size / SECTOR_SIZE;
+	const u32 block_count = src.GetBlockCount();
+
+	u64 pos = data_start;
+	u32 crc = crc32(0, nullptr, 0);
+	static constexpr u8 padding[16] = {};
+	const bool ok = RunOrderedBatches(num_batches, threads, progress,
+		[&](u32 batch_index, FrameBatch& batch) {
+			batch.first_frame = batch_index * frames_per_batch;
+			batch.num_frames = std::min(frames_per_batch, num_frames - batch.first_frame);
+			batch.data.resize(static_cast<size_t>(batch.num_frames) * frame_size);
+
+			// Partial last frame is zero-filled, CsoFileReader always decompresses whole frames.
+			const u32 first_lsn = batch.first_frame * sectors_per_frame;
+			const u32 end_lsn = std::min(first_lsn + batch.num_frames * sectors_per_frame, block_count);
+			for (u32 lsn = first_lsn; lsn < end_lsn; lsn++)
+			{
+				if (src.ReadSync(sector, lsn) < 0)
+				{
+					progress->DisplayFormattedError("Failed to read sector %u.", lsn);
+					return false;
+				}
+				std::memcpy(&batch.data[static_cast<size_t>(lsn - first_lsn) * SECTOR_SIZE], sector + SECTOR_DATA_OFFSET, SECTOR_SIZE);
+			}
+			batch.crc_length = static_cast<u64>(end_lsn - first_lsn) * SECTOR_SIZE;
+			return true;
+		},
+		[method, frame_size, level, align_mask](FrameBatch& batch) {
+			CompressBatch(batch, method, frame_size, level, align_mask);
+		},
+		[&](const FrameBatch& batch) {
+			const u8* data = batch.data.data();
+			for (u32 i = 0; i < batch.num_frames; i++)
+			{
+				const u32 size = batch.sizes[i] & ~CSO_INDEX_UNCOMPRESSED;
+				const u32 padded_size = (size + align_mask) & ~align_mask;
+				index[batch.first_frame + i] = static_cast<u32>(pos >> align) | (batch.sizes[i] & CSO_INDEX_UNCOMPRESSED);
+				if (std::fwrite(data, size, 1, fp.get()) != 1)
+					return false;
+
+				for (u32 remaining = padded_size - size; remaining > 0;)
+				{
+					const u32 count = std::min<u32>(remaining, sizeof(padding));
+					if (std::fwrite(padding, count, 1, fp.get()) != 1)
+						return false;
+					remaining -= count;
+				}
+
+				data += size;
+				pos += padded_size;
+			}
+
+			crc = crc32_combine(crc, batch.crc, static_cast<z_off_t>(batch.crc_length));
+			progress->IncrementProgressValue();
+			return true;
+		});
+
+	index[num_frames] = static_cast<u32>(pos >> align);
+	if (!ok || FileSystem::FSeek64(fp.get(), sizeof(CsoHeader), SEEK_SET) != 0 ||
+		std::fwrite(index.data(), sizeof(u32), index.size(), fp.get()) != index.size() || std::fflush(fp.get()) != 0)
+	{
+		if (!progress->IsCancelled())
+			progress->DisplayFormattedError("Failed to compress '%s'.", src_path.c_str());
+		return false;
+	}
+
+	delete_on_failure.Cancel();
+
+	Console.WriteLn("(CsoFileWriter) Compressed %s to %s (%.1f%%) in %.2f seconds using %u threads.",
+		src_path.c_str(), dst_path.c_str(), (static_cast<double>(pos) * 100.0) / static_cast<double>(std::max<u64>(total_bytes, 1)),
+		timer.GetTimeSeconds(), threads);
+
+	if (out_crc)
+		*out_crc = crc;
+
+	return true;
+}
+
+bool CsoFileWriter::Verify(const std::string& path, u32 threads, ProgressCallback* progress, u32* out_crc)
+{
+	if (!progress)
+		progress = ProgressCallback::NullProgressCallback;
+
+	auto fp = FileSystem::OpenManagedCFile(path.c_str(), "rb");
+	CsoHeader hdr;
+	if (!fp || std::fread(&hdr, sizeof(hdr), 1, fp.get()) != 1)
+	{
+		progress->DisplayFormattedError("Failed to read CSO header from '%s'.", path.c_str());
+		return false;
+	}
+
+	const bool zstd = (std::memcmp(hdr.magic, ZCSO_MAGIC, sizeof(hdr.magic)) == 0);
+	if ((!zstd && std::memcmp(hdr.magic, CSO_MAGIC, sizeof(hdr.magic)) != 0) || hdr.ver > 1 ||
+		hdr.frame_size < SECTOR_SIZE || (hdr.frame_size & (hdr.frame_size - 1)) != 0 || hdr.frame_size > BATCH_SIZE)
+	{
+		progress->DisplayFormattedError("'%s' is not a supported CSO image.", path.c_str());
+		return false;
+	}
+
+	const u32 frame_size = hdr.frame_size;
+	const u32 num_frames = static_cast<u32>((hdr.total_bytes + frame_size - 1) / frame_size);
+	std::vector<u32> index(num_frames + 1);
+	if (std::fread(index.data(), sizeof(u32), index.size(), fp.get()) != index.size())
+	{
+		progress->DisplayFormattedError("Failed to read CSO index from '%s'.", path.c_str());
+		return false;
+	}
+
+	const auto frame_pos = [&index, &hdr](u32 frame) { return static_cast<u64>(index[frame] & ~CSO_INDEX_UNCOMPRESSED) << hdr.align; };
+	for (u32 i = 0; i < num_frames; i++)
+	{
+		if (frame_pos(i + 1) < frame_pos(i))
+		{
+			progress->DisplayFormattedError("CSO index is corrupted at frame %u.", i);
+			return false;
+		}
+	}
+
+	const u32 frames_per_batch = BATCH_SIZE / frame_size;
+	const u32 num_batches = (num_frames + frames_per_batch - 1) / frames_per_batch;
+	threads = GetThreadCount(threads);
+
+	progress->SetStatusText("Verifying disc image...");
+	progress->SetProgressRange(num_batches);
+	progress->SetProgressValue(0);
+
+	Common::Timer timer;
+	u32 crc = crc32(0, nullptr, 0);
+	const u64 total_bytes = hdr.total_bytes;
+	const bool ok = RunOrderedBatches(num_batches, threads, progress,
+		[&](u32 batch_index, FrameBatch& batch) {
+			batch.first_frame = batch_index * frames_per_batch;
+			batch.num_frames = std::min(frames_per_batch, num_frames - batch.first_frame);
+
+			// Frames are contiguous, so the whole batch is one read. Alignment padding is
+			// accounted to the preceding frame, decompressors stop at the end of their stream.
+			const u64 start = frame_pos(batch.first_frame);
+			const u64 end = frame_pos(batch.first_frame + batch.num_frames);
+			batch.sizes.resize(batch.num_frames);
+			for (u32 i = 0; i < batch.num_frames; i++)
+			{
+				const u32 frame = batch.first_frame + i;
+				batch.sizes[i] = static_cast<u32>(frame_pos(frame + 1) - frame_pos(frame)) | (index[frame] & CSO_INDEX_UNCOMPRESSED);
+			}
+
+			batch.data.resize(static_cast<size_t>(end - start));
+			const size_t bytes_read = (FileSystem::FSeek64(fp.get(), static_cast<s64>(start), SEEK_SET) == 0) ?
+				std::fread(batch.data.data(), 1, batch.data.size(), fp.get()) : 0;
+			if (bytes_read != batch.data.size())
+			{
+				// Only the alignment padding after the last frame may be missing. The last frame is
+				// trimmed to what was read, so a truncated stream fails to decompress.
+				const size_t missing = batch.data.size() - bytes_read;
+				const u32 last_size = batch.sizes.back() & ~CSO_INDEX_UNCOMPRESSED;
+				if (batch.first_frame + batch.num_frames != num_frames || missing >= (1u << hdr.align) || missing >= last_size)
+				{
+					progress->DisplayFormattedError("Failed to read frames %u-%u.", batch.first_frame, batch.first_frame + batch.num_frames - 1);
+					return false;
+				}
+
+				batch.data.resize(bytes_read);
+				batch.sizes.back() -= static_cast<u32>(missing);
+			}
+			return true;
+		},
+		[zstd, frame_size, total_bytes](FrameBatch& batch) {
+			DecompressBatch(batch, zstd, frame_size, total_bytes);
+		},
+		[&](const FrameBatch& batch) {
+			crc = crc32_combine(crc, batch.crc, static_cast<z_off_t>(batch.crc_length));
+			progress->IncrementProgressValue();
+			return true;
+		});
+
+	if (!ok)
+	{
+		if (!progress->IsCancelled())
+			progress->DisplayFormattedError("Verification of '%s' failed.", path.c_str());
+		return false;
+	}
+
+	Console.WriteLn("(CsoFileWriter) Verified %u frames of %s in %.2f seconds using %u threads, CRC %08X.",
+		num_frames, path.c_str(), timer.GetTimeSeconds(), threads, crc);
+
+	if (out_crc)
+		*out_crc = crc;
+
+	return true;
+}
@@ -0,0 +1,56 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/Pcsx2Defs.h"
+
+#include <string>
+
+class ProgressCallback;
+
+/// Creates and checks CSO images readable by CsoFileReader.
+/// Frames are compressed/decompressed on a thread pool, while the calling thread reads and writes in order.
+namespace CsoFileWriter
+{
+	enum class Method : u8
+	{
+		Deflate, // Standard CSOv1, readable by other tools.
+		Zstd, // ZCSO, same layout but frames are zstd-compressed. Faster to decompress, only PCSX2 reads it.
+	};
+
+	struct Options
+	{
+		Method method = Method::Deflate;
+
+		/// Bytes per frame, must be a power of two and at least one sector.
+		u32 frame_size = 2048;
+
+		/// Compression level, 0 selects the default for the method.
+		int level = 0;
+
+		/// Worker thread count, 0 uses one per logical core.
+		u32 threads = 0;
+	};
+
+	/// Compresses the 2048-byte user data of every sector of the image at src_path (any format InputIsoFile opens).
+	/// If out_crc is set, it receives the CRC32 of the uncompressed data, to compare against Verify().
+	bool Compress(const std::string& src_path, const std::string& dst_path, const Options& options,
+		ProgressCallback* progress = nullptr, u32* out_crc = nullptr);
+
+	/// Decompresses every frame of a CSO/ZCSO image in parallel, failing on the first frame which doesn't decode.
+	/// If out_crc is set, it receives the CRC32 of the decompressed image.
+	bool Verify(const std::string& path, u32 threads = 0, ProgressCallback* progress = nullptr, u32* out_crc = nullptr);
+} // namespace CsoFileWriter
@@ -0,0 +1,247 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+
+#include "CDVD/DiscAccessTrace.h"
+#include "Config.h"
+
+#include "common/Console.h"
+#include "common/FileSystem.h"
+#include "common/Path.h"
+
+static constexpr u32 TRACE_MAGIC = 0x52544450; // PDTR
+static constexpr u32 TRACE_VERSION = 1;
+
+// Stop recording once a session has issued this many discontiguous reads.
+// Games which stream audio/video for hours would otherwise grow the trace forever,
+// and the start of the session (boot, loading screens) is what we want to replay anyway.
+static constexpr size_t MAX_RUNS = 256 * 1024;
+
+// Number of runs after the hint which are checked before falling back to the index.
+static constexpr size_t LOCATE_WINDOW = 16;
+
+// Number of runs with a lower starting sector which are checked for containment in the index.
+static constexpr size_t LOCATE_INDEX_SCAN = 32;
+
+struct TraceHeader
+{
+	u32 magic;
+	u32 version;
+	u32 block_count;
+	u32 run_count;
+};
+
+static void WriteVarInt(std::vector<u8>& out, u32 value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back(static_cast<u8>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<u8>(value));
+}
+
+static bool ReadVarInt(const u8*& ptr, const u8* end, u32* value)
+{
+	u32 result = 0;
+	for (u32 shift = 0; shift < 35; shift += 7)
+	{
+		if (ptr == end)
+			return false;
+
+		const u8 byte = *(ptr++);
+		result |= static_cast<u32>(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+		{
+			*value = result;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Runs are stored as the signed distance from the end of the previous run, which is
+// small for the usual seek-within-a-file pattern, so zigzag it to keep the varint short.
+static u32 ZigZagEncode(s32 value)
+{
+	return (static_cast<u32>(value) << 1) ^ static_cast<u32>(value >> 31);
+}
+
+static s32 ZigZagDecode(u32 value)
+{
+	return static_cast<s32>(value >> 1) ^ -static_cast<s32>(value & 1);
+}
+
+DiscAccessTrace::DiscAccessTrace() = default;
+
+DiscAccessTrace::~DiscAccessTrace() = default;
+
+std::string DiscAccessTrace::GetPath(const std::string_view& serial)
+{
+	return Path::Combine(EmuFolders::Cache, Path::Combine("disctrace", fmt::format("{}.trace", Path::SanitizeFileName(serial))));
+}
+
+bool DiscAccessTrace::Load(const std::string& path, u32 block_count)
+{
+	Clear();
+
+	std::optional<std::vector<u8>> data = FileSystem::ReadBinaryFile(path.c_str());
+	if (!data.has_value() || data->size() < sizeof(TraceHeader))
+		return false;
+
+	TraceHeader hdr;
+	std::memcpy(&hdr, data->data(), sizeof(hdr));
+	if (hdr.magic != TRACE_MAGIC || hdr.version != TRACE_VERSION || hdr.run_count > MAX_RUNS)
+	{
+		Console.Warning("(DiscAccessTrace) Ignoring invalid trace '%s'", path.c_str());
+		return false;
+	}
+
+	if (hdr.block_count != block_count)
+	{
+		Console.Warning("(DiscAccessTrace) Ignoring trace '%s' recorded for a different image (%u vs %u sectors)",
+			path.c_str(), hdr.block_count, block_count);
+		return false;
+	}
+
+	const u8* ptr = data->data() + sizeof(hdr);
+	const u8* end = data->data() + data->size();
+	m_runs.reserve(hdr.run_count);
+
+	s64 prev_end = 0;
+	for (u32 i = 0; i < hdr.run_count; i++)
+	{
+		u32 delta, count;
+		if (!ReadVarInt(ptr, end, &delta) || !ReadVarInt(ptr, end, &count))
+		{
+			Console.Error("(DiscAccessTrace) Trace '%s' is truncated", path.c_str());
+			Clear();
+			return false;
+		}
+
+		const s64 lsn = prev_end + ZigZagDecode(delta);
+		if (lsn < 0 || count == 0 || (lsn + count) > block_count)
+		{
+			Console.Error("(DiscAccessTrace) Trace '%s' is corrupted", path.c_str());
+			Clear();
+			return false;
+		}
+
+		m_runs.push_back({static_cast<u32>(lsn), count});
+		prev_end = lsn + count;
+	}
+
+	BuildIndex();
+	return true;
+}
+
+bool DiscAccessTrace::Save(const std::string& path, u32 block_count) const
+{
+	std::vector<u8> data(sizeof(TraceHeader));
+	data.reserve(sizeof(TraceHeader) + m_runs.size() * 3);
+
+	const TraceHeader hdr = {TRACE_MAGIC, TRACE_VERSION, block_count, static_cast<u32>(m_runs.size())};
+	std::memcpy(data.data(), &hdr, sizeof(hdr));
+
+	s64 prev_end = 0;
+	for (const Run& run : m_runs)
+	{
+		WriteVarInt(data, ZigZagEncode(static_cast<s32>(static_cast<s64>(run.lsn) - prev_end)));
+		WriteVarInt(data, run.count);
+		prev_end = static_cast<s64>(run.lsn) + run.count;
+	}
+
+	const std::string dir(Path::GetDirectory(path));
+	if (!FileSystem::EnsureDirectoryExists(dir.c_str(), true) ||
+		!FileSystem::WriteBinaryFile(path.c_str(), data.data(), data.size()))
+	{
+		Console.Error("(DiscAccessTrace) Failed to write trace to '%s'", path.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void DiscAccessTrace::Record(u32 lsn, u32 count)
+{
+	if (!m_runs.empty())
+	{
+		// Merge reads which continue (or re-read part of) the last run.
+		Run& last = m_runs.back();
+		if (lsn >= last.lsn && lsn <= (last.lsn + last.count))
+		{
+			last.count = std::max(last.count, lsn + count - last.lsn);
+			return;
+		}
+	}
+
+	if (m_runs.size() >= MAX_RUNS)
+		return;
+
+	m_runs.push_back({lsn, count});
+}
+
+void DiscAccessTrace::Clear()
+{
+	m_runs = {};
+	m_index = {};
+}
+
+size_t DiscAccessTrace::Locate(u32 lsn, size_t hint) const
+{
+	// The guest almost always follows the recorded order, so check the next few runs first.
+	const size_t window_end = std::min(m_runs.size(), hint + LOCATE_WINDOW);
+	for (size_t i = hint; i < window_end; i++)
+	{
+		if (Contains(m_runs[i], lsn))
+			return i;
+	}
+
+	if (m_index.empty())
+		return NOT_FOUND;
+
+	// Diverged, resync using the sorted index. Prefer the first matching run at or after
+	// the hint, since the same sectors are usually read several times during a session.
+	auto it = std::upper_bound(m_index.begin(), m_index.end(), lsn,
+		[this](u32 value, u32 idx) { return value < m_runs[idx].lsn; });
+
+	size_t best_after = NOT_FOUND;
+	size_t best_before = NOT_FOUND;
+	for (size_t scanned = 0; it != m_index.begin() && scanned < LOCATE_INDEX_SCAN; scanned++)
+	{
+		const u32 idx = *(--it);
+		if (!Contains(m_runs[idx], lsn))
+			continue;
+
+		if (idx >= hint)
+			best_after = std::min<size_t>(best_after, idx);
+		else if (best_before == NOT_FOUND || idx > best_before)
+			best_before = idx;
+	}
+
+	return (best_after != NOT_FOUND) ? best_after : best_before;
+}
+
+void DiscAccessTrace::BuildIndex()
+{
+	m_index.resize(m_runs.size());
+	for (u32 i = 0; i < static_cast<u32>(m_runs.size()); i++)
+		m_index[i] = i;
+
+	std::stable_sort(m_index.begin(), m_index.end(),
+		[this](u32 lhs, u32 rhs) { return m_runs[lhs].lsn < m_runs[rhs].lsn; });
+}
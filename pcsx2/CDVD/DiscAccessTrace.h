@@ -0,0 +1,72 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/Pcsx2Defs.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Sequence of sector reads issued by the guest during a session, stored per serial.
+/// Contiguous reads are merged into runs, so a typical session only needs a few thousand entries.
+/// A trace recorded on a previous boot is handed to the compressed readers, which replay it
+/// ahead of the guest to decompress chunks before they are requested.
+class DiscAccessTrace
+{
+public:
+	struct Run
+	{
+		u32 lsn;
+		u32 count;
+	};
+
+	static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+	DiscAccessTrace();
+	~DiscAccessTrace();
+
+	/// Returns the path the trace for the specified serial is stored at.
+	static std::string GetPath(const std::string_view& serial);
+
+	/// Loads a previously saved trace. Fails if the trace was recorded on an image with a different sector count.
+	bool Load(const std::string& path, u32 block_count);
+
+	/// Writes the trace to disk, creating the trace directory if needed.
+	bool Save(const std::string& path, u32 block_count) const;
+
+	/// Appends a read to the trace, extending the last run when the read continues it.
+	void Record(u32 lsn, u32 count = 1);
+
+	void Clear();
+
+	const std::vector<Run>& GetRuns() const { return m_runs; }
+	bool IsEmpty() const { return m_runs.empty(); }
+
+	/// Finds the run containing the specified sector, preferring runs at or after hint.
+	/// Returns NOT_FOUND if no run covers the sector.
+	size_t Locate(u32 lsn, size_t hint) const;
+
+private:
+	static bool Contains(const Run& run, u32 lsn) { return (lsn >= run.lsn && (lsn - run.lsn) < run.count); }
+
+	void BuildIndex();
+
+	std::vector<Run> m_runs;
+
+	/// Run indices sorted by starting sector, for resynchronizing after the guest diverges from the trace.
+	std::vector<u32> m_index;
+};
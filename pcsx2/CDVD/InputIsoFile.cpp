@@ -53,6 +53,9 @@ int InputIsoFile::ReadSync(u8* dst, uint lsn)
 		return -1;
 	}
 
+	if (m_trace)
+		m_trace->Record(lsn);
+
 	return m_reader->ReadSync(dst + m_blockofs, lsn, 1);
 }
 
@@ -68,6 +71,9 @@ void InputIsoFile::BeginRead2(uint lsn)
 		return;
 	}
 
+	if (m_trace)
+		m_trace->Record(lsn);
+
 	if (lsn >= m_read_lsn && lsn < (m_read_lsn + m_read_count))
 	{
 		// Already buffered
@@ -186,6 +192,10 @@ void InputIsoFile::_init()
 	m_current_lsn = -1;
 	m_read_lsn = -1;
 	m_reader = NULL;
+
+	m_trace.reset();
+	m_trace_serial.clear();
+	m_trace_loaded_runs = 0;
 }
 
 // Tests the specified filename to see if it is a supported ISO type.  This function typically
@@ -287,6 +297,8 @@ bool InputIsoFile::Open(std::string srcfile, bool testOnly)
 
 void InputIsoFile::Close()
 {
+	SaveAccessTrace();
+
 	delete m_reader;
 	m_reader = NULL;
 
@@ -298,6 +310,48 @@ bool InputIsoFile::IsOpened() const
 	return m_reader != NULL;
 }
 
+void InputIsoFile::SetAccessTraceSerial(std::string serial)
+{
+	if (!IsOpened())
+		return;
+
+	// Uncompressed images are read straight from the file, there's nothing to prefetch.
+	if (!m_reader->SupportsPrefetchTrace())
+		serial.clear();
+
+	if (m_trace_serial == serial)
+		return;
+
+	SaveAccessTrace();
+	m_trace_serial = std::move(serial);
+	if (m_trace_serial.empty())
+	{
+		m_reader->SetPrefetchTrace(nullptr);
+		return;
+	}
+
+	std::shared_ptr<DiscAccessTrace> previous = std::make_shared<DiscAccessTrace>();
+	if (previous->Load(DiscAccessTrace::GetPath(m_trace_serial), m_blocks) && !previous->IsEmpty())
+	{
+		DevCon.WriteLn("isoFile: Replaying %zu recorded reads for %s", previous->GetRuns().size(), m_trace_serial.c_str());
+		m_trace_loaded_runs = previous->GetRuns().size();
+		m_reader->SetPrefetchTrace(std::move(previous));
+	}
+
+	m_trace = std::make_unique<DiscAccessTrace>();
+}
+
+void InputIsoFile::SaveAccessTrace()
+{
+	// Keep whichever session got further into the game, a quick boot-and-quit
+	// shouldn't replace the trace of a long play session.
+	if (m_trace && m_trace->GetRuns().size() > m_trace_loaded_runs)
+		m_trace->Save(DiscAccessTrace::GetPath(m_trace_serial), m_blocks);
+
+	m_trace.reset();
+	m_trace_loaded_runs = 0;
+}
+
 bool InputIsoFile::tryIsoType(u32 _size, s32 _offset, s32 _blockofs)
 {
 	static u8 buf[2456];
@@ -18,6 +18,9 @@
 
 #include "IsoFSCDVD.h"
 #include "CDVD/CDVDcommon.h"
+#include "CDVD/IsoFileFormats.h"
+
+#include <cstring>
 
 IsoFSCDVD::IsoFSCDVD()
 {
@@ -35,3 +38,27 @@ int IsoFSCDVD::getNumSectors()
 
 	return td.lsn;
 }
+
+IsoFSInputIsoFile::IsoFSInputIsoFile(InputIsoFile& iso)
+	: m_iso(iso)
+{
+}
+
+bool IsoFSInputIsoFile::readSector(unsigned char* buffer, int lba)
+{
+	if (lba < 0 || static_cast<uint>(lba) >= m_iso.GetBlockCount())
+		return false;
+
+	// Same as a CDVD_MODE_2048 read from the ISO plugin, the user data starts after the sync and header.
+	u8 sector[CD_FRAMESIZE_RAW];
+	if (m_iso.ReadSync(sector, lba) < 0)
+		return false;
+
+	std::memcpy(buffer, sector + 24, 2048);
+	return true;
+}
+
+int IsoFSInputIsoFile::getNumSectors()
+{
+	return static_cast<int>(m_iso.GetBlockCount());
+}
@@ -19,6 +19,8 @@
 
 #include "SectorSource.h"
 
+class InputIsoFile;
+
 class IsoFSCDVD : public SectorSource
 {
 public:
@@ -29,3 +31,18 @@ public:
 
 	virtual int getNumSectors();
 };
+
+// Reads straight from an image opened on its own, rather than the one mounted in CDVD.
+class IsoFSInputIsoFile : public SectorSource
+{
+public:
+	IsoFSInputIsoFile(InputIsoFile& iso);
+	virtual ~IsoFSInputIsoFile() = default;
+
+	virtual bool readSector(unsigned char* buffer, int lba);
+
+	virtual int getNumSectors();
+
+private:
+	InputIsoFile& m_iso;
+};
@@ -18,6 +18,7 @@
 #include "CDVD.h"
 #include "AsyncFileReader.h"
 #include "CompressedFileReader.h"
+#include "DiscAccessTrace.h"
 #include <memory>
 #include <string>
 
@@ -65,6 +66,11 @@ protected:
 	uint m_read_count;
 	u8 m_readbuffer[MaxReadUnit * CD_FRAMESIZE_RAW];
 
+	// Reads issued by the guest this session, saved on close and replayed on the next boot.
+	std::unique_ptr<DiscAccessTrace> m_trace;
+	std::string m_trace_serial;
+	size_t m_trace_loaded_runs;
+
 public:
 	InputIsoFile();
 	virtual ~InputIsoFile();
@@ -90,8 +96,11 @@ public:
 	void BeginRead2(uint lsn);
 	int FinishRead3(u8* dest, uint mode);
 
+	void SetAccessTraceSerial(std::string serial);
+
 protected:
 	void _init();
+	void SaveAccessTrace();
 
 	bool tryIsoType(u32 _size, s32 _offset, s32 _blockofs);
 	void FindParts();
@@ -15,13 +15,21 @@
 
 #include "PrecompiledHeader.h"
 #include "ThreadedFileReader.h"
+#include "DiscAccessTrace.h"
 
+#include "common/Console.h"
 #include "common/Threading.h"
 
 // Make sure buffer size is bigger than the cutoff where PCSX2 emulates a seek
 // If buffers are smaller than that, we can't keep up with linear reads
 static constexpr u32 MINIMUM_SIZE = 128 * 1024;
 
+// Upper bound on decompressed chunks held for the trace replay
+static constexpr u32 PREFETCH_CACHE_SIZE = 32 * 1024 * 1024;
+
+// How many trace runs past the guest's current one to prefetch
+static constexpr size_t PREFETCH_RUN_LOOKAHEAD = 64;
+
 ThreadedFileReader::ThreadedFileReader()
 {
 	m_readThread = std::thread([](ThreadedFileReader* r){ r->Loop(); }, this);
@@ -74,6 +82,7 @@ void ThreadedFileReader::Loop()
 
 		u64 requestOffset;
 		u32 requestSize;
+		size_t prefetchCursor;
 
 		bool ok = true;
 		m_running = true;
@@ -83,6 +92,7 @@ void ThreadedFileReader::Loop()
 			void* ptr = m_requestPtr.load(std::memory_order_acquire);
 			requestOffset = m_requestOffset;
 			requestSize = m_requestSize;
+			prefetchCursor = m_prefetchCursor;
 			lock.unlock();
 
 			if (ptr)
@@ -125,13 +135,17 @@ void ThreadedFileReader::Loop()
 					}
 					else
 					{
-						int amt = ReadChunk(static_cast<char*>(buf->ptr) + bufsize, chunk.chunkID);
+						int amt = ReadChunkOrPrefetched(static_cast<char*>(buf->ptr) + bufsize, chunk.chunkID);
 						if (amt <= 0)
 							break;
 						buf->size.store(bufsize + amt, std::memory_order_release);
 					}
 				}
 			}
+
+			// Linear readahead is done, use the remaining idle time to replay the trace.
+			if (m_prefetchTrace)
+				Prefetch(prefetchCursor);
 		}
 
 		lock.lock();
@@ -175,7 +189,7 @@ ThreadedFileReader::Buffer* ThreadedFileReader::GetBlockPtr(const Chunk& block)
 		}
 		buf.size.store(0, std::memory_order_relaxed);
 	}
-	int size = ReadChunk(buf.ptr, block.chunkID);
+	int size = ReadChunkOrPrefetched(buf.ptr, block.chunkID);
 	if (size > 0)
 	{
 		buf.offset = block.offset;
@@ -186,6 +200,103 @@ ThreadedFileReader::Buffer* ThreadedFileReader::GetBlockPtr(const Chunk& block)
 	return nullptr;
 }
 
+int ThreadedFileReader::ReadChunkOrPrefetched(void* dst, s64 chunkID)
+{
+	if (m_prefetchTrace)
+	{
+		std::unique_lock<std::mutex> lock(m_prefetchMutex);
+		const auto it = m_prefetchCache.find(chunkID);
+		if (it != m_prefetchCache.end())
+		{
+			// Each chunk is normally only needed once per run, so hand the memory back.
+			const u32 size = it->second.size;
+			memcpy(dst, it->second.data.get(), size);
+			m_prefetchCacheSize -= size;
+			m_prefetchOrder.erase(it->second.order);
+			m_prefetchCache.erase(it);
+			m_prefetchHits++;
+			return static_cast<int>(size);
+		}
+
+		m_prefetchMisses++;
+	}
+
+	return ReadChunk(dst, chunkID);
+}
+
+void ThreadedFileReader::UpdatePrefetchCursor(uint sector)
+{
+	if (!m_prefetchTrace)
+		return;
+
+	const size_t run = m_prefetchTrace->Locate(sector, m_prefetchCursor);
+	if (run != DiscAccessTrace::NOT_FOUND)
+		m_prefetchCursor = run;
+}
+
+void ThreadedFileReader::Prefetch(size_t cursor)
+{
+	const std::vector<DiscAccessTrace::Run>& runs = m_prefetchTrace->GetRuns();
+	const u64 blocksize = InternalBlockSize();
+	const size_t end_run = std::min(runs.size(), cursor + 1 + PREFETCH_RUN_LOOKAHEAD);
+	for (size_t run = cursor + 1; run < end_run; run++)
+	{
+		u64 offset = static_cast<u64>(runs[run].lsn) * blocksize + m_dataoffset;
+		const u64 end = offset + static_cast<u64>(runs[run].count) * blocksize;
+		while (offset < end)
+		{
+			// Give way to the guest, we'll continue from the new cursor after its request.
+			if (m_requestPtr.load(std::memory_order_acquire))
+				return;
+
+			const Chunk chunk = ChunkForOffset(offset);
+			if (chunk.chunkID < 0 || chunk.length == 0)
+				break;
+			offset = chunk.offset + chunk.length;
+
+			{
+				std::unique_lock<std::mutex> lock(m_prefetchMutex);
+				if (m_prefetchCache.find(chunk.chunkID) != m_prefetchCache.end())
+					continue;
+
+				// Chunks for runs the guest has already passed are never going to be used.
+				while ((m_prefetchCacheSize + chunk.length) > PREFETCH_CACHE_SIZE && !m_prefetchOrder.empty())
+				{
+					const auto oldest = m_prefetchCache.find(m_prefetchOrder.front());
+					if (oldest->second.run >= cursor)
+						break;
+
+					m_prefetchCacheSize -= oldest->second.size;
+					m_prefetchCache.erase(oldest);
+					m_prefetchOrder.pop_front();
+				}
+
+				// Still full, wait for the guest to catch up.
+				if ((m_prefetchCacheSize + chunk.length) > PREFETCH_CACHE_SIZE)
+					return;
+			}
+
+			std::unique_ptr<u8[]> data = std::make_unique<u8[]>(chunk.length);
+			const int size = ReadChunk(data.get(), chunk.chunkID);
+			if (size <= 0)
+				return;
+
+			std::unique_lock<std::mutex> lock(m_prefetchMutex);
+			const auto order = m_prefetchOrder.insert(m_prefetchOrder.end(), chunk.chunkID);
+			m_prefetchCache.emplace(chunk.chunkID, PrefetchedChunk{run, static_cast<u32>(size), std::move(data), order});
+			m_prefetchCacheSize += static_cast<u32>(size);
+		}
+	}
+}
+
+void ThreadedFileReader::ClearPrefetchCache()
+{
+	std::unique_lock<std::mutex> lock(m_prefetchMutex);
+	m_prefetchCache.clear();
+	m_prefetchOrder.clear();
+	m_prefetchCacheSize = 0;
+}
+
 bool ThreadedFileReader::Decompress(void* target, u64 begin, u32 size)
 {
 	char* write = static_cast<char*>(target);
@@ -213,7 +324,7 @@ bool ThreadedFileReader::Decompress(void* target, u64 begin, u32 size)
 		}
 		else
 		{
-			int amt = ReadChunk(write, chunk.chunkID);
+			int amt = ReadChunkOrPrefetched(write, chunk.chunkID);
 			if (amt < static_cast<int>(chunk.length))
 				return false;
 			write += chunk.length;
@@ -269,6 +380,7 @@ int ThreadedFileReader::ReadSync(void* pBuffer, uint sector, uint count)
 	u32 size = count * blocksize;
 	{
 		std::lock_guard<std::mutex> l(m_mtx);
+		UpdatePrefetchCursor(sector);
 		if (TryCachedRead(pBuffer, offset, size, l))
 			return m_amtRead;
 
@@ -323,6 +435,7 @@ void ThreadedFileReader::BeginRead(void* pBuffer, uint sector, uint count)
 	u32 size = count * blocksize;
 	{
 		std::lock_guard<std::mutex> l(m_mtx);
+		UpdatePrefetchCursor(sector);
 		if (TryCachedRead(pBuffer, offset, size, l))
 			return;
 		if (size == 0)
@@ -368,6 +481,7 @@ void ThreadedFileReader::Close(void)
 	CancelAndWaitUntilStopped();
 	for (auto& buf : m_buffer)
 		buf.size.store(0, std::memory_order_relaxed);
+	SetPrefetchTrace(nullptr);
 	Close2();
 }
 
@@ -380,3 +494,20 @@ void ThreadedFileReader::SetDataOffset(int bytes)
 {
 	m_dataoffset = bytes;
 }
+
+void ThreadedFileReader::SetPrefetchTrace(std::shared_ptr<const DiscAccessTrace> trace)
+{
+	CancelAndWaitUntilStopped();
+
+	if (m_prefetchTrace && (m_prefetchHits + m_prefetchMisses) > 0)
+	{
+		DevCon.WriteLn("(ThreadedFileReader) Trace prefetch: %u hits, %u misses (%.1f%%)", m_prefetchHits, m_prefetchMisses,
+			(static_cast<double>(m_prefetchHits) * 100.0) / static_cast<double>(m_prefetchHits + m_prefetchMisses));
+	}
+
+	ClearPrefetchCache();
+	m_prefetchTrace = std::move(trace);
+	m_prefetchCursor = 0;
+	m_prefetchHits = 0;
+	m_prefetchMisses = 0;
+}
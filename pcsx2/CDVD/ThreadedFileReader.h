@@ -21,6 +21,8 @@
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
+#include <list>
+#include <unordered_map>
 
 /// A file reader for use with compressed formats
 /// Calls decompression code on a separate thread to make a synchronous decompression API async
@@ -86,6 +88,28 @@ private:
 	/// View while holding `m_mtx`.  If false, you may touch decompression functions from other threads
 	bool m_running = false;
 
+	struct PrefetchedChunk
+	{
+		/// Index of the trace run this chunk was prefetched for, entries for runs behind the guest can be evicted
+		size_t run;
+		u32 size;
+		std::unique_ptr<u8[]> data;
+		/// Position of the chunk in `m_prefetchOrder`
+		std::list<s64>::iterator order;
+	};
+	/// Trace of a previous session, replayed ahead of the guest by the read thread
+	std::shared_ptr<const DiscAccessTrace> m_prefetchTrace;
+	/// Index of the trace run the guest is currently reading, protected by `m_mtx`
+	size_t m_prefetchCursor = 0;
+	/// Chunks decompressed from the trace which the guest hasn't read yet, by chunk ID
+	std::unordered_map<s64, PrefetchedChunk> m_prefetchCache;
+	/// IDs of the chunks in `m_prefetchCache`, oldest first
+	std::list<s64> m_prefetchOrder;
+	std::mutex m_prefetchMutex;
+	u32 m_prefetchCacheSize = 0;
+	u32 m_prefetchHits = 0;
+	u32 m_prefetchMisses = 0;
+
 	/// Get the internal block size
 	u32 InternalBlockSize() const { return m_internalBlockSize ? m_internalBlockSize : m_blocksize; }
 	/// memcpy from internal to external blocks
@@ -98,6 +122,14 @@ private:
 
 	/// Load the given block into one of the `m_buffer` buffers if necessary and return a pointer to its contents if successful
 	Buffer* GetBlockPtr(const Chunk& block);
+	/// ReadChunk, but takes the chunk from the prefetch cache if the trace replay already decompressed it
+	int ReadChunkOrPrefetched(void* dst, s64 chunkID);
+	/// Move the trace cursor to the run containing `sector`, call with `m_mtx` held
+	void UpdatePrefetchCursor(uint sector);
+	/// Decompress chunks for the trace runs following `cursor` until the cache is full or a request comes in
+	void Prefetch(size_t cursor);
+	/// Drop all prefetched chunks
+	void ClearPrefetchCache();
 	/// Decompress from offset to size into
 	bool Decompress(void* ptr, u64 offset, u32 size);
 	/// Cancel any inflight read and wait until the thread is no longer doing anything
@@ -116,4 +148,6 @@ public:
 	void Close(void) final override;
 	void SetBlockSize(uint bytes) final override;
 	void SetDataOffset(int bytes) final override;
+	void SetPrefetchTrace(std::shared_ptr<const DiscAccessTrace> trace) final override;
+	bool SupportsPrefetchTrace() const final override { return true; }
 };
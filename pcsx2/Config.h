@@ -844,6 +844,9 @@ struct Pcsx2Config
 
 		BITFIELD32()
 		bool OutputLatencyMinimal : 1;
+		bool ThreadedOutput : 1;
+		bool LowLatencyBuffer : 1;
+		bool ResampleStretch : 1;
 		bool
 			DebugEnabled : 1,
 			MsgToConsole : 1,
@@ -1102,6 +1105,8 @@ struct Pcsx2Config
 			ShowDebuggerOnStart : 1;
 		bool
 			AlignMemoryWindowStart : 1;
+		bool
+			PageProtectWatchpoints : 1; // with fastmem, only check the EE loads/stores which fault on a watched page
 		BITFIELD_END
 
 		u8 FontWidth;
@@ -1145,6 +1150,27 @@ struct Pcsx2Config
 		}
 	};
 
+	// ------------------------------------------------------------------------
+	struct RewindOptions
+	{
+		bool Enabled{false};
+		u32 Frequency{10}; // frames between snapshots
+		u32 BufferSizeMB{512}; // limit for compressed snapshots
+
+		void LoadSave(SettingsWrapper& wrap);
+		void SanityCheck();
+
+		bool operator==(const RewindOptions& right) const
+		{
+			return OpEqu(Enabled) && OpEqu(Frequency) && OpEqu(BufferSizeMB);
+		}
+
+		bool operator!=(const RewindOptions& right) const
+		{
+			return !this->operator==(right);
+		}
+	};
+
 	// ------------------------------------------------------------------------
 	struct FilenameOptions
 	{
@@ -1240,6 +1266,7 @@ struct Pcsx2Config
 		CdvdVerboseReads : 1, // enables cdvd read activity verbosely dumped to the console
 		CdvdDumpBlocks : 1, // enables cdvd block dumping
 		CdvdShareWrite : 1, // allows the iso to be modified while it's loaded
+		CdvdPrefetchTrace : 1, // records disc reads per serial and replays them to prefetch compressed images
 		EnablePatches : 1, // enables patch detection and application
 		EnableCheats : 1, // enables cheat detection and application
 		EnablePINE : 1, // enables inter-process communication
@@ -1255,6 +1282,8 @@ struct Pcsx2Config
 		UseBOOT2Injection : 1,
 		BackupSavestate : 1,
 		SavestateZstdCompression : 1,
+		SavestateIncremental : 1, // only write pages changed since a base state, which is kept next to the state
+		SavestateParallelCompression : 1, // compress large state components up front on all cores, as zstd frames
 		// enables simulated ejection of memory cards when loading savestates
 		McdEnableEjection : 1,
 		McdFolderAutoManage : 1,
@@ -1280,6 +1309,7 @@ struct Pcsx2Config
 	ProfilerOptions Profiler;
 	DebugOptions Debugger;
 	FramerateOptions Framerate;
+	RewindOptions Rewind;
 	SPU2Options SPU2;
 	DEV9Options DEV9;
 	USBOptions USB;
@@ -1296,6 +1326,11 @@ struct Pcsx2Config
 	// slots (3 each)
 	McdOptions Mcd[8];
 	std::string GzipIsoIndexTemplate; // for quick-access index with gzipped ISO
+	int PINESlot; // TCP port on Windows, socket name suffix elsewhere
+
+	// Host memory is reserved once at startup, so changes take effect after a restart.
+	HugePageMode HugePages = HugePageMode::Disabled;
+	static const char* HugePageModeNames[];
 
 	// Set at runtime, not loaded from config.
 	std::string CurrentBlockdump;
@@ -0,0 +1,112 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/Pcsx2Defs.h"
+
+#include <array>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// Handlers for the scheduled events of a CPU (cpuRegs/psxRegs interrupt, sCycle and eCycle), tested
+/// in a fixed order on every event test.
+///
+/// Only the pending events are visited, so the cost of a test depends on how many events are
+/// scheduled rather than on how many sources exist. The order decides which handler sees the side
+/// effects of the others when several are due in the same test, so it must not change, or
+/// savestates and input recordings will play back differently.
+///
+/// This is not a scheduler: the next event cycle is still the running minimum kept by
+/// cpuSetNextEvent()/psxSetNextBranch(), which the interpreters and the recompiled blocks compare
+/// against. The table only runs once that cycle has been reached.
+template <size_t N>
+class CpuEventTable
+{
+	static_assert(N > 0 && N <= 32, "Event ids are bits of a 32-bit mask");
+
+public:
+	struct Handler
+	{
+		u8 id;
+		void (*callback)();
+	};
+
+	constexpr explicit CpuEventTable(const std::array<Handler, N>& handlers)
+		: m_handlers(handlers)
+	{
+		for (u32 i = 0; i < N; i++)
+		{
+			m_order[handlers[i].id] = static_cast<u8>(i);
+			m_mask |= 1u << handlers[i].id;
+		}
+	}
+
+	/// Bits of the interrupt mask which have a handler in this table.
+	constexpr u32 GetMask() const { return m_mask; }
+
+	/// Calls test(id, callback) for each pending event in table order. The interrupt mask is
+	/// re-read after every call, so events raised or cleared by a handler are seen by the later ones,
+	/// exactly as if every entry had been tested in turn. Only the bits a handler changed are
+	/// remapped, which is usually just the one of the event it handled.
+	template <typename TestFn>
+	__fi void Dispatch(const u32& interrupt, const TestFn& test) const
+	{
+		u32 pending = interrupt & m_mask;
+		u32 ordered = ToOrder(pending);
+		while (ordered)
+		{
+			const u32 index = LowestBit(ordered);
+			test(m_handlers[index].id, m_handlers[index].callback);
+
+			const u32 changed = (interrupt & m_mask) ^ pending;
+			pending ^= changed;
+			ordered ^= ToOrder(changed);
+
+			// Drop this entry and everything before it, they've had their turn.
+			ordered &= static_cast<u32>(~((2ull << index) - 1));
+		}
+	}
+
+private:
+	static __fi u32 LowestBit(u32 value)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, value);
+		return index;
+#else
+		return __builtin_ctz(value);
+#endif
+	}
+
+	/// Moves each pending event bit to the position of its handler, usually only one or two bits.
+	__fi u32 ToOrder(u32 pending) const
+	{
+		u32 ordered = 0;
+		while (pending)
+		{
+			ordered |= 1u << m_order[LowestBit(pending)];
+			pending &= pending - 1;
+		}
+		return ordered;
+	}
+
+	std::array<Handler, N> m_handlers;
+	u8 m_order[32] = {};
+	u32 m_mask = 0;
+};
@@ -17,6 +17,7 @@
 #include "Breakpoints.h"
 #include "SymbolMap.h"
 #include "MIPSAnalyst.h"
+#include <algorithm>
 #include <cstdio>
 #include "R5900.h"
 #include "R3000A.h"
@@ -29,6 +30,8 @@ u32 CBreakPoints::breakSkipFirstAtIop_ = 0;
 u64 CBreakPoints::breakSkipFirstTicksIop_ = 0;
 std::vector<MemCheck> CBreakPoints::memChecks_;
 std::vector<MemCheck*> CBreakPoints::cleanupMemChecks_;
+MemCheckIndex CBreakPoints::memCheckIndexEE_;
+MemCheckIndex CBreakPoints::memCheckIndexIop_;
 bool CBreakPoints::breakpointTriggered_ = false;
 bool CBreakPoints::corePaused = false;
 std::function<void()> CBreakPoints::cb_bpUpdated_;
@@ -125,6 +128,67 @@ void MemCheck::JitCleanup()
 		host->SetDebugMode(true);*/
 }
 
+void MemCheckIndex::Build(const std::vector<MemCheck>& checks, BreakPointCpu cpu)
+{
+	Clear();
+
+	for (const MemCheck& check : checks)
+	{
+		if (check.cpu != cpu || check.result == MEMCHECK_IGNORE)
+			continue;
+
+		Entry entry;
+		entry.start = cpu == BREAKPOINT_EE ? standardizeBreakpointAddress(check.start) : check.start;
+		entry.end = cpu == BREAKPOINT_EE ? standardizeBreakpointAddress(check.end) : check.end;
+		entry.cond = check.cond;
+		entry.result = check.result;
+		m_entries.push_back(entry);
+	}
+
+	std::sort(m_entries.begin(), m_entries.end(), [](const Entry& lhs, const Entry& rhs) { return lhs.start < rhs.start; });
+
+	m_max_end.reserve(m_entries.size());
+	u32 max_end = 0;
+	for (const Entry& entry : m_entries)
+	{
+		max_end = std::max(max_end, entry.end);
+		m_max_end.push_back(max_end);
+	}
+}
+
+void MemCheckIndex::Clear()
+{
+	m_entries.clear();
+	m_max_end.clear();
+}
+
+u32 MemCheckIndex::Find(u32 start, u32 end, bool write) const
+{
+	const u32 mask = write ? MEMCHECK_WRITE : MEMCHECK_READ;
+
+	// logic: memAddress < bpEnd && bpStart < memAddress+memSize
+	// Only the ranges starting before the end of the access can overlap, walk them back until none of
+	// the remaining ones reaches the start of the access.
+	const auto last = std::lower_bound(m_entries.begin(), m_entries.end(), end,
+		[](const Entry& entry, u32 value) { return entry.start < value; });
+
+	u32 result = MEMCHECK_IGNORE;
+	for (size_t i = static_cast<size_t>(last - m_entries.begin()); i > 0 && m_max_end[i - 1] > start; i--)
+	{
+		const Entry& entry = m_entries[i - 1];
+		if (entry.end > start && (entry.cond & mask))
+			result |= entry.result;
+	}
+
+	return result;
+}
+
+void CBreakPoints::RebuildMemCheckIndex()
+{
+	memCheckIndexEE_.Build(memChecks_, BREAKPOINT_EE);
+	memCheckIndexIop_.Build(memChecks_, BREAKPOINT_IOP);
+}
+
 size_t CBreakPoints::FindBreakpoint(BreakPointCpu cpu, u32 addr, bool matchTemp, bool temp)
 {
 	if (cpu == BREAKPOINT_EE)
@@ -307,12 +371,14 @@ void CBreakPoints::AddMemCheck(BreakPointCpu cpu, u32 start, u32 end, MemCheckCo
 		check.cpu = cpu;
 
 		memChecks_.push_back(check);
+		RebuildMemCheckIndex();
 		Update(cpu);
 	}
 	else
 	{
 		memChecks_[mc].cond = (MemCheckCondition)(memChecks_[mc].cond | cond);
 		memChecks_[mc].result = (MemCheckResult)(memChecks_[mc].result | result);
+		RebuildMemCheckIndex();
 		Update(cpu);
 	}
 }
@@ -326,6 +392,7 @@ void CBreakPoints::RemoveMemCheck(BreakPointCpu cpu, u32 start, u32 end)
 	if (mc != INVALID_MEMCHECK)
 	{
 		memChecks_.erase(memChecks_.begin() + mc);
+		RebuildMemCheckIndex();
 		Update(cpu);
 	}
 }
@@ -337,6 +404,7 @@ void CBreakPoints::ChangeMemCheck(BreakPointCpu cpu, u32 start, u32 end, MemChec
 	{
 		memChecks_[mc].cond = cond;
 		memChecks_[mc].result = result;
+		RebuildMemCheckIndex();
 		Update(cpu);
 	}
 }
@@ -349,6 +417,7 @@ void CBreakPoints::ClearAllMemChecks()
 	if (!memChecks_.empty())
 	{
 		memChecks_.clear();
+		RebuildMemCheckIndex();
 		Update();
 	}
 }
@@ -107,6 +107,41 @@ struct MemCheck
 	}
 };
 
+// Interval index over the memchecks of one CPU, so an access can be tested without scanning every check.
+// Ranges are sorted by start address along with a running maximum of their ends, which bounds the scan
+// to the ranges that can still overlap. EE ranges are stored as standardized addresses.
+class MemCheckIndex
+{
+public:
+	void Build(const std::vector<MemCheck>& checks, BreakPointCpu cpu);
+	void Clear();
+
+	bool IsEmpty() const { return m_entries.empty(); }
+
+	// Returns the combined results of the checks overlapping [start, end) which trigger on this kind of access.
+	u32 Find(u32 start, u32 end, bool write) const;
+
+	// Calls fn(start, end, cond) for every indexed range.
+	template <typename T>
+	void ForEachRange(const T& fn) const
+	{
+		for (const Entry& entry : m_entries)
+			fn(entry.start, entry.end, entry.cond);
+	}
+
+private:
+	struct Entry
+	{
+		u32 start;
+		u32 end;
+		u32 cond;
+		u32 result;
+	};
+
+	std::vector<Entry> m_entries;
+	std::vector<u32> m_max_end; // largest end of m_entries[0..i]
+};
+
 // BreakPoints cannot overlap, only one is allowed per address.
 // MemChecks can overlap, as long as their ends are different.
 // WARNING: MemChecks are not used in the interpreter or HLE currently.
@@ -142,6 +177,7 @@ public:
 	static const std::vector<MemCheck> GetMemCheckRanges();
 
 	static const std::vector<MemCheck> GetMemChecks(BreakPointCpu cpu);
+	static const MemCheckIndex& GetMemCheckIndex(BreakPointCpu cpu) { return cpu == BREAKPOINT_IOP ? memCheckIndexIop_ : memCheckIndexEE_; }
 	static const std::vector<BreakPoint> GetBreakpoints(BreakPointCpu cpu, bool includeTemp);
 	// Returns count of all non-temporary breakpoints
 	static size_t GetNumBreakpoints()
@@ -166,6 +202,7 @@ private:
 	static size_t FindBreakpoint(BreakPointCpu cpu, u32 addr, bool matchTemp = false, bool temp = false);
 	// Finds exactly, not using a range check.
 	static size_t FindMemCheck(BreakPointCpu cpu, u32 start, u32 end);
+	static void RebuildMemCheckIndex();
 
 	static std::vector<BreakPoint> breakPoints_;
 	static u32 breakSkipFirstAtEE_;
@@ -180,6 +217,8 @@ private:
 
 	static std::vector<MemCheck> memChecks_;
 	static std::vector<MemCheck *> cleanupMemChecks_;
+	static MemCheckIndex memCheckIndexEE_;
+	static MemCheckIndex memCheckIndexIop_;
 };
 
 
@@ -15,9 +15,12 @@
 
 #include "PrecompiledHeader.h"
 #include "common/FileSystem.h"
+#include "common/ThreadPool.h"
 
 #include "SymbolMap.h"
 #include <algorithm>
+#include <future>
+#include <optional>
 
 SymbolMap R5900SymbolMap;
 SymbolMap R3000SymbolMap;
@@ -28,6 +31,116 @@ SymbolMap R3000SymbolMap;
 
 #define ARRAY_SIZE(x) (sizeof((x))/sizeof(*(x)))
 
+// Below this many symbols, sorting and snapshotting aren't worth handing to worker threads.
+static constexpr size_t PARALLEL_SYMBOL_THRESHOLD = 16384;
+
+// Flattened copy of the active symbols in sorted arrays, so lookups are binary searches over
+// contiguous memory. Readers hold a reference to the current snapshot instead of the map lock.
+struct SymbolMap::Snapshot {
+	struct Function {
+		u32 start;
+		u32 size;
+		int index;
+	};
+
+	struct Label {
+		u32 address;
+		u32 nameOffset;
+	};
+
+	struct Data {
+		u32 start;
+		u32 size;
+		DataType type;
+	};
+
+	std::vector<Function> functions;
+	std::vector<Label> labels;
+	std::vector<Data> data;
+	std::vector<char> names;
+
+	template <typename T>
+	static const T* Find(const std::vector<T>& entries, u32 start) {
+		const auto it = std::lower_bound(entries.begin(), entries.end(), start, [](const T& entry, u32 value) { return entry.start < value; });
+		return (it != entries.end() && it->start == start) ? &*it : nullptr;
+	}
+
+	// Same rules as the map lookups: only the closest symbol starting at or before the address is considered.
+	template <typename T>
+	static const T* FindContaining(const std::vector<T>& entries, u32 address) {
+		const auto it = std::upper_bound(entries.begin(), entries.end(), address, [](u32 value, const T& entry) { return value < entry.start; });
+		if (it == entries.begin())
+			return nullptr;
+
+		const T& entry = *(it - 1);
+		return (entry.start <= address && entry.start + entry.size > address) ? &entry : nullptr;
+	}
+
+	template <typename T>
+	static u32 NextStart(const std::vector<T>& entries, u32 address) {
+		const auto it = std::upper_bound(entries.begin(), entries.end(), address, [](u32 value, const T& entry) { return value < entry.start; });
+		return (it != entries.end()) ? it->start : INVALID_ADDRESS;
+	}
+
+	const char* GetLabel(u32 address) const {
+		const auto it = std::lower_bound(labels.begin(), labels.end(), address, [](const Label& entry, u32 value) { return entry.address < value; });
+		return (it != labels.end() && it->address == address) ? &names[it->nameOffset] : nullptr;
+	}
+};
+
+std::shared_ptr<const SymbolMap::Snapshot> SymbolMap::GetSnapshot() const {
+	if (m_snapshotDirty.load(std::memory_order_acquire)) {
+		std::lock_guard<std::recursive_mutex> guard(m_lock);
+		if (m_snapshotDirty.load(std::memory_order_relaxed)) {
+			std::atomic_store(&m_snapshot, BuildSnapshot(false));
+			m_snapshotDirty.store(false, std::memory_order_release);
+		}
+	}
+
+	return std::atomic_load(&m_snapshot);
+}
+
+std::shared_ptr<const SymbolMap::Snapshot> SymbolMap::BuildSnapshot(bool parallel) const {
+	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	auto snapshot = std::make_shared<Snapshot>();
+
+	const auto buildFunctions = [this, &snapshot]() {
+		snapshot->functions.reserve(activeFunctions.size());
+		for (const auto& it : activeFunctions)
+			snapshot->functions.push_back({it.first, it.second.size, it.second.index});
+	};
+
+	const auto buildLabels = [this, &snapshot]() {
+		snapshot->labels.reserve(activeLabels.size());
+		for (const auto& it : activeLabels) {
+			snapshot->labels.push_back({it.first, static_cast<u32>(snapshot->names.size())});
+			snapshot->names.insert(snapshot->names.end(), it.second.name, it.second.name + strlen(it.second.name) + 1);
+		}
+	};
+
+	const auto buildData = [this, &snapshot]() {
+		snapshot->data.reserve(activeData.size());
+		for (const auto& it : activeData)
+			snapshot->data.push_back({it.first, it.second.size, it.second.type});
+	};
+
+	if (parallel && activeFunctions.size() + activeLabels.size() + activeData.size() >= PARALLEL_SYMBOL_THRESHOLD) {
+		// The three arrays are independent, and only read the maps we hold the lock for.
+		cb::ThreadPool pool(2);
+		std::future<void> functionsDone = pool.ScheduleAndGetFuture(buildFunctions);
+		std::future<void> dataDone = pool.ScheduleAndGetFuture(buildData);
+		buildLabels();
+		functionsDone.get();
+		dataDone.get();
+	} else {
+		buildFunctions();
+		buildLabels();
+		buildData();
+	}
+
+	return snapshot;
+}
+
 void SymbolMap::SortSymbols() {
 	std::lock_guard<std::recursive_mutex> guard(m_lock);
 	AssignFunctionIndices();
@@ -43,20 +156,22 @@ void SymbolMap::Clear() {
 	activeData.clear();
 	activeModuleEnds.clear();
 	modules.clear();
+	InvalidateSnapshot();
 }
 
 
-bool SymbolMap::LoadNocashSym(const char *filename) {
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	FILE *f = FileSystem::OpenCFile(filename, "r");
-	if (!f)
-		return false;
+// Parses the lines of a nocash symbol file into entries, keeping them in file order.
+static void ParseNocashSymLines(const char* begin, const char* end, std::vector<SymbolImportEntry>* entries) {
+	while (begin < end) {
+		const char* lineEnd = static_cast<const char*>(memchr(begin, '\n', end - begin));
+		if (!lineEnd)
+			lineEnd = end;
 
-	while (!feof(f)) {
 		char line[256], value[256] = {0};
-		char *p = fgets(line, 256, f);
-		if (p == NULL)
-			break;
+		const size_t length = std::min<size_t>(lineEnd - begin, sizeof(line) - 1);
+		memcpy(line, begin, length);
+		line[length] = 0;
+		begin = lineEnd + 1;
 
 		u32 address;
 		if (sscanf(line, "%08X %s", &address, value) != 2)
@@ -74,15 +189,20 @@ bool SymbolMap::LoadNocashSym(const char *filename) {
 				if (sscanf(s + 1, "%04X", &size) != 1)
 					continue;
 
+				DataType type;
 				if (strcasecmp(value, ".byt") == 0) {
-					AddData(address, size, DATATYPE_BYTE, 0);
+					type = DATATYPE_BYTE;
 				} else if (strcasecmp(value, ".wrd") == 0) {
-					AddData(address, size, DATATYPE_HALFWORD, 0);
+					type = DATATYPE_HALFWORD;
 				} else if (strcasecmp(value, ".dbl") == 0) {
-					AddData(address, size, DATATYPE_WORD, 0);
+					type = DATATYPE_WORD;
 				} else if (strcasecmp(value, ".asc") == 0) {
-					AddData(address, size, DATATYPE_ASCII, 0);
+					type = DATATYPE_ASCII;
+				} else {
+					continue;
 				}
+
+				entries->push_back({std::string(), address, size, ST_DATA, type});
 			}
 		} else {				// labels
 			int size = 1;
@@ -92,81 +212,225 @@ bool SymbolMap::LoadNocashSym(const char *filename) {
 				sscanf(seperator+1,"%08X",&size);
 			}
 
-			if (size != 1) {
-				AddFunction(value, address,size, 0);
-			} else {
-				AddLabel(value, address, 0);
-			}
+			entries->push_back({value, address, static_cast<u32>(size), (size != 1) ? ST_FUNCTION : ST_NONE, DATATYPE_NONE});
+		}
+	}
+}
+
+bool SymbolMap::LoadNocashSym(const char *filename) {
+	std::optional<std::string> contents = FileSystem::ReadFileToString(filename);
+	if (!contents.has_value())
+		return false;
+
+	// Split the file on line boundaries and parse the pieces on worker threads, then import the
+	// entries in file order so duplicates resolve as they would have line by line.
+	const char* begin = contents->data();
+	const char* end = begin + contents->size();
+	const size_t chunks = (contents->size() >= PARALLEL_SYMBOL_THRESHOLD * 32) ? std::max(cb::ThreadPool::GetNumLogicalCores(), 1u) : 1;
+
+	std::vector<std::vector<SymbolImportEntry>> parsed(chunks);
+	if (chunks > 1) {
+		cb::ThreadPool pool(static_cast<int>(chunks));
+		std::vector<std::future<void>> done;
+		const char* chunkBegin = begin;
+		for (size_t i = 0; i < chunks; i++) {
+			const char* chunkEnd = (i == chunks - 1) ? end : begin + contents->size() * (i + 1) / chunks;
+			if (chunkEnd < chunkBegin)
+				chunkEnd = chunkBegin;
+			while (chunkEnd < end && chunkEnd[-1] != '\n')
+				chunkEnd++;
+
+			std::vector<SymbolImportEntry>* entries = &parsed[i];
+			done.push_back(pool.ScheduleAndGetFuture([chunkBegin, chunkEnd, entries]() { ParseNocashSymLines(chunkBegin, chunkEnd, entries); }));
+			chunkBegin = chunkEnd;
 		}
+		for (std::future<void>& it : done)
+			it.get();
+	} else {
+		ParseNocashSymLines(begin, end, &parsed[0]);
+	}
+
+	for (size_t i = 1; i < chunks; i++) {
+		parsed[0].insert(parsed[0].end(), std::make_move_iterator(parsed[i].begin()), std::make_move_iterator(parsed[i].end()));
+		parsed[i] = {};
 	}
 
-	fclose(f);
+	ImportSymbols(std::move(parsed[0]), 0);
 	return true;
 }
 
-SymbolType SymbolMap::GetSymbolType(u32 address) const {
+void SymbolMap::ImportSymbols(std::vector<SymbolImportEntry> symbols, int moduleIndex) {
 	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	if (activeFunctions.find(address) != activeFunctions.end())
-		return ST_FUNCTION;
-	if (activeData.find(address) != activeData.end())
-		return ST_DATA;
-	return ST_NONE;
-}
+	if (symbols.empty())
+		return;
+
+	// Resolve the module and relative address of every entry, as AddFunction() etc would. The workers
+	// only read the module tables, which can't change while we hold the lock.
+	std::vector<SymbolKey> keys(symbols.size());
+	std::vector<u32> order(symbols.size());
+	const auto resolveAndSort = [this, moduleIndex, &symbols, &keys, &order](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const u32 address = symbols[i].address;
+			int module = moduleIndex;
+			if (module == -1) {
+				const auto mod = activeModuleEnds.upper_bound(address);
+				module = (mod != activeModuleEnds.end()) ? mod->second.index : -1;
+			}
 
-bool SymbolMap::GetSymbolInfo(SymbolInfo *info, u32 address, SymbolType symmask) const {
-	u32 functionAddress = INVALID_ADDRESS;
-	u32 dataAddress = INVALID_ADDRESS;
+			u32 relAddress = address;
+			for (const ModuleEntry& mod : modules) {
+				if (mod.index == module) {
+					relAddress = address - mod.start;
+					break;
+				}
+			}
 
-	if (symmask & ST_FUNCTION)
-		functionAddress = GetFunctionStart(address);
+			keys[i] = std::make_pair(module, relAddress);
+			order[i] = static_cast<u32>(i);
+		}
+
+		// Entries with the same key stay in input order, so duplicates resolve the same way.
+		std::sort(order.begin() + begin, order.begin() + end, [&keys](u32 lhs, u32 rhs) {
+			return keys[lhs] < keys[rhs] || (keys[lhs] == keys[rhs] && lhs < rhs);
+		});
+	};
 
-	if (symmask & ST_DATA)
-		dataAddress = GetDataStart(address);
+	const size_t workers = (symbols.size() >= PARALLEL_SYMBOL_THRESHOLD) ? std::max(cb::ThreadPool::GetNumLogicalCores(), 1u) : 1;
+	if (workers > 1) {
+		std::vector<size_t> bounds;
+		for (size_t i = 0; i <= workers; i++)
+			bounds.push_back(symbols.size() * i / workers);
 
-	if (functionAddress == INVALID_ADDRESS || dataAddress == INVALID_ADDRESS) {
-		if (functionAddress != INVALID_ADDRESS) {
-			if (info != NULL) {
-				info->type = ST_FUNCTION;
-				info->address = functionAddress;
-				info->size = GetFunctionSize(functionAddress);
+		{
+			cb::ThreadPool pool(static_cast<int>(workers));
+			for (size_t i = 0; i < workers; i++)
+				pool.Schedule([&resolveAndSort, begin = bounds[i], end = bounds[i + 1]]() { resolveAndSort(begin, end); });
+		}
+
+		for (size_t width = 1; width < workers; width *= 2) {
+			for (size_t i = 0; i + width < workers; i += width * 2) {
+				std::inplace_merge(order.begin() + bounds[i], order.begin() + bounds[i + width], order.begin() + bounds[std::min(i + width * 2, workers)],
+					[&keys](u32 lhs, u32 rhs) { return keys[lhs] < keys[rhs] || (keys[lhs] == keys[rhs] && lhs < rhs); });
 			}
+		}
+	} else {
+		resolveAndSort(0, symbols.size());
+	}
 
-			return true;
+	for (size_t i = 0; i < order.size();) {
+		const SymbolKey key = keys[order[i]];
+
+		// Within a key, the first name is kept while the last function or data size wins.
+		const SymbolImportEntry* label = nullptr;
+		const SymbolImportEntry* function = nullptr;
+		const SymbolImportEntry* dataEntry = nullptr;
+		for (; i < order.size() && keys[order[i]] == key; i++) {
+			const SymbolImportEntry& entry = symbols[order[i]];
+			if (entry.type == ST_DATA) {
+				dataEntry = &entry;
+			} else {
+				if (!label)
+					label = &entry;
+				if (entry.type == ST_FUNCTION)
+					function = &entry;
+			}
 		}
 
-		if (dataAddress != INVALID_ADDRESS) {
-			if (info != NULL) {
-				info->type = ST_DATA;
-				info->address = dataAddress;
-				info->size = GetDataSize(dataAddress);
+		// Anything which may already exist goes through the regular path, which knows how to merge it.
+		if (label) {
+			if (labels.find(key) == labels.end() && labels.find(std::make_pair(0, label->address)) == labels.end()) {
+				LabelEntry entry;
+				entry.addr = key.second;
+				entry.module = key.first;
+				strncpy(entry.name, label->name.c_str(), ARRAY_SIZE(entry.name));
+				entry.name[ARRAY_SIZE(entry.name) - 1] = 0;
+				labels.emplace(key, entry);
+			} else {
+				AddLabel(label->name.c_str(), label->address, key.first);
 			}
+		}
 
-			return true;
+		if (function) {
+			if (functions.find(key) == functions.end() && functions.find(std::make_pair(0, function->address)) == functions.end()) {
+				FunctionEntry entry;
+				entry.start = key.second;
+				entry.size = function->size;
+				entry.index = (int)functions.size();
+				entry.module = key.first;
+				functions.emplace(key, entry);
+			} else {
+				AddFunction(function->name.c_str(), function->address, function->size, key.first);
+			}
 		}
 
-		return false;
+		if (dataEntry) {
+			if (data.find(key) == data.end() && data.find(std::make_pair(0, dataEntry->address)) == data.end()) {
+				DataEntry entry;
+				entry.start = key.second;
+				entry.size = dataEntry->size;
+				entry.type = dataEntry->dataType;
+				entry.module = key.first;
+				data.emplace(key, entry);
+			} else {
+				AddData(dataEntry->address, dataEntry->size, dataEntry->dataType, key.first);
+			}
+		}
 	}
 
+	UpdateActiveSymbols();
+
+	std::atomic_store(&m_snapshot, BuildSnapshot(true));
+	m_snapshotDirty.store(false, std::memory_order_release);
+}
+
+SymbolType SymbolMap::GetSymbolType(u32 address) const {
+	const auto snapshot = GetSnapshot();
+	if (Snapshot::Find(snapshot->functions, address))
+		return ST_FUNCTION;
+	if (Snapshot::Find(snapshot->data, address))
+		return ST_DATA;
+	return ST_NONE;
+}
+
+bool SymbolMap::GetSymbolInfo(SymbolInfo *info, u32 address, SymbolType symmask) const {
+	const auto snapshot = GetSnapshot();
+	const Snapshot::Function* function = nullptr;
+	const Snapshot::Data* dataEntry = nullptr;
+
+	if (symmask & ST_FUNCTION)
+		function = Snapshot::FindContaining(snapshot->functions, address);
+
 	// if both exist, return the function
-	if (info != NULL) {
-		info->type = ST_FUNCTION;
-		info->address = functionAddress;
-		info->size = GetFunctionSize(functionAddress);
+	if (!function && (symmask & ST_DATA))
+		dataEntry = Snapshot::FindContaining(snapshot->data, address);
+
+	if (function) {
+		if (info != NULL) {
+			info->type = ST_FUNCTION;
+			info->address = function->start;
+			info->size = function->size;
+		}
+
+		return true;
 	}
 
-	return true;
-}
+	if (dataEntry) {
+		if (info != NULL) {
+			info->type = ST_DATA;
+			info->address = dataEntry->start;
+			info->size = dataEntry->size;
+		}
 
-u32 SymbolMap::GetNextSymbolAddress(u32 address, SymbolType symmask) {
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	const auto functionEntry = symmask & ST_FUNCTION ? activeFunctions.upper_bound(address) : activeFunctions.end();
-	const auto dataEntry = symmask & ST_DATA ? activeData.upper_bound(address) : activeData.end();
+		return true;
+	}
 
-	if (functionEntry == activeFunctions.end() && dataEntry == activeData.end())
-		return INVALID_ADDRESS;
+	return false;
+}
 
-	u32 funcAddress = (functionEntry != activeFunctions.end()) ? functionEntry->first : 0xFFFFFFFF;
-	u32 dataAddress = (dataEntry != activeData.end()) ? dataEntry->first : 0xFFFFFFFF;
+u32 SymbolMap::GetNextSymbolAddress(u32 address, SymbolType symmask) {
+	const auto snapshot = GetSnapshot();
+	const u32 funcAddress = (symmask & ST_FUNCTION) ? Snapshot::NextStart(snapshot->functions, address) : INVALID_ADDRESS;
+	const u32 dataAddress = (symmask & ST_DATA) ? Snapshot::NextStart(snapshot->data, address) : INVALID_ADDRESS;
 
 	if (funcAddress <= dataAddress)
 		return funcAddress;
@@ -175,16 +439,13 @@ u32 SymbolMap::GetNextSymbolAddress(u32 address, SymbolType symmask) {
 }
 
 std::string SymbolMap::GetDescription(unsigned int address) const {
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	const auto snapshot = GetSnapshot();
 	const char* labelName = NULL;
 
-	u32 funcStart = GetFunctionStart(address);
-	if (funcStart != INVALID_ADDRESS) {
-		labelName = GetLabelName(funcStart);
-	} else {
-		u32 dataStart = GetDataStart(address);
-		if (dataStart != INVALID_ADDRESS)
-			labelName = GetLabelName(dataStart);
+	if (const Snapshot::Function* function = Snapshot::FindContaining(snapshot->functions, address)) {
+		labelName = snapshot->GetLabel(function->start);
+	} else if (const Snapshot::Data* dataEntry = Snapshot::FindContaining(snapshot->data, address)) {
+		labelName = snapshot->GetLabel(dataEntry->start);
 	}
 
 	if (labelName != NULL)
@@ -196,15 +457,15 @@ std::string SymbolMap::GetDescription(unsigned int address) const {
 }
 
 std::vector<SymbolEntry> SymbolMap::GetAllSymbols(SymbolType symmask) {
+	const auto snapshot = GetSnapshot();
 	std::vector<SymbolEntry> result;
 
 	if (symmask & ST_FUNCTION) {
-		std::lock_guard<std::recursive_mutex> guard(m_lock);
-		for (auto it = activeFunctions.begin(); it != activeFunctions.end(); it++) {
+		for (const Snapshot::Function& function : snapshot->functions) {
 			SymbolEntry entry;
-			entry.address = it->first;
-			entry.size = GetFunctionSize(entry.address);
-			const char* name = GetLabelName(entry.address);
+			entry.address = function.start;
+			entry.size = function.size;
+			const char* name = snapshot->GetLabel(entry.address);
 			if (name != NULL)
 				entry.name = name;
 			result.push_back(entry);
@@ -212,12 +473,11 @@ std::vector<SymbolEntry> SymbolMap::GetAllSymbols(SymbolType symmask) {
 	}
 
 	if (symmask & ST_DATA) {
-		std::lock_guard<std::recursive_mutex> guard(m_lock);
-		for (auto it = activeData.begin(); it != activeData.end(); it++) {
+		for (const Snapshot::Data& dataEntry : snapshot->data) {
 			SymbolEntry entry;
-			entry.address = it->first;
-			entry.size = GetDataSize(entry.address);
-			const char* name = GetLabelName(entry.address);
+			entry.address = dataEntry.start;
+			entry.size = dataEntry.size;
+			const char* name = snapshot->GetLabel(entry.address);
 			if (name != NULL)
 				entry.name = name;
 			result.push_back(entry);
@@ -326,6 +586,7 @@ std::vector<LoadedModuleInfo> SymbolMap::getAllModules() const {
 
 void SymbolMap::AddFunction(const char* name, u32 address, u32 size, int moduleIndex) {
 	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	InvalidateSnapshot();
 
 	if (moduleIndex == -1) {
 		moduleIndex = GetModuleIndex(address);
@@ -370,52 +631,21 @@ void SymbolMap::AddFunction(const char* name, u32 address, u32 size, int moduleI
 }
 
 u32 SymbolMap::GetFunctionStart(u32 address) const {
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	auto it = activeFunctions.upper_bound(address);
-	if (it == activeFunctions.end()) {
-		// check last element
-		auto rit = activeFunctions.rbegin();
-		if (rit != activeFunctions.rend()) {
-			u32 start = rit->first;
-			u32 size = rit->second.size;
-			if (start <= address && start+size > address)
-				return start;
-		}
-		// otherwise there's no function that contains this address
-		return INVALID_ADDRESS;
-	}
-
-	if (it != activeFunctions.begin()) {
-		it--;
-		u32 start = it->first;
-		u32 size = it->second.size;
-		if (start <= address && start+size > address)
-			return start;
-	}
-
-	return INVALID_ADDRESS;
+	const auto snapshot = GetSnapshot();
+	const Snapshot::Function* function = Snapshot::FindContaining(snapshot->functions, address);
+	return function ? function->start : INVALID_ADDRESS;
 }
 
 u32 SymbolMap::GetFunctionSize(u32 startAddress) const {
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	auto it = activeFunctions.find(startAddress);
-	if (it == activeFunctions.end())
-		return INVALID_ADDRESS;
-
-	return it->second.size;
+	const auto snapshot = GetSnapshot();
+	const Snapshot::Function* function = Snapshot::Find(snapshot->functions, startAddress);
+	return function ? function->size : INVALID_ADDRESS;
 }
 
 int SymbolMap::GetFunctionNum(u32 address) const {
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	u32 start = GetFunctionStart(address);
-	if (start == INVALID_ADDRESS)
-		return INVALID_ADDRESS;
-
-	auto it = activeFunctions.find(start);
-	if (it == activeFunctions.end())
-		return INVALID_ADDRESS;
-
-	return it->second.index;
+	const auto snapshot = GetSnapshot();
+	const Snapshot::Function* function = Snapshot::FindContaining(snapshot->functions, address);
+	return function ? function->index : INVALID_ADDRESS;
 }
 
 void SymbolMap::AssignFunctionIndices() {
@@ -434,6 +664,8 @@ void SymbolMap::AssignFunctionIndices() {
 void SymbolMap::UpdateActiveSymbols() {
 	// return;   (slow in debug mode)
 	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	InvalidateSnapshot();
+
 	std::map<int, u32> activeModuleIndexes;
 	for (auto it = activeModuleEnds.begin(), end = activeModuleEnds.end(); it != end; ++it) {
 		activeModuleIndexes[it->second.index] = it->second.start;
@@ -446,27 +678,27 @@ void SymbolMap::UpdateActiveSymbols() {
 	for (auto it = functions.begin(), end = functions.end(); it != end; ++it) {
 		const auto mod = activeModuleIndexes.find(it->second.module);
 		if (it->second.module <= 0) {
-			activeFunctions.insert(std::make_pair(it->second.start, it->second));
+			activeFunctions.emplace_hint(activeFunctions.end(), it->second.start, it->second);
 		} else if (mod != activeModuleIndexes.end()) {
-			activeFunctions.insert(std::make_pair(mod->second + it->second.start, it->second));
+			activeFunctions.emplace(mod->second + it->second.start, it->second);
 		}
 	}
 
 	for (auto it = labels.begin(), end = labels.end(); it != end; ++it) {
 		const auto mod = activeModuleIndexes.find(it->second.module);
 		if (it->second.module <= 0) {
-			activeLabels.insert(std::make_pair(it->second.addr, it->second));
+			activeLabels.emplace_hint(activeLabels.end(), it->second.addr, it->second);
 		} else if (mod != activeModuleIndexes.end()) {
-			activeLabels.insert(std::make_pair(mod->second + it->second.addr, it->second));
+			activeLabels.emplace(mod->second + it->second.addr, it->second);
 		}
 	}
 
 	for (auto it = data.begin(), end = data.end(); it != end; ++it) {
 		const auto mod = activeModuleIndexes.find(it->second.module);
 		if (it->second.module <= 0) {
-			activeData.insert(std::make_pair(it->second.start, it->second));
+			activeData.emplace_hint(activeData.end(), it->second.start, it->second);
 		} else if (mod != activeModuleIndexes.end()) {
-			activeData.insert(std::make_pair(mod->second + it->second.start, it->second));
+			activeData.emplace(mod->second + it->second.start, it->second);
 		}
 	}
 
@@ -504,6 +736,8 @@ bool SymbolMap::RemoveFunction(u32 startAddress, bool removeName) {
 	}
 	activeFunctions.erase(it);
 
+	InvalidateSnapshot();
+
 	if (removeName) {
 		auto labelIt = activeLabels.find(startAddress);
 		if (labelIt != activeLabels.end()) {
@@ -521,6 +755,7 @@ bool SymbolMap::RemoveFunction(u32 startAddress, bool removeName) {
 
 void SymbolMap::AddLabel(const char* name, u32 address, int moduleIndex) {
 	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	InvalidateSnapshot();
 
 	if (moduleIndex == -1) {
 		moduleIndex = GetModuleIndex(address);
@@ -584,15 +819,6 @@ void SymbolMap::SetLabelName(const char* name, u32 address, bool updateImmediate
 	}
 }
 
-const char *SymbolMap::GetLabelName(u32 address) const {
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	auto it = activeLabels.find(address);
-	if (it == activeLabels.end())
-		return NULL;
-
-	return it->second.name;
-}
-
 const char *SymbolMap::GetLabelNameRel(u32 relAddress, int moduleIndex) const {
 	std::lock_guard<std::recursive_mutex> guard(m_lock);
 	auto it = labels.find(std::make_pair(moduleIndex, relAddress));
@@ -603,18 +829,18 @@ const char *SymbolMap::GetLabelNameRel(u32 relAddress, int moduleIndex) const {
 }
 
 std::string SymbolMap::GetLabelString(u32 address) const {
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	const char *label = GetLabelName(address);
+	const auto snapshot = GetSnapshot();
+	const char *label = snapshot->GetLabel(address);
 	if (label == NULL)
 		return "";
 	return label;
 }
 
 bool SymbolMap::GetLabelValue(const char* name, u32& dest) {
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	for (auto it = activeLabels.begin(); it != activeLabels.end(); it++) {
-		if (strcasecmp(name, it->second.name) == 0) {
-			dest = it->first;
+	const auto snapshot = GetSnapshot();
+	for (const Snapshot::Label& label : snapshot->labels) {
+		if (strcasecmp(name, &snapshot->names[label.nameOffset]) == 0) {
+			dest = label.address;
 			return true;
 		}
 	}
@@ -622,8 +848,14 @@ bool SymbolMap::GetLabelValue(const char* name, u32& dest) {
 	return false;
 }
 
+bool SymbolMap::IsEmpty() const {
+	const auto snapshot = GetSnapshot();
+	return snapshot->functions.empty() && snapshot->labels.empty() && snapshot->data.empty();
+}
+
 void SymbolMap::AddData(u32 address, u32 size, DataType type, int moduleIndex) {
 	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	InvalidateSnapshot();
 
 	if (moduleIndex == -1) {
 		moduleIndex = GetModuleIndex(address);
@@ -667,47 +899,19 @@ void SymbolMap::AddData(u32 address, u32 size, DataType type, int moduleIndex) {
 }
 
 u32 SymbolMap::GetDataStart(u32 address) const {
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	auto it = activeData.upper_bound(address);
-	if (it == activeData.end())
-	{
-		// check last element
-		auto rit = activeData.rbegin();
-
-		if (rit != activeData.rend())
-		{
-			u32 start = rit->first;
-			u32 size = rit->second.size;
-			if (start <= address && start+size > address)
-				return start;
-		}
-		// otherwise there's no data that contains this address
-		return INVALID_ADDRESS;
-	}
-
-	if (it != activeData.begin()) {
-		it--;
-		u32 start = it->first;
-		u32 size = it->second.size;
-		if (start <= address && start+size > address)
-			return start;
-	}
-
-	return INVALID_ADDRESS;
+	const auto snapshot = GetSnapshot();
+	const Snapshot::Data* dataEntry = Snapshot::FindContaining(snapshot->data, address);
+	return dataEntry ? dataEntry->start : INVALID_ADDRESS;
 }
 
 u32 SymbolMap::GetDataSize(u32 startAddress) const {
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	auto it = activeData.find(startAddress);
-	if (it == activeData.end())
-		return INVALID_ADDRESS;
-	return it->second.size;
+	const auto snapshot = GetSnapshot();
+	const Snapshot::Data* dataEntry = Snapshot::Find(snapshot->data, startAddress);
+	return dataEntry ? dataEntry->size : INVALID_ADDRESS;
 }
 
 DataType SymbolMap::GetDataType(u32 startAddress) const {
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	auto it = activeData.find(startAddress);
-	if (it == activeData.end())
-		return DATATYPE_NONE;
-	return it->second.type;
+	const auto snapshot = GetSnapshot();
+	const Snapshot::Data* dataEntry = Snapshot::Find(snapshot->data, startAddress);
+	return dataEntry ? dataEntry->type : DATATYPE_NONE;
 }
@@ -15,9 +15,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <vector>
 #include <set>
 #include <map>
+#include <memory>
 #include <string>
 #include <mutex>
 
@@ -53,6 +55,14 @@ enum DataType {
 	DATATYPE_NONE, DATATYPE_BYTE, DATATYPE_HALFWORD, DATATYPE_WORD, DATATYPE_ASCII
 };
 
+struct SymbolImportEntry {
+	std::string name;
+	u32 address;
+	u32 size;
+	SymbolType type; // ST_FUNCTION, ST_DATA, or ST_NONE for a label alone.
+	DataType dataType;
+};
+
 class SymbolMap {
 public:
 	SymbolMap() {}
@@ -61,6 +71,10 @@ public:
 
 	bool LoadNocashSym(const char *ilename);
 
+	// Adds many symbols at once, as AddFunction/AddData/AddLabel followed by UpdateActiveSymbols()
+	// would, but resolving and sorting them on worker threads and inserting them in address order.
+	void ImportSymbols(std::vector<SymbolImportEntry> symbols, int moduleIndex = -1);
+
 	SymbolType GetSymbolType(u32 address) const;
 	bool GetSymbolInfo(SymbolInfo *info, u32 address, SymbolType symmask = ST_FUNCTION) const;
 	u32 GetNextSymbolAddress(u32 address, SymbolType symmask);
@@ -95,12 +109,18 @@ public:
 	static const u32 INVALID_ADDRESS = (u32)-1;
 
 	void UpdateActiveSymbols();
-	bool IsEmpty() const { return activeFunctions.empty() && activeLabels.empty() && activeData.empty(); };
+	bool IsEmpty() const;
 private:
+	struct Snapshot;
+
 	void AssignFunctionIndices();
-	const char *GetLabelName(u32 address) const;
 	const char *GetLabelNameRel(u32 relAddress, int moduleIndex) const;
 
+	// Readers use the snapshot of the active symbols, which is rebuilt by the first reader after a change.
+	std::shared_ptr<const Snapshot> GetSnapshot() const;
+	std::shared_ptr<const Snapshot> BuildSnapshot(bool parallel) const;
+	void InvalidateSnapshot() { m_snapshotDirty.store(true, std::memory_order_release); }
+
 	struct FunctionEntry {
 		u32 start;
 		u32 size;
@@ -146,6 +166,9 @@ private:
 	std::vector<ModuleEntry> modules;
 
 	mutable std::recursive_mutex m_lock;
+
+	mutable std::shared_ptr<const Snapshot> m_snapshot;
+	mutable std::atomic<bool> m_snapshotDirty{true};
 };
 
 extern SymbolMap R5900SymbolMap;
@@ -297,13 +297,16 @@ void ElfObject::loadSectionHeaders()
 		eS = (Elf32_Sym*)data.GetPtr(secthead[i_st].sh_offset);
 		Console.WriteLn("found %d symbols", secthead[i_st].sh_size / sizeof(Elf32_Sym));
 
-		R5900SymbolMap.Clear();
+		std::vector<SymbolImportEntry> symbols;
 		for(uint i = 1; i < (secthead[i_st].sh_size / sizeof(Elf32_Sym)); i++) {
 			if ((eS[i].st_value != 0) && (ELF32_ST_TYPE(eS[i].st_info) == 2))
 			{
-				R5900SymbolMap.AddLabel(&SymNames[eS[i].st_name],eS[i].st_value);
+				symbols.push_back({&SymNames[eS[i].st_name], eS[i].st_value, 0, ST_NONE, DATATYPE_NONE});
 			}
 		}
+
+		R5900SymbolMap.Clear();
+		R5900SymbolMap.ImportSymbols(std::move(symbols));
 	}
 }
 
@@ -317,12 +320,17 @@ void ElfObject::loadHeaders()
 //   0 - Invalid or unknown disc.
 //   1 - PS1 CD
 //   2 - PS2 CD
-int GetPS2ElfName( std::string& name )
+int GetPS2ElfName( std::string& name, std::string* version )
+{
+	IsoFSCDVD isofs;
+	return GetPS2ElfName(isofs, name, version);
+}
+
+int GetPS2ElfName( SectorSource& isofs, std::string& name, std::string* version )
 {
 	int retype = 0;
 
 	try {
-		IsoFSCDVD isofs;
 		IsoFile file( isofs, "SYSTEM.CNF;1");
 
 		int size = file.getLength();
@@ -365,6 +373,8 @@ int GetPS2ElfName( std::string& name )
 			{
 				Console.WriteLn( Color_Blue, "(SYSTEM.CNF) Software version = %.*s",
 					static_cast<int>(value.size()), value.data());
+				if (version)
+					*version = value;
 			}
 		}
 
@@ -155,7 +155,8 @@ class ElfObject
 
 //-------------------
 extern void loadElfFile(const std::string& filename);
-extern int  GetPS2ElfName( std::string& dest );
+extern int  GetPS2ElfName( std::string& dest, std::string* version = nullptr );
+extern int  GetPS2ElfName( SectorSource& isofs, std::string& dest, std::string* version = nullptr );
 
 
 extern u32 ElfCRC;
@@ -34,6 +34,7 @@
 #include "MemoryCardFile.h"
 #include "PAD/Host/PAD.h"
 #include "PerformanceMetrics.h"
+#include "PINE.h"
 #include "Sio.h"
 #include "VMManager.h"
 
@@ -274,10 +275,15 @@ void CommonHost::CPUThreadInitialize()
 	if (EmuConfig.EnableDiscordPresence)
 		InitializeDiscordPresence();
 #endif
+
+	if (EmuConfig.EnablePINE)
+		PINEServer::Initialize(EmuConfig.PINESlot);
 }
 
 void CommonHost::CPUThreadShutdown()
 {
+	PINEServer::Deinitialize();
+
 #ifdef ENABLE_DISCORD_PRESENCE
 	ShutdownDiscordPresence();
 #endif
@@ -311,6 +317,14 @@ void CommonHost::CheckForSettingsChanges(const Pcsx2Config& old_config)
 
 	FullscreenUI::CheckForConfigChanges(old_config);
 
+	if (EmuConfig.EnablePINE != old_config.EnablePINE || EmuConfig.PINESlot != old_config.PINESlot)
+	{
+		if (EmuConfig.EnablePINE)
+			PINEServer::Initialize(EmuConfig.PINESlot);
+		else
+			PINEServer::Deinitialize();
+	}
+
 	if (EmuConfig.InhibitScreensaver != old_config.InhibitScreensaver)
 		UpdateInhibitScreensaver(EmuConfig.InhibitScreensaver && VMManager::GetState() == VMState::Running);
 
@@ -224,6 +224,10 @@ DEFINE_HOTKEY("FrameAdvance", "System", "Frame Advance", [](s32 pressed) {
 	if (!pressed && VMManager::HasValidVM())
 		VMManager::FrameAdvance(1);
 })
+DEFINE_HOTKEY("Rewind", "System", "Rewind", [](s32 pressed) {
+	if (!pressed && VMManager::HasValidVM())
+		VMManager::Rewind(1);
+})
 DEFINE_HOTKEY("ShutdownVM", "System", "Shut Down Virtual Machine", [](s32 pressed) {
 	if (!pressed && VMManager::HasValidVM())
 		Host::RequestVMShutdown(true, true, EmuConfig.SaveStateOnShutdown);
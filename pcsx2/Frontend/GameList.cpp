@@ -25,13 +25,18 @@
 #include "common/Path.h"
 #include "common/ProgressCallback.h"
 #include "common/StringUtil.h"
+#include "common/ThreadPool.h"
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cctype>
 #include <cstdio>
 #include <ctime>
 #include <fstream>
+#include <future>
+#include <optional>
 #include <string_view>
+#include <unordered_set>
 #include <utility>
 
 #include "CDVD/CDVD.h"
@@ -47,8 +52,14 @@ namespace GameList
 	enum : u32
 	{
 		GAME_LIST_CACHE_SIGNATURE = 0x45434C47,
-		GAME_LIST_CACHE_VERSION = 32,
+		GAME_LIST_CACHE_VERSION = 33,
 
+		// The cache is an append-only log of records, later records replace earlier ones for the same path.
+		CACHE_RECORD_ENTRY = 0,
+		CACHE_RECORD_DIRECTORY = 1,
+
+		// The log is rewritten when it holds more than twice as many records as are live, and at least this many.
+		CACHE_COMPACT_MIN_RECORDS = 256,
 
 		PLAYED_TIME_SERIAL_LENGTH = 32,
 		PLAYED_TIME_LAST_TIME_LENGTH = 20, // uint64
@@ -62,7 +73,32 @@ namespace GameList
 		std::time_t total_played_time;
 	};
 
+	/// Contents of a directory when it was last listed. Directories are listed again only when their
+	/// modification time changes, which happens when files are added, removed or renamed in them.
+	struct DirectoryEntry
+	{
+		std::time_t last_modified_time = 0;
+		std::vector<std::string> files;
+		std::vector<std::string> subdirectories;
+	};
+
+	struct DirectoryListing
+	{
+		std::string path;
+		DirectoryEntry entry;
+		std::vector<std::time_t> file_timestamps;
+		bool valid = false;
+		bool from_cache = false;
+	};
+
+	struct FileToScan
+	{
+		std::string path;
+		std::time_t timestamp;
+	};
+
 	using CacheMap = UnorderedStringMap<Entry>;
+	using DirectoryCacheMap = UnorderedStringMap<DirectoryEntry>;
 	using PlayedTimeMap = UnorderedStringMap<PlayedTimeEntry>;
 
 	static bool IsScannableFilename(const std::string_view& path);
@@ -73,9 +109,11 @@ namespace GameList
 	static bool GetIsoListEntry(const std::string& path, GameList::Entry* entry);
 
 	static bool GetGameListEntryFromCache(const std::string& path, GameList::Entry* entry);
+	static DirectoryListing ListDirectory(std::string path);
 	static void ScanDirectory(const char* path, bool recursive, bool only_cache, const std::vector<std::string>& excluded_paths,
-		const PlayedTimeMap& played_time_map, ProgressCallback* progress);
+		const PlayedTimeMap& played_time_map, UnorderedStringSet& seen_paths, cb::ThreadPool& pool, ProgressCallback* progress);
 	static bool AddFileFromCache(const std::string& path, std::time_t timestamp, const PlayedTimeMap& played_time_map);
+	static std::optional<Entry> ScanFileOnWorker(const std::string& path, std::time_t timestamp, const std::atomic_bool& cancelled);
 	static bool ScanFile(
 		std::string path, std::time_t timestamp, std::unique_lock<std::recursive_mutex>& lock, const PlayedTimeMap& played_time_map);
 
@@ -83,6 +121,7 @@ namespace GameList
 	static bool LoadEntriesFromCache(std::FILE* stream);
 	static bool OpenCacheForWriting();
 	static bool WriteEntryToCache(const GameList::Entry* entry);
+	static bool WriteDirectoryToCache(const std::string& path, const DirectoryEntry& entry);
 	static void CloseCacheFileStream();
 	static void DeleteCacheFile();
 	static void RewriteCacheFile();
@@ -98,7 +137,10 @@ namespace GameList
 static std::vector<GameList::Entry> s_entries;
 static std::recursive_mutex s_mutex;
 static GameList::CacheMap s_cache_map;
+static GameList::DirectoryCacheMap s_directory_cache_map;
+static GameList::DirectoryCacheMap s_scanned_directories;
 static std::FILE* s_cache_write_stream = nullptr;
+static size_t s_cache_record_count = 0;
 
 const char* GameList::EntryTypeToString(EntryType type)
 {
@@ -167,25 +209,7 @@ void GameList::FillBootParametersForEntry(VMBootParameters* params, const Entry*
 
 bool GameList::GetIsoSerialAndCRC(const std::string& path, s32* disc_type, std::string* serial, u32* crc)
 {
-	// This isn't great, we really want to make it all thread-local...
-	CDVD = &CDVDapi_Iso;
-	if (CDVD->open(path.c_str()) != 0)
-		return false;
-
-	*disc_type = DoCDVDdetectDiskType();
-	cdvdReloadElfInfo();
-
-	*serial = DiscSerial;
-	*crc = ElfCRC;
-
-	DoCDVDclose();
-
-	// TODO(Stenzek): These globals are **awful**. Clean it up.
-	DiscSerial.clear();
-	ElfCRC = 0;
-	ElfEntry = -1;
-	LastELF.clear();
-	return true;
+	return cdvdProbeIsoFile(path, disc_type, serial, crc);
 }
 
 bool GameList::GetElfListEntry(const std::string& path, GameList::Entry* entry)
@@ -430,6 +454,50 @@ bool GameList::LoadEntriesFromCache(std::FILE* stream)
 
 	while (FileSystem::FTell64(stream) != file_size)
 	{
+		u8 record_type;
+		if (!ReadU8(stream, &record_type))
+		{
+			Console.Warning("Game list cache entry is corrupted");
+			return false;
+		}
+
+		s_cache_record_count++;
+		if (record_type == CACHE_RECORD_DIRECTORY)
+		{
+			std::string path;
+			u64 last_modified_time;
+			u32 file_count, subdirectory_count;
+			DirectoryEntry de;
+			bool result = ReadString(stream, &path) && ReadU64(stream, &last_modified_time) && ReadU32(stream, &file_count);
+			for (u32 i = 0; result && i < file_count; i++)
+			{
+				std::string name;
+				result = ReadString(stream, &name);
+				de.files.push_back(Path::Combine(path, name));
+			}
+			result = result && ReadU32(stream, &subdirectory_count);
+			for (u32 i = 0; result && i < subdirectory_count; i++)
+			{
+				std::string name;
+				result = ReadString(stream, &name);
+				de.subdirectories.push_back(Path::Combine(path, name));
+			}
+			if (!result)
+			{
+				Console.Warning("Game list cache directory is corrupted");
+				return false;
+			}
+
+			de.last_modified_time = static_cast<std::time_t>(last_modified_time);
+			s_directory_cache_map[path] = std::move(de);
+			continue;
+		}
+		else if (record_type != CACHE_RECORD_ENTRY)
+		{
+			Console.Warning("Game list cache record type %u is unknown", record_type);
+			return false;
+		}
+
 		std::string path;
 		GameList::Entry ge;
 
@@ -480,6 +548,7 @@ void GameList::LoadCache()
 		Console.Warning("Deleting corrupted cache file '%s'", cache_filename.c_str());
 		stream.reset();
 		s_cache_map.clear();
+		s_directory_cache_map.clear();
 		DeleteCacheFile();
 		return;
 	}
@@ -515,6 +584,7 @@ bool GameList::OpenCacheForWriting()
 
 
 	// new cache file, write header
+	s_cache_record_count = 0;
 	if (!WriteU32(s_cache_write_stream, GAME_LIST_CACHE_SIGNATURE) || !WriteU32(s_cache_write_stream, GAME_LIST_CACHE_VERSION))
 	{
 		Console.Error("Failed to write game list cache header");
@@ -530,6 +600,7 @@ bool GameList::OpenCacheForWriting()
 bool GameList::WriteEntryToCache(const Entry* entry)
 {
 	bool result = true;
+	result &= WriteU8(s_cache_write_stream, CACHE_RECORD_ENTRY);
 	result &= WriteString(s_cache_write_stream, entry->path);
 	result &= WriteString(s_cache_write_stream, entry->serial);
 	result &= WriteString(s_cache_write_stream, entry->title);
@@ -544,6 +615,29 @@ bool GameList::WriteEntryToCache(const Entry* entry)
 	if (result)
 		result = (std::fflush(s_cache_write_stream) == 0);
 
+	s_cache_record_count++;
+	return result;
+}
+
+bool GameList::WriteDirectoryToCache(const std::string& path, const DirectoryEntry& entry)
+{
+	bool result = true;
+	result &= WriteU8(s_cache_write_stream, CACHE_RECORD_DIRECTORY);
+	result &= WriteString(s_cache_write_stream, path);
+	result &= WriteU64(s_cache_write_stream, static_cast<u64>(entry.last_modified_time));
+
+	// Contents are stored relative to the directory.
+	result &= WriteU32(s_cache_write_stream, static_cast<u32>(entry.files.size()));
+	for (const std::string& file : entry.files)
+		result &= WriteString(s_cache_write_stream, std::string(Path::GetFileName(file)));
+	result &= WriteU32(s_cache_write_stream, static_cast<u32>(entry.subdirectories.size()));
+	for (const std::string& subdirectory : entry.subdirectories)
+		result &= WriteString(s_cache_write_stream, std::string(Path::GetFileName(subdirectory)));
+
+	if (result)
+		result = (std::fflush(s_cache_write_stream) == 0);
+
+	s_cache_record_count++;
 	return result;
 }
 
@@ -564,6 +658,7 @@ void GameList::DeleteCacheFile()
 	if (cache_filename.empty() || !FileSystem::FileExists(cache_filename.c_str()))
 		return;
 
+	s_cache_record_count = 0;
 	if (FileSystem::DeleteFilePath(cache_filename.c_str()))
 		Console.WriteLn("Deleted game list cache '%s'", cache_filename.c_str());
 	else
@@ -577,6 +672,8 @@ void GameList::RewriteCacheFile()
 
 	if (OpenCacheForWriting())
 	{
+		for (const auto& [path, entry] : s_scanned_directories)
+			WriteDirectoryToCache(path, entry);
 		for (const GameList::Entry& entry : s_entries)
 			WriteEntryToCache(&entry);
 
@@ -584,47 +681,173 @@ void GameList::RewriteCacheFile()
 	}
 }
 
+// Only Windows paths are case insensitive, elsewhere names differing in case are different files.
+static std::string GetPathKey(const std::string& path)
+{
+#ifdef _WIN32
+	return StringUtil::toLower(path);
+#else
+	return path;
+#endif
+}
+
 static bool IsPathExcluded(const std::vector<std::string>& excluded_paths, const std::string& path)
 {
 	return (std::find(excluded_paths.begin(), excluded_paths.end(), path) != excluded_paths.end());
 }
 
+GameList::DirectoryListing GameList::ListDirectory(std::string path)
+{
+	DirectoryListing listing;
+	listing.path = std::move(path);
+
+	FILESYSTEM_STAT_DATA sd;
+	if (!FileSystem::StatFile(listing.path.c_str(), &sd))
+		return listing;
+
+	listing.valid = true;
+	auto iter = UnorderedStringMapFind(s_directory_cache_map, listing.path);
+	if (iter != s_directory_cache_map.end() && iter->second.last_modified_time == sd.ModificationTime)
+	{
+		// Writing to a file in place doesn't change its directory's time, so each file still gets its
+		// own time checked against the cache. Anything which has gone since is dropped.
+		listing.entry.last_modified_time = iter->second.last_modified_time;
+		listing.entry.subdirectories = iter->second.subdirectories;
+		for (const std::string& file : iter->second.files)
+		{
+			FILESYSTEM_STAT_DATA file_sd;
+			if (!FileSystem::StatFile(file.c_str(), &file_sd))
+				continue;
+
+			listing.entry.files.push_back(file);
+			listing.file_timestamps.push_back(file_sd.ModificationTime);
+		}
+
+		listing.from_cache = true;
+		return listing;
+	}
+
+	FileSystem::FindResultsArray files;
+	FileSystem::FindFiles(listing.path.c_str(), "*", FILESYSTEM_FIND_FILES | FILESYSTEM_FIND_FOLDERS | FILESYSTEM_FIND_HIDDEN_FILES, &files);
+
+	listing.entry.last_modified_time = sd.ModificationTime;
+	for (FILESYSTEM_FIND_DATA& ffd : files)
+	{
+		if (ffd.Attributes & FILESYSTEM_FILE_ATTRIBUTE_DIRECTORY)
+		{
+			listing.entry.subdirectories.push_back(std::move(ffd.FileName));
+		}
+		else if (IsScannableFilename(ffd.FileName))
+		{
+			listing.entry.files.push_back(std::move(ffd.FileName));
+			listing.file_timestamps.push_back(ffd.ModificationTime);
+		}
+	}
+
+	return listing;
+}
+
 void GameList::ScanDirectory(const char* path, bool recursive, bool only_cache, const std::vector<std::string>& excluded_paths,
-	const PlayedTimeMap& played_time_map, ProgressCallback* progress)
+	const PlayedTimeMap& played_time_map, UnorderedStringSet& seen_paths, cb::ThreadPool& pool, ProgressCallback* progress)
 {
 	Console.WriteLn("Scanning %s%s", path, recursive ? " (recursively)" : "");
 
 	progress->PushState();
 	progress->SetFormattedStatusText("Scanning directory '%s'%s...", path, recursive ? " (recursively)" : "");
 
-	FileSystem::FindResultsArray files;
-	FileSystem::FindFiles(path, "*",
-		recursive ? (FILESYSTEM_FIND_FILES | FILESYSTEM_FIND_HIDDEN_FILES | FILESYSTEM_FIND_RECURSIVE) :
-                    (FILESYSTEM_FIND_FILES | FILESYSTEM_FIND_HIDDEN_FILES),
-		&files);
+	// Walk the tree a level at a time, listing all the directories in a level in parallel.
+	std::vector<FileToScan> files;
+	std::vector<std::string> level;
+	level.emplace_back(path);
+	while (!level.empty() && !progress->IsCancelled())
+	{
+		std::vector<std::future<DirectoryListing>> listings;
+		for (std::string& dir : level)
+			listings.push_back(pool.ScheduleAndGetFuture([dir = std::move(dir)]() mutable { return ListDirectory(std::move(dir)); }));
+		level.clear();
+
+		for (std::future<DirectoryListing>& future : listings)
+		{
+			DirectoryListing listing(future.get());
+			if (!listing.valid)
+				continue;
+
+			if (!listing.from_cache && (s_cache_write_stream || OpenCacheForWriting()))
+			{
+				if (!WriteDirectoryToCache(listing.path, listing.entry))
+					Console.Warning("Failed to write directory '%s' to cache", listing.path.c_str());
+			}
+
+			for (size_t i = 0; i < listing.entry.files.size(); i++)
+			{
+				files.push_back({listing.entry.files[i], listing.file_timestamps[i]});
+			}
+
+			if (recursive)
+				level.insert(level.end(), listing.entry.subdirectories.begin(), listing.entry.subdirectories.end());
+
+			s_scanned_directories[listing.path] = std::move(listing.entry);
+		}
+	}
 
 	u32 files_scanned = 0;
 	progress->SetProgressRange(static_cast<u32>(files.size()));
 	progress->SetProgressValue(0);
 
-	for (FILESYSTEM_FIND_DATA& ffd : files)
+	// Anything which isn't in the cache is probed on the pool. Results are collected in order, so the
+	// list comes out the same however long each file takes.
+	std::atomic_bool cancelled{false};
+	std::vector<std::pair<std::string, std::future<std::optional<Entry>>>> scans;
+	for (FileToScan& file : files)
 	{
-		files_scanned++;
-
-		if (progress->IsCancelled() || !GameList::IsScannableFilename(ffd.FileName) || IsPathExcluded(excluded_paths, ffd.FileName))
+		if (progress->IsCancelled() || IsPathExcluded(excluded_paths, file.path) || !seen_paths.insert(GetPathKey(file.path)).second)
 		{
+			files_scanned++;
 			continue;
 		}
 
 		std::unique_lock lock(s_mutex);
-		if (GetEntryForPath(ffd.FileName.c_str()) || AddFileFromCache(ffd.FileName, ffd.ModificationTime, played_time_map) || only_cache)
+		if (AddFileFromCache(file.path, file.timestamp, played_time_map) || only_cache)
 		{
+			files_scanned++;
 			continue;
 		}
 
-		progress->SetFormattedStatusText("Scanning '%s'...", FileSystem::GetDisplayNameFromPath(ffd.FileName).c_str());
-		ScanFile(std::move(ffd.FileName), ffd.ModificationTime, lock, played_time_map);
-		progress->SetProgressValue(files_scanned);
+		lock.unlock();
+		scans.emplace_back(file.path, pool.ScheduleAndGetFuture([path = file.path, timestamp = file.timestamp, &cancelled]() {
+			return ScanFileOnWorker(path, timestamp, cancelled);
+		}));
+	}
+
+	progress->SetProgressValue(files_scanned);
+
+	for (auto& [file_path, future] : scans)
+	{
+		if (progress->IsCancelled())
+			cancelled.store(true, std::memory_order_relaxed);
+		else
+			progress->SetFormattedStatusText("Scanning '%s'...", FileSystem::GetDisplayNameFromPath(file_path).c_str());
+
+		std::optional<Entry> entry(future.get());
+		progress->SetProgressValue(++files_scanned);
+		if (!entry.has_value())
+			continue;
+
+		if (s_cache_write_stream || OpenCacheForWriting())
+		{
+			if (!WriteEntryToCache(&entry.value()))
+				Console.Warning("Failed to write entry '%s' to cache", entry->path.c_str());
+		}
+
+		auto iter = UnorderedStringMapFind(played_time_map, entry->serial);
+		if (iter != played_time_map.end())
+		{
+			entry->last_played_time = iter->second.last_played_time;
+			entry->total_played_time = iter->second.total_played_time;
+		}
+
+		std::unique_lock lock(s_mutex);
+		s_entries.push_back(std::move(entry.value()));
 	}
 
 	progress->SetProgressValue(files_scanned);
@@ -648,6 +871,22 @@ bool GameList::AddFileFromCache(const std::string& path, std::time_t timestamp,
 	return true;
 }
 
+std::optional<GameList::Entry> GameList::ScanFileOnWorker(const std::string& path, std::time_t timestamp, const std::atomic_bool& cancelled)
+{
+	if (cancelled.load(std::memory_order_relaxed))
+		return std::nullopt;
+
+	DevCon.WriteLn("Scanning '%s'...", path.c_str());
+
+	Entry entry;
+	if (!PopulateEntryFromPath(path, &entry))
+		return std::nullopt;
+
+	entry.path = path;
+	entry.last_modified_time = timestamp;
+	return entry;
+}
+
 bool GameList::ScanFile(
 	std::string path, std::time_t timestamp, std::unique_lock<std::recursive_mutex>& lock, const PlayedTimeMap& played_time_map)
 {
@@ -761,6 +1000,10 @@ void GameList::Refresh(bool invalidate_cache, bool only_cache, ProgressCallback*
 
 	if (!dirs.empty() || !recursive_dirs.empty())
 	{
+		// Most of the time goes on waiting for storage, so use more threads than there are cores.
+		cb::ThreadPool pool(static_cast<int>(std::clamp(cb::ThreadPool::GetNumLogicalCores() * 2, 4u, 16u)));
+		UnorderedStringSet seen_paths;
+
 		progress->SetProgressRange(static_cast<u32>(dirs.size() + recursive_dirs.size()));
 		progress->SetProgressValue(0);
 
@@ -771,7 +1014,7 @@ void GameList::Refresh(bool invalidate_cache, bool only_cache, ProgressCallback*
 			if (progress->IsCancelled())
 				break;
 
-			ScanDirectory(dir.c_str(), false, only_cache, excluded_paths, played_time, progress);
+			ScanDirectory(dir.c_str(), false, only_cache, excluded_paths, played_time, seen_paths, pool, progress);
 			progress->SetProgressValue(++directory_counter);
 		}
 		for (const std::string& dir : recursive_dirs)
@@ -779,14 +1022,25 @@ void GameList::Refresh(bool invalidate_cache, bool only_cache, ProgressCallback*
 			if (progress->IsCancelled())
 				break;
 
-			ScanDirectory(dir.c_str(), true, only_cache, excluded_paths, played_time, progress);
+			ScanDirectory(dir.c_str(), true, only_cache, excluded_paths, played_time, seen_paths, pool, progress);
 			progress->SetProgressValue(++directory_counter);
 		}
 	}
 
+	// Records for changed and removed files pile up in the cache, drop them once they outnumber the live ones.
+	// Skipped if cancelled, since the list is incomplete.
+	if (!progress->IsCancelled() &&
+		s_cache_record_count > std::max<size_t>((s_entries.size() + s_scanned_directories.size()) * 2, CACHE_COMPACT_MIN_RECORDS))
+	{
+		Console.WriteLn("Compacting game list cache (%zu records, %zu live)", s_cache_record_count, s_entries.size() + s_scanned_directories.size());
+		RewriteCacheFile();
+	}
+
 	// don't need unused cache entries
 	CloseCacheFileStream();
 	s_cache_map.clear();
+	s_directory_cache_map.clear();
+	s_scanned_directories.clear();
 }
 
 bool GameList::RescanPath(const std::string& path)
@@ -806,12 +1060,9 @@ bool GameList::RescanPath(const std::string& path)
 			return false;
 	}
 
-	// re-scan!
-	if (!ScanFile(path, sd.ModificationTime, lock, played_time))
-		return true;
-
-	// update cache.. this is far from ideal, but since everything's variable length, all we can do.
-	RewriteCacheFile();
+	// re-scan! the new entry is appended to the cache, and replaces the old one when it's next loaded.
+	ScanFile(path, sd.ModificationTime, lock, played_time);
+	CloseCacheFileStream();
 	return true;
 }
 
@@ -214,6 +214,14 @@ void ImGuiManager::DrawPerformanceOverlay()
 			FormatProcessorStat(text, PerformanceMetrics::GetCPUThreadUsage(), PerformanceMetrics::GetCPUThreadAverageTime());
 			DRAW_LINE(fixed_font, text.c_str(), IM_COL32(255, 255, 255, 255));
 
+			if (PerformanceMetrics::HasCPUThreadTLBMisses())
+			{
+				text.clear();
+				fmt::format_to(std::back_inserter(text), "EE TLB misses: {:.0f}D {:.0f}I /frame",
+					PerformanceMetrics::GetCPUThreadDataTLBMisses(), PerformanceMetrics::GetCPUThreadInstructionTLBMisses());
+				DRAW_LINE(fixed_font, text.c_str(), IM_COL32(255, 255, 255, 255));
+			}
+
 			text = "GS: ";
 			FormatProcessorStat(text, PerformanceMetrics::GetGSThreadUsage(), PerformanceMetrics::GetGSThreadAverageTime());
 			DRAW_LINE(fixed_font, text.c_str(), IM_COL32(255, 255, 255, 255));
@@ -240,6 +248,16 @@ void ImGuiManager::DrawPerformanceOverlay()
 				FormatProcessorStat(text, PerformanceMetrics::GetCaptureThreadUsage(), PerformanceMetrics::GetCaptureThreadAverageTime());
 				DRAW_LINE(fixed_font, text.c_str(), IM_COL32(255, 255, 255, 255));
 			}
+
+			if (EmuConfig.Rewind.Enabled)
+			{
+				const RewindBuffer::Stats rewind = VMManager::GetRewindStats();
+				text.clear();
+				fmt::format_to(std::back_inserter(text), "RW: {} ({} frames) {}/{}MB {:.2f}ms+{:.2f}ms", rewind.snapshot_count,
+					rewind.frames_covered, rewind.delta_bytes / _1mb, rewind.budget_bytes / _1mb, rewind.last_capture_ms,
+					rewind.last_compress_ms);
+				DRAW_LINE(fixed_font, text.c_str(), IM_COL32(255, 255, 255, 255));
+			}
 		}
 
 		if (GSConfig.OsdShowGPU)
@@ -69,6 +69,10 @@ class HostDisplay;
 s16 GSLookupGetSkipCountFunctionId(const std::string_view& name);
 s16 GSLookupBeforeDrawFunctionId(const std::string_view& name);
 
+// Returns the name of the function with the specified ID, otherwise nullptr.
+const char* GSLookupGetSkipCountFunctionName(s16 id);
+const char* GSLookupBeforeDrawFunctionName(s16 id);
+
 int GSinit();
 void GSshutdown();
 bool GSopen(const Pcsx2Config::GSOptions& config, GSRendererType renderer, u8* basemem);
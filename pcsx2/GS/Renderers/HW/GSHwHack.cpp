@@ -1240,6 +1240,16 @@ s16 GSLookupBeforeDrawFunctionId(const std::string_view& name)
 	return -1;
 }
 
+const char* GSLookupGetSkipCountFunctionName(s16 id)
+{
+	return (id >= 0 && static_cast<u32>(id) < std::size(GSHwHack::s_get_skip_count_functions)) ? GSHwHack::s_get_skip_count_functions[id].name : nullptr;
+}
+
+const char* GSLookupBeforeDrawFunctionName(s16 id)
+{
+	return (id >= 0 && static_cast<u32>(id) < std::size(GSHwHack::s_before_draw_functions)) ? GSHwHack::s_before_draw_functions[id].name : nullptr;
+}
+
 void GSRendererHW::UpdateCRCHacks()
 {
 	GSRenderer::UpdateCRCHacks();
@@ -22,6 +22,7 @@
 #include "vtlb.h"
 
 #include "common/FileSystem.h"
+#include "common/General.h"
 #include "common/Path.h"
 #include "common/StringUtil.h"
 #include "common/Timer.h"
@@ -31,6 +32,7 @@
 #include "ryml.hpp"
 #include "fmt/core.h"
 #include "fmt/ranges.h"
+#include <cstring>
 #include <fstream>
 #include <mutex>
 #include <optional>
@@ -46,13 +48,56 @@ namespace GameDatabase
 {
 	static void parseAndInsert(const std::string_view& serial, const c4::yml::NodeRef& node);
 	static void initDatabase();
+	static void parseDatabase();
+
+	static std::string getCacheFileName();
+	static bool openCache(const std::string& filename, u64 yaml_timestamp);
+	static void writeCache(const std::string& filename, u64 yaml_timestamp);
+	static const GameDatabaseSchema::GameEntry* findGameInCache(const std::string& serial);
 } // namespace GameDatabase
 
 static constexpr char GAMEDB_YAML_FILE_NAME[] = "GameIndex.yaml";
+static constexpr char GAMEDB_CACHE_FILE_NAME[] = "gamedb.cache";
+
+static constexpr u32 GAMEDB_CACHE_SIGNATURE = 0x43424447; // GDBC
+static constexpr u32 GAMEDB_CACHE_VERSION = 1;
+
+// The compiled database is a header, the index entries, an open-addressed hash table of serials
+// pointing into the entries, and the serials and serialized game entries. It is used in place,
+// so only the entries which are looked up are ever decoded.
+struct GameDatabaseCacheHeader
+{
+	u32 signature;
+	u32 version;
+	u64 yaml_timestamp;
+	u32 gamefix_count;
+	u32 speedhack_count;
+	u32 gs_hw_fix_count;
+	u32 entry_count;
+	u32 bucket_count;
+	u32 data_size;
+};
+
+struct GameDatabaseCacheEntry
+{
+	u32 hash;
+	u32 serial_offset;
+	u32 serial_length;
+	u32 data_offset;
+	u32 data_length;
+};
 
 static std::unordered_map<std::string, GameDatabaseSchema::GameEntry> s_game_db;
 static std::once_flag s_load_once_flag;
 
+// Entries are decoded from the cache into s_game_db on first lookup, which needs the lock.
+static std::mutex s_game_db_mutex;
+// The cache stays mapped for the lifetime of the process, like the parsed database.
+static const GameDatabaseCacheHeader* s_cache_header = nullptr;
+static const GameDatabaseCacheEntry* s_cache_entries = nullptr;
+static const u32* s_cache_buckets = nullptr;
+static const u8* s_cache_data = nullptr;
+
 std::string GameDatabaseSchema::GameEntry::memcardFiltersAsString() const
 {
 	return fmt::to_string(fmt::join(memcardFilters, "/"));
@@ -922,7 +967,414 @@ u32 GameDatabaseSchema::GameEntry::applyGSHardwareFixes(Pcsx2Config::GSOptions&
 	return num_applied_fixes;
 }
 
+static u32 hashSerial(const std::string_view& serial)
+{
+	// FNV-1a
+	u32 hash = 2166136261u;
+	for (const char ch : serial)
+		hash = (hash ^ static_cast<u8>(ch)) * 16777619u;
+	return hash;
+}
+
+static bool isFunctionHWFix(GameDatabaseSchema::GSHWFixId id)
+{
+	return (id == GameDatabaseSchema::GSHWFixId::GetSkipCount || id == GameDatabaseSchema::GSHWFixId::BeforeDraw);
+}
+
+namespace
+{
+	class CacheWriter
+	{
+	public:
+		template <typename T>
+		void Write(T value)
+		{
+			const size_t pos = m_data.size();
+			m_data.resize(pos + sizeof(T));
+			std::memcpy(&m_data[pos], &value, sizeof(T));
+		}
+
+		void WriteString(const std::string_view& str)
+		{
+			Write(static_cast<u32>(str.size()));
+			m_data.insert(m_data.end(), str.begin(), str.end());
+		}
+
+		std::vector<u8>& GetData() { return m_data; }
+
+	private:
+		std::vector<u8> m_data;
+	};
+
+	class CacheReader
+	{
+	public:
+		CacheReader(const u8* data, size_t size)
+			: m_pos(data)
+			, m_end(data + size)
+		{
+		}
+
+		template <typename T>
+		bool Read(T* value)
+		{
+			if (static_cast<size_t>(m_end - m_pos) < sizeof(T))
+				return false;
+
+			std::memcpy(value, m_pos, sizeof(T));
+			m_pos += sizeof(T);
+			return true;
+		}
+
+		bool ReadString(std::string* str)
+		{
+			u32 length;
+			if (!Read(&length) || static_cast<size_t>(m_end - m_pos) < length)
+				return false;
+
+			str->assign(reinterpret_cast<const char*>(m_pos), length);
+			m_pos += length;
+			return true;
+		}
+
+		bool ReadCount(u32* count, size_t min_element_size)
+		{
+			// Reject counts which can't possibly fit, so a damaged file can't make us allocate gigabytes.
+			return Read(count) && static_cast<size_t>(m_end - m_pos) / min_element_size >= *count;
+		}
+
+	private:
+		const u8* m_pos;
+		const u8* m_end;
+	};
+} // namespace
+
+static void serializeEntry(CacheWriter& writer, const GameDatabaseSchema::GameEntry& entry)
+{
+	writer.WriteString(entry.name);
+	writer.WriteString(entry.region);
+	writer.Write(static_cast<s8>(entry.compat));
+	writer.Write(static_cast<s8>(entry.eeRoundMode));
+	writer.Write(static_cast<s8>(entry.vu0RoundMode));
+	writer.Write(static_cast<s8>(entry.vu1RoundMode));
+	writer.Write(static_cast<s8>(entry.eeClampMode));
+	writer.Write(static_cast<s8>(entry.vu0ClampMode));
+	writer.Write(static_cast<s8>(entry.vu1ClampMode));
+
+	writer.Write(static_cast<u32>(entry.gameFixes.size()));
+	for (const GamefixId id : entry.gameFixes)
+		writer.Write(static_cast<u32>(id));
+
+	writer.Write(static_cast<u32>(entry.speedHacks.size()));
+	for (const auto& [id, value] : entry.speedHacks)
+	{
+		writer.Write(static_cast<u32>(id));
+		writer.Write(static_cast<s32>(value));
+	}
+
+	// Function fixes are stored by name, since the IDs are only indices into the GS tables.
+	writer.Write(static_cast<u32>(entry.gsHWFixes.size()));
+	for (const auto& [id, value] : entry.gsHWFixes)
+	{
+		writer.Write(static_cast<u32>(id));
+		if (isFunctionHWFix(id))
+		{
+			const char* name = (id == GameDatabaseSchema::GSHWFixId::GetSkipCount) ?
+								   GSLookupGetSkipCountFunctionName(static_cast<s16>(value)) :
+								   GSLookupBeforeDrawFunctionName(static_cast<s16>(value));
+			writer.WriteString(name ? name : "");
+		}
+		else
+		{
+			writer.Write(value);
+		}
+	}
+
+	writer.Write(static_cast<u32>(entry.memcardFilters.size()));
+	for (const std::string& filter : entry.memcardFilters)
+		writer.WriteString(filter);
+
+	writer.Write(static_cast<u32>(entry.patches.size()));
+	for (const auto& [crc, patch] : entry.patches)
+	{
+		writer.Write(crc);
+		writer.WriteString(patch);
+	}
+
+	writer.Write(static_cast<u32>(entry.dynaPatches.size()));
+	for (const DynamicPatch& patch : entry.dynaPatches)
+	{
+		writer.Write(static_cast<u32>(patch.pattern.size()));
+		for (const DynamicPatchEntry& it : patch.pattern)
+		{
+			writer.Write(it.offset);
+			writer.Write(it.value);
+		}
+		writer.Write(static_cast<u32>(patch.replacement.size()));
+		for (const DynamicPatchEntry& it : patch.replacement)
+		{
+			writer.Write(it.offset);
+			writer.Write(it.value);
+		}
+	}
+}
+
+static bool deserializeEntry(CacheReader& reader, GameDatabaseSchema::GameEntry* entry)
+{
+	s8 compat, ee_round, vu0_round, vu1_round, ee_clamp, vu0_clamp, vu1_clamp;
+	if (!reader.ReadString(&entry->name) || !reader.ReadString(&entry->region) || !reader.Read(&compat) ||
+		!reader.Read(&ee_round) || !reader.Read(&vu0_round) || !reader.Read(&vu1_round) ||
+		!reader.Read(&ee_clamp) || !reader.Read(&vu0_clamp) || !reader.Read(&vu1_clamp))
+	{
+		return false;
+	}
+
+	entry->compat = static_cast<GameDatabaseSchema::Compatibility>(compat);
+	entry->eeRoundMode = static_cast<GameDatabaseSchema::RoundMode>(ee_round);
+	entry->vu0RoundMode = static_cast<GameDatabaseSchema::RoundMode>(vu0_round);
+	entry->vu1RoundMode = static_cast<GameDatabaseSchema::RoundMode>(vu1_round);
+	entry->eeClampMode = static_cast<GameDatabaseSchema::ClampMode>(ee_clamp);
+	entry->vu0ClampMode = static_cast<GameDatabaseSchema::ClampMode>(vu0_clamp);
+	entry->vu1ClampMode = static_cast<GameDatabaseSchema::ClampMode>(vu1_clamp);
+
+	u32 count;
+	if (!reader.ReadCount(&count, sizeof(u32)))
+		return false;
+	for (u32 i = 0; i < count; i++)
+	{
+		u32 id;
+		if (!reader.Read(&id) || id >= GamefixId_COUNT)
+			return false;
+		entry->gameFixes.push_back(static_cast<GamefixId>(id));
+	}
+
+	if (!reader.ReadCount(&count, sizeof(u32) * 2))
+		return false;
+	for (u32 i = 0; i < count; i++)
+	{
+		u32 id;
+		s32 value;
+		if (!reader.Read(&id) || !reader.Read(&value) || id >= SpeedhackId_COUNT)
+			return false;
+		entry->speedHacks.emplace_back(static_cast<SpeedhackId>(id), value);
+	}
+
+	if (!reader.ReadCount(&count, sizeof(u32) * 2))
+		return false;
+	for (u32 i = 0; i < count; i++)
+	{
+		u32 id;
+		s32 value;
+		if (!reader.Read(&id) || id >= static_cast<u32>(GameDatabaseSchema::GSHWFixId::Count))
+			return false;
+
+		const GameDatabaseSchema::GSHWFixId fix_id = static_cast<GameDatabaseSchema::GSHWFixId>(id);
+		if (isFunctionHWFix(fix_id))
+		{
+			std::string name;
+			if (!reader.ReadString(&name))
+				return false;
+			value = (fix_id == GameDatabaseSchema::GSHWFixId::GetSkipCount) ? GSLookupGetSkipCountFunctionId(name) : GSLookupBeforeDrawFunctionId(name);
+			if (value < 0)
+				return false;
+		}
+		else if (!reader.Read(&value))
+		{
+			return false;
+		}
+
+		entry->gsHWFixes.emplace_back(fix_id, value);
+	}
+
+	if (!reader.ReadCount(&count, sizeof(u32)))
+		return false;
+	entry->memcardFilters.resize(count);
+	for (std::string& filter : entry->memcardFilters)
+	{
+		if (!reader.ReadString(&filter))
+			return false;
+	}
+
+	if (!reader.ReadCount(&count, sizeof(u32) * 2))
+		return false;
+	for (u32 i = 0; i < count; i++)
+	{
+		u32 crc;
+		std::string patch;
+		if (!reader.Read(&crc) || !reader.ReadString(&patch))
+			return false;
+		entry->patches.emplace(crc, std::move(patch));
+	}
+
+	if (!reader.ReadCount(&count, sizeof(u32) * 2))
+		return false;
+	entry->dynaPatches.resize(count);
+	for (DynamicPatch& patch : entry->dynaPatches)
+	{
+		for (std::vector<DynamicPatchEntry>* list : {&patch.pattern, &patch.replacement})
+		{
+			if (!reader.ReadCount(&count, sizeof(DynamicPatchEntry)))
+				return false;
+			list->resize(count);
+			for (DynamicPatchEntry& it : *list)
+			{
+				if (!reader.Read(&it.offset) || !reader.Read(&it.value))
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+std::string GameDatabase::getCacheFileName()
+{
+	return EmuFolders::Cache.empty() ? std::string() : Path::Combine(EmuFolders::Cache, GAMEDB_CACHE_FILE_NAME);
+}
+
+bool GameDatabase::openCache(const std::string& filename, u64 yaml_timestamp)
+{
+	size_t size;
+	u8* mapping = static_cast<u8*>(HostSys::MapFile(filename.c_str(), false, &size));
+	if (!mapping)
+		return false;
+
+	const GameDatabaseCacheHeader* header = reinterpret_cast<const GameDatabaseCacheHeader*>(mapping);
+	if (size < sizeof(GameDatabaseCacheHeader) || header->signature != GAMEDB_CACHE_SIGNATURE ||
+		header->version != GAMEDB_CACHE_VERSION || header->yaml_timestamp != yaml_timestamp ||
+		header->gamefix_count != GamefixId_COUNT || header->speedhack_count != SpeedhackId_COUNT ||
+		header->gs_hw_fix_count != static_cast<u32>(GameDatabaseSchema::GSHWFixId::Count) ||
+		header->bucket_count == 0 || (header->bucket_count & (header->bucket_count - 1)) != 0 ||
+		header->bucket_count < header->entry_count ||
+		size != sizeof(GameDatabaseCacheHeader) + static_cast<u64>(header->entry_count) * sizeof(GameDatabaseCacheEntry) +
+					static_cast<u64>(header->bucket_count) * sizeof(u32) + header->data_size)
+	{
+		Console.Warning("[GameDB] Cache is out of date, rebuilding.");
+		HostSys::UnmapFile(mapping, size);
+		return false;
+	}
+
+	s_cache_header = header;
+	s_cache_entries = reinterpret_cast<const GameDatabaseCacheEntry*>(mapping + sizeof(GameDatabaseCacheHeader));
+	s_cache_buckets = reinterpret_cast<const u32*>(s_cache_entries + header->entry_count);
+	s_cache_data = reinterpret_cast<const u8*>(s_cache_buckets + header->bucket_count);
+	return true;
+}
+
+void GameDatabase::writeCache(const std::string& filename, u64 yaml_timestamp)
+{
+	u32 bucket_count = 1;
+	while (bucket_count < s_game_db.size() * 2)
+		bucket_count <<= 1;
+
+	std::vector<GameDatabaseCacheEntry> entries;
+	std::vector<u32> buckets(bucket_count, 0);
+	CacheWriter data;
+	entries.reserve(s_game_db.size());
+	for (const auto& [serial, entry] : s_game_db)
+	{
+		GameDatabaseCacheEntry ce;
+		ce.hash = hashSerial(serial);
+		ce.serial_offset = static_cast<u32>(data.GetData().size());
+		ce.serial_length = static_cast<u32>(serial.size());
+		data.GetData().insert(data.GetData().end(), serial.begin(), serial.end());
+		ce.data_offset = static_cast<u32>(data.GetData().size());
+		serializeEntry(data, entry);
+		ce.data_length = static_cast<u32>(data.GetData().size()) - ce.data_offset;
+		entries.push_back(ce);
+
+		u32 bucket = ce.hash & (bucket_count - 1);
+		while (buckets[bucket] != 0)
+			bucket = (bucket + 1) & (bucket_count - 1);
+		buckets[bucket] = static_cast<u32>(entries.size());
+	}
+
+	GameDatabaseCacheHeader header = {};
+	header.signature = GAMEDB_CACHE_SIGNATURE;
+	header.version = GAMEDB_CACHE_VERSION;
+	header.yaml_timestamp = yaml_timestamp;
+	header.gamefix_count = GamefixId_COUNT;
+	header.speedhack_count = SpeedhackId_COUNT;
+	header.gs_hw_fix_count = static_cast<u32>(GameDatabaseSchema::GSHWFixId::Count);
+	header.entry_count = static_cast<u32>(entries.size());
+	header.bucket_count = bucket_count;
+	header.data_size = static_cast<u32>(data.GetData().size());
+
+	std::vector<u8> file(sizeof(header) + entries.size() * sizeof(GameDatabaseCacheEntry) + buckets.size() * sizeof(u32) + data.GetData().size());
+	u8* pos = file.data();
+	std::memcpy(pos, &header, sizeof(header));
+	pos += sizeof(header);
+	std::memcpy(pos, entries.data(), entries.size() * sizeof(GameDatabaseCacheEntry));
+	pos += entries.size() * sizeof(GameDatabaseCacheEntry);
+	std::memcpy(pos, buckets.data(), buckets.size() * sizeof(u32));
+	pos += buckets.size() * sizeof(u32);
+	std::memcpy(pos, data.GetData().data(), data.GetData().size());
+
+	// Write to a temporary file and rename it over the old one, so that other instances starting
+	// at the same time never see a partially written database.
+	const std::string temp_filename = filename + ".tmp";
+	if (!FileSystem::WriteBinaryFile(temp_filename.c_str(), file.data(), file.size()) ||
+		!FileSystem::RenamePath(temp_filename.c_str(), filename.c_str()))
+	{
+		Console.Error("[GameDB] Failed to write cache to '%s'", filename.c_str());
+		FileSystem::DeleteFilePath(temp_filename.c_str());
+	}
+}
+
+const GameDatabaseSchema::GameEntry* GameDatabase::findGameInCache(const std::string& serial)
+{
+	const u32 hash = hashSerial(serial);
+	const u32 mask = s_cache_header->bucket_count - 1;
+	for (u32 bucket = hash & mask, probes = 0; probes < s_cache_header->bucket_count; bucket = (bucket + 1) & mask, probes++)
+	{
+		const u32 index = s_cache_buckets[bucket];
+		if (index == 0)
+			break;
+		if (index > s_cache_header->entry_count)
+			return nullptr;
+
+		const GameDatabaseCacheEntry& ce = s_cache_entries[index - 1];
+		if (ce.hash != hash || ce.serial_length != serial.size() ||
+			static_cast<u64>(ce.serial_offset) + ce.serial_length > s_cache_header->data_size ||
+			std::memcmp(s_cache_data + ce.serial_offset, serial.data(), serial.size()) != 0)
+		{
+			continue;
+		}
+
+		if (static_cast<u64>(ce.data_offset) + ce.data_length > s_cache_header->data_size)
+			return nullptr;
+
+		GameDatabaseSchema::GameEntry entry;
+		CacheReader reader(s_cache_data + ce.data_offset, ce.data_length);
+		if (!deserializeEntry(reader, &entry))
+		{
+			Console.Error(fmt::format("[GameDB] Cache entry for '{}' is corrupted.", serial));
+			return nullptr;
+		}
+
+		return &s_game_db.emplace(serial, std::move(entry)).first->second;
+	}
+
+	return nullptr;
+}
+
 void GameDatabase::initDatabase()
+{
+	// Use the compiled database if it was built from this copy of the YAML, otherwise parse the YAML
+	// and compile it for the next run.
+	const std::optional<std::time_t> yaml_timestamp = Host::GetResourceFileTimestamp(GAMEDB_YAML_FILE_NAME);
+	const std::string cache_filename = getCacheFileName();
+	const bool use_cache = yaml_timestamp.has_value() && !cache_filename.empty();
+	if (use_cache && openCache(cache_filename, static_cast<u64>(yaml_timestamp.value())))
+		return;
+
+	parseDatabase();
+
+	if (use_cache && !s_game_db.empty())
+		writeCache(cache_filename, static_cast<u64>(yaml_timestamp.value()));
+}
+
+void GameDatabase::parseDatabase()
 {
 	ryml::Callbacks rymlCallbacks = ryml::get_callbacks();
 	rymlCallbacks.m_error = [](const char* msg, size_t msg_len, ryml::Location loc, void*) {
@@ -978,7 +1430,8 @@ void GameDatabase::ensureLoaded()
 		Common::Timer timer;
 		Console.WriteLn(fmt::format("[GameDB] Has not been initialized yet, initializing..."));
 		initDatabase();
-		Console.WriteLn("[GameDB] %zu games on record (loaded in %.2fms)", s_game_db.size(), timer.GetTimeMilliseconds());
+		Console.WriteLn("[GameDB] %zu games on record (loaded%s in %.2fms)", s_cache_header ? s_cache_header->entry_count : s_game_db.size(),
+			s_cache_header ? " from cache" : "", timer.GetTimeMilliseconds());
 	});
 }
 
@@ -992,11 +1445,16 @@ const GameDatabaseSchema::GameEntry* GameDatabase::findGame(const std::string_vi
 		return nullptr;
 
 	Console.WriteLn(fmt::format("[GameDB] Searching for '{}' in GameDB", serialLower));
+	std::unique_lock lock(s_game_db_mutex);
 	const auto gameEntry = s_game_db.find(serialLower);
-	if (gameEntry != s_game_db.end())
+	const GameDatabaseSchema::GameEntry* result = (gameEntry != s_game_db.end()) ? &gameEntry->second :
+																			   (s_cache_header ? findGameInCache(serialLower) : nullptr);
+	lock.unlock();
+
+	if (result)
 	{
 		Console.WriteLn(fmt::format("[GameDB] Found '{}' in GameDB", serialLower));
-		return &gameEntry->second;
+		return result;
 	}
 
 	Console.Error(fmt::format("[GameDB] Could not find '{}' in GameDB", serialLower));
@@ -142,6 +142,11 @@ void SaveStateBase::ipuFreeze()
 	Freeze(coded_block_pattern);
 	Freeze(decoder);
 	Freeze(ipu_cmd);
+
+	// CSC and PACK don't save their converted output (g_ipu_indx4 in particular), so convert
+	// the macroblock again from its input before sending the rest of it.
+	if (IsLoading() && (ipu_cmd.CMD == SCE_IPU_CSC || ipu_cmd.CMD == SCE_IPU_PACK))
+		ipu_cmd.pos[2] = 0;
 }
 
 void tIPU_CMD_IDEC::log() const
@@ -78,8 +78,7 @@ alignas(16) const mpeg2_scan_pack mpeg2_scan = make_scan_pack();
 
 MULTI_ISA_UNSHARED_START
 
-static void ipu_csc(macroblock_8& mb8, macroblock_rgb32& rgb32, int sgn);
-static void ipu_vq(macroblock_rgb16& rgb16, u8* indx4);
+static void ipu_vq(macroblock_rgb16& rgb16, u8* indx4, int first_row, int last_row);
 
 // --------------------------------------------------------------------------------------
 //  Buffer reader
@@ -227,7 +226,8 @@ __fi static void BUTTERFLY(int& t0, int& t1, int w0, int w1, int d0, int d1)
 	t1 = tmp - (w1 + w0) * d0;
 }
 
-__ri static void IDCT_Block(s16* block)
+// conforming implementation for reference, the SIMD version below must match it bit for bit
+void IDCT_Block_reference(s16* block)
 {
 	for (int i = 0; i < 8; i++)
 	{
@@ -336,25 +336,195 @@ __ri static void IDCT_Block(s16* block)
 	}
 }
 
+// The vector IDCT works on 32-bit lanes, so every intermediate matches the scalar ints exactly.
+// With AVX2 a pass handles all eight rows (or columns) at once, otherwise it's split into two halves.
+#if _M_SSE >= 0x501
+typedef __m256i idct_vec;
+static constexpr int IDCT_HALVES = 1;
+
+__fi static idct_vec idct_add(idct_vec a, idct_vec b) { return _mm256_add_epi32(a, b); }
+__fi static idct_vec idct_sub(idct_vec a, idct_vec b) { return _mm256_sub_epi32(a, b); }
+__fi static idct_vec idct_mul(idct_vec a, int w) { return _mm256_mullo_epi32(a, _mm256_set1_epi32(w)); }
+__fi static idct_vec idct_set1(int v) { return _mm256_set1_epi32(v); }
+template <int N> __fi static idct_vec idct_sll(idct_vec a) { return _mm256_slli_epi32(a, N); }
+template <int N> __fi static idct_vec idct_sra(idct_vec a) { return _mm256_srai_epi32(a, N); }
+
+__fi static idct_vec idct_load(__m128i v, int half) { return _mm256_cvtepi16_epi32(v); }
+
+__fi static __m128i idct_pack(const idct_vec* v)
+{
+	const __m256i packed = _mm256_packs_epi32(v[0], v[0]);
+	return _mm256_castsi256_si128(_mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+}
+#else
+typedef __m128i idct_vec;
+static constexpr int IDCT_HALVES = 2;
+
+__fi static idct_vec idct_add(idct_vec a, idct_vec b) { return _mm_add_epi32(a, b); }
+__fi static idct_vec idct_sub(idct_vec a, idct_vec b) { return _mm_sub_epi32(a, b); }
+__fi static idct_vec idct_mul(idct_vec a, int w) { return _mm_mullo_epi32(a, _mm_set1_epi32(w)); }
+__fi static idct_vec idct_set1(int v) { return _mm_set1_epi32(v); }
+template <int N> __fi static idct_vec idct_sll(idct_vec a) { return _mm_slli_epi32(a, N); }
+template <int N> __fi static idct_vec idct_sra(idct_vec a) { return _mm_srai_epi32(a, N); }
+
+__fi static idct_vec idct_load(__m128i v, int half) { return _mm_cvtepi16_epi32(half ? _mm_srli_si128(v, 8) : v); }
+
+__fi static __m128i idct_pack(const idct_vec* v) { return _mm_packs_epi32(v[0], v[1]); }
+#endif
+
+__fi static void IDCT_BUTTERFLY(idct_vec& t0, idct_vec& t1, int w0, int w1, idct_vec d0, idct_vec d1)
+{
+	const idct_vec tmp = idct_mul(idct_add(d0, d1), w0);
+	t0 = idct_add(tmp, idct_mul(d1, w1 - w0));
+	t1 = idct_sub(tmp, idct_mul(d0, w1 + w0));
+}
+
+// One 1D pass of IDCT_Block_reference, x[k] holding coefficient k of each lane's row (or column).
+template <bool rows>
+__fi static void IDCT_Pass(idct_vec* x)
+{
+	idct_vec a0, a1, a2, a3;
+	{
+		const idct_vec d0 = idct_add(idct_sll<11>(x[0]), idct_set1(rows ? 128 : 65536));
+		const idct_vec d2 = idct_sll<11>(x[2]);
+		const idct_vec t0 = idct_add(d0, d2);
+		const idct_vec t1 = idct_sub(d0, d2);
+		idct_vec t2, t3;
+		IDCT_BUTTERFLY(t2, t3, W6, W2, x[3], x[1]);
+		a0 = idct_add(t0, t2);
+		a1 = idct_add(t1, t3);
+		a2 = idct_sub(t1, t3);
+		a3 = idct_sub(t0, t2);
+	}
+
+	idct_vec b0, b1, b2, b3;
+	{
+		idct_vec t0, t1, t2, t3;
+		IDCT_BUTTERFLY(t0, t1, W7, W1, x[7], x[4]);
+		IDCT_BUTTERFLY(t2, t3, W3, W5, x[5], x[6]);
+		b0 = idct_add(t0, t2);
+		b3 = idct_add(t1, t3);
+		t0 = idct_sub(t0, t2);
+		t1 = idct_sub(t1, t3);
+		if (rows)
+		{
+			b1 = idct_sra<8>(idct_mul(idct_add(t0, t1), 181));
+			b2 = idct_sra<8>(idct_mul(idct_sub(t0, t1), 181));
+		}
+		else
+		{
+			t0 = idct_sra<8>(t0);
+			t1 = idct_sra<8>(t1);
+			b1 = idct_mul(idct_add(t0, t1), 181);
+			b2 = idct_mul(idct_sub(t0, t1), 181);
+		}
+	}
+
+	x[0] = idct_add(a0, b0);
+	x[1] = idct_add(a1, b1);
+	x[2] = idct_add(a2, b2);
+	x[3] = idct_add(a3, b3);
+	x[4] = idct_sub(a3, b3);
+	x[5] = idct_sub(a2, b2);
+	x[6] = idct_sub(a1, b1);
+	x[7] = idct_sub(a0, b0);
+
+	for (int i = 0; i < 8; i++)
+	{
+		// The row pass stores (x >> 8) truncated to 16 bits, which is bits 8-23 sign extended.
+		// The column pass result (x >> 17) always fits, so the saturating pack never kicks in.
+		x[i] = rows ? idct_sra<16>(idct_sll<8>(x[i])) : idct_sra<17>(x[i]);
+	}
+}
+
+__fi static void IDCT_Transpose(__m128i* r)
+{
+	const __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+	const __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+	const __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+	const __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+	const __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+	const __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+	const __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+	const __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+	const __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+	const __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+	const __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+	const __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+	const __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+	const __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+	const __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+	const __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+	r[0] = _mm_unpacklo_epi64(b0, b4);
+	r[1] = _mm_unpackhi_epi64(b0, b4);
+	r[2] = _mm_unpacklo_epi64(b1, b5);
+	r[3] = _mm_unpackhi_epi64(b1, b5);
+	r[4] = _mm_unpacklo_epi64(b2, b6);
+	r[5] = _mm_unpackhi_epi64(b2, b6);
+	r[6] = _mm_unpacklo_epi64(b3, b7);
+	r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+// Runs a pass over eight lanes of 16-bit coefficients, r[k] holding coefficient k of each lane.
+template <bool rows>
+__fi static void IDCT_Pass8(__m128i* r)
+{
+	idct_vec x[IDCT_HALVES][8];
+	for (int half = 0; half < IDCT_HALVES; half++)
+	{
+		for (int i = 0; i < 8; i++)
+			x[half][i] = idct_load(r[i], half);
+
+		IDCT_Pass<rows>(x[half]);
+	}
+
+	for (int i = 0; i < 8; i++)
+	{
+		idct_vec halves[IDCT_HALVES];
+		for (int half = 0; half < IDCT_HALVES; half++)
+			halves[half] = x[half][i];
+
+		r[i] = idct_pack(halves);
+	}
+}
+
+__ri void IDCT_Block(s16* block)
+{
+	__m128i r[8];
+	for (int i = 0; i < 8; i++)
+		r[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(block + 8 * i));
+
+	// Lanes need to be rows for the row pass, so transpose in and out of it.
+	IDCT_Transpose(r);
+	IDCT_Pass8<true>(r);
+	IDCT_Transpose(r);
+	IDCT_Pass8<false>(r);
+
+	for (int i = 0; i < 8; i++)
+		_mm_store_si128(reinterpret_cast<__m128i*>(block + 8 * i), r[i]);
+}
+
 __ri static void IDCT_Copy(s16* block, u8* dest, const int stride)
 {
 	IDCT_Block(block);
 
-	for (int i = 0; i < 8; i++)
+	// Legal streams stay within the clip table's range, where saturating to 0-255 gives the same result.
+	const __m128i zero = _mm_setzero_si128();
+	for (int i = 0; i < 8; i += 2)
 	{
-		dest[0] = (g_idct_clip_lut.data() + 384)[block[0]];
-		dest[1] = (g_idct_clip_lut.data() + 384)[block[1]];
-		dest[2] = (g_idct_clip_lut.data() + 384)[block[2]];
-		dest[3] = (g_idct_clip_lut.data() + 384)[block[3]];
-		dest[4] = (g_idct_clip_lut.data() + 384)[block[4]];
-		dest[5] = (g_idct_clip_lut.data() + 384)[block[5]];
-		dest[6] = (g_idct_clip_lut.data() + 384)[block[6]];
-		dest[7] = (g_idct_clip_lut.data() + 384)[block[7]];
-
-		std::memset(block, 0, 16);
-
-		dest += stride;
-		block += 8;
+		const __m128i row0 = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+		const __m128i row1 = _mm_load_si128(reinterpret_cast<const __m128i*>(block + 8));
+		const __m128i pixels = _mm_packus_epi16(row0, row1);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dest), pixels);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dest + stride), _mm_unpackhi_epi64(pixels, pixels));
+
+		_mm_store_si128(reinterpret_cast<__m128i*>(block), zero);
+		_mm_store_si128(reinterpret_cast<__m128i*>(block + 8), zero);
+
+		dest += stride * 2;
+		block += 16;
 	}
 }
 
@@ -1106,13 +1276,13 @@ __ri static bool mpeg2sliceIDEC()
 				}
 
 				// Send The MacroBlock via DmaIpuFrom
-				ipu_csc(mb8, rgb32, decoder.sgn);
+				ipu_csc(mb8, rgb32, decoder.sgn, 0, 8);
 
 				if (decoder.ofm == 0)
 					decoder.SetOutputTo(rgb32);
 				else
 				{
-					ipu_dither(rgb32, rgb16, decoder.dte);
+					ipu_dither(rgb32, rgb16, decoder.dte, 0, 16);
 					decoder.SetOutputTo(rgb16);
 				}
 				[[fallthrough]];
@@ -1383,6 +1553,15 @@ __fi static bool mpeg2_slice()
 				//Cr bias	- 8 * 8
 				//Cb bias	- 8 * 8
 
+#if _M_SSE >= 0x501
+				for (uint i = 0; i < (256+64+64) / 16; ++i)
+				{
+					const __m128i src = _mm_load_si128((const __m128i*)s);
+					_mm256_storeu_si256((__m256i*)d, _mm256_cvtepu8_epi16(src));
+					s += 16;
+					d += 16;
+				}
+#else
 				__m128i zeroreg = _mm_setzero_si128();
 
 				for (uint i = 0; i < (256+64+64) / 32; ++i)
@@ -1397,6 +1576,7 @@ __fi static bool mpeg2_slice()
 					s += 32;
 					d += 32;
 				}
+#endif
 			}
 		}
 		else
@@ -1778,8 +1958,14 @@ __ri static bool ipuCSC(tIPU_CMD_CSC csc)
 			if (!getBits64((u8*)&decoder.mb8 + 8 * ipu_cmd.pos[0], 1)) return false;
 		}
 
-		ipu_csc(decoder.mb8, decoder.rgb32, 0);
-		if (csc.OFM) ipu_dither(decoder.rgb32, decoder.rgb16, csc.DTE);
+		// Only convert once per macroblock, not every time the FIFO fills up.
+		if (ipu_cmd.pos[2] == 0)
+		{
+			ipu_csc(decoder.mb8, decoder.rgb32, 0, 0, 8);
+			if (csc.OFM)
+				ipu_dither(decoder.rgb32, decoder.rgb16, csc.DTE, 0, 16);
+			ipu_cmd.pos[2] = 1;
+		}
 
 		if (csc.OFM)
 		{
@@ -1794,6 +1980,7 @@ __ri static bool ipuCSC(tIPU_CMD_CSC csc)
 
 		ipu_cmd.pos[0] = 0;
 		ipu_cmd.pos[1] = 0;
+		ipu_cmd.pos[2] = 0;
 	}
 
 	return true;
@@ -1810,9 +1997,13 @@ __ri static bool ipuPACK(tIPU_CMD_CSC csc)
 			if (!getBits64((u8*)&decoder.rgb32 + 8 * ipu_cmd.pos[0], 1)) return false;
 		}
 
-		ipu_dither(decoder.rgb32, decoder.rgb16, csc.DTE);
-
-		if (!csc.OFM) ipu_vq(decoder.rgb16, g_ipu_indx4);
+		if (ipu_cmd.pos[2] == 0)
+		{
+			ipu_dither(decoder.rgb32, decoder.rgb16, csc.DTE, 0, 16);
+			if (!csc.OFM)
+				ipu_vq(decoder.rgb16, g_ipu_indx4, 0, 16);
+			ipu_cmd.pos[2] = 1;
+		}
 
 		if (csc.OFM)
 		{
@@ -1827,6 +2018,7 @@ __ri static bool ipuPACK(tIPU_CMD_CSC csc)
 
 		ipu_cmd.pos[0] = 0;
 		ipu_cmd.pos[1] = 0;
+		ipu_cmd.pos[2] = 0;
 	}
 
 	return true;
@@ -1836,41 +2028,46 @@ __ri static bool ipuPACK(tIPU_CMD_CSC csc)
 //  CORE Functions (referenced from MPEG library)
 // --------------------------------------------------------------------------------------
 
-__fi static void ipu_csc(macroblock_8& mb8, macroblock_rgb32& rgb32, int sgn)
+// Converts the pairs of rows [first, last) of mb8, which share chroma rows first to last - 1.
+void ipu_csc(macroblock_8& mb8, macroblock_rgb32& rgb32, int sgn, int first, int last)
 {
-	int i;
-	u8* p = (u8*)&rgb32;
-
-	yuv2rgb();
-
-	if (g_ipu_thresh[0] > 0)
+	yuv2rgb(first, last);
+
+	if (g_ipu_thresh[0] == 0 && g_ipu_thresh[1] == 0 && !sgn)
+		return;
+
+	// Pixels with all of R, G and B below thresh[0] become transparent black, otherwise
+	// below thresh[1] they get half alpha. With thresh[0] at zero only the second test can pass.
+	const __m128i thresh0 = _mm_set1_epi32(g_ipu_thresh[0]);
+	const __m128i thresh1 = _mm_set1_epi32(g_ipu_thresh[1]);
+	const __m128i low_byte = _mm_set1_epi32(0xFF);
+	const __m128i alpha_mask = _mm_set1_epi32(0xFF000000);
+	const __m128i alpha_40 = _mm_set1_epi32(0x40000000);
+	const __m128i sign = _mm_set1_epi32(sgn ? 0x808080 : 0);
+	const bool thresholds = (g_ipu_thresh[0] > 0 || g_ipu_thresh[1] > 0);
+
+	// 8 vectors of 4 pixels per pair of rows
+	__m128i* p = reinterpret_cast<__m128i*>(&rgb32);
+	for (int i = first * 8; i < last * 8; i++)
 	{
-		for (i = 0; i < 16*16; i++, p += 4)
-		{
-			if ((p[0] < g_ipu_thresh[0]) && (p[1] < g_ipu_thresh[0]) && (p[2] < g_ipu_thresh[0]))
-				*(u32*)p = 0;
-			else if ((p[0] < g_ipu_thresh[1]) && (p[1] < g_ipu_thresh[1]) && (p[2] < g_ipu_thresh[1]))
-				p[3] = 0x40;
-		}
-	}
-	else if (g_ipu_thresh[1] > 0)
-	{
-		for (i = 0; i < 16*16; i++, p += 4)
-		{
-			if ((p[0] < g_ipu_thresh[1]) && (p[1] < g_ipu_thresh[1]) && (p[2] < g_ipu_thresh[1]))
-				p[3] = 0x40;
-		}
-	}
-	if (sgn)
-	{
-		for (i = 0; i < 16*16; i++, p += 4)
+		__m128i rgba = _mm_load_si128(p + i);
+
+		if (thresholds)
 		{
-			*(u32*)p ^= 0x808080;
+			__m128i max_rgb = _mm_max_epu8(rgba, _mm_srli_epi32(rgba, 8));
+			max_rgb = _mm_and_si128(_mm_max_epu8(max_rgb, _mm_srli_epi32(rgba, 16)), low_byte);
+
+			const __m128i below0 = _mm_cmplt_epi32(max_rgb, thresh0);
+			const __m128i below1 = _mm_andnot_si128(below0, _mm_cmplt_epi32(max_rgb, thresh1));
+			rgba = _mm_andnot_si128(below0, rgba);
+			rgba = _mm_or_si128(_mm_andnot_si128(_mm_and_si128(below1, alpha_mask), rgba), _mm_and_si128(below1, alpha_40));
 		}
+
+		_mm_store_si128(p + i, _mm_xor_si128(rgba, sign));
 	}
 }
 
-__fi static void ipu_vq(macroblock_rgb16& rgb16, u8* indx4)
+__fi static void ipu_vq(macroblock_rgb16& rgb16, u8* indx4, int first_row, int last_row)
 {
 	const auto closest_index = [&](int i, int j) {
 		u8 index = 0;
@@ -1893,7 +2090,7 @@ __fi static void ipu_vq(macroblock_rgb16& rgb16, u8* indx4)
 		return index;
 	};
 
-	for (int i = 0; i < 16; ++i)
+	for (int i = first_row; i < last_row; ++i)
 		for (int j = 0; j < 8; ++j)
 			indx4[i * 8 + j] = closest_index(i, 2 * j + 1) << 4 | closest_index(i, 2 * j);
 }
@@ -154,7 +154,18 @@ alignas(16) extern decoder_t decoder;
 alignas(16) extern tIPU_BP g_BP;
 
 MULTI_ISA_DEF(
-	extern void ipu_dither(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte);
+	/// Converts rows [first_row, last_row) of rgb32 to rgb16, dithering them if dte is set.
+	extern void ipu_dither(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte, int first_row, int last_row);
+	extern void ipu_dither_reference(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte, int first_row, int last_row);
+	extern void ipu_dither_sse2(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte, int first_row, int last_row);
+	extern void ipu_dither_avx2(const macroblock_rgb32& rgb32, macroblock_rgb16& rgb16, int dte, int first_row, int last_row);
+
+	/// Converts the chroma rows [first, last) of decoder.mb8 into rgb32, then applies the thresholds and sign.
+	extern void ipu_csc(macroblock_8& mb8, macroblock_rgb32& rgb32, int sgn, int first, int last);
+
+	/// Inverse transforms an 8x8 block of coefficients in place.
+	extern void IDCT_Block(s16* block);
+	extern void IDCT_Block_reference(s16* block);
 
 	void IPUWorker();
 )
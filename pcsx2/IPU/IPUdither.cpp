@@ -23,15 +23,16 @@
 
 MULTI_ISA_UNSHARED_START
 
-void ipu_dither_reference(const macroblock_rgb32 &rgb32, macroblock_rgb16 &rgb16, int dte);
-void ipu_dither_sse2(const macroblock_rgb32 &rgb32, macroblock_rgb16 &rgb16, int dte);
-
-__ri void ipu_dither(const macroblock_rgb32 &rgb32, macroblock_rgb16 &rgb16, int dte)
+__ri void ipu_dither(const macroblock_rgb32 &rgb32, macroblock_rgb16 &rgb16, int dte, int first_row, int last_row)
 {
-    ipu_dither_sse2(rgb32, rgb16, dte);
+#if _M_SSE >= 0x501
+    ipu_dither_avx2(rgb32, rgb16, dte, first_row, last_row);
+#else
+    ipu_dither_sse2(rgb32, rgb16, dte, first_row, last_row);
+#endif
 }
 
-__ri void ipu_dither_reference(const macroblock_rgb32 &rgb32, macroblock_rgb16 &rgb16, int dte)
+__ri void ipu_dither_reference(const macroblock_rgb32 &rgb32, macroblock_rgb16 &rgb16, int dte, int first_row, int last_row)
 {
     if (dte) {
         // I'm guessing values are rounded down when clamping.
@@ -41,7 +42,7 @@ __ri void ipu_dither_reference(const macroblock_rgb32 &rgb32, macroblock_rgb16 &
             {-3, 1, -4, 0},
             {3, -1, 2, -2},
         };
-        for (int i = 0; i < 16; ++i) {
+        for (int i = first_row; i < last_row; ++i) {
             for (int j = 0; j < 16; ++j) {
                 const int dither = dither_coefficient[i & 3][j & 3];
                 const int r = std::max(0, std::min(rgb32.c[i][j].r + dither, 255));
@@ -55,7 +56,7 @@ __ri void ipu_dither_reference(const macroblock_rgb32 &rgb32, macroblock_rgb16 &
             }
         }
     } else {
-        for (int i = 0; i < 16; ++i) {
+        for (int i = first_row; i < last_row; ++i) {
             for (int j = 0; j < 16; ++j) {
                 rgb16.c[i][j].r = rgb32.c[i][j].r >> 3;
                 rgb16.c[i][j].g = rgb32.c[i][j].g >> 3;
@@ -66,7 +67,7 @@ __ri void ipu_dither_reference(const macroblock_rgb32 &rgb32, macroblock_rgb16 &
     }
 }
 
-__ri void ipu_dither_sse2(const macroblock_rgb32 &rgb32, macroblock_rgb16 &rgb16, int dte)
+__ri void ipu_dither_sse2(const macroblock_rgb32 &rgb32, macroblock_rgb16 &rgb16, int dte, int first_row, int last_row)
 {
     const __m128i alpha_test = _mm_set1_epi16(0x40);
     const __m128i dither_add_matrix[] = {
@@ -81,7 +82,7 @@ __ri void ipu_dither_sse2(const macroblock_rgb32 &rgb32, macroblock_rgb16 &rgb16
         _mm_setr_epi32(0x00030303, 0x00000000, 0x00040404, 0x00000000),
         _mm_setr_epi32(0x00000000, 0x00010101, 0x00000000, 0x00020202),
     };
-    for (int i = 0; i < 16; ++i) {
+    for (int i = first_row; i < last_row; ++i) {
         const __m128i dither_add = dither_add_matrix[i & 3];
         const __m128i dither_sub = dither_sub_matrix[i & 3];
         for (int n = 0; n < 2; ++n) {
@@ -123,4 +124,62 @@ __ri void ipu_dither_sse2(const macroblock_rgb32 &rgb32, macroblock_rgb16 &rgb16
     }
 }
 
+#if _M_SSE >= 0x501
+// ipu_dither_sse2 on a whole row at a time. The unpacks work per 128-bit lane, which leaves
+// pixels 0-3 and 8-11 in the low lane, so the 64-bit groups are put back in order at the end.
+__ri void ipu_dither_avx2(const macroblock_rgb32 &rgb32, macroblock_rgb16 &rgb16, int dte, int first_row, int last_row)
+{
+    const __m256i alpha_test = _mm256_set1_epi16(0x40);
+    const __m128i dither_add_matrix[] = {
+        _mm_setr_epi32(0x00000000, 0x00000000, 0x00000000, 0x00010101),
+        _mm_setr_epi32(0x00020202, 0x00000000, 0x00030303, 0x00000000),
+        _mm_setr_epi32(0x00000000, 0x00010101, 0x00000000, 0x00000000),
+        _mm_setr_epi32(0x00030303, 0x00000000, 0x00020202, 0x00000000),
+    };
+    const __m128i dither_sub_matrix[] = {
+        _mm_setr_epi32(0x00040404, 0x00000000, 0x00030303, 0x00000000),
+        _mm_setr_epi32(0x00000000, 0x00020202, 0x00000000, 0x00010101),
+        _mm_setr_epi32(0x00030303, 0x00000000, 0x00040404, 0x00000000),
+        _mm_setr_epi32(0x00000000, 0x00010101, 0x00000000, 0x00020202),
+    };
+    for (int i = first_row; i < last_row; ++i) {
+        const __m256i dither_add = _mm256_broadcastsi128_si256(dither_add_matrix[i & 3]);
+        const __m256i dither_sub = _mm256_broadcastsi128_si256(dither_sub_matrix[i & 3]);
+
+        __m256i rgba_8_0_7 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&rgb32.c[i][0]));
+        __m256i rgba_8_8_15 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&rgb32.c[i][8]));
+
+        // Dither and clamp
+        if (dte) {
+            rgba_8_0_7 = _mm256_subs_epu8(_mm256_adds_epu8(rgba_8_0_7, dither_add), dither_sub);
+            rgba_8_8_15 = _mm256_subs_epu8(_mm256_adds_epu8(rgba_8_8_15, dither_add), dither_sub);
+        }
+
+        // Split into channel components and extend to 16 bits
+        const __m256i rgba_16_lo = _mm256_unpacklo_epi8(rgba_8_0_7, rgba_8_8_15);
+        const __m256i rgba_16_hi = _mm256_unpackhi_epi8(rgba_8_0_7, rgba_8_8_15);
+        const __m256i rgba_32_even = _mm256_unpacklo_epi8(rgba_16_lo, rgba_16_hi);
+        const __m256i rgba_32_odd = _mm256_unpackhi_epi8(rgba_16_lo, rgba_16_hi);
+        const __m256i rg_64 = _mm256_unpacklo_epi8(rgba_32_even, rgba_32_odd);
+        const __m256i ba_64 = _mm256_unpackhi_epi8(rgba_32_even, rgba_32_odd);
+
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i r = _mm256_unpacklo_epi8(rg_64, zero);
+        __m256i g = _mm256_unpackhi_epi8(rg_64, zero);
+        __m256i b = _mm256_unpacklo_epi8(ba_64, zero);
+        __m256i a = _mm256_unpackhi_epi8(ba_64, zero);
+
+        // Create RGBA
+        r = _mm256_srli_epi16(r, 3);
+        g = _mm256_slli_epi16(_mm256_srli_epi16(g, 3), 5);
+        b = _mm256_slli_epi16(_mm256_srli_epi16(b, 3), 10);
+        a = _mm256_slli_epi16(_mm256_cmpeq_epi16(a, alpha_test), 15);
+
+        const __m256i rgba16 = _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, a));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(&rgb16.c[i][0]), _mm256_permute4x64_epi64(rgba16, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+}
+#endif
+
 MULTI_ISA_UNSHARED_END
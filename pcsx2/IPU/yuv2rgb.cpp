@@ -38,13 +38,16 @@
 
 MULTI_ISA_UNSHARED_START
 
+// Each function converts the chroma rows [first, last) of decoder.mb8, and the pairs of luma rows which
+// share them, into decoder.rgb32. Passing 0 and 8 converts the whole macroblock.
+
 // conforming implementation for reference, do not optimise
-void yuv2rgb_reference(void)
+void yuv2rgb_reference(int first, int last)
 {
 	const macroblock_8& mb8 = decoder.mb8;
 	macroblock_rgb32& rgb32 = decoder.rgb32;
 
-	for (int y = 0; y < 16; y++)
+	for (int y = first * 2; y < last * 2; y++)
 		for (int x = 0; x < 16; x++)
 		{
 			s32 lum = (IPU_Y_COEFF * (std::max(0, (s32)mb8.Y[y][x] - IPU_Y_BIAS))) >> 6;
@@ -61,10 +64,7 @@ void yuv2rgb_reference(void)
 }
 
 // Suikoden Tactics FMV speed results: Reference - ~72fps, SSE2 - ~120fps
-// An AVX2 version is only slightly faster than an SSE2 version (+2-3fps)
-// (or I'm a poor optimiser), though it might be worth attempting again
-// once we've ported to 64 bits (the extra registers should help).
-__ri void yuv2rgb_sse2()
+__ri void yuv2rgb_sse2(int first, int last)
 {
 	const __m128i c_bias = _mm_set1_epi8(s8(IPU_C_BIAS));
 	const __m128i y_bias = _mm_set1_epi8(IPU_Y_BIAS);
@@ -82,7 +82,7 @@ __ri void yuv2rgb_sse2()
 	// Alpha set to 0x80 here. The threshold stuff is done later.
 	const __m128i& alpha = c_bias;
 
-	for (int n = 0; n < 8; ++n) {
+	for (int n = first; n < last; ++n) {
 		// could skip the loadl_epi64 but most SSE instructions require 128-bit
 		// alignment so two versions would be needed.
 		__m128i cb = _mm_loadl_epi64(reinterpret_cast<__m128i*>(&decoder.mb8.Cb[n][0]));
@@ -152,4 +152,87 @@ __ri void yuv2rgb_sse2()
 	}
 }
 
+#if _M_SSE >= 0x501
+// Same arithmetic as yuv2rgb_sse2, with both luma rows sharing a chroma row converted together,
+// one per 128-bit lane. Every AVX2 instruction used here stays within its lane, so the results match.
+__ri void yuv2rgb_avx2(int first, int last)
+{
+	const __m256i c_bias = _mm256_set1_epi8(s8(IPU_C_BIAS));
+	const __m256i y_bias = _mm256_set1_epi8(IPU_Y_BIAS);
+	const __m256i y_mask = _mm256_set1_epi16(s16(0xFF00));
+	const __m256i round_1bit = _mm256_set1_epi16(0x0001);
+
+	const __m256i y_coefficient = _mm256_set1_epi16(s16(IPU_Y_COEFF << 2));
+	const __m256i gcr_coefficient = _mm256_set1_epi16(s16(u16(IPU_GCR_COEFF) << 2));
+	const __m256i gcb_coefficient = _mm256_set1_epi16(s16(u16(IPU_GCB_COEFF) << 2));
+	const __m256i rcr_coefficient = _mm256_set1_epi16(s16(IPU_RCR_COEFF << 2));
+	const __m256i bcb_coefficient = _mm256_set1_epi16(s16(IPU_BCB_COEFF << 2));
+
+	const __m256i& alpha = c_bias;
+
+	for (int n = first; n < last; ++n) {
+		__m256i cb = _mm256_broadcastq_epi64(_mm_loadl_epi64(reinterpret_cast<__m128i*>(&decoder.mb8.Cb[n][0])));
+		__m256i cr = _mm256_broadcastq_epi64(_mm_loadl_epi64(reinterpret_cast<__m128i*>(&decoder.mb8.Cr[n][0])));
+
+		// (Cb - 128) << 8, (Cr - 128) << 8
+		cb = _mm256_xor_si256(cb, c_bias);
+		cr = _mm256_xor_si256(cr, c_bias);
+		cb = _mm256_unpacklo_epi8(_mm256_setzero_si256(), cb);
+		cr = _mm256_unpacklo_epi8(_mm256_setzero_si256(), cr);
+
+		const __m256i rc = _mm256_mulhi_epi16(cr, rcr_coefficient);
+		const __m256i gc = _mm256_adds_epi16(_mm256_mulhi_epi16(cr, gcr_coefficient), _mm256_mulhi_epi16(cb, gcb_coefficient));
+		const __m256i bc = _mm256_mulhi_epi16(cb, bcb_coefficient);
+
+		// luma rows n * 2 and n * 2 + 1 go in the low and high lanes
+		__m256i y = _mm256_inserti128_si256(
+			_mm256_castsi128_si256(_mm_load_si128(reinterpret_cast<__m128i*>(&decoder.mb8.Y[n * 2][0]))),
+			_mm_load_si128(reinterpret_cast<__m128i*>(&decoder.mb8.Y[n * 2 + 1][0])), 1);
+		y = _mm256_subs_epu8(y, y_bias);
+		__m256i y_even = _mm256_mulhi_epu16(_mm256_slli_epi16(y, 8), y_coefficient);
+		__m256i y_odd = _mm256_mulhi_epu16(_mm256_and_si256(y, y_mask), y_coefficient);
+
+		__m256i r_even = _mm256_adds_epi16(rc, y_even);
+		__m256i r_odd  = _mm256_adds_epi16(rc, y_odd);
+		__m256i g_even = _mm256_adds_epi16(gc, y_even);
+		__m256i g_odd  = _mm256_adds_epi16(gc, y_odd);
+		__m256i b_even = _mm256_adds_epi16(bc, y_even);
+		__m256i b_odd  = _mm256_adds_epi16(bc, y_odd);
+
+		// round
+		r_even = _mm256_srai_epi16(_mm256_add_epi16(r_even, round_1bit), 1);
+		r_odd  = _mm256_srai_epi16(_mm256_add_epi16(r_odd,  round_1bit), 1);
+		g_even = _mm256_srai_epi16(_mm256_add_epi16(g_even, round_1bit), 1);
+		g_odd  = _mm256_srai_epi16(_mm256_add_epi16(g_odd,  round_1bit), 1);
+		b_even = _mm256_srai_epi16(_mm256_add_epi16(b_even, round_1bit), 1);
+		b_odd  = _mm256_srai_epi16(_mm256_add_epi16(b_odd,  round_1bit), 1);
+
+		// combine even and odd bytes in original order
+		__m256i r = _mm256_packus_epi16(r_even, r_odd);
+		__m256i g = _mm256_packus_epi16(g_even, g_odd);
+		__m256i b = _mm256_packus_epi16(b_even, b_odd);
+
+		r = _mm256_unpacklo_epi8(r, _mm256_shuffle_epi32(r, _MM_SHUFFLE(3, 2, 3, 2)));
+		g = _mm256_unpacklo_epi8(g, _mm256_shuffle_epi32(g, _MM_SHUFFLE(3, 2, 3, 2)));
+		b = _mm256_unpacklo_epi8(b, _mm256_shuffle_epi32(b, _MM_SHUFFLE(3, 2, 3, 2)));
+
+		const __m256i rg_l = _mm256_unpacklo_epi8(r, g);
+		const __m256i ba_l = _mm256_unpacklo_epi8(b, alpha);
+		const __m256i rgba_ll = _mm256_unpacklo_epi16(rg_l, ba_l);
+		const __m256i rgba_lh = _mm256_unpackhi_epi16(rg_l, ba_l);
+
+		const __m256i rg_h = _mm256_unpackhi_epi8(r, g);
+		const __m256i ba_h = _mm256_unpackhi_epi8(b, alpha);
+		const __m256i rgba_hl = _mm256_unpacklo_epi16(rg_h, ba_h);
+		const __m256i rgba_hh = _mm256_unpackhi_epi16(rg_h, ba_h);
+
+		// low lanes hold the first row, high lanes the second
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(&decoder.rgb32.c[n * 2][0]), _mm256_permute2x128_si256(rgba_ll, rgba_lh, 0x20));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(&decoder.rgb32.c[n * 2][8]), _mm256_permute2x128_si256(rgba_hl, rgba_hh, 0x20));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(&decoder.rgb32.c[n * 2 + 1][0]), _mm256_permute2x128_si256(rgba_ll, rgba_lh, 0x31));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(&decoder.rgb32.c[n * 2 + 1][8]), _mm256_permute2x128_si256(rgba_hl, rgba_hh, 0x31));
+	}
+}
+#endif
+
 MULTI_ISA_UNSHARED_END
@@ -17,7 +17,12 @@
 
 #include "GS/MultiISA.h"
 
-MULTI_ISA_DEF(extern void yuv2rgb_reference();)
+MULTI_ISA_DEF(extern void yuv2rgb_reference(int first, int last);)
 
+#if _M_SSE >= 0x501
+#define yuv2rgb yuv2rgb_avx2
+#else
 #define yuv2rgb yuv2rgb_sse2
-MULTI_ISA_DEF(extern void yuv2rgb_sse2();)
+#endif
+MULTI_ISA_DEF(extern void yuv2rgb_sse2(int first, int last);)
+MULTI_ISA_DEF(extern void yuv2rgb_avx2(int first, int last);)
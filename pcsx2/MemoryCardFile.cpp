@@ -15,6 +15,7 @@
 
 #include "PrecompiledHeader.h"
 #include "common/FileSystem.h"
+#include "common/General.h"
 #include "common/SafeArray.inl"
 #include "common/Path.h"
 #include "common/StringUtil.h"
@@ -174,6 +175,14 @@ protected:
 	bool m_ispsx[8];
 	u32 m_chkaddr;
 
+	// PS2 cards of 8MB and more are mapped into memory instead of being accessed through m_file
+	u8* m_mapping[8] = {};
+	size_t m_mappingSize[8] = {};
+
+	// range of the mapping written since the last NextFrame(), written back to the file in one go
+	u32 m_dirtyStart[8] = {};
+	u32 m_dirtyEnd[8] = {};
+
 public:
 	FileMemoryCard();
 	virtual ~FileMemoryCard() = default;
@@ -191,10 +200,15 @@ public:
 	s32 Save(uint slot, const u8* src, u32 adr, int size);
 	s32 EraseBlock(uint slot, u32 adr);
 	u64 GetCRC(uint slot);
+	void NextFrame(uint slot);
 
 protected:
 	bool Seek(std::FILE* f, u32 adr);
 	bool Create(const char* mcdFile, uint sizeInMB);
+
+	// maps the card file if it's large enough, otherwise opens it for file access
+	void OpenCardFile(uint slot, const std::string& path);
+	void MarkDirty(uint slot, u32 adr, u32 size);
 };
 
 uint FileMcd_GetMtapPort(uint slot)
@@ -335,14 +349,14 @@ void FileMemoryCard::Open()
 			}
 
 			// store the original filename
-			m_file[slot] = FileSystem::OpenSharedCFile(newname.c_str(), "r+b", FileSystem::FileShareMode::DenyWrite);
+			OpenCardFile(slot, newname);
 		}
 		else
 		{
-			m_file[slot] = FileSystem::OpenSharedCFile(fname.c_str(), "r+b", FileSystem::FileShareMode::DenyWrite);
+			OpenCardFile(slot, fname);
 		}
 
-		if (!m_file[slot])
+		if (!m_file[slot] && !m_mapping[slot])
 		{
 			// Translation note: detailed description should mention that the memory card will be disabled
 			// for the duration of this session.
@@ -356,6 +370,13 @@ void FileMemoryCard::Open()
 #endif
 				);
 		}
+		else if (m_mapping[slot]) // Load checksum
+		{
+			m_filenames[slot] = std::move(fname);
+			m_ispsx[slot] = false;
+			m_chkaddr = 0x210;
+			std::memcpy(&m_chksum[slot], m_mapping[slot] + m_chkaddr, sizeof(m_chksum[slot]));
+		}
 		else // Load checksum
 		{
 			m_filenames[slot] = std::move(fname);
@@ -376,15 +397,34 @@ void FileMemoryCard::Close()
 {
 	for (int slot = 0; slot < 8; ++slot)
 	{
-		if (!m_file[slot])
-			continue;
-
-		// Store checksum
-		if (!m_ispsx[slot] && FileSystem::FSeek64(m_file[slot], m_chkaddr, SEEK_SET) == 0)
-			std::fwrite(&m_chksum[slot], sizeof(m_chksum[slot]), 1, m_file[slot]);
+		if (m_mapping[slot])
+		{
+			// Store checksum
+			std::memcpy(m_mapping[slot] + m_chkaddr, &m_chksum[slot], sizeof(m_chksum[slot]));
+
+			HostSys::FlushMappedFile(m_mapping[slot], m_mappingSize[slot]);
+			HostSys::UnmapFile(m_mapping[slot], m_mappingSize[slot]);
+			m_mapping[slot] = nullptr;
+			m_mappingSize[slot] = 0;
+			m_dirtyStart[slot] = 0;
+			m_dirtyEnd[slot] = 0;
+
+			std::fclose(m_file[slot]);
+			m_file[slot] = nullptr;
+		}
+		else if (m_file[slot])
+		{
+			// Store checksum
+			if (!m_ispsx[slot] && FileSystem::FSeek64(m_file[slot], m_chkaddr, SEEK_SET) == 0)
+				std::fwrite(&m_chksum[slot], sizeof(m_chksum[slot]), 1, m_file[slot]);
 
-		std::fclose(m_file[slot]);
-		m_file[slot] = nullptr;
+			std::fclose(m_file[slot]);
+			m_file[slot] = nullptr;
+		}
+		else
+		{
+			continue;
+		}
 
 		if (StringUtil::EndsWith(m_filenames[slot], ".bin"))
 		{
@@ -397,6 +437,39 @@ void FileMemoryCard::Close()
 	}
 }
 
+void FileMemoryCard::OpenCardFile(uint slot, const std::string& path)
+{
+	// The file stays open while it's mapped, so nothing else can write to the card behind our back.
+	m_file[slot] = FileSystem::OpenSharedCFile(path.c_str(), "r+b", FileSystem::FileShareMode::DenyWrite);
+	if (!m_file[slot])
+		return;
+
+	// Games read the whole card page by page at boot, which is a seek and a read each with file access.
+	if (FileSystem::FSize64(m_file[slot]) >= 8 * MC2_MBSIZE)
+	{
+		size_t size;
+		m_mapping[slot] = static_cast<u8*>(HostSys::MapFile(m_file[slot], true, &size));
+		if (m_mapping[slot])
+			m_mappingSize[slot] = size;
+		else
+			Console.Warning("(FileMcd) Could not map %s, using file access.", path.c_str());
+	}
+}
+
+void FileMemoryCard::MarkDirty(uint slot, u32 adr, u32 size)
+{
+	if (m_dirtyEnd[slot] == 0)
+	{
+		m_dirtyStart[slot] = adr;
+		m_dirtyEnd[slot] = adr + size;
+	}
+	else
+	{
+		m_dirtyStart[slot] = std::min(m_dirtyStart[slot], adr);
+		m_dirtyEnd[slot] = std::max(m_dirtyEnd[slot], adr + size);
+	}
+}
+
 // Returns FALSE if the seek failed (is outside the bounds of the file).
 bool FileMemoryCard::Seek(std::FILE* f, u32 adr)
 {
@@ -441,7 +514,7 @@ bool FileMemoryCard::Create(const char* mcdFile, uint sizeInMB)
 
 s32 FileMemoryCard::IsPresent(uint slot)
 {
-	return m_file[slot] != nullptr;
+	return m_file[slot] != nullptr || m_mapping[slot] != nullptr;
 }
 
 void FileMemoryCard::GetSizeInfo(uint slot, McdSizeInfo& outways)
@@ -450,7 +523,9 @@ void FileMemoryCard::GetSizeInfo(uint slot, McdSizeInfo& outways)
 	outways.EraseBlockSizeInSectors = 16; // 0x0010
 	outways.Xor = 18;                     // 0x12, XOR 02 00 00 10
 
-	if (pxAssert(m_file[slot]))
+	if (m_mapping[slot])
+		outways.McdSizeInSectors = static_cast<u32>(m_mappingSize[slot]) / (outways.SectorSize + outways.EraseBlockSizeInSectors);
+	else if (pxAssert(m_file[slot]))
 		outways.McdSizeInSectors = static_cast<u32>(FileSystem::FSize64(m_file[slot])) / (outways.SectorSize + outways.EraseBlockSizeInSectors);
 	else
 		outways.McdSizeInSectors = 0x4000;
@@ -466,6 +541,14 @@ bool FileMemoryCard::IsPSX(uint slot)
 
 s32 FileMemoryCard::Read(uint slot, u8* dest, u32 adr, int size)
 {
+	if (m_mapping[slot])
+	{
+		if (static_cast<u64>(adr) + size > m_mappingSize[slot])
+			return 0;
+		std::memcpy(dest, m_mapping[slot] + adr, size);
+		return 1;
+	}
+
 	std::FILE* mcfp = m_file[slot];
 	if (!mcfp)
 	{
@@ -478,8 +561,56 @@ s32 FileMemoryCard::Read(uint slot, u8* dest, u32 adr, int size)
 	return std::fread(dest, size, 1, mcfp) == 1;
 }
 
+static void ReportCardSaved(uint slot, const std::string& filename)
+{
+	static auto last = std::chrono::time_point<std::chrono::system_clock>();
+
+	std::chrono::duration<float> elapsed = std::chrono::system_clock::now() - last;
+	if (elapsed > std::chrono::seconds(5))
+	{
+		Host::AddIconOSDMessage(fmt::format("MemoryCardSave{}", slot), ICON_FA_SD_CARD,
+			fmt::format("Memory card '{}' was saved to storage.", Path::GetFileName(filename)),
+			Host::OSD_INFO_DURATION);
+		last = std::chrono::system_clock::now();
+	}
+}
+
 s32 FileMemoryCard::Save(uint slot, const u8* src, u32 adr, int size)
 {
+	if (m_mapping[slot])
+	{
+		if (static_cast<u64>(adr) + size > m_mappingSize[slot])
+			return 0;
+
+		// Writes go straight into the mapping. The protocol writes a page and its ECC separately,
+		// both end up in the dirty range and are written back together on the next frame.
+		u8* dest = m_mapping[slot] + adr;
+		for (int i = 0; i < size; i++)
+		{
+			if ((dest[i] & src[i]) != src[i])
+				Console.Warning("(FileMcd) Warning: writing to uncleared data. (%d) [%08X]", slot, adr);
+			dest[i] &= src[i];
+		}
+
+		// Checksumness
+		{
+			if (adr == m_chkaddr)
+				Console.Warning("(FileMcd) Warning: checksum sector overwritten. (%d)", slot);
+
+			const u32 loops = size / 8;
+			for (u32 i = 0; i < loops; i++)
+			{
+				u64 data;
+				std::memcpy(&data, dest + i * 8, sizeof(data));
+				m_chksum[slot] ^= data;
+			}
+		}
+
+		MarkDirty(slot, adr, size);
+		ReportCardSaved(slot, m_filenames[slot]);
+		return 1;
+	}
+
 	std::FILE* mcfp = m_file[slot];
 
 	if (!mcfp)
@@ -529,16 +660,7 @@ s32 FileMemoryCard::Save(uint slot, const u8* src, u32 adr, int size)
 
 	if (std::fwrite(m_currentdata.GetPtr(), size, 1, mcfp) == 1)
 	{
-		static auto last = std::chrono::time_point<std::chrono::system_clock>();
-
-		std::chrono::duration<float> elapsed = std::chrono::system_clock::now() - last;
-		if (elapsed > std::chrono::seconds(5))
-		{
-			Host::AddIconOSDMessage(fmt::format("MemoryCardSave{}", slot), ICON_FA_SD_CARD,
-				fmt::format("Memory card '{}' was saved to storage.", Path::GetFileName(m_filenames[slot])),
-				Host::OSD_INFO_DURATION);
-			last = std::chrono::system_clock::now();
-		}
+		ReportCardSaved(slot, m_filenames[slot]);
 		return 1;
 	}
 
@@ -547,6 +669,15 @@ s32 FileMemoryCard::Save(uint slot, const u8* src, u32 adr, int size)
 
 s32 FileMemoryCard::EraseBlock(uint slot, u32 adr)
 {
+	if (m_mapping[slot])
+	{
+		if (static_cast<u64>(adr) + sizeof(m_effeffs) > m_mappingSize[slot])
+			return 0;
+		std::memcpy(m_mapping[slot] + adr, m_effeffs, sizeof(m_effeffs));
+		MarkDirty(slot, adr, sizeof(m_effeffs));
+		return 1;
+	}
+
 	std::FILE* mcfp = m_file[slot];
 	if (!mcfp)
 	{
@@ -561,6 +692,9 @@ s32 FileMemoryCard::EraseBlock(uint slot, u32 adr)
 
 u64 FileMemoryCard::GetCRC(uint slot)
 {
+	if (m_mapping[slot])
+		return m_chksum[slot];
+
 	std::FILE* mcfp = m_file[slot];
 	if (!mcfp)
 		return 0;
@@ -598,6 +732,16 @@ u64 FileMemoryCard::GetCRC(uint slot)
 	return retval;
 }
 
+void FileMemoryCard::NextFrame(uint slot)
+{
+	if (m_dirtyEnd[slot] == 0)
+		return;
+
+	HostSys::FlushMappedFile(m_mapping[slot] + m_dirtyStart[slot], m_dirtyEnd[slot] - m_dirtyStart[slot]);
+	m_dirtyStart[slot] = 0;
+	m_dirtyEnd[slot] = 0;
+}
+
 // --------------------------------------------------------------------------------------
 //  MemoryCard Component API Bindings
 // --------------------------------------------------------------------------------------
@@ -759,9 +903,9 @@ void FileMcd_NextFrame(uint port, uint slot)
 	const uint combinedSlot = FileMcd_ConvertToSlot(port, slot);
 	switch (EmuConfig.Mcd[combinedSlot].Type)
 	{
-		//case MemoryCardType::MemoryCard_File:
-		//	Mcd::impl.NextFrame( combinedSlot );
-		//	break;
+		case MemoryCardType::File:
+			Mcd::impl.NextFrame(combinedSlot);
+			break;
 		case MemoryCardType::Folder:
 			Mcd::implFolder.NextFrame(combinedSlot);
 			break;
@@ -28,6 +28,7 @@
 #include "common/FileSystem.h"
 #include "common/Path.h"
 #include "common/StringUtil.h"
+#include "common/ThreadPool.h"
 #include "common/Timer.h"
 
 #include "fmt/core.h"
@@ -40,6 +41,12 @@
 #include <mutex>
 #include <optional>
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 static ryml::Tree parseYamlStr(const std::string& str)
 {
 	ryml::Callbacks rymlCallbacks = ryml::get_callbacks();
@@ -136,6 +143,11 @@ FolderMemoryCard::FolderMemoryCard()
 {
 }
 
+FolderMemoryCard::~FolderMemoryCard()
+{
+	FinishPendingFlush(true);
+}
+
 void FolderMemoryCard::InitializeInternalData()
 {
 	memset(&m_superBlock, 0xFF, sizeof(m_superBlock));
@@ -168,6 +180,7 @@ void FolderMemoryCard::Open(const bool enableFiltering, std::string filter)
 
 void FolderMemoryCard::Open(std::string fullPath, const Pcsx2Config::McdOptions& mcdOptions, const u32 sizeInClusters, const bool enableFiltering, std::string filter, bool simulateFileWrites)
 {
+	FinishPendingFlush(true);
 	InitializeInternalData();
 	m_performFileWrites = !simulateFileWrites;
 
@@ -230,6 +243,8 @@ void FolderMemoryCard::Close(bool flush)
 		Flush();
 	}
 
+	FinishPendingFlush(true);
+
 	m_cache.clear();
 	m_oldDataCache.clear();
 	m_lastAccessedFile.CloseAll();
@@ -929,6 +944,17 @@ bool FolderMemoryCard::ReadFromFile(u8* dest, u32 adr, u32 dataLength)
 		return false;
 	}
 
+	// data which is still being written by the flush thread
+	if (m_pendingFlushJob)
+	{
+		auto pageIt = m_pendingFlushJob->pages.find(page);
+		if (pageIt != m_pendingFlushJob->pages.end())
+		{
+			memcpy(dest, &pageIt->second.raw[offset], dataLength);
+			return true;
+		}
+	}
+
 	// figure out which file to read from
 	auto it = m_fileMetadataQuickAccess.find(fatCluster);
 	if (it != m_fileMetadataQuickAccess.end())
@@ -1084,12 +1110,22 @@ s32 FolderMemoryCard::Save(const u8* src, u32 adr, int size)
 
 void FolderMemoryCard::NextFrame()
 {
+	if (m_pendingFlushJob)
+	{
+		FinishPendingFlush(false);
+	}
+
 	if (m_framesUntilFlush > 0 && --m_framesUntilFlush == 0)
 	{
 		Flush();
 	}
 }
 
+const FolderMemoryCard::FlushStats& FolderMemoryCard::GetFlushStats() const
+{
+	return m_flushStats;
+}
+
 void FolderMemoryCard::Flush()
 {
 	if (m_cache.empty())
@@ -1097,6 +1133,9 @@ void FolderMemoryCard::Flush()
 		return;
 	}
 
+	// files may be renamed or deleted below, so the previous flush has to be on disk first
+	FinishPendingFlush(true);
+
 #ifdef DEBUG_WRITE_FOLDER_CARD_IN_MEMORY_TO_FILE_ON_CHANGE
 	WriteToFile(m_folderName.GetFullPath().RemoveLast() + L"-debug_" + wxDateTime::Now().Format(L"%Y-%m-%d-%H-%M-%S") + L"_pre-flush.ps2");
 #endif
@@ -1104,6 +1143,16 @@ void FolderMemoryCard::Flush()
 	Console.WriteLn("(FolderMcd) Writing data for slot %u to file system...", m_slot);
 	Common::Timer timeFlushStart;
 
+	FlushCache();
+	SubmitFlushJob(static_cast<float>(timeFlushStart.GetTimeMilliseconds()));
+
+#ifdef DEBUG_WRITE_FOLDER_CARD_IN_MEMORY_TO_FILE_ON_CHANGE
+	WriteToFile(m_folderName.GetFullPath().RemoveLast() + L"-debug_" + wxDateTime::Now().Format(L"%Y-%m-%d-%H-%M-%S") + L"_post-flush.ps2");
+#endif
+}
+
+void FolderMemoryCard::FlushCache()
+{
 	// Keep a copy of the old file entries so we can figure out which files and directories, if any, have been deleted from the memory card.
 	std::vector<MemoryCardFileEntryTreeNode> oldFileEntryTree;
 	if (IsFormatted())
@@ -1165,15 +1214,134 @@ void FolderMemoryCard::Flush()
 		FlushPage(i);
 	}
 
-	m_lastAccessedFile.FlushAll();
-	m_lastAccessedFile.ClearMetadataWriteState();
 	m_oldDataCache.clear();
+}
 
-	Console.WriteLn("(FolderMcd) Done! Took %.2f ms.", timeFlushStart.GetTimeMilliseconds());
+void FolderMemoryCard::SubmitFlushJob(float prepareMs)
+{
+	if (!m_flushJob)
+	{
+		Console.WriteLn("(FolderMcd) Done! Took %.2f ms.", prepareMs);
+		return;
+	}
 
-#ifdef DEBUG_WRITE_FOLDER_CARD_IN_MEMORY_TO_FILE_ON_CHANGE
-	WriteToFile(m_folderName.GetFullPath().RemoveLast() + L"-debug_" + wxDateTime::Now().Format(L"%Y-%m-%d-%H-%M-%S") + L"_post-flush.ps2");
+	pxAssert(!m_pendingFlushJob);
+	m_pendingFlushJob = std::move(m_flushJob);
+	m_pendingFlushJob->prepareMs = prepareMs;
+	m_pendingFlushDone.store(false, std::memory_order_relaxed);
+
+	if (!m_flushThread)
+	{
+		m_flushThread = std::make_unique<cb::ThreadPool>(1);
+	}
+
+	FlushJob* job = m_pendingFlushJob.get();
+	m_flushThread->Schedule([this, job]() {
+		WriteFlushJob(job);
+		m_pendingFlushDone.store(true, std::memory_order_release);
+	});
+}
+
+void FolderMemoryCard::WriteFlushJob(FlushJob* job)
+{
+	Common::Timer timeWriteStart;
+	std::vector<std::FILE*> written;
+	written.reserve(job->files.size());
+
+	for (auto& it : job->files)
+	{
+		PendingFileWrite& file = it.second;
+
+		if (!FileSystem::FileExists(file.hostPath.c_str()))
+		{
+			const std::string directory(Path::GetDirectory(file.hostPath));
+			if (!FileSystem::DirectoryExists(directory.c_str()))
+				FileSystem::CreateDirectoryPath(directory.c_str(), true);
+
+			auto createEmptyFile = FileSystem::OpenManagedCFile(file.hostPath.c_str(), "wb");
+		}
+
+		FileAccessHelper::WriteMetadata(file.hostPath, file.cleanedFilename, file.entry);
+
+		std::FILE* fp = FileSystem::OpenCFile(file.hostPath.c_str(), "r+b");
+		if (!fp)
+		{
+			Console.Error("(FolderMcd) Failed to open '%s' for writing.", file.hostPath.c_str());
+			continue;
+		}
+
+		// the runs are sorted by offset, so gaps past the end of the file are padded in one go
+		u64 fileSize = static_cast<u64>(std::max<s64>(FileSystem::FSize64(fp), 0));
+		for (const auto& run : file.runs)
+		{
+			if (fileSize < run.first)
+			{
+				const std::vector<u8> padding(run.first - fileSize, 0xFF);
+				if (FileSystem::FSeek64(fp, fileSize, SEEK_SET) == 0)
+					std::fwrite(padding.data(), padding.size(), 1, fp);
+			}
+
+			if (FileSystem::FSeek64(fp, run.first, SEEK_SET) == 0)
+			{
+				std::fwrite(run.second.data(), run.second.size(), 1, fp);
+				job->bytesWritten += run.second.size();
+			}
+
+			fileSize = std::max<u64>(fileSize, run.first + run.second.size());
+		}
+
+		std::fflush(fp);
+		written.push_back(fp);
+	}
+
+	// sync after all files have been written, so the writes of the files can overlap in the OS
+	Common::Timer timeSyncStart;
+	for (std::FILE* fp : written)
+	{
+#ifdef _WIN32
+		_commit(_fileno(fp));
+#else
+		fsync(fileno(fp));
 #endif
+		std::fclose(fp);
+	}
+
+	job->syncMs = static_cast<float>(timeSyncStart.GetTimeMilliseconds());
+	job->writeMs = static_cast<float>(timeWriteStart.GetTimeMilliseconds());
+}
+
+void FolderMemoryCard::FinishPendingFlush(bool wait)
+{
+	if (!m_pendingFlushJob)
+	{
+		return;
+	}
+
+	if (wait)
+	{
+		m_flushThread->Wait();
+	}
+	else if (!m_pendingFlushDone.load(std::memory_order_acquire))
+	{
+		return;
+	}
+
+	const FlushJob* job = m_pendingFlushJob.get();
+	m_flushStats.flushCount++;
+	m_flushStats.totalBytesWritten += job->bytesWritten;
+	m_flushStats.lastFilesWritten = static_cast<u32>(job->files.size());
+	m_flushStats.lastBytesWritten = job->bytesWritten;
+	m_flushStats.lastPrepareMs = job->prepareMs;
+	m_flushStats.lastWriteMs = job->writeMs;
+	m_flushStats.lastSyncMs = job->syncMs;
+	m_flushStats.maxWriteMs = std::max(m_flushStats.maxWriteMs, job->writeMs);
+
+	Console.WriteLn("(FolderMcd) Done! Slot %u: %llu bytes to %u files, %.2f ms on the emulation thread, %.2f ms writing (%.2f ms sync).",
+		m_slot, static_cast<unsigned long long>(job->bytesWritten), m_flushStats.lastFilesWritten, job->prepareMs, job->writeMs, job->syncMs);
+
+	// our read handles may have buffered the data from before the write
+	m_lastAccessedFile.CloseAll();
+	m_pendingFlushJob.reset();
 }
 
 bool FolderMemoryCard::FlushPage(const u32 page)
@@ -1544,38 +1712,56 @@ bool FolderMemoryCard::WriteToFile(const u8* src, u32 adr, u32 dataLength)
 
 		if (m_performFileWrites)
 		{
-			std::FILE* file = m_lastAccessedFile.ReOpen(m_folderName, &it->second, true);
-			if (file)
+			if (!m_flushJob)
+			{
+				m_flushJob = std::make_unique<FlushJob>();
+			}
+
+			auto fileIt = m_flushJob->files.find(entry);
+			if (fileIt == m_flushJob->files.end())
+			{
+				PendingFileWrite file;
+				file.hostPath = m_folderName;
+				file.cleanedFilename = it->second.GetPath(&file.hostPath);
+				file.entry = *entry;
+				fileIt = m_flushJob->files.emplace(entry, std::move(file)).first;
+			}
+
+			const u32 clusterOffset = (page % 2) * PageSize + offset;
+			const u32 fileSize = entry->entry.data.length;
+			const u32 fileOffsetStart = std::min(clusterNumber * ClusterSize + clusterOffset, fileSize);
+			const u32 fileOffsetEnd = std::min(fileOffsetStart + dataLength, fileSize);
+			const u32 bytesToWrite = fileOffsetEnd - fileOffsetStart;
+
+			if (bytesToWrite > 0)
 			{
-				const u32 clusterOffset = (page % 2) * PageSize + offset;
-				const u32 fileSize = entry->entry.data.length;
-				const u32 fileOffsetStart = std::min(clusterNumber * ClusterSize + clusterOffset, fileSize);
-				const u32 fileOffsetEnd = std::min(fileOffsetStart + dataLength, fileSize);
-				const u32 bytesToWrite = fileOffsetEnd - fileOffsetStart;
-
-				u32 actualFileSize = static_cast<u32>(std::clamp<s64>(FileSystem::FSize64(file), 0, std::numeric_limits<u32>::max()));
-				if (actualFileSize < fileOffsetStart)
+				// append to a run ending where this write starts, then merge with a run starting where it ends
+				std::map<u32, std::vector<u8>>& runs = fileIt->second.runs;
+				auto run = runs.lower_bound(fileOffsetStart);
+				if (run != runs.begin() && std::prev(run)->first + std::prev(run)->second.size() == fileOffsetStart)
 				{
-					FileSystem::FSeek64(file, actualFileSize, SEEK_SET);
-					const u32 diff = fileOffsetStart - actualFileSize;
-					u8 temp = 0xFF;
-					for (u32 i = 0; i < diff; ++i)
-					{
-						std::fwrite(&temp, 1, 1, file);
-					}
+					--run;
+					run->second.insert(run->second.end(), src, src + bytesToWrite);
+				}
+				else
+				{
+					run = runs.emplace_hint(run, fileOffsetStart, std::vector<u8>(src, src + bytesToWrite));
 				}
 
-				if (FileSystem::FTell64(file) == fileOffsetStart || FileSystem::FSeek64(file, fileOffsetStart, SEEK_SET) == 0)
+				auto next = std::next(run);
+				if (next != runs.end() && next->first == fileOffsetEnd)
 				{
-					if (bytesToWrite > 0)
-					{
-						std::fwrite(src, bytesToWrite, 1, file);
-					}
+					run->second.insert(run->second.end(), next->second.begin(), next->second.end());
+					runs.erase(next);
 				}
 			}
-			else
+
+			// reads of this page see what ReadFromFile() would once the file has been written
+			if (offset == 0 && dataLength == PageSize)
 			{
-				return false;
+				MemoryCardPage& snapshot = m_flushJob->pages[page];
+				memcpy(&snapshot.raw[0], src, bytesToWrite);
+				memset(&snapshot.raw[bytesToWrite], 0xFF, PageSize - bytesToWrite);
 			}
 		}
 
@@ -2040,10 +2226,15 @@ void FileAccessHelper::WriteMetadata(const std::string_view& folderName, const M
 {
 	std::string fileName(folderName);
 	const bool cleanedFilename = fileRef->GetPath(&fileName);
+	WriteMetadata(fileName, cleanedFilename, *fileRef->entry);
+}
+
+void FileAccessHelper::WriteMetadata(const std::string& fileName, bool cleanedFilename, const MemoryCardFileEntry& fileEntry)
+{
 	std::string metaFileName(Path::AppendDirectory(fileName, "_pcsx2_meta"));
 	std::string metaDirName(Path::GetDirectory(metaFileName));
 
-	const auto* entry = &fileRef->entry->entry;
+	const auto* entry = &fileEntry.entry;
 	const bool metadataIsNonstandard = cleanedFilename || entry->data.mode != MemoryCardFileEntry::DefaultFileMode || entry->data.attr != 0;
 
 	if (metadataIsNonstandard)
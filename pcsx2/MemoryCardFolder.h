@@ -15,7 +15,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -26,6 +28,11 @@
 
 //#define DEBUG_WRITE_FOLDER_CARD_IN_MEMORY_TO_FILE_ON_CHANGE
 
+namespace cb
+{
+	class ThreadPool;
+}
+
 // --------------------------------------------------------------------------------------
 //  Superblock Header Struct
 // --------------------------------------------------------------------------------------
@@ -220,6 +227,9 @@ public:
 
 	static void WriteIndex(const std::string& baseFolderName, MemoryCardFileEntry* const entry, MemoryCardFileMetadataReference* const parent);
 
+	// writes or removes the metadata file of the host file fileName, as given by GetPath() of its reference
+	static void WriteMetadata(const std::string& fileName, bool cleanedFilename, const MemoryCardFileEntry& entry);
+
 private:
 	// helper function for CleanMemcardFilename()
 	static bool CleanMemcardFilenameEndDotOrSpace(char* name, size_t length);
@@ -261,7 +271,52 @@ public:
 
 	static const int FramesAfterWriteUntilFlush = 2;
 
+	struct FlushStats
+	{
+		// number of flushes that wrote to the host file system, and the data written by all of them
+		u32 flushCount;
+		u64 totalBytesWritten;
+
+		// host files and data written by the last flush
+		u32 lastFilesWritten;
+		u64 lastBytesWritten;
+
+		// time the last flush spent on the emulation thread, and on the flush thread (including lastSyncMs)
+		float lastPrepareMs;
+		float lastWriteMs;
+		float lastSyncMs;
+
+		// longest time a flush spent on the flush thread
+		float maxWriteMs;
+	};
+
 protected:
+	// data of a single host file written by a flush
+	struct PendingFileWrite
+	{
+		std::string hostPath;
+		bool cleanedFilename;
+		MemoryCardFileEntry entry;
+
+		// contiguous runs of data to write, keyed by file offset
+		std::map<u32, std::vector<u8>> runs;
+	};
+
+	// everything a flush writes to the host file system, gathered on the emulation thread and written on the flush thread
+	struct FlushJob
+	{
+		// keyed by the file entry in m_fileEntryDict, only used to find the file while gathering
+		std::map<const MemoryCardFileEntry*, PendingFileWrite> files;
+
+		// copy of the flushed data pages, reads are served from this until the files have been written
+		std::map<u32, MemoryCardPage> pages;
+
+		float prepareMs = 0.0f;
+		float writeMs = 0.0f;
+		float syncMs = 0.0f;
+		u64 bytesWritten = 0;
+	};
+
 	union superBlockUnion
 	{
 		superblock data;
@@ -304,6 +359,12 @@ protected:
 	// remembers and keeps the last accessed file open for further access
 	FileAccessHelper m_lastAccessedFile;
 
+	// flush currently being gathered, and the one being written by the flush thread
+	std::unique_ptr<FlushJob> m_flushJob;
+	std::unique_ptr<FlushJob> m_pendingFlushJob;
+	std::atomic_bool m_pendingFlushDone{false};
+	FlushStats m_flushStats = {};
+
 	// path to the folder that contains the files of this memory card
 	std::string m_folderName;
 
@@ -319,9 +380,13 @@ protected:
 	bool m_filteringEnabled;
 	std::string m_filteringString;
 
+	// writes flushed data to the host file system, created on the first flush; declared last so it's
+	// stopped (and finishes the pending job) before the members above are destroyed
+	std::unique_ptr<cb::ThreadPool> m_flushThread;
+
 public:
 	FolderMemoryCard();
-	virtual ~FolderMemoryCard() = default;
+	virtual ~FolderMemoryCard();
 
 	void Lock();
 	void Unlock();
@@ -359,6 +424,8 @@ public:
 	// called once per frame, used for flushing data after FramesAfterWriteUntilFlush frames of no writes
 	void NextFrame();
 
+	const FlushStats& GetFlushStats() const;
+
 	static void CalculateECC(u8* ecc, const u8* data);
 
 	void WriteToFile(const std::string& filename);
@@ -480,9 +547,21 @@ protected:
 	bool WriteToFile(const u8* src, u32 adr, u32 dataLength);
 
 
-	// flush the whole cache to the internal data and/or host file system
+	// flush the whole cache to the internal data, the host file system is written on the flush thread
 	void Flush();
 
+	// gathers the cache into the internal data and m_flushJob, the body of Flush()
+	void FlushCache();
+
+	// hands m_flushJob to the flush thread
+	void SubmitFlushJob(float prepareMs);
+
+	// writes the files of a job to the host file system, runs on the flush thread
+	static void WriteFlushJob(FlushJob* job);
+
+	// releases the pending job if the flush thread is done with it, or waits for that when wait is set
+	void FinishPendingFlush(bool wait);
+
 	// flush a single page of the cache to the internal data and/or host file system
 	bool FlushPage(const u32 page);
 
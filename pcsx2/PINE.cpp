@@ -15,54 +15,329 @@
 
 #include "PrecompiledHeader.h"
 
-#ifdef PCSX2_LEFTOVER_FROM_WX
-
-#include <stdio.h>
-#include <stdlib.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 #include <sys/types.h>
 #if _WIN32
 #define read_portable(a, b, c) (recv(a, b, c, 0))
 #define write_portable(a, b, c) (send(a, b, c, 0))
 #define close_portable(a) (closesocket(a))
-#define bzero(b, len) (memset((b), '\0', (len)), (void)0)
 #include <WinSock2.h>
-#include <windows.h>
+#include "common/RedtapeWindows.h"
 #else
 #define read_portable(a, b, c) (read(a, b, c))
 #define write_portable(a, b, c) (write(a, b, c))
 #define close_portable(a) (close(a))
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <unistd.h>
 #endif
 
+#include "common/StringUtil.h"
+#include "common/Threading.h"
 #include "Common.h"
+#include "Counters.h"
+#include "Host.h"
 #include "Memory.h"
-#include "gui/AppSaveStates.h"
-#include "gui/AppCoreThread.h"
-#include "gui/SysThreads.h"
-#include "svnrev.h"
 #include "PINE.h"
+#include "VMManager.h"
+#include "svnrev.h"
+#include "vtlb.h"
 
-PINEServer::PINEServer(SysCoreThread* vm, unsigned int slot)
-	: pxThread("PINE_Server")
+namespace PINEServer
 {
+#ifdef _WIN32
+	// windows claim to have support for AF_UNIX sockets but that is a blatant lie,
+	// their SDK won't even run their own examples, so we go on TCP sockets.
+	using SocketType = SOCKET;
+	static constexpr SocketType INVALID_SOCKET_VALUE = INVALID_SOCKET;
+#else
+	using SocketType = int;
+	static constexpr SocketType INVALID_SOCKET_VALUE = -1;
+#endif
+
+	/**
+	 * Maximum memory used by an IPC message request.
+	 * Equivalent to 50,000 Write64 requests.
+	 */
+	static constexpr u32 MAX_IPC_SIZE = 650000;
+
+	/**
+	 * Maximum memory used by an IPC message reply.
+	 * Equivalent to 50,000 Read64 replies.
+	 */
+	static constexpr u32 MAX_IPC_RETURN_SIZE = 450000;
+
+	/**
+	 * Maximum number of ranges in a range command, and total size of a mirror.
+	 */
+	static constexpr u32 MAX_RANGE_COUNT = 4096;
+	static constexpr u32 MAX_MIRROR_SIZE = Ps2MemSize::MainRam * 2;
+
+	/**
+	 * IPC Command messages opcodes.
+	 * A list of possible operations possible by the IPC.
+	 * Each one of them is what we call an "opcode" and is the first
+	 * byte sent by the IPC to differentiate between commands.
+	 */
+	enum IPCCommand : unsigned char
+	{
+		MsgRead8 = 0, /**< Read 8 bit value to memory. */
+		MsgRead16 = 1, /**< Read 16 bit value to memory. */
+		MsgRead32 = 2, /**< Read 32 bit value to memory. */
+		MsgRead64 = 3, /**< Read 64 bit value to memory. */
+		MsgWrite8 = 4, /**< Write 8 bit value to memory. */
+		MsgWrite16 = 5, /**< Write 16 bit value to memory. */
+		MsgWrite32 = 6, /**< Write 32 bit value to memory. */
+		MsgWrite64 = 7, /**< Write 64 bit value to memory. */
+		MsgVersion = 8, /**< Returns PCSX2 version. */
+		MsgSaveState = 9, /**< Saves a savestate. */
+		MsgLoadState = 0xA, /**< Loads a savestate. */
+		MsgTitle = 0xB, /**< Returns the game title. */
+		MsgID = 0xC, /**< Returns the game ID. */
+		MsgUUID = 0xD, /**< Returns the game UUID. */
+		MsgGameVersion = 0xE, /**< Returns the game verion. */
+		MsgStatus = 0xF, /**< Returns the emulator status. */
+		MsgReadRanges = 0x10, /**< Reads a list of memory ranges. PCSX2 extension. */
+		MsgWriteRanges = 0x11, /**< Writes a list of memory ranges. PCSX2 extension. */
+		MsgSubscribe = 0x12, /**< Pushes a list of memory ranges every frame. PCSX2 extension. */
+		MsgMirror = 0x13, /**< Mirrors a list of memory ranges to shared memory. PCSX2 extension. */
+		MsgUnimplemented = 0xFF /**< Unimplemented IPC message. */
+	};
+
+	/**
+	 * Emulator status enum.
+	 * A list of possible emulator statuses.
+	 */
+	enum EmuStatus : uint32_t
+	{
+		Running = 0, /**< Game is running */
+		Paused = 1, /**< Game is paused */
+		Shutdown = 2 /**< Game is shutdown */
+	};
+
+	/**
+	 * IPC message buffer.
+	 * A list of all needed fields to store an IPC message.
+	 */
+	struct IPCBuffer
+	{
+		int size; /**< Size of the buffer. */
+		char* buffer; /**< Buffer. */
+	};
+
+	/**
+	 * IPC result codes.
+	 * A list of possible result codes the IPC can send back.
+	 * Each one of them is what we call an "opcode" or "tag" and is the
+	 * first byte sent by the IPC to differentiate between results.
+	 */
+	enum IPCResult : unsigned char
+	{
+		IPC_OK = 0, /**< IPC command successfully completed. */
+		IPC_EVENT = 0x80, /**< Unsolicited subscription update, not a reply. */
+		IPC_FAIL = 0xFF /**< IPC command failed to complete. */
+	};
+
+	/**
+	 * A range of guest memory, as sent by range commands.
+	 */
+	struct MemoryRange
+	{
+		u32 address;
+		u32 size;
+	};
+
+	/**
+	 * Header at the start of the shared memory mirror, followed by range_count
+	 * MirrorRange entries and then the data of each range.
+	 * sequence is odd while the CPU thread is copying, readers should copy the
+	 * data they need and retry if sequence was odd or changed meanwhile.
+	 */
+	struct MirrorHeader
+	{
+		u32 magic;
+		u32 version;
+		std::atomic<u32> sequence;
+		u32 frame;
+		u32 range_count;
+		u32 data_offset;
+		u32 data_size;
+		u32 reserved;
+	};
+
+	struct MirrorRange
+	{
+		u32 address;
+		u32 size;
+		u32 offset; /**< From the start of the shared memory. */
+		u32 reserved;
+	};
+
+	static_assert(std::atomic<u32>::is_always_lock_free, "Mirror sequence must be lock free to be shared");
+	static_assert(sizeof(MirrorHeader) == 32 && sizeof(MirrorRange) == 16, "Mirror layout is part of the protocol");
+
+	static constexpr u32 MIRROR_MAGIC = 0x524D4950; // PIMR
+	static constexpr u32 MIRROR_VERSION = 1;
+
+	static void ServerThread();
+	static void PushThread();
+	static bool AcceptClient();
+	static IPCBuffer ParseCommand(char* buf, char* ret_buffer, u32 buf_size);
+	static bool ReadRanges(const char* buf, u32 buf_size, u32* buf_cnt, std::vector<MemoryRange>* ranges, u32* total_size);
+	static bool CopyFromGuest(u8* dst, u32 address, u32 size);
+	static bool WriteAll(SocketType sock, const char* data, u32 size);
+
+	static bool CreateMirror(const std::vector<MemoryRange>& ranges, u32 data_size);
+	static void DestroyMirror();
+	static void UpdateMirror();
+
+	static int s_slot = PINE_DEFAULT_SLOT;
+	static std::atomic_bool s_end{true};
+
+	static SocketType s_sock = INVALID_SOCKET_VALUE;
+	// the message socket used in thread's accept().
+	static SocketType s_msgsock = INVALID_SOCKET_VALUE;
+#ifndef _WIN32
+	// absolute path of the socket. Stored in XDG_RUNTIME_DIR, if unset /tmp
+	static std::string s_socket_name;
+#endif
+
+	static std::thread s_server_thread;
+	static std::thread s_push_thread;
+
+	// Serializes replies from the server thread with pushes from the push thread.
+	static std::mutex s_write_mutex;
+
+	// Guards replacing s_msgsock against shutting it down. Never held across a blocking call,
+	// unlike s_write_mutex, so Deinitialize() can always get it to unblock the writers.
+	static std::mutex s_socket_mutex;
+
+	/**
+	 * IPC return buffer.
+	 * A preallocated buffer used to store all IPC replies.
+	 * to the size of 50.000 MsgWrite64 IPC calls.
+	 */
+	static std::unique_ptr<char[]> s_ret_buffer;
+
+	/**
+	 * IPC messages buffer.
+	 * A preallocated buffer used to store all IPC messages.
+	 */
+	static std::unique_ptr<char[]> s_ipc_buffer;
+
+	// Everything the CPU thread touches on vsync, guarded by s_vsync_mutex.
+	static std::mutex s_vsync_mutex;
+	static std::condition_variable s_push_cv;
+	static std::vector<MemoryRange> s_subscription;
+	static std::vector<char> s_push_buffer;
+	static bool s_push_pending = false;
+	static std::vector<MemoryRange> s_mirror_ranges;
+	static u8* s_mirror_ptr = nullptr;
+	static u32 s_mirror_size = 0;
+	static u32 s_mirror_generation = 0;
+	static std::string s_mirror_name;
+#ifdef _WIN32
+	static HANDLE s_mirror_handle = nullptr;
+#else
+	static int s_mirror_fd = -1;
+#endif
+	static std::atomic_bool s_has_vsync_work{false};
+
+	/**
+	 * Formats an IPC buffer
+	 * ret_buffer: return buffer to use.
+	 * size: size of the IPC buffer.
+	 * return value: buffer containing the status code allocated of size
+	 */
+	static inline char* MakeOkIPC(char* ret_buffer, uint32_t size = 5);
+	static inline char* MakeFailIPC(char* ret_buffer, uint32_t size = 5);
+
+	/**
+	 * Converts an uint to an char* in little endian
+	 * res_array: the array to modify
+	 * res: the value to convert
+	 * i: when to insert it into the array
+	 * return value: res_array
+	 * NB: implicitely inlined
+	 */
+	template <typename T>
+	static char* ToArray(char* res_array, T res, int i)
+	{
+		memcpy((res_array + i), (char*)&res, sizeof(T));
+		return res_array;
+	}
+
+	/**
+	 * Converts a char* to an uint in little endian
+	 * arr: the array to convert
+	 * i: when to load it from the array
+	 * return value: the converted value
+	 * NB: implicitely inlined
+	 */
+	template <typename T>
+	static T FromArray(const char* arr, int i)
+	{
+		T res;
+		memcpy(&res, arr + i, sizeof(T));
+		return res;
+	}
+
+	/**
+	 * Ensures an IPC message isn't too big.
+	 * return value: false if checks failed, true otherwise.
+	 */
+	static inline bool SafetyChecks(u32 command_len, int command_size, u32 reply_len, int reply_size = 0, u32 buf_size = MAX_IPC_SIZE - 1)
+	{
+		bool res = ((command_len + command_size) > buf_size ||
+					(reply_len + reply_size) >= MAX_IPC_RETURN_SIZE);
+		if (unlikely(res))
+			return false;
+		return true;
+	}
+} // namespace PINEServer
+
+bool PINEServer::IsInitialized()
+{
+	return !s_end.load(std::memory_order_acquire);
+}
+
+int PINEServer::GetSlot()
+{
+	return s_slot;
+}
+
+bool PINEServer::Initialize(int slot)
+{
+	if (IsInitialized())
+		Deinitialize();
+
+	s_slot = slot;
+
 #ifdef _WIN32
 	WSADATA wsa;
 	struct sockaddr_in server;
 
-
 	if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
 	{
-		Console.WriteLn(Color_Red, "PINE: Cannot initialize winsock! Shutting down...");
-		return;
+		Console.Error("PINE: Cannot initialize winsock! Shutting down...");
+		return false;
 	}
 
-	m_sock = socket(AF_INET, SOCK_STREAM, 0);
-	if ((m_sock == INVALID_SOCKET) || slot > 65536)
+	s_sock = socket(AF_INET, SOCK_STREAM, 0);
+	if ((s_sock == INVALID_SOCKET) || slot > 65536)
 	{
-		Console.WriteLn(Color_Red, "PINE: Cannot open socket! Shutting down...");
-		return;
+		Console.Error("PINE: Cannot open socket! Shutting down...");
+		WSACleanup();
+		return false;
 	}
 
 	// yes very good windows s/sun/sin/g sure is fine
@@ -71,10 +346,13 @@ PINEServer::PINEServer(SysCoreThread* vm, unsigned int slot)
 	server.sin_addr.s_addr = inet_addr("127.0.0.1");
 	server.sin_port = htons(slot);
 
-	if (bind(m_sock, (struct sockaddr*)&server, sizeof(server)) == SOCKET_ERROR)
+	if (bind(s_sock, (struct sockaddr*)&server, sizeof(server)) == SOCKET_ERROR)
 	{
-		Console.WriteLn(Color_Red, "PINE: Error while binding to socket! Shutting down...");
-		return;
+		Console.Error("PINE: Error while binding to socket! Shutting down...");
+		close_portable(s_sock);
+		s_sock = INVALID_SOCKET_VALUE;
+		WSACleanup();
+		return false;
 	}
 
 #else
@@ -87,69 +365,153 @@ PINEServer::PINEServer(SysCoreThread* vm, unsigned int slot)
 	// fallback in case macOS or other OSes don't implement the XDG base
 	// spec
 	if (runtime_dir == nullptr)
-		m_socket_name = "/tmp/" PINE_EMULATOR_NAME ".sock";
+		s_socket_name = "/tmp/" PINE_EMULATOR_NAME ".sock";
 	else
 	{
-		m_socket_name = runtime_dir;
-		m_socket_name += "/" PINE_EMULATOR_NAME ".sock";
+		s_socket_name = runtime_dir;
+		s_socket_name += "/" PINE_EMULATOR_NAME ".sock";
 	}
 
 	if (slot != PINE_DEFAULT_SLOT)
-		m_socket_name += "." + std::to_string(slot);
+		s_socket_name += "." + std::to_string(slot);
 
-	struct sockaddr_un server;
+	struct sockaddr_un server = {};
 
-	m_sock = socket(AF_UNIX, SOCK_STREAM, 0);
-	if (m_sock < 0)
+	s_sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (s_sock < 0)
 	{
-		Console.WriteLn(Color_Red, "PINE: Cannot open socket! Shutting down...");
-		return;
+		Console.Error("PINE: Cannot open socket! Shutting down...");
+		s_sock = INVALID_SOCKET_VALUE;
+		return false;
 	}
 	server.sun_family = AF_UNIX;
-	strcpy(server.sun_path, m_socket_name.c_str());
+	StringUtil::Strlcpy(server.sun_path, s_socket_name.c_str(), sizeof(server.sun_path));
 
 	// we unlink the socket so that when releasing this thread the socket gets
 	// freed even if we didn't close correctly the loop
-	unlink(m_socket_name.c_str());
-	if (bind(m_sock, (struct sockaddr*)&server, sizeof(struct sockaddr_un)))
+	unlink(s_socket_name.c_str());
+	if (bind(s_sock, (struct sockaddr*)&server, sizeof(struct sockaddr_un)))
 	{
-		Console.WriteLn(Color_Red, "PINE: Error while binding to socket! Shutting down...");
-		return;
+		Console.Error("PINE: Error while binding to socket! Shutting down...");
+		close_portable(s_sock);
+		s_sock = INVALID_SOCKET_VALUE;
+		return false;
 	}
 #endif
 
 	// maximum queue of 4096 commands before refusing, approximated to the
 	// nearest legal value. We do not use SOMAXCONN as windows have this idea
 	// that a "reasonable" value is 5, which is not.
-	listen(m_sock, 4096);
+	listen(s_sock, 4096);
 
-	// we save a handle of the main vm object
-	m_vm = vm;
+	// we allocate once buffers to not have to do mallocs for each IPC
+	// request, as malloc is expansive when we optimize for µs.
+	s_ret_buffer = std::make_unique<char[]>(MAX_IPC_RETURN_SIZE);
+	s_ipc_buffer = std::make_unique<char[]>(MAX_IPC_SIZE);
 
-	// we start the thread
-	Start();
-}
+	s_end.store(false, std::memory_order_release);
+	s_server_thread = std::thread(ServerThread);
+	s_push_thread = std::thread(PushThread);
 
-char* PINEServer::MakeOkIPC(char* ret_buffer, uint32_t size = 5)
-{
-	ToArray<uint32_t>(ret_buffer, size, 0);
-	ret_buffer[4] = IPC_OK;
-	return ret_buffer;
+	Console.WriteLn("PINE: Listening on slot %d.", slot);
+	return true;
 }
 
-char* PINEServer::MakeFailIPC(char* ret_buffer, uint32_t size = 5)
+void PINEServer::Deinitialize()
 {
-	ToArray<uint32_t>(ret_buffer, size, 0);
-	ret_buffer[4] = IPC_FAIL;
-	return ret_buffer;
+	if (!IsInitialized())
+		return;
+
+	s_end.store(true, std::memory_order_release);
+
+	// wake up the threads blocked in accept()/read()/write() and the push thread.
+	// winsock only aborts blocking calls when the socket is closed, elsewhere the sockets
+	// are shut down and only closed once nothing can use them anymore.
+	// s_write_mutex must not be taken here, a writer may hold it while blocked on a client
+	// which stopped reading, and it is this shutdown which makes it return.
+	{
+		std::unique_lock lock(s_socket_mutex);
+#ifdef _WIN32
+		close_portable(s_sock);
+		if (s_msgsock != INVALID_SOCKET_VALUE)
+			close_portable(s_msgsock);
+#else
+		shutdown(s_sock, SHUT_RDWR);
+		if (s_msgsock != INVALID_SOCKET_VALUE)
+			shutdown(s_msgsock, SHUT_RDWR);
+#endif
+	}
+	{
+		std::unique_lock lock(s_vsync_mutex);
+		s_push_cv.notify_all();
+	}
+
+	s_server_thread.join();
+	s_push_thread.join();
+
+#ifdef _WIN32
+	WSACleanup();
+#else
+	close_portable(s_sock);
+	if (s_msgsock != INVALID_SOCKET_VALUE)
+		close_portable(s_msgsock);
+	unlink(s_socket_name.c_str());
+#endif
+	s_sock = INVALID_SOCKET_VALUE;
+	s_msgsock = INVALID_SOCKET_VALUE;
+
+	{
+		std::unique_lock lock(s_vsync_mutex);
+		s_subscription.clear();
+		s_push_buffer.clear();
+		s_push_pending = false;
+		DestroyMirror();
+		s_has_vsync_work.store(false, std::memory_order_release);
+	}
+
+	s_ret_buffer.reset();
+	s_ipc_buffer.reset();
 }
 
-int PINEServer::StartSocket()
+bool PINEServer::AcceptClient()
 {
-	m_msgsock = accept(m_sock, 0, 0);
-
-	if (m_msgsock == -1)
+	for (;;)
 	{
+		const SocketType sock = accept(s_sock, 0, 0);
+		if (s_end.load(std::memory_order_acquire))
+		{
+			if (sock != INVALID_SOCKET_VALUE)
+				close_portable(sock);
+			return false;
+		}
+
+		if (sock != INVALID_SOCKET_VALUE)
+		{
+			// subscriptions belong to the connection which made them.
+			{
+				std::unique_lock lock(s_vsync_mutex);
+				s_subscription.clear();
+				s_push_pending = false;
+				s_has_vsync_work.store(s_mirror_ptr != nullptr, std::memory_order_release);
+			}
+
+			std::unique_lock lock(s_write_mutex);
+			std::unique_lock socket_lock(s_socket_mutex);
+
+			// Deinitialize() may have shut the sockets down since accept() returned, in which
+			// case it would never see this one.
+			if (s_end.load(std::memory_order_acquire))
+			{
+				close_portable(sock);
+				return false;
+			}
+
+			if (s_msgsock != INVALID_SOCKET_VALUE)
+				close_portable(s_msgsock);
+			s_msgsock = sock;
+			return true;
+		}
+
 		// everything else is non recoverable in our scope
 		// we also mark as recoverable socket errors where it would block a
 		// non blocking socket, even though our socket is blocking, in case
@@ -162,27 +524,38 @@ int PINEServer::StartSocket()
 		if (!(errno == ECONNABORTED || errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
 		{
 #endif
-			fprintf(stderr, "PINE: An unrecoverable error happened! Shutting down...\n");
-			m_end = true;
-			return -1;
+			Console.Error("PINE: An unrecoverable error happened! Shutting down...");
+			return false;
 		}
 	}
-	return 0;
 }
 
-void PINEServer::ExecuteTaskInThread()
+bool PINEServer::WriteAll(SocketType sock, const char* data, u32 size)
 {
-	m_end = false;
+	while (size > 0)
+	{
+		const auto written = write_portable(sock, data, size);
+		if (written <= 0)
+			return false;
 
-	// we allocate once buffers to not have to do mallocs for each IPC
-	// request, as malloc is expansive when we optimize for µs.
-	m_ret_buffer = new char[MAX_IPC_RETURN_SIZE];
-	m_ipc_buffer = new char[MAX_IPC_SIZE];
+		data += written;
+		size -= static_cast<u32>(written);
+	}
+
+	return true;
+}
+
+void PINEServer::ServerThread()
+{
+	Threading::SetNameOfCurrentThread("PINE Server");
 
-	if (StartSocket() < 0)
+	if (!AcceptClient())
 		return;
 
-	while (true)
+	char* const ipc_buffer = s_ipc_buffer.get();
+	char* const ret_buffer = s_ret_buffer.get();
+
+	while (!s_end.load(std::memory_order_acquire))
 	{
 		// either int or ssize_t depending on the platform, so we have to
 		// use a bunch of auto
@@ -193,13 +566,13 @@ void PINEServer::ExecuteTaskInThread()
 		// socket datagram splittage, we continue to read
 		while (receive_length < end_length)
 		{
-			auto tmp_length = read_portable(m_msgsock, &m_ipc_buffer[receive_length], MAX_IPC_SIZE - receive_length);
+			auto tmp_length = read_portable(s_msgsock, &ipc_buffer[receive_length], MAX_IPC_SIZE - receive_length);
 
 			// we recreate the socket if an error happens
 			if (tmp_length <= 0)
 			{
 				receive_length = 0;
-				if (StartSocket() < 0)
+				if (!AcceptClient())
 					return;
 				break;
 			}
@@ -209,16 +582,15 @@ void PINEServer::ExecuteTaskInThread()
 			// if we got at least the final size then update
 			if (end_length == 4 && receive_length >= 4)
 			{
-				end_length = FromArray<u32>(m_ipc_buffer, 0);
+				end_length = FromArray<u32>(ipc_buffer, 0);
 				// we'd like to avoid a client trying to do OOB
-				if (end_length > MAX_IPC_SIZE || end_length < 4)
+				if (end_length > static_cast<decltype(end_length)>(MAX_IPC_SIZE) || end_length < 4)
 				{
 					receive_length = 0;
 					break;
 				}
 			}
 		}
-		PINEServer::IPCBuffer res;
 
 		// we remove 4 bytes to get the message size out of the IPC command
 		// size in ParseCommand.
@@ -227,43 +599,300 @@ void PINEServer::ExecuteTaskInThread()
 		// disconnects
 		if (receive_length != 0)
 		{
-			res = ParseCommand(&m_ipc_buffer[4], m_ret_buffer, (u32)end_length - 4);
+			const IPCBuffer res = ParseCommand(&ipc_buffer[4], ret_buffer, (u32)end_length - 4);
 
 			// if we cannot send back our answer restart the socket
-			if (write_portable(m_msgsock, res.buffer, res.size) < 0)
+			bool written;
 			{
-				if (StartSocket() < 0)
-					return;
+				std::unique_lock lock(s_write_mutex);
+				written = WriteAll(s_msgsock, res.buffer, res.size);
 			}
+			if (!written && !AcceptClient())
+				return;
+		}
+	}
+}
+
+void PINEServer::PushThread()
+{
+	Threading::SetNameOfCurrentThread("PINE Push");
+
+	// Frames are swapped out of s_push_buffer, so the CPU thread never waits for the socket.
+	// If the client is slower than the game, it only gets the most recent frame.
+	std::vector<char> send_buffer;
+	std::unique_lock lock(s_vsync_mutex);
+	for (;;)
+	{
+		s_push_cv.wait(lock, []() { return s_push_pending || s_end.load(std::memory_order_acquire); });
+		if (s_end.load(std::memory_order_acquire))
+			return;
+
+		send_buffer.swap(s_push_buffer);
+		s_push_pending = false;
+		lock.unlock();
+
+		{
+			std::unique_lock write_lock(s_write_mutex);
+			if (s_msgsock != INVALID_SOCKET_VALUE)
+				WriteAll(s_msgsock, send_buffer.data(), static_cast<u32>(send_buffer.size()));
 		}
+
+		lock.lock();
 	}
-	return;
 }
 
-PINEServer::~PINEServer()
+void PINEServer::OnVSync()
 {
-	m_end = true;
+	if (!s_has_vsync_work.load(std::memory_order_acquire))
+		return;
+
+	std::unique_lock lock(s_vsync_mutex);
+
+	if (!s_subscription.empty())
+	{
+		//        event code
+		//        |  frame number (4 bytes)
+		//        |  |           range data, in subscription order
+		//        |  |           |
+		// push:  80 FF FF FF FF ZZ ZZ ZZ ZZ ...
+		u32 size = 4 + 1 + 4;
+		for (const MemoryRange& range : s_subscription)
+			size += range.size;
+
+		s_push_buffer.resize(size);
+		char* buffer = s_push_buffer.data();
+		ToArray<u32>(buffer, size, 0);
+		buffer[4] = static_cast<char>(IPC_EVENT);
+		ToArray<u32>(buffer, g_FrameCount, 5);
+
+		u32 offset = 9;
+		for (const MemoryRange& range : s_subscription)
+		{
+			CopyFromGuest(reinterpret_cast<u8*>(buffer + offset), range.address, range.size);
+			offset += range.size;
+		}
+
+		s_push_pending = true;
+		s_push_cv.notify_one();
+	}
+
+	if (s_mirror_ptr)
+		UpdateMirror();
+}
+
+bool PINEServer::CopyFromGuest(u8* dst, u32 address, u32 size)
+{
+	using namespace vtlb_private;
+
+	// Go through the TLB a page at a time, without calling handlers: pages which aren't backed by
+	// memory read as zero, rather than triggering hardware register side effects.
+	bool result = true;
+	while (size > 0)
+	{
+		const u32 chunk = std::min<u32>(size, VTLB_PAGE_SIZE - (address & VTLB_PAGE_MASK));
+		const auto vmv = vtlbdata.vmap[address >> VTLB_PAGE_BITS];
+		if (vmv.isHandler(address))
+		{
+			std::memset(dst, 0, chunk);
+			result = false;
+		}
+		else
+		{
+			std::memcpy(dst, reinterpret_cast<const void*>(vmv.assumePtr(address)), chunk);
+		}
+
+		dst += chunk;
+		address += chunk;
+		size -= chunk;
+	}
+
+	return result;
+}
+
+bool PINEServer::ReadRanges(const char* buf, u32 buf_size, u32* buf_cnt, std::vector<MemoryRange>* ranges, u32* total_size)
+{
+	if (!SafetyChecks(*buf_cnt, 4, 0, 0, buf_size))
+		return false;
+
+	const u32 count = FromArray<u32>(&buf[*buf_cnt], 0);
+	*buf_cnt += 4;
+	if (count > MAX_RANGE_COUNT || !SafetyChecks(*buf_cnt, count * 8, 0, 0, buf_size))
+		return false;
+
+	ranges->clear();
+	ranges->reserve(count);
+
+	u64 size = 0;
+	for (u32 i = 0; i < count; i++)
+	{
+		const MemoryRange range = {FromArray<u32>(&buf[*buf_cnt], 0), FromArray<u32>(&buf[*buf_cnt], 4)};
+		*buf_cnt += 8;
+
+		// don't let ranges wrap around the address space.
+		if ((static_cast<u64>(range.address) + range.size) > 0x100000000ull)
+			return false;
+
+		size += range.size;
+		ranges->push_back(range);
+	}
+
+	if (size > MAX_MIRROR_SIZE)
+		return false;
+
+	*total_size = static_cast<u32>(size);
+	return true;
+}
+
+bool PINEServer::CreateMirror(const std::vector<MemoryRange>& ranges, u32 data_size)
+{
+	DestroyMirror();
+
+	const u32 data_offset = sizeof(MirrorHeader) + static_cast<u32>(ranges.size()) * sizeof(MirrorRange);
+	const u32 size = data_offset + data_size;
+
+	// a new name each time, so a client still mapping the previous mirror never sees a resized one.
+	s_mirror_name = fmt::format(PINE_EMULATOR_NAME "_pine_{}_{}", s_slot, s_mirror_generation++);
+
 #ifdef _WIN32
-	WSACleanup();
+	s_mirror_handle = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, size,
+		StringUtil::UTF8StringToWideString(s_mirror_name).c_str());
+	if (!s_mirror_handle)
+	{
+		Console.Error("PINE: CreateFileMapping() for mirror failed: %u", GetLastError());
+		return false;
+	}
+
+	s_mirror_ptr = static_cast<u8*>(MapViewOfFile(s_mirror_handle, FILE_MAP_ALL_ACCESS, 0, 0, size));
+	if (!s_mirror_ptr)
+	{
+		Console.Error("PINE: MapViewOfFile() for mirror failed: %u", GetLastError());
+		CloseHandle(s_mirror_handle);
+		s_mirror_handle = nullptr;
+		return false;
+	}
 #else
-	unlink(m_socket_name.c_str());
+	// POSIX shared memory objects live in their own namespace and need a leading slash.
+	s_mirror_name.insert(0, 1, '/');
+	s_mirror_fd = shm_open(s_mirror_name.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+	if (s_mirror_fd < 0)
+	{
+		Console.Error("PINE: shm_open(%s) for mirror failed: %d", s_mirror_name.c_str(), errno);
+		return false;
+	}
+
+	void* ptr = MAP_FAILED;
+	if (ftruncate(s_mirror_fd, static_cast<off_t>(size)) == 0)
+		ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, s_mirror_fd, 0);
+	if (ptr == MAP_FAILED)
+	{
+		Console.Error("PINE: Mapping mirror of %u bytes failed: %d", size, errno);
+		close(s_mirror_fd);
+		shm_unlink(s_mirror_name.c_str());
+		s_mirror_fd = -1;
+		return false;
+	}
+	s_mirror_ptr = static_cast<u8*>(ptr);
 #endif
-	close_portable(m_sock);
-	close_portable(m_msgsock);
-	delete[] m_ret_buffer;
-	delete[] m_ipc_buffer;
-	// destroy the thread
-	try
-	{
-		pxThread::Cancel();
+
+	s_mirror_size = size;
+	s_mirror_ranges = ranges;
+
+	MirrorHeader* header = new (s_mirror_ptr) MirrorHeader();
+	header->magic = MIRROR_MAGIC;
+	header->version = MIRROR_VERSION;
+	header->sequence.store(0, std::memory_order_relaxed);
+	header->frame = 0;
+	header->range_count = static_cast<u32>(ranges.size());
+	header->data_offset = data_offset;
+	header->data_size = data_size;
+	header->reserved = 0;
+
+	MirrorRange* table = reinterpret_cast<MirrorRange*>(s_mirror_ptr + sizeof(MirrorHeader));
+	u32 offset = data_offset;
+	for (const MemoryRange& range : ranges)
+	{
+		*table++ = MirrorRange{range.address, range.size, offset, 0};
+		offset += range.size;
+	}
+
+	// fill it straight away, so the client doesn't have to wait for the next frame.
+	if (VMManager::HasValidVM())
+		UpdateMirror();
+
+	DevCon.WriteLn("PINE: Mirroring %zu ranges (%u bytes) to %s", ranges.size(), data_size, s_mirror_name.c_str());
+	return true;
+}
+
+void PINEServer::DestroyMirror()
+{
+	if (!s_mirror_ptr)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(s_mirror_ptr);
+	CloseHandle(s_mirror_handle);
+	s_mirror_handle = nullptr;
+#else
+	munmap(s_mirror_ptr, s_mirror_size);
+	close(s_mirror_fd);
+	shm_unlink(s_mirror_name.c_str());
+	s_mirror_fd = -1;
+#endif
+
+	s_mirror_ptr = nullptr;
+	s_mirror_size = 0;
+	s_mirror_ranges.clear();
+	s_mirror_name.clear();
+}
+
+void PINEServer::UpdateMirror()
+{
+	MirrorHeader* header = reinterpret_cast<MirrorHeader*>(s_mirror_ptr);
+	const u32 sequence = header->sequence.load(std::memory_order_relaxed) + 1;
+	header->sequence.store(sequence, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	u8* data = s_mirror_ptr + header->data_offset;
+	for (const MemoryRange& range : s_mirror_ranges)
+	{
+		CopyFromGuest(data, range.address, range.size);
+		data += range.size;
 	}
-	DESTRUCTOR_CATCHALL
+
+	header->frame = g_FrameCount;
+	header->sequence.store(sequence + 1, std::memory_order_release);
+}
+
+char* PINEServer::MakeOkIPC(char* ret_buffer, uint32_t size)
+{
+	ToArray<uint32_t>(ret_buffer, size, 0);
+	ret_buffer[4] = IPC_OK;
+	return ret_buffer;
+}
+
+char* PINEServer::MakeFailIPC(char* ret_buffer, uint32_t size)
+{
+	ToArray<uint32_t>(ret_buffer, size, 0);
+	ret_buffer[4] = static_cast<char>(IPC_FAIL);
+	return ret_buffer;
 }
 
 PINEServer::IPCBuffer PINEServer::ParseCommand(char* buf, char* ret_buffer, u32 buf_size)
 {
 	u32 ret_cnt = 5;
 	u32 buf_cnt = 0;
+	std::vector<MemoryRange> ranges;
+
+	const auto reply_string = [&ret_buffer, &ret_cnt, &buf_cnt, buf_size](const std::string& str) {
+		const u32 size = static_cast<u32>(str.size()) + 1;
+		if (!SafetyChecks(buf_cnt, 0, ret_cnt, size + 4, buf_size))
+			return false;
+		ToArray(ret_buffer, size, ret_cnt);
+		ret_cnt += 4;
+		memcpy(&ret_buffer[ret_cnt], str.c_str(), size);
+		ret_cnt += size;
+		return true;
+	};
 
 	while (buf_cnt < buf_size)
 	{
@@ -285,7 +914,7 @@ PINEServer::IPCBuffer PINEServer::ParseCommand(char* buf, char* ret_buffer, u32
 		{
 			case MsgRead8:
 			{
-				if (!m_vm->HasActiveMachine())
+				if (!VMManager::HasValidVM())
 					goto error;
 				if (!SafetyChecks(buf_cnt, 4, ret_cnt, 1, buf_size))
 					goto error;
@@ -298,7 +927,7 @@ PINEServer::IPCBuffer PINEServer::ParseCommand(char* buf, char* ret_buffer, u32
 			}
 			case MsgRead16:
 			{
-				if (!m_vm->HasActiveMachine())
+				if (!VMManager::HasValidVM())
 					goto error;
 				if (!SafetyChecks(buf_cnt, 4, ret_cnt, 2, buf_size))
 					goto error;
@@ -311,7 +940,7 @@ PINEServer::IPCBuffer PINEServer::ParseCommand(char* buf, char* ret_buffer, u32
 			}
 			case MsgRead32:
 			{
-				if (!m_vm->HasActiveMachine())
+				if (!VMManager::HasValidVM())
 					goto error;
 				if (!SafetyChecks(buf_cnt, 4, ret_cnt, 4, buf_size))
 					goto error;
@@ -324,7 +953,7 @@ PINEServer::IPCBuffer PINEServer::ParseCommand(char* buf, char* ret_buffer, u32
 			}
 			case MsgRead64:
 			{
-				if (!m_vm->HasActiveMachine())
+				if (!VMManager::HasValidVM())
 					goto error;
 				if (!SafetyChecks(buf_cnt, 4, ret_cnt, 8, buf_size))
 					goto error;
@@ -337,7 +966,7 @@ PINEServer::IPCBuffer PINEServer::ParseCommand(char* buf, char* ret_buffer, u32
 			}
 			case MsgWrite8:
 			{
-				if (!m_vm->HasActiveMachine())
+				if (!VMManager::HasValidVM())
 					goto error;
 				if (!SafetyChecks(buf_cnt, 1 + 4, ret_cnt, 0, buf_size))
 					goto error;
@@ -348,7 +977,7 @@ PINEServer::IPCBuffer PINEServer::ParseCommand(char* buf, char* ret_buffer, u32
 			}
 			case MsgWrite16:
 			{
-				if (!m_vm->HasActiveMachine())
+				if (!VMManager::HasValidVM())
 					goto error;
 				if (!SafetyChecks(buf_cnt, 2 + 4, ret_cnt, 0, buf_size))
 					goto error;
@@ -359,7 +988,7 @@ PINEServer::IPCBuffer PINEServer::ParseCommand(char* buf, char* ret_buffer, u32
 			}
 			case MsgWrite32:
 			{
-				if (!m_vm->HasActiveMachine())
+				if (!VMManager::HasValidVM())
 					goto error;
 				if (!SafetyChecks(buf_cnt, 4 + 4, ret_cnt, 0, buf_size))
 					goto error;
@@ -370,7 +999,7 @@ PINEServer::IPCBuffer PINEServer::ParseCommand(char* buf, char* ret_buffer, u32
 			}
 			case MsgWrite64:
 			{
-				if (!m_vm->HasActiveMachine())
+				if (!VMManager::HasValidVM())
 					goto error;
 				if (!SafetyChecks(buf_cnt, 8 + 4, ret_cnt, 0, buf_size))
 					goto error;
@@ -381,115 +1010,67 @@ PINEServer::IPCBuffer PINEServer::ParseCommand(char* buf, char* ret_buffer, u32
 			}
 			case MsgVersion:
 			{
-				if (!m_vm->HasActiveMachine())
+				if (!VMManager::HasValidVM())
 					goto error;
 				char version[256] = {};
 				if (GIT_TAGGED_COMMIT) // Nightly builds
 				{
 					// tagged commit - more modern implementation of dev build versioning
 					// - there is no need to include the commit - that is associated with the tag, git is implied
-					sprintf(version, "PCSX2 Nightly - %s", GIT_TAG);
+					snprintf(version, sizeof(version), "PCSX2 Nightly - %s", GIT_TAG);
 				}
 				else
 				{
-					sprintf(version, "PCSX2 %u.%u.%u-%lld", PCSX2_VersionHi, PCSX2_VersionMid, PCSX2_VersionLo, SVN_REV);
+					snprintf(version, sizeof(version), "PCSX2 %u.%u.%u-%lld", PCSX2_VersionHi, PCSX2_VersionMid, PCSX2_VersionLo, SVN_REV);
 				}
-				const u32 size = strlen(version) + 1;
-				version[size] = 0x00;
-				if (!SafetyChecks(buf_cnt, 0, ret_cnt, size + 4, buf_size))
+				if (!reply_string(version))
 					goto error;
-				ToArray(ret_buffer, size, ret_cnt);
-				ret_cnt += 4;
-				memcpy(&ret_buffer[ret_cnt], version, size);
-				ret_cnt += size;
 				break;
 			}
 			case MsgSaveState:
 			{
-				if (!m_vm->HasActiveMachine())
+				if (!VMManager::HasValidVM())
 					goto error;
 				if (!SafetyChecks(buf_cnt, 1, ret_cnt, 0, buf_size))
 					goto error;
-				StateCopy_SaveToSlot(FromArray<u8>(&buf[buf_cnt], 0));
+				const s32 slot = FromArray<u8>(&buf[buf_cnt], 0);
+				Host::RunOnCPUThread([slot]() { VMManager::SaveStateToSlot(slot); });
 				buf_cnt += 1;
 				break;
 			}
 			case MsgLoadState:
 			{
-				if (!m_vm->HasActiveMachine())
+				if (!VMManager::HasValidVM())
 					goto error;
 				if (!SafetyChecks(buf_cnt, 1, ret_cnt, 0, buf_size))
 					goto error;
-				StateCopy_LoadFromSlot(FromArray<u8>(&buf[buf_cnt], 0), false);
+				const s32 slot = FromArray<u8>(&buf[buf_cnt], 0);
+				Host::RunOnCPUThread([slot]() { VMManager::LoadStateFromSlot(slot); });
 				buf_cnt += 1;
 				break;
 			}
 			case MsgTitle:
 			{
-				if (!m_vm->HasActiveMachine())
-					goto error;
-				char* title = new char[GameInfo::gameName.size() + 1];
-				sprintf(title, "%s", GameInfo::gameName.ToUTF8().data());
-				const u32 size = strlen(title) + 1;
-				title[size] = 0x00;
-				if (!SafetyChecks(buf_cnt, 0, ret_cnt, size + 4, buf_size))
+				if (!VMManager::HasValidVM() || !reply_string(VMManager::GetGameName()))
 					goto error;
-				ToArray(ret_buffer, size, ret_cnt);
-				ret_cnt += 4;
-				memcpy(&ret_buffer[ret_cnt], title, size);
-				ret_cnt += size;
-				delete[] title;
 				break;
 			}
 			case MsgID:
 			{
-				if (!m_vm->HasActiveMachine())
+				if (!VMManager::HasValidVM() || !reply_string(VMManager::GetGameSerial()))
 					goto error;
-				char* title = new char[GameInfo::gameSerial.size() + 1];
-				sprintf(title, "%s", GameInfo::gameSerial.ToUTF8().data());
-				const u32 size = strlen(title) + 1;
-				title[size] = 0x00;
-				if (!SafetyChecks(buf_cnt, 0, ret_cnt, size + 4, buf_size))
-					goto error;
-				ToArray(ret_buffer, size, ret_cnt);
-				ret_cnt += 4;
-				memcpy(&ret_buffer[ret_cnt], title, size);
-				ret_cnt += size;
-				delete[] title;
 				break;
 			}
 			case MsgUUID:
 			{
-				if (!m_vm->HasActiveMachine())
-					goto error;
-				char* title = new char[GameInfo::gameCRC.size() + 1];
-				sprintf(title, "%s", GameInfo::gameCRC.ToUTF8().data());
-				const u32 size = strlen(title) + 1;
-				title[size] = 0x00;
-				if (!SafetyChecks(buf_cnt, 0, ret_cnt, size + 4, buf_size))
+				if (!VMManager::HasValidVM() || !reply_string(fmt::format("{:08x}", VMManager::GetGameCRC())))
 					goto error;
-				ToArray(ret_buffer, size, ret_cnt);
-				ret_cnt += 4;
-				memcpy(&ret_buffer[ret_cnt], title, size);
-				ret_cnt += size;
-				delete[] title;
 				break;
 			}
 			case MsgGameVersion:
 			{
-				if (!m_vm->HasActiveMachine())
+				if (!VMManager::HasValidVM() || !reply_string(VMManager::GetGameVersion()))
 					goto error;
-				char* title = new char[GameInfo::gameVersion.size() + 1];
-				sprintf(title, "%s", GameInfo::gameVersion.ToUTF8().data());
-				const u32 size = strlen(title) + 1;
-				title[size] = 0x00;
-				if (!SafetyChecks(buf_cnt, 0, ret_cnt, size + 4, buf_size))
-					goto error;
-				ToArray(ret_buffer, size, ret_cnt);
-				ret_cnt += 4;
-				memcpy(&ret_buffer[ret_cnt], title, size);
-				ret_cnt += size;
-				delete[] title;
 				break;
 			}
 			case MsgStatus:
@@ -497,18 +1078,110 @@ PINEServer::IPCBuffer PINEServer::ParseCommand(char* buf, char* ret_buffer, u32
 				if (!SafetyChecks(buf_cnt, 0, ret_cnt, 4, buf_size))
 					goto error;
 				EmuStatus status;
-				if (m_vm->HasActiveMachine())
+				switch (VMManager::GetState())
 				{
-					if (GetCoreThread().IsClosing())
-						status = Paused;
-					else
+					case VMState::Running:
 						status = Running;
+						break;
+					case VMState::Paused:
+						status = Paused;
+						break;
+					default:
+						status = Shutdown;
+						break;
 				}
-				else
+				ToArray(ret_buffer, status, ret_cnt);
+				ret_cnt += 4;
+				break;
+			}
+			case MsgReadRanges:
+			{
+				// format: 10 NN NN NN NN [AA AA AA AA SS SS SS SS] * N
+				// reply:  00 [data of each range] * N
+				u32 size;
+				if (!VMManager::HasValidVM() || !ReadRanges(buf, buf_size, &buf_cnt, &ranges, &size))
+					goto error;
+				if (!SafetyChecks(buf_cnt, 0, ret_cnt, size, buf_size))
+					goto error;
+				for (const MemoryRange& range : ranges)
 				{
-					status = Shutdown;
+					CopyFromGuest(reinterpret_cast<u8*>(&ret_buffer[ret_cnt]), range.address, range.size);
+					ret_cnt += range.size;
 				}
-				ToArray(ret_buffer, status, ret_cnt);
+				break;
+			}
+			case MsgWriteRanges:
+			{
+				// format: 11 NN NN NN NN [AA AA AA AA SS SS SS SS ZZ * S] * N
+				if (!VMManager::HasValidVM() || !SafetyChecks(buf_cnt, 4, ret_cnt, 0, buf_size))
+					goto error;
+				const u32 count = FromArray<u32>(&buf[buf_cnt], 0);
+				buf_cnt += 4;
+				for (u32 i = 0; i < count; i++)
+				{
+					if (!SafetyChecks(buf_cnt, 8, ret_cnt, 0, buf_size))
+						goto error;
+					u32 a = FromArray<u32>(&buf[buf_cnt], 0);
+					const u32 size = FromArray<u32>(&buf[buf_cnt], 4);
+					buf_cnt += 8;
+					if (size > buf_size || !SafetyChecks(buf_cnt, size, ret_cnt, 0, buf_size))
+						goto error;
+
+					// through the regular write path, so recompiled code in the range is invalidated.
+					const char* data = &buf[buf_cnt];
+					u32 remaining = size;
+					for (; remaining > 0 && (a & 3) != 0; remaining--)
+						memWrite8(a++, static_cast<u8>(*data++));
+					for (; remaining >= 4; remaining -= 4, a += 4, data += 4)
+						memWrite32(a, FromArray<u32>(data, 0));
+					for (; remaining > 0; remaining--)
+						memWrite8(a++, static_cast<u8>(*data++));
+					buf_cnt += size;
+				}
+				break;
+			}
+			case MsgSubscribe:
+			{
+				// format: 12 NN NN NN NN [AA AA AA AA SS SS SS SS] * N, N = 0 unsubscribes.
+				// reply:  00 FF FF FF FF, the size of the data pushed every frame.
+				u32 size;
+				if (!ReadRanges(buf, buf_size, &buf_cnt, &ranges, &size))
+					goto error;
+				if (size > MAX_IPC_RETURN_SIZE - 9 || !SafetyChecks(buf_cnt, 0, ret_cnt, 4, buf_size))
+					goto error;
+				{
+					std::unique_lock lock(s_vsync_mutex);
+					s_subscription = std::move(ranges);
+					s_push_pending = false;
+					s_has_vsync_work.store(!s_subscription.empty() || s_mirror_ptr, std::memory_order_release);
+				}
+				ranges = {};
+				ToArray(ret_buffer, size, ret_cnt);
+				ret_cnt += 4;
+				break;
+			}
+			case MsgMirror:
+			{
+				// format: 13 NN NN NN NN [AA AA AA AA SS SS SS SS] * N, N = 0 removes the mirror.
+				// reply:  00 LL LL LL LL [name] 00 SS SS SS SS, name of the shared memory and its size.
+				u32 size;
+				if (!ReadRanges(buf, buf_size, &buf_cnt, &ranges, &size))
+					goto error;
+				std::string name;
+				u32 mirror_size = 0;
+				{
+					std::unique_lock lock(s_vsync_mutex);
+					if (ranges.empty())
+						DestroyMirror();
+					else if (!CreateMirror(ranges, size))
+						goto error;
+					name = s_mirror_name;
+					mirror_size = s_mirror_size;
+					s_has_vsync_work.store(!s_subscription.empty() || s_mirror_ptr, std::memory_order_release);
+				}
+				if (!reply_string(name) || !SafetyChecks(buf_cnt, 0, ret_cnt, 4, buf_size))
+					goto error;
+				ToArray(ret_buffer, mirror_size, ret_cnt);
 				ret_cnt += 4;
 				break;
 			}
@@ -521,5 +1194,3 @@ PINEServer::IPCBuffer PINEServer::ParseCommand(char* buf, char* ret_buffer, u32
 	}
 	return IPCBuffer{(int)ret_cnt, MakeOkIPC(ret_buffer, ret_cnt)};
 }
-
-#endif
\ No newline at end of file
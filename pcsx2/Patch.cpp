@@ -29,15 +29,20 @@
 #include <sstream>
 #include <vector>
 
-// This is a declaration for PatchMemory.cpp::_ApplyPatch where we're (patch.cpp)
-// the only consumer, so it's not made public via Patch.h
-// Applies a single patch line to emulation memory regardless of its "place" value.
-extern void _ApplyPatch(IniPatch* p);
+// These are declarations for PatchMemory.cpp::_CompilePatches/_ApplyCompiledPatches where we're
+// (patch.cpp) the only consumer, so they're not made public via Patch.h
+// Builds the list of memory operations for each "place" value from the loaded patch lines.
+extern void _CompilePatches(const std::vector<IniPatch>& patches);
+// Applies the compiled operations for one "place" value to emulation memory.
+extern void _ApplyCompiledPatches(patch_place_type place);
 extern void _ApplyDynaPatch(const DynamicPatch& patch, u32 address);
 
 static std::vector<IniPatch> Patch;
 static std::vector<DynamicPatch> DynaPatch;
 
+// Set whenever Patch changes, the operations are rebuilt on the next ApplyLoadedPatches
+static bool s_patches_changed = true;
+
 struct PatchTextTable
 {
 	int code;
@@ -142,6 +147,7 @@ void ForgetLoadedPatches()
 {
 	Patch.clear();
 	DynaPatch.clear();
+	s_patches_changed = true;
 }
 
 // This routine loads patches from a zip file
@@ -275,6 +281,7 @@ namespace PatchFunc
 
 		iPatch.enabled = 1;
 		Patch.push_back(iPatch);
+		s_patches_changed = true;
 
 #undef PATCH_ERROR
 	}
@@ -283,11 +290,13 @@ namespace PatchFunc
 // This is for applying patches directly to memory
 void ApplyLoadedPatches(patch_place_type place)
 {
-	for (auto& i : Patch)
+	if (s_patches_changed)
 	{
-		if (i.placetopatch == place)
-			_ApplyPatch(&i);
+		_CompilePatches(Patch);
+		s_patches_changed = false;
 	}
+
+	_ApplyCompiledPatches(place);
 }
 
 void ApplyDynamicPatches(u32 pc)
@@ -20,6 +20,10 @@
 #include "Common.h"
 #include "Patch.h"
 #include "IopMem.h"
+#include "vtlb.h"
+
+#include <array>
+#include <vector>
 
 u32 SkipCount = 0, IterationCount = 0;
 u32 IterationIncrement = 0, ValueIncrement = 0;
@@ -43,60 +47,432 @@ void writeCheat()
 	}
 }
 
-void handle_extended_t(IniPatch *p)
+// Loaded patches are compiled into a list of operations for each place, in load order, since later
+// lines may overwrite earlier ones and conditional codes read what the lines before them wrote.
+// Everything which only depends on the pnach line (data type, byte swapping, which extended code a
+// line is and its operands) is decided once when compiling, so applying a patch is a single switch.
+//
+// Plain EE writes keep a host pointer for their address, resolved through the same virtual map
+// memRead/memWrite use. The map entry for the page is compared on each apply, so a TLB change or a
+// page which becomes a handler sends the write back through memRead/memWrite.
+
+namespace
+{
+	enum PatchOpKind : u8
+	{
+		OP_EE_WRITE,
+		OP_IOP_WRITE,
+		OP_EXTENDED,
+	};
+
+	// What an extended line does when it isn't the second half of a multi-line code
+	enum ExtendedKind : u8
+	{
+		EXT_NONE,
+		EXT_WRITE8,
+		EXT_WRITE16,
+		EXT_WRITE32,
+		EXT_INC8,
+		EXT_DEC8,
+		EXT_INC16,
+		EXT_DEC16,
+		EXT_BEGIN_INC32,
+		EXT_BEGIN_DEC32,
+		EXT_BEGIN_SERIAL,
+		EXT_BEGIN_COPY,
+		EXT_BEGIN_POINTER,
+		EXT_OR8,
+		EXT_OR16,
+		EXT_AND8,
+		EXT_AND16,
+		EXT_XOR8,
+		EXT_XOR16,
+		EXT_TEST8,
+		EXT_TEST16,
+	};
+
+	struct PatchOp
+	{
+		PatchOpKind kind;
+		ExtendedKind ext;
+		u8 size;
+		u8 test_cond;
+		u32 addr;
+		u64 value;
+
+		// Raw line, for the second half of multi-line extended codes
+		u32 raw_addr;
+		u32 raw_data;
+
+		// OP_EE_WRITE: map entry the host pointer was resolved from
+		uptr vmap;
+		u8* host;
+	};
+} // namespace
+
+static std::array<std::vector<PatchOp>, _PPT_END_MARKER> s_patch_plan;
+
+static ExtendedKind DecodeExtended(u32 addr, u32 data, PatchOp* op)
+{
+	switch (addr >> 28)
+	{
+		case 0x0: // 0aaaaaaa 0000000vv
+			op->addr = addr & 0x0FFFFFFF;
+			op->value = data & 0xFF;
+			return EXT_WRITE8;
+
+		case 0x1: // 1aaaaaaa 0000vvvv
+			op->addr = addr & 0x0FFFFFFF;
+			op->value = data & 0xFFFF;
+			return EXT_WRITE16;
+
+		case 0x2: // 2aaaaaaa vvvvvvvv
+			op->addr = addr & 0x0FFFFFFF;
+			op->value = data;
+			return EXT_WRITE32;
+
+		case 0x3:
+			op->addr = data;
+			switch (addr & 0xFFFF0000)
+			{
+				case 0x30000000: // 300000vv 0aaaaaaa Inc
+					op->value = addr & 0xFF;
+					return EXT_INC8;
+				case 0x30100000: // 301000vv 0aaaaaaa Dec
+					op->value = addr & 0xFF;
+					return EXT_DEC8;
+				case 0x30200000: // 3020vvvv 0aaaaaaa Inc
+					op->value = addr & 0xFFFF;
+					return EXT_INC16;
+				case 0x30300000: // 3030vvvv 0aaaaaaa Dec
+					op->value = addr & 0xFFFF;
+					return EXT_DEC16;
+				case 0x30400000: // 30400000 0aaaaaaa Inc + Another line
+					return EXT_BEGIN_INC32;
+				case 0x30500000: // 30500000 0aaaaaaa Dec + Another line
+					return EXT_BEGIN_DEC32;
+				default:
+					return EXT_NONE;
+			}
+
+		case 0x4: // 4aaaaaaa nnnnssss + Another line
+			op->addr = addr & 0x0FFFFFFF;
+			return EXT_BEGIN_SERIAL;
+
+		case 0x5: // 5sssssss nnnnnnnn + Another line
+			op->addr = addr & 0x0FFFFFFF;
+			return EXT_BEGIN_COPY;
+
+		case 0x6: // 6aaaaaaa 000000vv + Another line/s
+			op->addr = addr & 0x0FFFFFFF;
+			return EXT_BEGIN_POINTER;
+
+		case 0x7:
+			op->addr = addr & 0x0FFFFFFF;
+			switch (data & 0x00F00000)
+			{
+				case 0x00000000: // 7aaaaaaa 000000vv
+					op->value = data & 0xFF;
+					return EXT_OR8;
+				case 0x00100000: // 7aaaaaaa 0010vvvv
+					op->value = data & 0xFFFF;
+					return EXT_OR16;
+				case 0x00200000: // 7aaaaaaa 002000vv
+					op->value = data & 0xFF;
+					return EXT_AND8;
+				case 0x00300000: // 7aaaaaaa 0030vvvv
+					op->value = data & 0xFFFF;
+					return EXT_AND16;
+				case 0x00400000: // 7aaaaaaa 004000vv
+					op->value = data & 0xFF;
+					return EXT_XOR8;
+				case 0x00500000: // 7aaaaaaa 0050vvvv
+					op->value = data & 0xFFFF;
+					return EXT_XOR16;
+				default:
+					return EXT_NONE;
+			}
+
+		case 0xD:
+		case 0xE:
+		{
+			// Since D-codes now have the additional functionality present in PS2rd which
+			// incorporates E-code-like functionality by making use of the unused bits in
+			// D-codes, the E-codes are now just converted to D-codes to reduce bloat.
+			u32 test_addr = addr;
+			u32 test_data = data;
+			if ((addr & 0xF0000000) == 0xE0000000)
+			{
+				// Ezyyvvvv taaaaaaa  ->  Daaaaaaa yytzvvvv
+				test_addr = 0xD0000000 | (data & 0x0FFFFFFF);
+				test_data = (addr & 0x0000FFFF);
+				test_data |= (addr & 0x00FF0000) << 8;
+				test_data |= (addr & 0x0F000000) >> 8;
+				test_data |= (data & 0xF0000000) >> 8;
+			}
+
+			const u8 type = (test_data & 0x000F0000) >> 16;
+			const u8 cond = (test_data & 0x00F00000) >> 20;
+			if (cond > 7 || type > 1)
+				return EXT_NONE;
+
+			// Daaaaaaa yyczvvvv, skips yy lines (at least one) when the condition holds
+			op->addr = test_addr & 0x0FFFFFFF;
+			op->value = (type == 0) ? (test_data & 0xFFFF) : (test_data & 0xFF);
+			op->test_cond = cond;
+			op->size = std::max<u8>(static_cast<u8>(test_data >> 24), 1);
+			return (type == 0) ? EXT_TEST16 : EXT_TEST8;
+		}
+
+		default:
+			return EXT_NONE;
+	}
+}
+
+static bool CompilePatch(const IniPatch& p, PatchOp* op)
+{
+	*op = {};
+	op->addr = p.addr;
+	op->raw_addr = p.addr;
+	op->raw_data = static_cast<u32>(p.data);
+	op->vmap = ~static_cast<uptr>(0);
+
+	if (p.cpu == CPU_EE)
+	{
+		op->kind = OP_EE_WRITE;
+		switch (p.type)
+		{
+			case BYTE_T:
+				op->size = 1;
+				op->value = static_cast<u8>(p.data);
+				return true;
+			case SHORT_T:
+				op->size = 2;
+				op->value = static_cast<u16>(p.data);
+				return true;
+			case WORD_T:
+				op->size = 4;
+				op->value = static_cast<u32>(p.data);
+				return true;
+			case DOUBLE_T:
+				op->size = 8;
+				op->value = p.data;
+				return true;
+			case SHORT_LE_T:
+				op->size = 2;
+				op->value = static_cast<u16>(SwapEndian(p.data, 16));
+				return true;
+			case WORD_LE_T:
+				op->size = 4;
+				op->value = static_cast<u32>(SwapEndian(p.data, 32));
+				return true;
+			case DOUBLE_LE_T:
+				op->size = 8;
+				op->value = SwapEndian(p.data, 64);
+				return true;
+			case EXTENDED_T:
+				// Lines which do nothing on their own still count towards skips and multi-line codes
+				op->kind = OP_EXTENDED;
+				op->ext = DecodeExtended(p.addr, static_cast<u32>(p.data), op);
+				return true;
+			default:
+				return false;
+		}
+	}
+	else if (p.cpu == CPU_IOP)
+	{
+		op->kind = OP_IOP_WRITE;
+		switch (p.type)
+		{
+			case BYTE_T:
+				op->size = 1;
+				op->value = static_cast<u8>(p.data);
+				return true;
+			case SHORT_T:
+				op->size = 2;
+				op->value = static_cast<u16>(p.data);
+				return true;
+			case WORD_T:
+				op->size = 4;
+				op->value = static_cast<u32>(p.data);
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	return false;
+}
+
+// Only used from Patch.cpp and we don't export this in any h file.
+// Patch.cpp itself declares this prototype, so make sure to keep in sync.
+void _CompilePatches(const std::vector<IniPatch>& patches)
+{
+	for (std::vector<PatchOp>& plan : s_patch_plan)
+		plan.clear();
+
+	for (const IniPatch& p : patches)
+	{
+		PatchOp op;
+		if (p.enabled && p.placetopatch < _PPT_END_MARKER && CompilePatch(p, &op))
+			s_patch_plan[p.placetopatch].push_back(op);
+	}
+}
+
+template <typename T>
+static __fi void WriteIfDifferent(u8* host, u64 value)
+{
+	T current;
+	std::memcpy(&current, host, sizeof(T));
+	if (current != static_cast<T>(value))
+	{
+		const T new_value = static_cast<T>(value);
+		std::memcpy(host, &new_value, sizeof(T));
+	}
+}
+
+static void ApplyEEWrite(PatchOp& op, bool allow_host)
+{
+	using namespace vtlb_private;
+
+	const auto vmv = vtlbdata.vmap[op.addr >> VTLB_PAGE_BITS];
+	if (vmv.raw() != op.vmap)
+	{
+		op.vmap = vmv.raw();
+		const bool in_page = ((op.addr & VTLB_PAGE_MASK) + op.size) <= VTLB_PAGE_SIZE;
+		op.host = (in_page && !vmv.isHandler(op.addr)) ? reinterpret_cast<u8*>(vmv.assumePtr(op.addr)) : nullptr;
+	}
+
+	if (op.host && allow_host)
+	{
+		switch (op.size)
+		{
+			case 1: WriteIfDifferent<u8>(op.host, op.value); break;
+			case 2: WriteIfDifferent<u16>(op.host, op.value); break;
+			case 4: WriteIfDifferent<u32>(op.host, op.value); break;
+			case 8: WriteIfDifferent<u64>(op.host, op.value); break;
+			jNO_DEFAULT
+		}
+		return;
+	}
+
+	switch (op.size)
+	{
+		case 1:
+			if (memRead8(op.addr) != static_cast<u8>(op.value))
+				memWrite8(op.addr, static_cast<u8>(op.value));
+			break;
+		case 2:
+			if (memRead16(op.addr) != static_cast<u16>(op.value))
+				memWrite16(op.addr, static_cast<u16>(op.value));
+			break;
+		case 4:
+			if (memRead32(op.addr) != static_cast<u32>(op.value))
+				memWrite32(op.addr, static_cast<u32>(op.value));
+			break;
+		case 8:
+			if (memRead64(op.addr) != op.value)
+				memWrite64(op.addr, op.value);
+			break;
+		jNO_DEFAULT
+	}
+}
+
+static void ApplyIOPWrite(const PatchOp& op)
+{
+	switch (op.size)
+	{
+		case 1:
+			if (iopMemRead8(op.addr) != static_cast<u8>(op.value))
+				iopMemWrite8(op.addr, static_cast<u8>(op.value));
+			break;
+		case 2:
+			if (iopMemRead16(op.addr) != static_cast<u16>(op.value))
+				iopMemWrite16(op.addr, static_cast<u16>(op.value));
+			break;
+		case 4:
+			if (iopMemRead32(op.addr) != static_cast<u32>(op.value))
+				iopMemWrite32(op.addr, static_cast<u32>(op.value));
+			break;
+		jNO_DEFAULT
+	}
+}
+
+static __fi bool TestCondition(u32 mem, u32 value, u8 cond)
+{
+	// All eight D-code comparisons, picked by index rather than branching on the condition
+	const bool results[8] = {
+		mem != value,
+		mem == value,
+		mem >= value,
+		mem <= value,
+		(mem & value) != 0,
+		(mem & value) == 0,
+		(mem | value) != 0,
+		(mem | value) == 0,
+	};
+	return results[cond];
+}
+
+static void ApplyExtended(const PatchOp& op)
 {
 	if (SkipCount > 0)
 	{
 		SkipCount--;
+		return;
 	}
-	else switch (PrevCheatType)
+
+	const u32 raw_addr = op.raw_addr;
+	const u32 raw_data = op.raw_data;
+
+	switch (PrevCheatType)
 	{
 	case 0x3040: // vvvvvvvv 00000000 Inc
 	{
 		u32 mem = memRead32(PrevCheatAddr);
-		memWrite32(PrevCheatAddr, mem + (p->addr));
+		memWrite32(PrevCheatAddr, mem + raw_addr);
 		PrevCheatType = 0;
-		break;
+		return;
 	}
 
 	case 0x3050: // vvvvvvvv 00000000 Dec
 	{
 		u32 mem = memRead32(PrevCheatAddr);
-		memWrite32(PrevCheatAddr, mem - (p->addr));
+		memWrite32(PrevCheatAddr, mem - raw_addr);
 		PrevCheatType = 0;
-		break;
+		return;
 	}
 
 	case 0x4000: // vvvvvvvv iiiiiiii
 		for (u32 i = 0; i < IterationCount; i++)
 		{
-			memWrite32((u32)(PrevCheatAddr + (i * IterationIncrement)), (u32)(p->addr + ((u32)p->data * i)));
+			memWrite32((u32)(PrevCheatAddr + (i * IterationIncrement)), (u32)(raw_addr + (raw_data * i)));
 		}
 		PrevCheatType = 0;
-		break;
+		return;
 
 	case 0x5000: // bbbbbbbb 00000000
 		for (u32 i = 0; i < IterationCount; i++)
 		{
 			u8 mem = memRead8(PrevCheatAddr + i);
-			memWrite8((p->addr + i) & 0x0FFFFFFF, mem);
+			memWrite8((raw_addr + i) & 0x0FFFFFFF, mem);
 		}
 		PrevCheatType = 0;
-		break;
+		return;
 
 	case 0x6000: // 000Xnnnn iiiiiiii
 	{
 		// Get Number of pointers
-		if (((u32)p->addr & 0x0000FFFF) == 0)
+		if ((raw_addr & 0x0000FFFF) == 0)
 			IterationCount = 1;
 		else
-			IterationCount = (u32)p->addr & 0x0000FFFF;
+			IterationCount = raw_addr & 0x0000FFFF;
 
 		// Read first pointer
-		LastType = ((u32)p->addr & 0x000F0000) >> 16;
+		LastType = (raw_addr & 0x000F0000) >> 16;
 		u32 mem = memRead32(PrevCheatAddr);
 
-		PrevCheatAddr = mem + (u32)p->data;
+		PrevCheatAddr = mem + raw_data;
 		IterationCount--;
 
 		// Check if needed to read another pointer
@@ -112,15 +488,15 @@ void handle_extended_t(IniPatch *p)
 			else
 				PrevCheatType = 0x6001;
 		}
+		return;
 	}
-		break;
 
 	case 0x6001: // 000Xnnnn iiiiiiii
 	{
 		// Read first pointer
 		u32 mem = memRead32(PrevCheatAddr & 0x0FFFFFFF);
 
-		PrevCheatAddr = mem + (u32)p->addr;
+		PrevCheatAddr = mem + raw_addr;
 		IterationCount--;
 
 		// Check if needed to read another pointer
@@ -133,7 +509,7 @@ void handle_extended_t(IniPatch *p)
 		{
 			mem = memRead32(PrevCheatAddr);
 
-			PrevCheatAddr = mem + (u32)p->data;
+			PrevCheatAddr = mem + raw_data;
 			IterationCount--;
 			if (IterationCount == 0)
 			{
@@ -141,452 +517,115 @@ void handle_extended_t(IniPatch *p)
 				if (((mem & 0x0FFFFFFF) & 0x3FFFFFFC) != 0) writeCheat();
 			}
 		}
+		return;
 	}
-		break;
 
 	default:
-		if ((p->addr & 0xF0000000) == 0x00000000)				// 0aaaaaaa 0000000vv
-		{
-			memWrite8(p->addr & 0x0FFFFFFF, (u8)p->data & 0x000000FF);
-			PrevCheatType = 0;
-		}
-		else if ((p->addr & 0xF0000000) == 0x10000000)			// 1aaaaaaa 0000vvvv
-		{
-			memWrite16(p->addr & 0x0FFFFFFF, (u16)p->data & 0x0000FFFF);
-			PrevCheatType = 0;
-		}
-		else if ((p->addr & 0xF0000000) == 0x20000000)			// 2aaaaaaa vvvvvvvv
-		{
-			memWrite32(p->addr & 0x0FFFFFFF, (u32)p->data);
-			PrevCheatType = 0;
-		}
-		else if ((p->addr & 0xFFFF0000) == 0x30000000)			// 300000vv 0aaaaaaa Inc
-		{
-			u8 mem = memRead8((u32)p->data);
-			memWrite8((u32)p->data, mem + (p->addr & 0x000000FF));
-			PrevCheatType = 0;
-		}
-		else if ((p->addr & 0xFFFF0000) == 0x30100000)			// 301000vv 0aaaaaaa Dec
-		{
-			u8 mem = memRead8((u32)p->data);
-			memWrite8((u32)p->data, mem - (p->addr & 0x000000FF));
-			PrevCheatType = 0;
-		}
-		else if ((p->addr & 0xFFFF0000) == 0x30200000)			// 3020vvvv 0aaaaaaa Inc
-		{
-			u16 mem = memRead16((u32)p->data);
-			memWrite16((u32)p->data, mem + (p->addr & 0x0000FFFF));
-			PrevCheatType = 0;
-		}
-		else if ((p->addr & 0xFFFF0000) == 0x30300000)			// 3030vvvv 0aaaaaaa Dec
-		{
-			u16 mem = memRead16((u32)p->data);
-			memWrite16((u32)p->data, mem - (p->addr & 0x0000FFFF));
-			PrevCheatType = 0;
-		}
-		else if ((p->addr & 0xFFFF0000) == 0x30400000)			// 30400000 0aaaaaaa Inc + Another line
-		{
+		break;
+	}
+
+	switch (op.ext)
+	{
+		case EXT_WRITE8:
+			memWrite8(op.addr, static_cast<u8>(op.value));
+			break;
+		case EXT_WRITE16:
+			memWrite16(op.addr, static_cast<u16>(op.value));
+			break;
+		case EXT_WRITE32:
+			memWrite32(op.addr, static_cast<u32>(op.value));
+			break;
+		case EXT_INC8:
+			memWrite8(op.addr, memRead8(op.addr) + static_cast<u8>(op.value));
+			break;
+		case EXT_DEC8:
+			memWrite8(op.addr, memRead8(op.addr) - static_cast<u8>(op.value));
+			break;
+		case EXT_INC16:
+			memWrite16(op.addr, memRead16(op.addr) + static_cast<u16>(op.value));
+			break;
+		case EXT_DEC16:
+			memWrite16(op.addr, memRead16(op.addr) - static_cast<u16>(op.value));
+			break;
+		case EXT_BEGIN_INC32:
 			PrevCheatType = 0x3040;
-			PrevCheatAddr = (u32)p->data;
-		}
-		else if ((p->addr & 0xFFFF0000) == 0x30500000)			// 30500000 0aaaaaaa Inc + Another line
-		{
+			PrevCheatAddr = op.addr;
+			break;
+		case EXT_BEGIN_DEC32:
 			PrevCheatType = 0x3050;
-			PrevCheatAddr = (u32)p->data;
-		}
-		else if ((p->addr & 0xF0000000) == 0x40000000)			// 4aaaaaaa nnnnssss + Another line
-		{
-			IterationCount = ((u32)p->data & 0xFFFF0000) >> 16;
-			IterationIncrement = ((u32)p->data & 0x0000FFFF) * 4;
-			PrevCheatAddr = (u32)p->addr & 0x0FFFFFFF;
+			PrevCheatAddr = op.addr;
+			break;
+		case EXT_BEGIN_SERIAL:
+			IterationCount = (raw_data & 0xFFFF0000) >> 16;
+			IterationIncrement = (raw_data & 0x0000FFFF) * 4;
+			PrevCheatAddr = op.addr;
 			PrevCheatType = 0x4000;
-		}
-		else if ((p->addr & 0xF0000000) == 0x50000000)			// 5sssssss nnnnnnnn + Another line
-		{
-			PrevCheatAddr = (u32)p->addr & 0x0FFFFFFF;
-			IterationCount = ((u32)p->data);
+			break;
+		case EXT_BEGIN_COPY:
+			PrevCheatAddr = op.addr;
+			IterationCount = raw_data;
 			PrevCheatType = 0x5000;
-		}
-		else if ((p->addr & 0xF0000000) == 0x60000000)			// 6aaaaaaa 000000vv + Another line/s
-		{
-			PrevCheatAddr = (u32)p->addr & 0x0FFFFFFF;
-			IterationIncrement = ((u32)p->data);
+			break;
+		case EXT_BEGIN_POINTER:
+			PrevCheatAddr = op.addr;
+			IterationIncrement = raw_data;
 			IterationCount = 0;
 			PrevCheatType = 0x6000;
-		}
-		else if ((p->addr & 0xF0000000) == 0x70000000)
-		{
-			if ((p->data & 0x00F00000) == 0x00000000)			// 7aaaaaaa 000000vv
-			{
-				u8 mem = memRead8((u32)p->addr & 0x0FFFFFFF);
-				memWrite8((u32)p->addr & 0x0FFFFFFF, (u8)(mem | (p->data & 0x000000FF)));
-			}
-			else if ((p->data & 0x00F00000) == 0x00100000)		// 7aaaaaaa 0010vvvv
-			{
-				u16 mem = memRead16((u32)p->addr & 0x0FFFFFFF);
-				memWrite16((u32)p->addr & 0x0FFFFFFF, (u16)(mem | (p->data & 0x0000FFFF)));
-			}
-			else if ((p->data & 0x00F00000) == 0x00200000)		// 7aaaaaaa 002000vv
-			{
-				u8 mem = memRead8((u32)p->addr & 0x0FFFFFFF);
-				memWrite8((u32)p->addr & 0x0FFFFFFF, (u8)(mem & (p->data & 0x000000FF)));
-			}
-			else if ((p->data & 0x00F00000) == 0x00300000)		// 7aaaaaaa 0030vvvv
-			{
-				u16 mem = memRead16((u32)p->addr & 0x0FFFFFFF);
-				memWrite16((u32)p->addr & 0x0FFFFFFF, (u16)(mem & (p->data & 0x0000FFFF)));
-			}
-			else if ((p->data & 0x00F00000) == 0x00400000)		// 7aaaaaaa 004000vv
-			{
-				u8 mem = memRead8((u32)p->addr & 0x0FFFFFFF);
-				memWrite8((u32)p->addr & 0x0FFFFFFF, (u8)(mem ^ (p->data & 0x000000FF)));
-			}
-			else if ((p->data & 0x00F00000) == 0x00500000)		// 7aaaaaaa 0050vvvv
-			{
-				u16 mem = memRead16((u32)p->addr & 0x0FFFFFFF);
-				memWrite16((u32)p->addr & 0x0FFFFFFF, (u16)(mem ^ (p->data & 0x0000FFFF)));
-			}
-		}
-		else if ((p->addr & 0xF0000000) == 0xD0000000 || (p->addr & 0xF0000000) == 0xE0000000)
-		{
-			u32 addr = (u32)p->addr;
-			u32 data = (u32)p->data;
-
-			// Since D-codes now have the additional functionality present in PS2rd which
-			// incorporates E-code-like functionality by making use of the unused bits in
-			// D-codes, the E-codes are now just converted to D-codes to reduce bloat.
-
-			if ((addr & 0xF0000000) == 0xE0000000)
-			{
-				// Ezyyvvvv taaaaaaa  ->  Daaaaaaa yytzvvvv
-				addr = 0xD0000000 | ((u32)p->data & 0x0FFFFFFF);
-				data = 0x00000000 | ((u32)p->addr & 0x0000FFFF);
-				data = data | ((u32)p->addr & 0x00FF0000) << 8;
-				data = data | ((u32)p->addr & 0x0F000000) >> 8;
-				data = data | ((u32)p->data & 0xF0000000) >> 8;
-			}
-
-			const u8 type = (data & 0x000F0000) >> 16;
-			const u8 cond = (data & 0x00F00000) >> 20;
-
-			if (cond == 0)										// Daaaaaaa yy0zvvvv
-			{
-				if (type == 0)										// Daaaaaaa yy00vvvv
-				{
-					u16 mem = memRead16(addr & 0x0FFFFFFF);
-					if (mem != (data & 0x0000FFFF))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-				else if (type == 1)									// Daaaaaaa yy0100vv
-				{
-					u8 mem = memRead8(addr & 0x0FFFFFFF);
-					if (mem != (data & 0x000000FF))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-			}
-			else if (cond == 1)									// Daaaaaaa yy1zvvvv
-			{
-				if (type == 0)										// Daaaaaaa yy10vvvv
-				{
-					u16 mem = memRead16(addr & 0x0FFFFFFF);
-					if (mem == (data & 0x0000FFFF))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-				else if (type == 1)									// Daaaaaaa yy1100vv
-				{
-					u8 mem = memRead8(addr & 0x0FFFFFFF);
-					if (mem == (data & 0x000000FF))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-			}
-			else if (cond == 2)									// Daaaaaaa yy2zvvvv
-			{
-				if (type == 0)										// Daaaaaaa yy20vvvv
-				{
-					u16 mem = memRead16(addr & 0x0FFFFFFF);
-					if (mem >= (data & 0x0000FFFF))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-				else if (type == 1)									// Daaaaaaa yy2100vv
-				{
-					u8 mem = memRead8(addr & 0x0FFFFFFF);
-					if (mem >= (data & 0x000000FF))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-			}
-			else if (cond == 3)									// Daaaaaaa yy3zvvvv
-			{
-				if (type == 0)										// Daaaaaaa yy30vvvv
-				{
-					u16 mem = memRead16(addr & 0x0FFFFFFF);
-					if (mem <= (data & 0x0000FFFF))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-				else if (type == 1)									// Daaaaaaa yy3100vv
-				{
-					u8 mem = memRead8(addr & 0x0FFFFFFF);
-					if (mem <= (data & 0x000000FF))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-			}
-			else if (cond == 4)									// Daaaaaaa yy4zvvvv
-			{
-				if (type == 0)										// Daaaaaaa yy40vvvv
-				{
-					u16 mem = memRead16(addr & 0x0FFFFFFF);
-					if (mem & (data & 0x0000FFFF))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-				else if (type == 1)									// Daaaaaaa yy4100vv
-				{
-					u8 mem = memRead8(addr & 0x0FFFFFFF);
-					if (mem & (data & 0x000000FF))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-			}
-			else if (cond == 5)									// Daaaaaaa yy5zvvvv
-			{
-				if (type == 0)										// Daaaaaaa yy50vvvv
-				{
-					u16 mem = memRead16(addr & 0x0FFFFFFF);
-					if (!(mem & (data & 0x0000FFFF)))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-				else if (type == 1)									// Daaaaaaa yy5100vv
-				{
-					u8 mem = memRead8(addr & 0x0FFFFFFF);
-					if (!(mem & (data & 0x000000FF)))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-			}
-			else if (cond == 6)									// Daaaaaaa yy6zvvvv
-			{
-				if (type == 0)										// Daaaaaaa yy60vvvv
-				{
-					u16 mem = memRead16(addr & 0x0FFFFFFF);
-					if (mem | (data & 0x0000FFFF))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-				else if (type == 1)									// Daaaaaaa yy6100vv
-				{
-					u8 mem = memRead8(addr & 0x0FFFFFFF);
-					if (mem | (data & 0x000000FF))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-			}
-			else if (cond == 7)									// Daaaaaaa yy7zvvvv
-			{
-				if (type == 0)										// Daaaaaaa yy70vvvv
-				{
-					u16 mem = memRead16(addr & 0x0FFFFFFF);
-					if (!(mem | (data & 0x0000FFFF)))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-				else if (type == 1)									// Daaaaaaa yy7100vv
-				{
-					u8 mem = memRead8(addr & 0x0FFFFFFF);
-					if (!(mem | (data & 0x000000FF)))
-					{
-						SkipCount = (data & 0xFF000000) >> 24;
-						if (!SkipCount)
-						{
-							SkipCount = 1;
-						}
-					}
-					PrevCheatType = 0;
-				}
-			}
-		}
-	}
-}
-
-// Only used from Patch.cpp and we don't export this in any h file.
-// Patch.cpp itself declares this prototype, so make sure to keep in sync.
-void _ApplyPatch(IniPatch *p)
-{
-	u64 ledata = 0;
-
-	if (p->enabled == 0) return;
-
-	switch (p->cpu)
-	{
-	case CPU_EE:
-		switch (p->type)
-		{
-		case BYTE_T:
-			if (memRead8(p->addr) != (u8)p->data)
-				memWrite8(p->addr, (u8)p->data);
 			break;
-
-		case SHORT_T:
-			if (memRead16(p->addr) != (u16)p->data)
-				memWrite16(p->addr, (u16)p->data);
+		case EXT_OR8:
+			memWrite8(op.addr, static_cast<u8>(memRead8(op.addr) | op.value));
 			break;
-
-		case WORD_T:
-			if (memRead32(p->addr) != (u32)p->data)
-				memWrite32(p->addr, (u32)p->data);
+		case EXT_OR16:
+			memWrite16(op.addr, static_cast<u16>(memRead16(op.addr) | op.value));
 			break;
-
-		case DOUBLE_T:
-			if (memRead64(p->addr) != (u64)p->data)
-				memWrite64(p->addr, (u64)p->data);
+		case EXT_AND8:
+			memWrite8(op.addr, static_cast<u8>(memRead8(op.addr) & op.value));
 			break;
-
-		case EXTENDED_T:
-			handle_extended_t(p);
+		case EXT_AND16:
+			memWrite16(op.addr, static_cast<u16>(memRead16(op.addr) & op.value));
 			break;
-
-		case SHORT_LE_T:
-			ledata = SwapEndian(p->data, 16);
-			if (memRead16(p->addr) != (u16)ledata)
-				memWrite16(p->addr, (u16)ledata);
+		case EXT_XOR8:
+			memWrite8(op.addr, static_cast<u8>(memRead8(op.addr) ^ op.value));
 			break;
-
-		case WORD_LE_T:
-			ledata = SwapEndian(p->data, 32);
-			if (memRead32(p->addr) != (u32)ledata)
-				memWrite32(p->addr, (u32)ledata);
+		case EXT_XOR16:
+			memWrite16(op.addr, static_cast<u16>(memRead16(op.addr) ^ op.value));
 			break;
-
-		case DOUBLE_LE_T:
-			ledata = SwapEndian(p->data, 64);
-			if (memRead64(p->addr) != (u64)ledata)
-				memWrite64(p->addr, (u64)ledata);
+		case EXT_TEST8:
+			if (TestCondition(memRead8(op.addr), static_cast<u32>(op.value), op.test_cond))
+				SkipCount = op.size;
 			break;
-
+		case EXT_TEST16:
+			if (TestCondition(memRead16(op.addr), static_cast<u32>(op.value), op.test_cond))
+				SkipCount = op.size;
+			break;
+		case EXT_NONE:
 		default:
 			break;
-		}
-		break;
+	}
+}
 
-	case CPU_IOP:
-		switch (p->type)
+// Only used from Patch.cpp and we don't export this in any h file.
+// Patch.cpp itself declares this prototype, so make sure to keep in sync.
+void _ApplyCompiledPatches(patch_place_type place)
+{
+	// Host pointers skip the interpreter's data cache, so it gets the full memRead/memWrite path
+	const bool allow_host = CHECK_EEREC || !CHECK_CACHE;
+
+	for (PatchOp& op : s_patch_plan[place])
+	{
+		switch (op.kind)
 		{
-		case BYTE_T:
-			if (iopMemRead8(p->addr) != (u8)p->data)
-				iopMemWrite8(p->addr, (u8)p->data);
-			break;
-		case SHORT_T:
-			if (iopMemRead16(p->addr) != (u16)p->data)
-				iopMemWrite16(p->addr, (u16)p->data);
-			break;
-		case WORD_T:
-			if (iopMemRead32(p->addr) != (u32)p->data)
-				iopMemWrite32(p->addr, (u32)p->data);
-			break;
-		default:
-			break;
+			case OP_EE_WRITE:
+				ApplyEEWrite(op, allow_host);
+				break;
+			case OP_IOP_WRITE:
+				ApplyIOPWrite(op);
+				break;
+			case OP_EXTENDED:
+				ApplyExtended(op);
+				break;
+			jNO_DEFAULT
 		}
-		break;
-
-	default:
-		break;
 	}
 }
 
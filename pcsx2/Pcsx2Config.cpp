@@ -883,6 +883,9 @@ void Pcsx2Config::SPU2Options::LoadSave(SettingsWrapper& wrap)
 		SettingsWrapEntry(Latency);
 		SettingsWrapEntry(OutputLatency);
 		SettingsWrapBitBool(OutputLatencyMinimal);
+		SettingsWrapBitBool(ThreadedOutput);
+		SettingsWrapBitBool(LowLatencyBuffer);
+		SettingsWrapBitBool(ResampleStretch);
 		SynchMode = static_cast<SynchronizationMode>(wrap.EntryBitfield(CURRENT_SETTINGS_SECTION, "SynchMode", static_cast<int>(SynchMode), static_cast<int>(SynchMode)));
 		SettingsWrapEntry(SpeakerConfiguration);
 		SettingsWrapEntry(DplDecodingLevel);
@@ -1140,6 +1143,7 @@ Pcsx2Config::DebugOptions::DebugOptions()
 {
 	ShowDebuggerOnStart = false;
 	AlignMemoryWindowStart = true;
+	PageProtectWatchpoints = true;
 	FontWidth = 8;
 	FontHeight = 12;
 	WindowWidth = 0;
@@ -1153,6 +1157,7 @@ void Pcsx2Config::DebugOptions::LoadSave(SettingsWrapper& wrap)
 
 	SettingsWrapBitBool(ShowDebuggerOnStart);
 	SettingsWrapBitBool(AlignMemoryWindowStart);
+	SettingsWrapBitBool(PageProtectWatchpoints);
 	SettingsWrapBitfield(FontWidth);
 	SettingsWrapBitfield(FontHeight);
 	SettingsWrapBitfield(WindowWidth);
@@ -1189,6 +1194,24 @@ void Pcsx2Config::FramerateOptions::LoadSave(SettingsWrapper& wrap)
 	SettingsWrapEntry(SlomoScalar);
 }
 
+void Pcsx2Config::RewindOptions::SanityCheck()
+{
+	Frequency = std::clamp<u32>(Frequency, 1, 600);
+	BufferSizeMB = std::clamp<u32>(BufferSizeMB, 16, 8192);
+}
+
+void Pcsx2Config::RewindOptions::LoadSave(SettingsWrapper& wrap)
+{
+	SettingsWrapSection("EmuCore/Rewind");
+
+	SettingsWrapEntry(Enabled);
+	SettingsWrapEntry(Frequency);
+	SettingsWrapEntry(BufferSizeMB);
+
+	if (wrap.IsLoading())
+		SanityCheck();
+}
+
 Pcsx2Config::USBOptions::USBOptions()
 {
 	for (u32 i = 0; i < static_cast<u32>(Ports.size()); i++)
@@ -1276,6 +1299,12 @@ void Pcsx2Config::AchievementsOptions::LoadSave(SettingsWrapper& wrap)
 
 #endif
 
+const char* Pcsx2Config::HugePageModeNames[] = {
+	"Disabled",
+	"Transparent",
+	"Explicit",
+	nullptr};
+
 Pcsx2Config::Pcsx2Config()
 {
 	bitset = 0;
@@ -1288,6 +1317,7 @@ Pcsx2Config::Pcsx2Config()
 	InhibitScreensaver = true;
 	BackupSavestate = true;
 	SavestateZstdCompression = true;
+	CdvdPrefetchTrace = true;
 
 #ifdef _WIN32
 	McdCompressNTFS = true;
@@ -1306,6 +1336,7 @@ Pcsx2Config::Pcsx2Config()
 	}
 
 	GzipIsoIndexTemplate = "$(f).pindex.tmp";
+	PINESlot = 28011;
 }
 
 void Pcsx2Config::LoadSave(SettingsWrapper& wrap)
@@ -1320,6 +1351,7 @@ void Pcsx2Config::LoadSave(SettingsWrapper& wrap)
 	SettingsWrapBitBool(CdvdVerboseReads);
 	SettingsWrapBitBool(CdvdDumpBlocks);
 	SettingsWrapBitBool(CdvdShareWrite);
+	SettingsWrapBitBool(CdvdPrefetchTrace);
 	SettingsWrapBitBool(EnablePatches);
 	SettingsWrapBitBool(EnableCheats);
 	SettingsWrapBitBool(EnablePINE);
@@ -1335,6 +1367,8 @@ void Pcsx2Config::LoadSave(SettingsWrapper& wrap)
 
 	SettingsWrapBitBool(BackupSavestate);
 	SettingsWrapBitBool(SavestateZstdCompression);
+	SettingsWrapBitBool(SavestateIncremental);
+	SettingsWrapBitBool(SavestateParallelCompression);
 	SettingsWrapBitBool(McdEnableEjection);
 	SettingsWrapBitBool(McdFolderAutoManage);
 
@@ -1359,12 +1393,15 @@ void Pcsx2Config::LoadSave(SettingsWrapper& wrap)
 #endif
 
 	SettingsWrapEntry(GzipIsoIndexTemplate);
+	SettingsWrapEntry(PINESlot);
+	SettingsWrapEnumEx(HugePages, "HugePages", HugePageModeNames);
 
 	// For now, this in the derived config for backwards ini compatibility.
 	SettingsWrapEntryEx(CurrentBlockdump, "BlockDumpSaveDirectory");
 
 	BaseFilenames.LoadSave(wrap);
 	Framerate.LoadSave(wrap);
+	Rewind.LoadSave(wrap);
 	LoadSaveMemcards(wrap);
 
 #ifdef _WIN32
@@ -1432,9 +1469,12 @@ bool Pcsx2Config::operator==(const Pcsx2Config& right) const
 		OpEqu(Profiler) &&
 		OpEqu(Debugger) &&
 		OpEqu(Framerate) &&
+		OpEqu(Rewind) &&
 		OpEqu(Trace) &&
 		OpEqu(BaseFilenames) &&
-		OpEqu(GzipIsoIndexTemplate);
+		OpEqu(GzipIsoIndexTemplate) &&
+		OpEqu(PINESlot) &&
+		OpEqu(HugePages);
 	for (u32 i = 0; i < sizeof(Mcd) / sizeof(Mcd[0]); i++)
 	{
 		equal &= OpEqu(Mcd[i].Enabled);
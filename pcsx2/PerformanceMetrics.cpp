@@ -18,6 +18,7 @@
 #include <chrono>
 #include <vector>
 
+#include "common/Perf.h"
 #include "common/Timer.h"
 #include "common/Threading.h"
 
@@ -54,6 +55,9 @@ static u32 s_gs_framebuffer_blits_since_last_update = 0;
 static u32 s_gs_privileged_register_writes_since_last_update = 0;
 
 static Threading::ThreadHandle s_cpu_thread_handle;
+static Perf::TLBMissCounter s_cpu_thread_tlb_misses;
+static u64 s_last_cpu_data_tlb_misses = 0;
+static u64 s_last_cpu_instruction_tlb_misses = 0;
 static u64 s_last_cpu_time = 0;
 static u64 s_last_gs_time = 0;
 static u64 s_last_vu_time = 0;
@@ -62,6 +66,8 @@ static u64 s_last_ticks = 0;
 
 static double s_cpu_thread_usage = 0.0f;
 static double s_cpu_thread_time = 0.0f;
+static double s_cpu_data_tlb_misses = 0.0;
+static double s_cpu_instruction_tlb_misses = 0.0;
 static float s_gs_thread_usage = 0.0f;
 static float s_gs_thread_time = 0.0f;
 static float s_vu_thread_usage = 0.0f;
@@ -99,6 +105,8 @@ void PerformanceMetrics::Clear()
 
 	s_cpu_thread_usage = 0.0f;
 	s_cpu_thread_time = 0.0f;
+	s_cpu_data_tlb_misses = 0.0;
+	s_cpu_instruction_tlb_misses = 0.0;
 	s_gs_thread_usage = 0.0f;
 	s_gs_thread_time = 0.0f;
 	s_vu_thread_usage = 0.0f;
@@ -132,6 +140,8 @@ void PerformanceMetrics::Reset()
 	s_last_frame_time.Reset();
 
 	s_last_cpu_time = s_cpu_thread_handle.GetCPUTime();
+	s_last_cpu_data_tlb_misses = s_cpu_thread_tlb_misses.ReadDataMisses();
+	s_last_cpu_instruction_tlb_misses = s_cpu_thread_tlb_misses.ReadInstructionMisses();
 	s_last_gs_time = GetMTGS().GetThreadHandle().GetCPUTime();
 	s_last_vu_time = THREAD_VU1 ? vu1Thread.GetThreadHandle().GetCPUTime() : 0;
 	s_last_ticks = GetCPUTicks();
@@ -227,6 +237,17 @@ void PerformanceMetrics::Update(bool gs_register_write, bool fb_blit, bool is_sk
 	s_vu_thread_time = static_cast<double>(vu_delta) * time_divider;
 	s_capture_thread_time = static_cast<double>(capture_delta) * time_divider;
 
+	if (s_cpu_thread_tlb_misses.IsOpen())
+	{
+		const u64 data_misses = s_cpu_thread_tlb_misses.ReadDataMisses();
+		const u64 instruction_misses = s_cpu_thread_tlb_misses.ReadInstructionMisses();
+		s_cpu_data_tlb_misses = static_cast<double>(data_misses - s_last_cpu_data_tlb_misses) / static_cast<double>(s_frames_since_last_update);
+		s_cpu_instruction_tlb_misses =
+			static_cast<double>(instruction_misses - s_last_cpu_instruction_tlb_misses) / static_cast<double>(s_frames_since_last_update);
+		s_last_cpu_data_tlb_misses = data_misses;
+		s_last_cpu_instruction_tlb_misses = instruction_misses;
+	}
+
 	for (GSSWThreadStats& thread : s_gs_sw_threads)
 	{
 		const u64 time = thread.handle.GetCPUTime();
@@ -253,6 +274,22 @@ void PerformanceMetrics::SetCPUThread(Threading::ThreadHandle thread)
 {
 	s_last_cpu_time = thread ? thread.GetCPUTime() : 0;
 	s_cpu_thread_handle = std::move(thread);
+
+	// Perf events count the thread which opens them, which is the CPU thread itself.
+	if (s_cpu_thread_handle)
+	{
+		if (!s_cpu_thread_tlb_misses.Open())
+			DevCon.WriteLn("TLB miss counters are unavailable, perf events may be restricted by perf_event_paranoid.");
+	}
+	else
+	{
+		s_cpu_thread_tlb_misses.Close();
+	}
+
+	s_last_cpu_data_tlb_misses = s_cpu_thread_tlb_misses.ReadDataMisses();
+	s_last_cpu_instruction_tlb_misses = s_cpu_thread_tlb_misses.ReadInstructionMisses();
+	s_cpu_data_tlb_misses = 0.0;
+	s_cpu_instruction_tlb_misses = 0.0;
 }
 
 void PerformanceMetrics::SetGSSWThreadCount(u32 count)
@@ -317,6 +354,21 @@ float PerformanceMetrics::GetMaximumFrameTime()
 	return s_maximum_frame_time;
 }
 
+bool PerformanceMetrics::HasCPUThreadTLBMisses()
+{
+	return s_cpu_thread_tlb_misses.IsOpen();
+}
+
+double PerformanceMetrics::GetCPUThreadDataTLBMisses()
+{
+	return s_cpu_data_tlb_misses;
+}
+
+double PerformanceMetrics::GetCPUThreadInstructionTLBMisses()
+{
+	return s_cpu_instruction_tlb_misses;
+}
+
 double PerformanceMetrics::GetCPUThreadUsage()
 {
 	return s_cpu_thread_usage;
@@ -57,6 +57,12 @@ namespace PerformanceMetrics
 	float GetMinimumFrameTime();
 	float GetMaximumFrameTime();
 
+	/// TLB misses of the EE thread per frame, only counted where the host exposes perf events.
+	/// Useful to see the effect of huge pages (EmuCore/HugePages).
+	bool HasCPUThreadTLBMisses();
+	double GetCPUThreadDataTLBMisses();
+	double GetCPUThreadInstructionTLBMisses();
+
 	double GetCPUThreadUsage();
 	double GetCPUThreadAverageTime();
 	float GetGSThreadUsage();
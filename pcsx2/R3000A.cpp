@@ -28,6 +28,7 @@
 #include "IopDma.h"
 #include "CDVD/Ps1CD.h"
 #include "CDVD/CDVD.h"
+#include "CpuEventTable.h"
 
 using namespace R3000A;
 
@@ -150,7 +151,7 @@ __fi void PSX_INT( IopEventId n, s32 ecycle )
 	}
 }
 
-static __fi void IopTestEvent( IopEventId n, void (*callback)() )
+static __fi void IopTestEvent( u8 n, void (*callback)() )
 {
 	if( !(psxRegs.interrupt & (1 << n)) ) return;
 
@@ -163,48 +164,31 @@ static __fi void IopTestEvent( IopEventId n, void (*callback)() )
 		psxSetNextBranch( psxRegs.sCycle[n], psxRegs.eCycle[n] );
 }
 
-static __fi void Sio0TestEvent(IopEventId n)
+static void sio0TestInterrupt()
 {
-	if (!(psxRegs.interrupt & (1 << n)))
-	{
-		return;
-	}
-
-	if (psxTestCycle(psxRegs.sCycle[n], psxRegs.eCycle[n]))
-	{
-		psxRegs.interrupt &= ~(1 << n);
-		sio0.Interrupt(Sio0Interrupt::TEST_EVENT);
-	}
-	else
-	{
-		psxSetNextBranch(psxRegs.sCycle[n], psxRegs.eCycle[n]);
-	}
+	sio0.Interrupt(Sio0Interrupt::TEST_EVENT);
 }
 
+// Keep the order stable, it decides which handler runs first when several are due in one test.
+static constexpr CpuEventTable<13> s_iop_events({{
+	{IopEvt_SIF0,				sif0Interrupt},
+	{IopEvt_SIF1,				sif1Interrupt},
+	{IopEvt_SIF2,				sif2Interrupt},
+	{IopEvt_SIO,				sio0TestInterrupt},
+	{IopEvt_CdvdRead,			cdvdReadInterrupt},
+	{IopEvt_CdvdSectorReady,	cdvdSectorReady},
+	{IopEvt_Cdvd,				cdvdActionInterrupt},
+	{IopEvt_Dma11,				psxDMA11Interrupt},	// SIO2
+	{IopEvt_Dma12,				psxDMA12Interrupt},	// SIO2
+	{IopEvt_Cdrom,				cdrInterrupt},
+	{IopEvt_CdromRead,			cdrReadInterrupt},
+	{IopEvt_DEV9,				dev9Interrupt},
+	{IopEvt_USB,				usbInterrupt},
+}});
+
 static __fi void _psxTestInterrupts()
 {
-	IopTestEvent(IopEvt_SIF0,		sif0Interrupt);	// SIF0
-	IopTestEvent(IopEvt_SIF1,		sif1Interrupt);	// SIF1
-	IopTestEvent(IopEvt_SIF2,		sif2Interrupt);	// SIF2
-	Sio0TestEvent(IopEvt_SIO);
-	IopTestEvent(IopEvt_CdvdRead,	cdvdReadInterrupt);
-	IopTestEvent(IopEvt_CdvdSectorReady, cdvdSectorReady);
-
-	// Profile-guided Optimization (sorta)
-	// The following ints are rarely called.  Encasing them in a conditional
-	// as follows helps speed up most games.
-
-	if( psxRegs.interrupt & ((1 << IopEvt_Cdvd) | (1 << IopEvt_Dma11) | (1 << IopEvt_Dma12)
-		| (1 << IopEvt_Cdrom) | (1 << IopEvt_CdromRead) | (1 << IopEvt_DEV9) | (1 << IopEvt_USB)))
-	{
-		IopTestEvent(IopEvt_Cdvd,		cdvdActionInterrupt);
-		IopTestEvent(IopEvt_Dma11,		psxDMA11Interrupt);	// SIO2
-		IopTestEvent(IopEvt_Dma12,		psxDMA12Interrupt);	// SIO2
-		IopTestEvent(IopEvt_Cdrom,		cdrInterrupt);
-		IopTestEvent(IopEvt_CdromRead,	cdrReadInterrupt);
-		IopTestEvent(IopEvt_DEV9,		dev9Interrupt);
-		IopTestEvent(IopEvt_USB,		usbInterrupt);
-	}
+	s_iop_events.Dispatch(psxRegs.interrupt, IopTestEvent);
 }
 
 __ri void iopEventTest()
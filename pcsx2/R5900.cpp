@@ -24,6 +24,7 @@
 #include "ps2/pgif.h" // pgif init
 #include "VUmicro.h"
 #include "COP0.h"
+#include "CpuEventTable.h"
 #include "MTVU.h"
 #include "VMManager.h"
 
@@ -288,6 +289,26 @@ static __fi void TESTINT( u8 n, void (*callback)() )
 		cpuSetNextEvent( cpuRegs.sCycle[n], cpuRegs.eCycle[n] );
 }
 
+// These are 'pcsx2 interrupts', they handle asynchronous stuff that depends on the cycle timings.
+// Keep the order stable, it decides which handler runs first when several are due in one test.
+static constexpr CpuEventTable<15> s_ee_events({{
+	{VU_MTVU_BUSY,		MTVUInterrupt},
+	{DMAC_VIF1,			vif1Interrupt},
+	{DMAC_GIF,			gifInterrupt},
+	{DMAC_SIF0,			EEsif0Interrupt},
+	{DMAC_SIF1,			EEsif1Interrupt},
+	{DMAC_VIF0,			vif0Interrupt},
+	{DMAC_FROM_IPU,		ipu0Interrupt},
+	{DMAC_TO_IPU,		ipu1Interrupt},
+	{IPU_PROCESS,		ipuCMDProcess},
+	{DMAC_FROM_SPR,		SPRFROMinterrupt},
+	{DMAC_TO_SPR,		SPRTOinterrupt},
+	{DMAC_MFIFO_VIF,	vifMFIFOInterrupt},
+	{DMAC_MFIFO_GIF,	gifMFIFOInterrupt},
+	{VIF_VU0_FINISH,	vif0VUFinish},
+	{VIF_VU1_FINISH,	vif1VUFinish},
+}});
+
 // [TODO] move this function to Dmac.cpp, and remove most of the DMAC-related headers from
 // being included into R5900.cpp.
 static __fi bool _cpuTestInterrupts()
@@ -298,36 +319,8 @@ static __fi bool _cpuTestInterrupts()
 		//Console.Write("DMAC Disabled or suspended");
 		return false;
 	}
-	/* These are 'pcsx2 interrupts', they handle asynchronous stuff
-	   that depends on the cycle timings */
-	TESTINT(VU_MTVU_BUSY,	MTVUInterrupt);
-	TESTINT(DMAC_VIF1,		vif1Interrupt);
-	TESTINT(DMAC_GIF,		gifInterrupt);
-	TESTINT(DMAC_SIF0,		EEsif0Interrupt);
-	TESTINT(DMAC_SIF1,		EEsif1Interrupt);
-	// Profile-guided Optimization (sorta)
-	// The following ints are rarely called.  Encasing them in a conditional
-	// as follows helps speed up most games.
-
-	if (cpuRegs.interrupt & ((1 << DMAC_VIF0) | (1 << DMAC_FROM_IPU) | (1 << DMAC_TO_IPU)
-		| (1 << DMAC_FROM_SPR) | (1 << DMAC_TO_SPR) | (1 << DMAC_MFIFO_VIF) | (1 << DMAC_MFIFO_GIF)
-		| (1 << VIF_VU0_FINISH) | (1 << VIF_VU1_FINISH) | (1 << IPU_PROCESS)))
-	{
-		TESTINT(DMAC_VIF0,		vif0Interrupt);
-
-		TESTINT(DMAC_FROM_IPU,	ipu0Interrupt);
-		TESTINT(DMAC_TO_IPU,	ipu1Interrupt);
-		TESTINT(IPU_PROCESS,	ipuCMDProcess);
 
-		TESTINT(DMAC_FROM_SPR,	SPRFROMinterrupt);
-		TESTINT(DMAC_TO_SPR,	SPRTOinterrupt);
-
-		TESTINT(DMAC_MFIFO_VIF, vifMFIFOInterrupt);
-		TESTINT(DMAC_MFIFO_GIF, gifMFIFOInterrupt);
-
-		TESTINT(VIF_VU0_FINISH, vif0VUFinish);
-		TESTINT(VIF_VU1_FINISH, vif1VUFinish);
-	}
+	s_ee_events.Dispatch(cpuRegs.interrupt, TESTINT);
 
 	if ((cpuRegs.interrupt & 0x1FFFF) & ~cpuRegs.dmastall)
 		return true;
@@ -824,7 +817,7 @@ int isBreakpointNeeded(u32 addr)
 
 int isMemcheckNeeded(u32 pc)
 {
-	if (CBreakPoints::GetNumMemchecks() == 0)
+	if (CBreakPoints::GetMemCheckIndex(BREAKPOINT_EE).IsEmpty())
 		return 0;
 
 	u32 addr = pc;
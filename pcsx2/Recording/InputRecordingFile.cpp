@@ -16,6 +16,7 @@
 #include "PrecompiledHeader.h"
 
 #include "InputRecordingFile.h"
+#include "InputRecordingFileInternal.h"
 
 #include "Utilities/InputRecordingLogger.h"
 
@@ -25,12 +26,28 @@
 
 #include <fmt/format.h>
 
-#include <vector>
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <vector>
+
+// Version 2 layout, all values little endian:
+//   header   the version 1 header (with the total frames, undo count and savestate flag), followed
+//            by u32 frames per block, u64 index offset and u32 block count
+//   records  u32 magic, two u32 values and a u32 data size, followed by the data
+//            blocks: BLOCK_MAGIC, block number, frame count, then the encoded frames
+//            index:  INDEX_MAGIC, block count, 0, then u64 offset, u32 size, u32 frame count per block
+//
+// A block is appended again whenever it changes, so re-recording leaves its old record behind. The
+// index is written when the file is closed, and the header points to it. While a recording is open
+// the index offset is 0, and if the file was never closed properly the records are scanned from the
+// start instead, the latest record of each block winning.
+static constexpr u32 BLOCK_MAGIC = 0x32425249; // IRB2
+static constexpr u32 INDEX_MAGIC = 0x58495249; // IRIX
 
 void InputRecordingFile::InputRecordingFileHeader::init() noexcept
 {
-	m_fileVersion = 1;
+	m_fileVersion = s_currentFileVersion;
 }
 
 void InputRecordingFile::setEmulatorVersion()
@@ -70,9 +87,14 @@ bool InputRecordingFile::close() noexcept
 	{
 		return false;
 	}
+	if (!isLegacyFormat())
+	{
+		finishWriting();
+	}
 	fclose(m_recordingFile);
 	m_recordingFile = nullptr;
 	m_filename.clear();
+	m_blocks.clear();
 	return true;
 }
 
@@ -103,6 +125,11 @@ void InputRecordingFile::incrementUndoCount()
 	{
 		return;
 	}
+	if (!isLegacyFormat())
+	{
+		queueHeaderWrite();
+		return;
+	}
 	fseek(m_recordingFile, s_seekpointUndoCount, SEEK_SET);
 	fwrite(&m_undoCount, 4, 1, m_recordingFile);
 }
@@ -120,6 +147,16 @@ bool InputRecordingFile::openNew(const std::string& path, bool fromSavestate)
 	m_undoCount = 0;
 	m_header.init();
 	m_savestate = fromSavestate;
+
+	m_blocks.clear();
+	m_framesPerBlock = s_framesPerBlock;
+	m_fileEnd = s_headerSizeV2;
+	m_lastWrittenBlock = 0;
+	m_modified = true;
+	if (!m_writer)
+	{
+		m_writer = std::make_unique<cb::ThreadPool>(1);
+	}
 	return true;
 }
 
@@ -133,6 +170,8 @@ bool InputRecordingFile::openExisting(const std::string& path)
 
 	if (!verifyRecordingFileHeader())
 	{
+		// Nothing has been written, don't let close() touch the file
+		m_header.m_fileVersion = s_legacyFileVersion;
 		close();
 		InputRec::consoleLog("Input recording file header is invalid");
 		return false;
@@ -151,6 +190,19 @@ std::optional<PadData> InputRecordingFile::readPadData(const uint frame, const u
 
 	std::array<u8, s_controllerInputBytes> data{};
 
+	if (!isLegacyFormat())
+	{
+		const size_t index = frame / m_framesPerBlock;
+		const u32 frameInBlock = frame % m_framesPerBlock;
+		if (port >= s_controllerPortsSupported || index >= m_blocks.size() ||
+			frameInBlock >= m_blocks[index].frameCount || !loadBlock(index))
+		{
+			return std::nullopt;
+		}
+		std::memcpy(data.data(), &m_blocks[index].frames[frameInBlock * s_inputBytesPerFrame + s_controllerInputBytes * port], data.size());
+		return PadData(port, slot, data);
+	}
+
 	// TODO - slot unused, use it in the new format
 	const size_t seek = getRecordingBlockSeekPoint(frame) + s_controllerInputBytes * port;
 	if (fseek(m_recordingFile, seek, SEEK_SET) != 0 || fread(&data, 1, 18, m_recordingFile) != 1)
@@ -168,6 +220,11 @@ void InputRecordingFile::setTotalFrames(u32 frame)
 		return;
 	}
 	m_totalFrames = frame;
+	if (!isLegacyFormat())
+	{
+		// Written along with the next block
+		return;
+	}
 	fseek(m_recordingFile, s_seekpointTotalFrames, SEEK_SET);
 	fwrite(&m_totalFrames, 4, 1, m_recordingFile);
 }
@@ -178,6 +235,11 @@ bool InputRecordingFile::writeHeader() const
 	{
 		return false;
 	}
+	if (!isLegacyFormat())
+	{
+		std::unique_lock lock(m_fileMutex);
+		return writeHeaderState(m_recordingFile, captureHeader(0));
+	}
 	rewind(m_recordingFile);
 	if (fwrite(&m_header, sizeof(InputRecordingFileHeader), 1, m_recordingFile) != 1 ||
 		fwrite(&m_totalFrames, 4, 1, m_recordingFile) != 1 ||
@@ -189,13 +251,69 @@ bool InputRecordingFile::writeHeader() const
 	return true;
 }
 
-bool InputRecordingFile::writePadData(const uint frame, const PadData data) const
+bool InputRecordingFile::writePadData(const uint frame, const PadData data)
 {
 	if (m_recordingFile == nullptr)
 	{
 		return false;
 	}
 
+	if (!isLegacyFormat())
+	{
+		const size_t index = frame / m_framesPerBlock;
+		const u32 frameInBlock = frame % m_framesPerBlock;
+		if (data.m_port >= s_controllerPortsSupported)
+		{
+			return false;
+		}
+		if (index >= m_blocks.size())
+		{
+			m_blocks.resize(index + 1);
+		}
+		if (!loadBlock(index))
+		{
+			return false;
+		}
+		if (!m_modified)
+		{
+			// Any index already in the file is stale from here on
+			m_modified = true;
+			queueHeaderWrite();
+		}
+		// Recording has moved on, the previous block can go to disk
+		if (index != m_lastWrittenBlock && m_lastWrittenBlock < m_blocks.size() && m_blocks[m_lastWrittenBlock].dirty)
+		{
+			flushBlock(m_lastWrittenBlock);
+		}
+		m_lastWrittenBlock = index;
+
+		const std::array<u8, s_controllerInputBytes> bytes = {
+			data.m_compactPressFlagsGroupOne,
+			data.m_compactPressFlagsGroupTwo,
+			std::get<0>(data.m_rightAnalog),
+			std::get<1>(data.m_rightAnalog),
+			std::get<0>(data.m_leftAnalog),
+			std::get<1>(data.m_leftAnalog),
+			std::get<1>(data.m_right),
+			std::get<1>(data.m_left),
+			std::get<1>(data.m_up),
+			std::get<1>(data.m_down),
+			std::get<1>(data.m_triangle),
+			std::get<1>(data.m_circle),
+			std::get<1>(data.m_cross),
+			std::get<1>(data.m_square),
+			std::get<1>(data.m_l1),
+			std::get<1>(data.m_r1),
+			std::get<1>(data.m_l2),
+			std::get<1>(data.m_r2),
+		};
+		Block& block = m_blocks[index];
+		std::memcpy(&block.frames[frameInBlock * s_inputBytesPerFrame + s_controllerInputBytes * data.m_port], bytes.data(), bytes.size());
+		block.frameCount = std::max(block.frameCount, frameInBlock + 1);
+		block.dirty = true;
+		return true;
+	}
+
 	// TODO - use the slot in the future
 	const size_t seek = getRecordingBlockSeekPoint(frame) + s_controllerInputBytes * data.m_port;
 
@@ -259,6 +377,11 @@ std::vector<PadData> InputRecordingFile::bulkReadPadData(u32 frameStart, u32 fra
 	return data;
 }
 
+bool InputRecordingFile::isLegacyFormat() const noexcept
+{
+	return m_header.m_fileVersion == s_legacyFileVersion;
+}
+
 size_t InputRecordingFile::getRecordingBlockSeekPoint(const u32 frame) const noexcept
 {
 	return s_headerSize + sizeof(bool) + frame * s_inputBytesPerFrame;
@@ -281,10 +404,344 @@ bool InputRecordingFile::verifyRecordingFileHeader()
 	}
 
 	// Check for current verison
-	if (m_header.m_fileVersion != 1)
+	if (m_header.m_fileVersion != s_legacyFileVersion && m_header.m_fileVersion != s_currentFileVersion)
 	{
 		InputRec::consoleLog(fmt::format("Input recording file is not a supported version - {}", m_header.m_fileVersion));
 		return false;
 	}
+	if (isLegacyFormat())
+	{
+		return true;
+	}
+
+	u64 indexOffset;
+	u32 blockCount;
+	if (fread(&m_framesPerBlock, 4, 1, m_recordingFile) != 1 ||
+		fread(&indexOffset, 8, 1, m_recordingFile) != 1 ||
+		fread(&blockCount, 4, 1, m_recordingFile) != 1 ||
+		m_framesPerBlock == 0 || m_framesPerBlock > 65536)
+	{
+		return false;
+	}
+
+	m_blocks.clear();
+	m_fileEnd = static_cast<u64>(std::max<s64>(FileSystem::FSize64(m_recordingFile), s_headerSizeV2));
+	m_lastWrittenBlock = 0;
+	m_modified = false;
+	if (indexOffset == 0 || !readIndex(indexOffset, blockCount))
+	{
+		recoverBlocks();
+	}
+	if (!m_writer)
+	{
+		m_writer = std::make_unique<cb::ThreadPool>(1);
+	}
+	return true;
+}
+
+InputRecordingFile::HeaderState InputRecordingFile::captureHeader(u64 indexOffset) const
+{
+	HeaderState state;
+	state.header = m_header;
+	state.totalFrames = static_cast<u32>(m_totalFrames);
+	state.undoCount = static_cast<u32>(m_undoCount);
+	state.savestate = m_savestate;
+	state.framesPerBlock = m_framesPerBlock;
+	state.indexOffset = indexOffset;
+	state.blockCount = static_cast<u32>(m_blocks.size());
+	return state;
+}
+
+bool InputRecordingFile::writeHeaderState(FILE* fp, const HeaderState& state)
+{
+	return FileSystem::FSeek64(fp, 0, SEEK_SET) == 0 &&
+		   fwrite(&state.header, sizeof(InputRecordingFileHeader), 1, fp) == 1 &&
+		   fwrite(&state.totalFrames, 4, 1, fp) == 1 &&
+		   fwrite(&state.undoCount, 4, 1, fp) == 1 &&
+		   fwrite(&state.savestate, 1, 1, fp) == 1 &&
+		   fwrite(&state.framesPerBlock, 4, 1, fp) == 1 &&
+		   fwrite(&state.indexOffset, 8, 1, fp) == 1 &&
+		   fwrite(&state.blockCount, 4, 1, fp) == 1;
+}
+
+void InputRecordingFile::queueHeaderWrite()
+{
+	m_writer->Schedule([this, state = captureHeader(0)]() {
+		std::unique_lock lock(m_fileMutex);
+		if (!writeHeaderState(m_recordingFile, state))
+		{
+			InputRec::consoleLog("Failed to write the input recording header");
+		}
+		fflush(m_recordingFile);
+	});
+}
+
+bool InputRecordingFile::readIndex(u64 indexOffset, u32 blockCount)
+{
+	u32 record[4];
+	if (FileSystem::FSeek64(m_recordingFile, indexOffset, SEEK_SET) != 0 ||
+		fread(record, sizeof(record), 1, m_recordingFile) != 1 ||
+		record[0] != INDEX_MAGIC || record[1] != blockCount ||
+		record[3] != static_cast<u64>(blockCount) * s_indexEntrySize ||
+		indexOffset + s_blockHeaderSize + record[3] > m_fileEnd)
+	{
+		return false;
+	}
+
+	std::vector<u8> index(record[3]);
+	if (!index.empty() && fread(index.data(), index.size(), 1, m_recordingFile) != 1)
+	{
+		return false;
+	}
+
+	m_blocks.resize(blockCount);
+	for (u32 i = 0; i < blockCount; i++)
+	{
+		Block& block = m_blocks[i];
+		const u8* entry = &index[i * s_indexEntrySize];
+		std::memcpy(&block.offset, entry, 8);
+		std::memcpy(&block.size, entry + 8, 4);
+		std::memcpy(&block.frameCount, entry + 12, 4);
+		if (block.frameCount > m_framesPerBlock || (block.offset != 0 && block.offset + s_blockHeaderSize + block.size > indexOffset))
+		{
+			m_blocks.clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+void InputRecordingFile::recoverBlocks()
+{
+	m_blocks.clear();
+
+	u64 offset = s_headerSizeV2;
+	u32 record[4];
+	while (offset + s_blockHeaderSize <= m_fileEnd &&
+		   FileSystem::FSeek64(m_recordingFile, offset, SEEK_SET) == 0 &&
+		   fread(record, sizeof(record), 1, m_recordingFile) == 1)
+	{
+		// A record cut short by a crash ends the scan
+		const u64 next = offset + s_blockHeaderSize + record[3];
+		if (next > m_fileEnd)
+		{
+			break;
+		}
+		if (record[0] == BLOCK_MAGIC)
+		{
+			if (record[2] > m_framesPerBlock || record[1] > UINT32_MAX / m_framesPerBlock)
+			{
+				break;
+			}
+			if (record[1] >= m_blocks.size())
+			{
+				m_blocks.resize(record[1] + 1);
+			}
+			Block& block = m_blocks[record[1]];
+			block.offset = offset;
+			block.size = record[3];
+			block.frameCount = record[2];
+		}
+		else if (record[0] != INDEX_MAGIC)
+		{
+			break;
+		}
+		offset = next;
+	}
+
+	if (!m_blocks.empty())
+	{
+		const u64 recoveredFrames = static_cast<u64>(m_blocks.size() - 1) * m_framesPerBlock + m_blocks.back().frameCount;
+		m_totalFrames = std::max<u64>(m_totalFrames, recoveredFrames);
+	}
+	InputRec::consoleLog(fmt::format("Input recording file has no block index, recovered {} blocks", m_blocks.size()));
+}
+
+bool InputRecordingFile::loadBlock(size_t index)
+{
+	Block& block = m_blocks[index];
+	if (!block.frames.empty())
+	{
+		return true;
+	}
+
+	std::vector<u8> frames(static_cast<size_t>(m_framesPerBlock) * s_inputBytesPerFrame);
+	if (block.offset != 0)
+	{
+		std::vector<u8> data(block.size);
+		{
+			std::unique_lock lock(m_fileMutex);
+			if (FileSystem::FSeek64(m_recordingFile, block.offset + s_blockHeaderSize, SEEK_SET) != 0 ||
+				(!data.empty() && fread(data.data(), data.size(), 1, m_recordingFile) != 1))
+			{
+				return false;
+			}
+		}
+		if (!InputRecordingBlock::decode(data.data(), data.size(), block.frameCount, s_inputBytesPerFrame, frames.data()))
+		{
+			InputRec::consoleLog(fmt::format("Input recording block {} is corrupted", index));
+			return false;
+		}
+	}
+	block.frames = std::move(frames);
+	return true;
+}
+
+void InputRecordingFile::flushBlock(size_t index)
+{
+	Block& block = m_blocks[index];
+
+	// Encoding a block takes microseconds, only the I/O is left to the writer
+	std::vector<u8> record(s_blockHeaderSize);
+	InputRecordingBlock::encode(block.frames.data(), block.frameCount, s_inputBytesPerFrame, &record);
+	const u32 header[4] = {BLOCK_MAGIC, static_cast<u32>(index), block.frameCount, static_cast<u32>(record.size() - s_blockHeaderSize)};
+	std::memcpy(record.data(), header, sizeof(header));
+
+	block.offset = m_fileEnd;
+	block.size = header[3];
+	block.dirty = false;
+	m_fileEnd += record.size();
+
+	m_writer->Schedule([this, record = std::move(record), offset = block.offset, state = captureHeader(0)]() {
+		std::unique_lock lock(m_fileMutex);
+		if (FileSystem::FSeek64(m_recordingFile, offset, SEEK_SET) != 0 ||
+			fwrite(record.data(), record.size(), 1, m_recordingFile) != 1 ||
+			!writeHeaderState(m_recordingFile, state))
+		{
+			InputRec::consoleLog("Failed to write input recording block");
+		}
+		fflush(m_recordingFile);
+	});
+}
+
+void InputRecordingFile::finishWriting()
+{
+	if (m_modified)
+	{
+		for (size_t i = 0; i < m_blocks.size(); i++)
+		{
+			if (m_blocks[i].dirty)
+			{
+				flushBlock(i);
+			}
+		}
+
+		std::vector<u8> record(s_blockHeaderSize + m_blocks.size() * s_indexEntrySize);
+		const u32 header[4] = {INDEX_MAGIC, static_cast<u32>(m_blocks.size()), 0, static_cast<u32>(record.size() - s_blockHeaderSize)};
+		std::memcpy(record.data(), header, sizeof(header));
+		for (size_t i = 0; i < m_blocks.size(); i++)
+		{
+			u8* entry = &record[s_blockHeaderSize + i * s_indexEntrySize];
+			std::memcpy(entry, &m_blocks[i].offset, 8);
+			std::memcpy(entry + 8, &m_blocks[i].size, 4);
+			std::memcpy(entry + 12, &m_blocks[i].frameCount, 4);
+		}
+
+		m_writer->Schedule([this, record = std::move(record), offset = m_fileEnd, state = captureHeader(m_fileEnd)]() {
+			std::unique_lock lock(m_fileMutex);
+			if (FileSystem::FSeek64(m_recordingFile, offset, SEEK_SET) != 0 ||
+				fwrite(record.data(), record.size(), 1, m_recordingFile) != 1 ||
+				!writeHeaderState(m_recordingFile, state))
+			{
+				InputRec::consoleLog("Failed to write input recording block index");
+			}
+			fflush(m_recordingFile);
+		});
+		m_modified = false;
+	}
+	if (m_writer)
+	{
+		m_writer->Wait();
+	}
+}
+
+void InputRecordingBlock::encode(const u8* frames, u32 frameCount, size_t bytesPerFrame, std::vector<u8>* out)
+{
+	// Columns change rarely from one frame to the next, so the deltas are mostly long runs of zeroes
+	const size_t size = static_cast<size_t>(frameCount) * bytesPerFrame;
+	std::vector<u8> deltas(size);
+	for (size_t column = 0; column < bytesPerFrame; column++)
+	{
+		u8 previous = 0;
+		for (u32 frame = 0; frame < frameCount; frame++)
+		{
+			const u8 value = frames[frame * bytesPerFrame + column];
+			deltas[column * frameCount + frame] = value - previous;
+			previous = value;
+		}
+	}
+
+	// PackBits: a control byte below 128 is followed by that many plus one literal bytes, otherwise
+	// the next byte is repeated control - 126 times
+	size_t pos = 0;
+	while (pos < size)
+	{
+		size_t run = 1;
+		while (pos + run < size && run < 129 && deltas[pos + run] == deltas[pos])
+		{
+			run++;
+		}
+		if (run >= 2)
+		{
+			out->push_back(static_cast<u8>(run + 126));
+			out->push_back(deltas[pos]);
+			pos += run;
+			continue;
+		}
+
+		const size_t start = pos;
+		while (pos < size && pos - start < 128 && (pos + 1 >= size || deltas[pos + 1] != deltas[pos]))
+		{
+			pos++;
+		}
+		out->push_back(static_cast<u8>(pos - start - 1));
+		out->insert(out->end(), deltas.begin() + start, deltas.begin() + pos);
+	}
+}
+
+bool InputRecordingBlock::decode(const u8* data, size_t size, u32 frameCount, size_t bytesPerFrame, u8* frames)
+{
+	const size_t expected = static_cast<size_t>(frameCount) * bytesPerFrame;
+	std::vector<u8> deltas;
+	deltas.reserve(expected);
+
+	size_t pos = 0;
+	while (pos < size)
+	{
+		const u8 control = data[pos++];
+		if (control < 128)
+		{
+			const size_t count = control + 1;
+			if (pos + count > size || deltas.size() + count > expected)
+			{
+				return false;
+			}
+			deltas.insert(deltas.end(), data + pos, data + pos + count);
+			pos += count;
+		}
+		else
+		{
+			const size_t count = control - 126;
+			if (pos >= size || deltas.size() + count > expected)
+			{
+				return false;
+			}
+			deltas.insert(deltas.end(), count, data[pos++]);
+		}
+	}
+	if (deltas.size() != expected)
+	{
+		return false;
+	}
+
+	for (size_t column = 0; column < bytesPerFrame; column++)
+	{
+		u8 value = 0;
+		for (u32 frame = 0; frame < frameCount; frame++)
+		{
+			value += deltas[column * frameCount + frame];
+			frames[frame * bytesPerFrame + column] = value;
+		}
+	}
 	return true;
 }
@@ -18,10 +18,17 @@
 #include "System.h"
 #include "PadData.h"
 
-// NOTE / TODOs for Version 2
-// - Move fromSavestate, undoCount, and total frames into the header
+#include "common/ThreadPool.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
 
 // Handles all operations on the input recording file
+//
+// Version 1 files store every frame uncompressed at a fixed offset. Version 2 files, which are
+// what new recordings use, store the frames in compressed blocks with an index, see
+// InputRecordingFile.cpp for the layout.
 class InputRecordingFile
 {
 	struct InputRecordingFileHeader
@@ -70,7 +77,7 @@ public:
 	// Persist the input recording file header's current state to the file
 	bool writeHeader() const;
 	// Writes the current frame's input data to the file so it can be replayed
-	bool writePadData(const uint frame, const PadData data) const;
+	bool writePadData(const uint frame, const PadData data);
 
 
 	// Retrieve the input recording's filename (not the path)
@@ -94,6 +101,35 @@ private:
 	static constexpr size_t s_seekpointUndoCount = sizeof(InputRecordingFileHeader) + 4;
 	static constexpr size_t s_seekpointSaveStateHeader = s_seekpointUndoCount + 4;
 
+	static constexpr u8 s_legacyFileVersion = 1;
+	static constexpr u8 s_currentFileVersion = 2;
+	static constexpr u32 s_framesPerBlock = 1024;
+	// Version 2 adds the frames per block, index offset and block count after the version 1 header
+	static constexpr size_t s_blockHeaderSize = 16;
+	static constexpr size_t s_indexEntrySize = 16;
+	static constexpr size_t s_headerSizeV2 = s_headerSize + s_recordingSavestateHeaderSize + 4 + 8 + 4;
+
+	// A run of frames, kept decoded in memory once it has been read or written
+	struct Block
+	{
+		std::vector<u8> frames;
+		u64 offset = 0;
+		u32 size = 0;
+		u32 frameCount = 0;
+		bool dirty = false;
+	};
+
+	struct HeaderState
+	{
+		InputRecordingFileHeader header;
+		u32 totalFrames;
+		u32 undoCount;
+		bool savestate;
+		u32 framesPerBlock;
+		u64 indexOffset;
+		u32 blockCount;
+	};
+
 	std::string m_filename = "";
 	FILE* m_recordingFile = nullptr;
 	bool m_savestate = false;
@@ -102,7 +138,27 @@ private:
 	unsigned long m_totalFrames = 0;
 	unsigned long m_undoCount = 0;
 
+	std::vector<Block> m_blocks;
+	u32 m_framesPerBlock = s_framesPerBlock;
+	u64 m_fileEnd = 0;
+	size_t m_lastWrittenBlock = 0;
+	bool m_modified = false;
+
+	// Blocks and header updates are written on this thread, file access is serialised with the mutex
+	std::unique_ptr<cb::ThreadPool> m_writer;
+	mutable std::mutex m_fileMutex;
+
+	bool isLegacyFormat() const noexcept;
 	// Calculates the position of the current frame in the input recording
 	size_t getRecordingBlockSeekPoint(const u32 frame) const noexcept;
 	bool verifyRecordingFileHeader();
+
+	HeaderState captureHeader(u64 indexOffset) const;
+	static bool writeHeaderState(FILE* fp, const HeaderState& state);
+	void queueHeaderWrite();
+	bool readIndex(u64 indexOffset, u32 blockCount);
+	void recoverBlocks();
+	bool loadBlock(size_t index);
+	void flushBlock(size_t index);
+	void finishWriting();
 };
@@ -0,0 +1,31 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Not part of the input recording API, only for the file itself and its tests.
+
+#include "common/Pcsx2Defs.h"
+
+#include <vector>
+
+namespace InputRecordingBlock
+{
+	// Frames are stored column by column, each byte as the difference from the previous frame, then
+	// run-length encoded.
+	void encode(const u8* frames, u32 frameCount, size_t bytesPerFrame, std::vector<u8>* out);
+	// Returns false unless data decodes to exactly frameCount frames.
+	bool decode(const u8* data, size_t size, u32 frameCount, size_t bytesPerFrame, u8* frames);
+} // namespace InputRecordingBlock
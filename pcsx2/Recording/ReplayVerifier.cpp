@@ -0,0 +1,262 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+
+#include "Recording/ReplayVerifier.h"
+
+#include "common/Console.h"
+#include "common/FileSystem.h"
+#include "common/StringUtil.h"
+#include "common/Timer.h"
+
+#include "GS.h"
+#include "GS/GSXXH.h"
+#include "Memory.h"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace ReplayVerifier
+{
+	static u64 HashEERAM();
+	static u64 HashFramebuffer();
+	static void ReportDivergence(const Sample& sample, const Sample& golden);
+
+	static std::FILE* s_log_file = nullptr;
+	static std::vector<Sample> s_golden;
+	static size_t s_golden_pos = 0;
+	static u32 s_interval = 60;
+	static u32 s_sources = HASH_EE_RAM;
+	static std::optional<u32> s_first_divergent_frame;
+
+	static Common::Timer s_frame_timer;
+	static Common::Timer s_total_timer;
+	static u32 s_frames_run = 0;
+	static double s_frames_ms = 0.0;
+	static double s_interval_ms = 0.0;
+	static u32 s_interval_frames = 0;
+	static double s_max_frame_ms = 0.0;
+	static u32 s_max_frame = 0;
+	static bool s_first_vsync = true;
+} // namespace ReplayVerifier
+
+bool ReplayVerifier::ParseLog(const std::string_view& text, std::vector<Sample>* samples)
+{
+	samples->clear();
+	for (const std::string_view& line : StringUtil::SplitString(text, '\n'))
+	{
+		const std::string_view stripped = StringUtil::StripWhitespace(line);
+		if (stripped.empty() || stripped[0] == '#')
+			continue;
+
+		const std::vector<std::string_view> fields = StringUtil::SplitString(stripped, ' ');
+		std::optional<u32> frame;
+		std::optional<u64> ee_ram_hash, framebuffer_hash;
+		if (fields.size() < 3 ||
+			!(frame = StringUtil::FromChars<u32>(fields[0])).has_value() ||
+			!(ee_ram_hash = StringUtil::FromChars<u64>(fields[1], 16)).has_value() ||
+			!(framebuffer_hash = StringUtil::FromChars<u64>(fields[2], 16)).has_value())
+		{
+			Console.Error(fmt::format("(ReplayVerifier) Malformed hash log line: {}", stripped));
+			return false;
+		}
+
+		const double ms_per_frame = (fields.size() > 3) ? StringUtil::FromChars<double>(fields[3]).value_or(0.0) : 0.0;
+		samples->push_back({frame.value(), ee_ram_hash.value(), framebuffer_hash.value(), ms_per_frame});
+	}
+
+	// Lookups walk the log in frame order
+	std::stable_sort(samples->begin(), samples->end(), [](const Sample& lhs, const Sample& rhs) { return lhs.frame < rhs.frame; });
+	return true;
+}
+
+std::string ReplayVerifier::FormatSample(const Sample& sample)
+{
+	return fmt::format("{} {:016x} {:016x} {:.3f}", sample.frame, sample.ee_ram_hash, sample.framebuffer_hash, sample.ms_per_frame);
+}
+
+bool ReplayVerifier::SamplesMatch(const Sample& sample, const Sample& golden)
+{
+	if (sample.ee_ram_hash != 0 && golden.ee_ram_hash != 0 && sample.ee_ram_hash != golden.ee_ram_hash)
+		return false;
+	if (sample.framebuffer_hash != 0 && golden.framebuffer_hash != 0 && sample.framebuffer_hash != golden.framebuffer_hash)
+		return false;
+	return true;
+}
+
+bool ReplayVerifier::Initialize(const std::string& log_path, const std::string& golden_path, u32 interval, u32 sources)
+{
+	s_interval = std::max(interval, 1u);
+	s_sources = sources;
+	s_golden.clear();
+	s_golden_pos = 0;
+	s_first_divergent_frame.reset();
+	s_frames_run = 0;
+	s_frames_ms = 0.0;
+	s_interval_ms = 0.0;
+	s_interval_frames = 0;
+	s_max_frame_ms = 0.0;
+	s_max_frame = 0;
+	s_first_vsync = true;
+
+	if (!golden_path.empty())
+	{
+		const std::optional<std::string> golden = FileSystem::ReadFileToString(golden_path.c_str());
+		if (!golden.has_value())
+		{
+			Console.Error(fmt::format("(ReplayVerifier) Failed to read golden hash log '{}'", golden_path));
+			return false;
+		}
+		if (!ParseLog(golden.value(), &s_golden))
+			return false;
+
+		Console.WriteLn(fmt::format("(ReplayVerifier) Comparing against {} samples from '{}'", s_golden.size(), golden_path));
+	}
+
+	if (!log_path.empty())
+	{
+		s_log_file = FileSystem::OpenCFile(log_path.c_str(), "wb");
+		if (!s_log_file)
+		{
+			Console.Error(fmt::format("(ReplayVerifier) Failed to open hash log '{}'", log_path));
+			return false;
+		}
+		std::fprintf(s_log_file, "# frame ee_ram_hash framebuffer_hash ms_per_frame, every %u frames\n", s_interval);
+	}
+
+	return true;
+}
+
+bool ReplayVerifier::OnVSync(u32 frame)
+{
+	if (s_first_divergent_frame.has_value())
+		return false;
+
+	// The first vsync ends the boot or state load, which isn't part of the replay's timing
+	if (s_first_vsync)
+	{
+		s_first_vsync = false;
+		s_total_timer.Reset();
+		s_frame_timer.Reset();
+	}
+	else
+	{
+		const double frame_ms = s_frame_timer.GetTimeMillisecondsAndReset();
+		s_frames_run++;
+		s_frames_ms += frame_ms;
+		s_interval_ms += frame_ms;
+		s_interval_frames++;
+		if (frame_ms > s_max_frame_ms)
+		{
+			s_max_frame_ms = frame_ms;
+			s_max_frame = frame;
+		}
+	}
+
+	if ((frame % s_interval) != 0)
+		return true;
+
+	Sample sample;
+	sample.frame = frame;
+	sample.ee_ram_hash = (s_sources & HASH_EE_RAM) ? HashEERAM() : 0;
+	sample.framebuffer_hash = (s_sources & HASH_FRAMEBUFFER) ? HashFramebuffer() : 0;
+	sample.ms_per_frame = (s_interval_frames > 0) ? (s_interval_ms / s_interval_frames) : 0.0;
+	s_interval_ms = 0.0;
+	s_interval_frames = 0;
+
+	if (s_log_file)
+		std::fprintf(s_log_file, "%s\n", FormatSample(sample).c_str());
+
+	while (s_golden_pos < s_golden.size() && s_golden[s_golden_pos].frame < frame)
+		s_golden_pos++;
+	if (s_golden_pos < s_golden.size() && s_golden[s_golden_pos].frame == frame)
+	{
+		const Sample& golden = s_golden[s_golden_pos++];
+		if (!SamplesMatch(sample, golden))
+		{
+			ReportDivergence(sample, golden);
+			s_first_divergent_frame = frame;
+			return false;
+		}
+	}
+
+	// Hashing is excluded from the frame times
+	s_frame_timer.Reset();
+	return true;
+}
+
+bool ReplayVerifier::Shutdown()
+{
+	const double total_seconds = s_total_timer.GetTimeSeconds();
+	if (s_frames_run > 0)
+	{
+		const double average_ms = s_frames_ms / s_frames_run;
+		Console.WriteLn(fmt::format("(ReplayVerifier) {} frames in {:.2f} seconds, {:.3f} ms/frame average ({:.1f} fps) excluding hashing, slowest frame {} at {:.3f} ms",
+			s_frames_run, total_seconds, average_ms, 1000.0 / std::max(average_ms, 0.001), s_max_frame, s_max_frame_ms));
+	}
+
+	bool result = !s_first_divergent_frame.has_value();
+	if (result && s_golden_pos < s_golden.size())
+	{
+		Console.Error(fmt::format("(ReplayVerifier) Replay ended before golden sample at frame {}", s_golden[s_golden_pos].frame));
+		result = false;
+	}
+	else if (result && !s_golden.empty())
+	{
+		Console.WriteLn(Color_StrongGreen, "(ReplayVerifier) All samples matched the golden log.");
+	}
+
+	if (s_log_file)
+	{
+		std::fclose(s_log_file);
+		s_log_file = nullptr;
+	}
+	s_golden.clear();
+	return result;
+}
+
+std::optional<u32> ReplayVerifier::GetFirstDivergentFrame()
+{
+	return s_first_divergent_frame;
+}
+
+u64 ReplayVerifier::HashEERAM()
+{
+	return GSXXH3_64bits(eeMem->Main, Ps2MemSize::MainRam);
+}
+
+u64 ReplayVerifier::HashFramebuffer()
+{
+	u32 width, height;
+	std::vector<u32> pixels;
+	if (!GetMTGS().SaveMemorySnapshot(0, 0, false, false, &width, &height, &pixels) || pixels.empty())
+		return 0;
+
+	// Fold in the size so a resolution change can't hash the same as the pixels alone
+	const u64 hash = GSXXH3_64bits(pixels.data(), pixels.size() * sizeof(u32));
+	return hash ^ ((static_cast<u64>(width) << 32) | height);
+}
+
+void ReplayVerifier::ReportDivergence(const Sample& sample, const Sample& golden)
+{
+	Console.Error(fmt::format("(ReplayVerifier) Replay diverged at frame {}", sample.frame));
+	if (sample.ee_ram_hash != 0 && golden.ee_ram_hash != 0 && sample.ee_ram_hash != golden.ee_ram_hash)
+		Console.Error(fmt::format("  EE RAM hash {:016x}, expected {:016x}", sample.ee_ram_hash, golden.ee_ram_hash));
+	if (sample.framebuffer_hash != 0 && golden.framebuffer_hash != 0 && sample.framebuffer_hash != golden.framebuffer_hash)
+		Console.Error(fmt::format("  Framebuffer hash {:016x}, expected {:016x}", sample.framebuffer_hash, golden.framebuffer_hash));
+}
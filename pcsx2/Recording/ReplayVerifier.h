@@ -0,0 +1,65 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/Pcsx2Defs.h"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Hashes the machine state every few frames while an input recording plays back, and compares the
+/// hashes against a log from a known good run, for spotting where two builds start to diverge.
+///
+/// A hash log is text, one sample per line: the recording frame, the EE RAM hash and the framebuffer
+/// hash in hex (0 when not taken), then the average wall time per frame since the previous sample.
+/// Lines starting with '#' are comments. The timing column is informational and never compared.
+namespace ReplayVerifier
+{
+	enum HashSource : u32
+	{
+		HASH_EE_RAM = (1 << 0),
+		HASH_FRAMEBUFFER = (1 << 1),
+	};
+
+	struct Sample
+	{
+		u32 frame;
+		u64 ee_ram_hash;
+		u64 framebuffer_hash;
+		double ms_per_frame;
+	};
+
+	bool ParseLog(const std::string_view& text, std::vector<Sample>* samples);
+	std::string FormatSample(const Sample& sample);
+
+	/// Returns false if the samples differ in any hash which both of them have.
+	bool SamplesMatch(const Sample& sample, const Sample& golden);
+
+	/// Either path may be empty. Framebuffer hashes are only stable with the software renderer.
+	bool Initialize(const std::string& log_path, const std::string& golden_path, u32 interval, u32 sources);
+
+	/// Called on the CPU thread once per frame with the recording's frame counter. Returns false
+	/// once a sample did not match the golden log.
+	bool OnVSync(u32 frame);
+
+	/// Prints the timing summary and closes the log. Returns true if the replay matched the golden log
+	/// and reached its last sample.
+	bool Shutdown();
+
+	std::optional<u32> GetFirstDivergentFrame();
+} // namespace ReplayVerifier
@@ -0,0 +1,415 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+
+#include "RewindBuffer.h"
+#include "RewindBufferInternal.h"
+#include "Config.h"
+#include "SaveState.h"
+
+#include "common/Console.h"
+#include "common/SafeArray.inl"
+#include "common/ThreadPool.h"
+#include "common/Timer.h"
+
+#include <zstd.h>
+
+#include <deque>
+#include <future>
+#include <mutex>
+
+static constexpr u32 PAGE_SIZE = 4096;
+
+// Big enough for EE/IOP memory, VRAM, SPU2 RAM and the rest, so the arenas never reallocate while running.
+static constexpr int ARENA_INITIAL_SIZE = 48 * _1mb;
+
+// Speed matters more than ratio here, deltas are mostly sparse pages of RAM.
+static constexpr int COMPRESSION_LEVEL = 1;
+
+namespace RewindBuffer
+{
+	namespace
+	{
+		/// An older snapshot, stored as its pages which differ from the snapshot after it.
+		struct Delta
+		{
+			u32 frame;
+			u32 size;
+			std::vector<ArchiveEntry> entries;
+			std::vector<u32> pages;
+
+			u32 raw_size;
+			std::vector<u8> compressed;
+			bool stored_uncompressed = false;
+
+			/// Compressed payload and whether compression was skipped, until the worker finishes.
+			std::future<std::pair<std::vector<u8>, bool>> pending;
+		};
+	} // namespace
+
+	static size_t GetUsedSize(const ArchiveEntryList& list);
+	static bool TakeSnapshot();
+	static void CollectCompressedDeltas(bool wait);
+	static void EnforceBudget();
+	static bool ApplyDelta(Delta& delta);
+	static bool PopDelta();
+
+	static CaptureFunction s_capture = SaveState_DownloadState;
+	static RestoreFunction s_restore = SaveState_LoadFromMemory;
+
+	static bool s_active = false;
+	static u32 s_frequency = 0;
+	static u64 s_budget = 0;
+	static u32 s_frame_counter = 0;
+	static u32 s_frames_until_snapshot = 0;
+
+	/// Newest snapshot, uncompressed, and the buffer the next snapshot is captured into.
+	static std::unique_ptr<ArchiveEntryList> s_head;
+	static std::unique_ptr<ArchiveEntryList> s_arena;
+	static u32 s_head_frame = 0;
+	static u32 s_head_size = 0;
+
+	static std::deque<Delta> s_deltas;
+	static u64 s_delta_bytes = 0;
+	static std::unique_ptr<cb::ThreadPool> s_compress_pool;
+
+	static std::mutex s_stats_mutex;
+	static Stats s_stats = {};
+} // namespace RewindBuffer
+
+size_t RewindBuffer::GetUsedSize(const ArchiveEntryList& list)
+{
+	size_t size = 0;
+	for (size_t i = 0; i < list.GetLength(); i++)
+		size = std::max<size_t>(size, list[i].GetDataIndex() + list[i].GetDataSize());
+	return size;
+}
+
+void RewindBuffer::Initialize()
+{
+	if (!EmuConfig.Rewind.Enabled)
+		return;
+
+	s_active = true;
+	s_frequency = EmuConfig.Rewind.Frequency;
+	s_budget = static_cast<u64>(EmuConfig.Rewind.BufferSizeMB) * _1mb;
+	s_frame_counter = 0;
+	s_frames_until_snapshot = s_frequency;
+
+	s_head = std::make_unique<ArchiveEntryList>(new VmStateBuffer("Rewind Snapshot"));
+	s_arena = std::make_unique<ArchiveEntryList>(new VmStateBuffer("Rewind Snapshot"));
+	s_head->GetBuffer()->MakeRoomFor(ARENA_INITIAL_SIZE);
+	s_arena->GetBuffer()->MakeRoomFor(ARENA_INITIAL_SIZE);
+	s_head_size = 0;
+
+	s_compress_pool = std::make_unique<cb::ThreadPool>(1);
+
+	std::unique_lock lock(s_stats_mutex);
+	s_stats = {};
+	s_stats.budget_bytes = s_budget;
+	s_stats.arena_bytes = static_cast<u64>(ARENA_INITIAL_SIZE) * 2;
+
+	Console.WriteLn("(RewindBuffer) Taking snapshots every %u frames, %u MB budget.", s_frequency, EmuConfig.Rewind.BufferSizeMB);
+}
+
+void RewindBuffer::Shutdown()
+{
+	if (s_compress_pool)
+		s_compress_pool->Wait();
+
+	s_deltas.clear();
+	s_delta_bytes = 0;
+	s_compress_pool.reset();
+	s_head.reset();
+	s_arena.reset();
+	s_head_size = 0;
+	s_active = false;
+
+	std::unique_lock lock(s_stats_mutex);
+	s_stats = {};
+}
+
+void RewindBuffer::UpdateConfig()
+{
+	if (s_active == EmuConfig.Rewind.Enabled && s_frequency == EmuConfig.Rewind.Frequency &&
+		s_budget == static_cast<u64>(EmuConfig.Rewind.BufferSizeMB) * _1mb)
+	{
+		return;
+	}
+
+	Shutdown();
+	Initialize();
+}
+
+bool RewindBuffer::IsActive()
+{
+	return s_active;
+}
+
+void RewindBuffer::OnVSync()
+{
+	if (!s_active)
+		return;
+
+	s_frame_counter++;
+	if (--s_frames_until_snapshot > 0)
+		return;
+
+	s_frames_until_snapshot = s_frequency;
+	if (!TakeSnapshot())
+	{
+		Console.Error("(RewindBuffer) Failed to take snapshot, disabling rewind.");
+		Shutdown();
+	}
+}
+
+bool RewindBuffer::TakeSnapshot()
+{
+	Common::Timer timer;
+
+	try
+	{
+		s_capture(s_arena.get());
+	}
+	catch (std::exception& e)
+	{
+		Console.Error("(RewindBuffer) %s", e.what());
+		return false;
+	}
+
+	const u32 new_size = static_cast<u32>(GetUsedSize(*s_arena));
+	const u8* new_data = s_arena->GetPtr(0);
+	u32 dirty_pages = 0;
+	u32 total_pages = 0;
+	u32 raw_size = 0;
+
+	if (s_head_size > 0)
+	{
+		// Keep the pages of the previous snapshot which this one overwrote. Anything past the end of the
+		// new snapshot counts as changed, since the layout can shift when a component grows.
+		const u8* old_data = s_head->GetPtr(0);
+		Delta delta;
+		delta.frame = s_head_frame;
+		delta.size = s_head_size;
+		delta.entries.reserve(s_head->GetLength());
+		for (size_t i = 0; i < s_head->GetLength(); i++)
+			delta.entries.push_back((*s_head)[static_cast<uint>(i)]);
+
+		total_pages = (s_head_size + PAGE_SIZE - 1) / PAGE_SIZE;
+		for (u32 page = 0; page < total_pages; page++)
+		{
+			const u32 offset = page * PAGE_SIZE;
+			const u32 size = std::min(PAGE_SIZE, s_head_size - offset);
+			if (offset + size > new_size || std::memcmp(old_data + offset, new_data + offset, size) != 0)
+				delta.pages.push_back(page);
+		}
+
+		auto payload = std::make_shared<std::vector<u8>>();
+		payload->reserve(delta.pages.size() * PAGE_SIZE);
+		for (const u32 page : delta.pages)
+		{
+			const u32 offset = page * PAGE_SIZE;
+			payload->insert(payload->end(), old_data + offset, old_data + offset + std::min(PAGE_SIZE, s_head_size - offset));
+		}
+
+		dirty_pages = static_cast<u32>(delta.pages.size());
+		raw_size = static_cast<u32>(payload->size());
+		delta.raw_size = raw_size;
+		delta.pending = s_compress_pool->ScheduleAndGetFuture([payload]() {
+			Common::Timer compress_timer;
+			std::vector<u8> compressed(ZSTD_compressBound(payload->size()));
+			const size_t compressed_size = ZSTD_compress(compressed.data(), compressed.size(), payload->data(), payload->size(), COMPRESSION_LEVEL);
+			const bool stored = ZSTD_isError(compressed_size);
+			if (stored)
+			{
+				compressed = std::move(*payload);
+			}
+			else
+			{
+				compressed.resize(compressed_size);
+				compressed.shrink_to_fit();
+			}
+
+			std::unique_lock lock(s_stats_mutex);
+			s_stats.last_compress_ms = static_cast<float>(compress_timer.GetTimeMilliseconds());
+			s_stats.last_delta_compressed_bytes = compressed.size();
+			return std::make_pair(std::move(compressed), stored);
+		});
+
+		s_delta_bytes += raw_size;
+		s_deltas.push_back(std::move(delta));
+	}
+
+	std::swap(s_head, s_arena);
+	s_head_frame = s_frame_counter;
+	s_head_size = new_size;
+
+	CollectCompressedDeltas(false);
+	EnforceBudget();
+
+	std::unique_lock lock(s_stats_mutex);
+	s_stats.last_capture_ms = static_cast<float>(timer.GetTimeMilliseconds());
+	s_stats.last_dirty_pages = dirty_pages;
+	s_stats.last_total_pages = total_pages;
+	s_stats.last_delta_raw_bytes = raw_size;
+	s_stats.arena_bytes = static_cast<u64>(s_head->GetBuffer()->GetSizeInBytes()) + s_arena->GetBuffer()->GetSizeInBytes();
+	return true;
+}
+
+void RewindBuffer::CollectCompressedDeltas(bool wait)
+{
+	for (Delta& delta : s_deltas)
+	{
+		if (!delta.pending.valid())
+			continue;
+
+		if (!wait && delta.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			continue;
+
+		std::tie(delta.compressed, delta.stored_uncompressed) = delta.pending.get();
+		s_delta_bytes = s_delta_bytes - delta.raw_size + delta.compressed.size();
+	}
+}
+
+void RewindBuffer::EnforceBudget()
+{
+	while (!s_deltas.empty() && s_delta_bytes > s_budget)
+	{
+		const Delta& oldest = s_deltas.front();
+		s_delta_bytes -= oldest.pending.valid() ? oldest.raw_size : oldest.compressed.size();
+		s_deltas.pop_front();
+	}
+
+	std::unique_lock lock(s_stats_mutex);
+	s_stats.snapshot_count = static_cast<u32>(s_deltas.size()) + ((s_head_size > 0) ? 1 : 0);
+	s_stats.frames_covered = s_frame_counter - (s_deltas.empty() ? s_head_frame : s_deltas.front().frame);
+	s_stats.delta_bytes = s_delta_bytes;
+}
+
+bool RewindBuffer::ApplyDelta(Delta& delta)
+{
+	std::vector<u8> payload;
+	if (delta.stored_uncompressed)
+	{
+		payload = std::move(delta.compressed);
+	}
+	else
+	{
+		payload.resize(delta.raw_size);
+		const size_t size = ZSTD_decompress(payload.data(), payload.size(), delta.compressed.data(), delta.compressed.size());
+		if (ZSTD_isError(size) || size != delta.raw_size)
+			return false;
+	}
+
+	s_head->GetBuffer()->MakeRoomFor(static_cast<int>(delta.size));
+	u8* data = s_head->GetPtr(0);
+	size_t pos = 0;
+	for (const u32 page : delta.pages)
+	{
+		const u32 offset = page * PAGE_SIZE;
+		const u32 size = std::min(PAGE_SIZE, delta.size - offset);
+		if (pos + size > payload.size())
+			return false;
+
+		std::memcpy(data + offset, payload.data() + pos, size);
+		pos += size;
+	}
+
+	s_head->Clear();
+	for (const ArchiveEntry& entry : delta.entries)
+		s_head->Add(entry);
+
+	s_head_frame = delta.frame;
+	s_head_size = delta.size;
+	return true;
+}
+
+bool RewindBuffer::Rewind(u32 steps)
+{
+	if (!s_active || s_head_size == 0 || steps == 0)
+		return false;
+
+	Common::Timer timer;
+	CollectCompressedDeltas(true);
+
+	// Step 1 is the newest snapshot itself, each further step walks one delta back.
+	steps = std::min<u32>(steps, static_cast<u32>(s_deltas.size()) + 1);
+	for (u32 i = 1; i < steps; i++)
+	{
+		if (!PopDelta())
+			return false;
+	}
+
+	try
+	{
+		s_restore(*s_head);
+	}
+	catch (Exception::BaseException& e)
+	{
+		Console.Error("(RewindBuffer) Failed to load snapshot: %s", e.DiagMsg().c_str());
+		return false;
+	}
+	catch (std::exception& e)
+	{
+		Console.Error("(RewindBuffer) Failed to load snapshot: %s", e.what());
+		return false;
+	}
+
+	// Continue from the restored snapshot, the frames after it no longer happened.
+	s_frame_counter = s_head_frame;
+	s_frames_until_snapshot = s_frequency;
+
+	// The restored snapshot is the present now, so drop it as well. Rewinding again before the
+	// next snapshot is taken then goes to the one before it, rather than restoring this one again.
+	if (s_deltas.empty())
+		s_head_size = 0;
+	else if (!PopDelta())
+		return true;
+
+	EnforceBudget();
+
+	DevCon.WriteLn("(RewindBuffer) Rewound %u snapshots in %.2f ms", steps, timer.GetTimeMilliseconds());
+	return true;
+}
+
+bool RewindBuffer::PopDelta()
+{
+	Delta& delta = s_deltas.back();
+	s_delta_bytes -= delta.compressed.size();
+	const bool ok = ApplyDelta(delta);
+	const u32 frame = delta.frame;
+	s_deltas.pop_back();
+	if (!ok)
+	{
+		Console.Error("(RewindBuffer) Delta for frame %u is corrupted, dropping all snapshots.", frame);
+		Shutdown();
+		Initialize();
+	}
+
+	return ok;
+}
+
+void RewindBuffer::SetStateFunctions(CaptureFunction capture, RestoreFunction restore)
+{
+	s_capture = capture ? capture : static_cast<CaptureFunction>(SaveState_DownloadState);
+	s_restore = restore ? restore : SaveState_LoadFromMemory;
+}
+
+RewindBuffer::Stats RewindBuffer::GetStats()
+{
+	std::unique_lock lock(s_stats_mutex);
+	return s_stats;
+}
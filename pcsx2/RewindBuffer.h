@@ -0,0 +1,76 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/Pcsx2Defs.h"
+
+/// Ring of in-memory savestate snapshots, taken every few frames, for stepping backwards.
+///
+/// The most recent snapshot is kept uncompressed. Each older snapshot is stored as the pages which
+/// differ from the snapshot after it, compressed with zstd on a worker thread, so stepping back means
+/// patching the newest snapshot backwards one delta at a time. Deltas are dropped oldest first once
+/// the memory budget is exceeded.
+namespace RewindBuffer
+{
+	struct Stats
+	{
+		/// Number of snapshots which can be restored, including the uncompressed one.
+		u32 snapshot_count;
+
+		/// Frames between the oldest snapshot and now.
+		u32 frames_covered;
+
+		/// Bytes held by compressed deltas, and the configured limit for them.
+		u64 delta_bytes;
+		u64 budget_bytes;
+
+		/// Bytes held by the uncompressed newest snapshot and the capture arena.
+		u64 arena_bytes;
+
+		/// Cost of the last snapshot: CPU thread time to capture and diff, worker time to compress.
+		float last_capture_ms;
+		float last_compress_ms;
+
+		/// Pages which changed since the previous snapshot, out of the pages in the snapshot.
+		u32 last_dirty_pages;
+		u32 last_total_pages;
+
+		/// Size of the last delta before and after compression.
+		u64 last_delta_raw_bytes;
+		u64 last_delta_compressed_bytes;
+	};
+
+	/// Allocates the buffer according to EmuConfig.Rewind. Snapshots start on the next vsync.
+	void Initialize();
+
+	/// Waits for pending compression and frees all snapshots.
+	void Shutdown();
+
+	/// Re-reads EmuConfig.Rewind, dropping all snapshots if the buffer was disabled or resized.
+	void UpdateConfig();
+
+	bool IsActive();
+
+	/// Called once per frame on the CPU thread, takes a snapshot every EmuConfig.Rewind.Frequency frames.
+	void OnVSync();
+
+	/// Restores the snapshot the specified number of steps back, 1 being the most recent one.
+	/// The restored snapshot and the ones newer than it are discarded, so rewinding by one step
+	/// repeatedly walks back through the snapshots.
+	bool Rewind(u32 steps);
+
+	Stats GetStats();
+} // namespace RewindBuffer
@@ -0,0 +1,30 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Not part of the rewind API, only for the buffer itself and its tests.
+
+class ArchiveEntryList;
+
+namespace RewindBuffer
+{
+	using CaptureFunction = void (*)(ArchiveEntryList* list);
+	using RestoreFunction = void (*)(const ArchiveEntryList& list);
+
+	/// Replaces the savestate functions snapshots are taken and restored with, so the buffer can run
+	/// without a VM. Passing nullptr goes back to the savestate system.
+	void SetStateFunctions(CaptureFunction capture, RestoreFunction restore);
+} // namespace RewindBuffer
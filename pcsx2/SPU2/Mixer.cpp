@@ -342,35 +342,6 @@ static __forceinline void CalculateADSR(V_Core& thiscore, uint voiceidx)
 	pxAssume(vc.ADSR.Value >= 0); // ADSR should never be negative...
 }
 
-__forceinline static s32 GaussianInterpolate(s32 pv4, s32 pv3, s32 pv2, s32 pv1, s32 i)
-{
-	s32 out = 0;
-	out =  (interpTable[0x0FF - i] * pv4) >> 15;
-	out += (interpTable[0x1FF - i] * pv3) >> 15;
-	out += (interpTable[0x100 + i] * pv2) >> 15;
-	out += (interpTable[0x000 + i] * pv1) >> 15;
-
-	return out;
-}
-
-static __forceinline s32 GetVoiceValues(V_Core& thiscore, uint voiceidx)
-{
-	V_Voice& vc(thiscore.Voices[voiceidx]);
-
-	while (vc.SP >= 0)
-	{
-		vc.PV4 = vc.PV3;
-		vc.PV3 = vc.PV2;
-		vc.PV2 = vc.PV1;
-		vc.PV1 = GetNextDataBuffered(thiscore, voiceidx);
-		vc.SP -= 0x1000;
-	}
-
-	const s32 mu = vc.SP + 0x1000;
-
-	return GaussianInterpolate(vc.PV4, vc.PV3, vc.PV2, vc.PV1, (mu & 0x0ff0) >> 4);
-}
-
 // This is Dr. Hell's noise algorithm as implemented in pcsxr
 // Supposedly this is 100% accurate
 static __forceinline void UpdateNoise(V_Core& thiscore)
@@ -441,7 +412,9 @@ static __forceinline void spu2M_WriteFast(u32 addr, s16 value)
 }
 
 
-static __forceinline StereoOut32 MixVoice(uint coreidx, uint voiceidx)
+// First pass for one voice. Returns true if the voice was playing, in which case its lanes hold the
+// samples and envelope to output.
+static __forceinline bool PrepareVoice(VoiceMixLanes& lanes, uint coreidx, uint voiceidx)
 {
 	V_Core& thiscore(Cores[coreidx]);
 	V_Voice& vc(thiscore.Voices[voiceidx]);
@@ -462,45 +435,144 @@ static __forceinline StereoOut32 MixVoice(uint coreidx, uint voiceidx)
 
 	UpdatePitch(coreidx, voiceidx);
 
-	StereoOut32 voiceOut(0, 0);
-	s32 Value = 0;
+	lanes.VolL[voiceidx] = vc.Volume.Left.Value;
+	lanes.VolR[voiceidx] = vc.Volume.Right.Value;
+	lanes.DryL[voiceidx] = thiscore.VoiceGates[voiceidx].DryL;
+	lanes.DryR[voiceidx] = thiscore.VoiceGates[voiceidx].DryR;
+	lanes.WetL[voiceidx] = thiscore.VoiceGates[voiceidx].WetL;
+	lanes.WetR[voiceidx] = thiscore.VoiceGates[voiceidx].WetR;
 
 	if (vc.ADSR.Phase > 0)
 	{
 		if (vc.Noise)
-			Value = GetNoiseValues(thiscore);
+		{
+			lanes.Coef[0][voiceidx] = 0x8000;
+			lanes.Coef[1][voiceidx] = 0;
+			lanes.Coef[2][voiceidx] = 0;
+			lanes.Coef[3][voiceidx] = 0;
+			lanes.PV[0][voiceidx] = GetNoiseValues(thiscore);
+			lanes.PV[1][voiceidx] = 0;
+			lanes.PV[2][voiceidx] = 0;
+			lanes.PV[3][voiceidx] = 0;
+		}
 		else
-			Value = GetVoiceValues(thiscore, voiceidx);
+		{
+			while (vc.SP >= 0)
+			{
+				vc.PV4 = vc.PV3;
+				vc.PV3 = vc.PV2;
+				vc.PV2 = vc.PV1;
+				vc.PV1 = GetNextDataBuffered(thiscore, voiceidx);
+				vc.SP -= 0x1000;
+			}
+
+			const s32 i = ((vc.SP + 0x1000) & 0x0ff0) >> 4;
+			lanes.Coef[0][voiceidx] = interpTable[0x0FF - i];
+			lanes.Coef[1][voiceidx] = interpTable[0x1FF - i];
+			lanes.Coef[2][voiceidx] = interpTable[0x100 + i];
+			lanes.Coef[3][voiceidx] = interpTable[0x000 + i];
+			lanes.PV[0][voiceidx] = vc.PV4;
+			lanes.PV[1][voiceidx] = vc.PV3;
+			lanes.PV[2][voiceidx] = vc.PV2;
+			lanes.PV[3][voiceidx] = vc.PV1;
+		}
 
-		// Update and Apply ADSR  (applies to normal and noise sources)
-		//
 		// Note!  It's very important that ADSR stay as accurate as possible.  By the way
 		// it is used, various sound effects can end prematurely if we truncate more than
 		// one or two bits.  Best result comes from no truncation at all, which is why we
 		// use a full 64-bit multiply/result here.
 
 		CalculateADSR(thiscore, voiceidx);
-		Value = ApplyVolume(Value, vc.ADSR.Value);
-		vc.OutX = Value;
-
-		if (IsDevBuild)
-			DebugCores[coreidx].Voices[voiceidx].displayPeak = std::max(DebugCores[coreidx].Voices[voiceidx].displayPeak, (s32)vc.OutX);
-
-		voiceOut = ApplyVolume(StereoOut32(Value, Value), vc.Volume);
+		lanes.Envelope[voiceidx] = vc.ADSR.Value;
+		return true;
 	}
 	else
 	{
 		while (vc.SP >= 0)
 			GetNextDataDummy(thiscore, voiceidx); // Dummy is enough
+
+		for (int n = 0; n < 4; n++)
+		{
+			lanes.Coef[n][voiceidx] = 0;
+			lanes.PV[n][voiceidx] = 0;
+		}
+		lanes.Envelope[voiceidx] = 0;
+		return false;
+	}
+}
+
+// Scalar version of the second pass for a single voice, for values needed before the rest of the
+// voices have been prepared.
+static __forceinline s32 GetPreparedValue(const VoiceMixLanes& lanes, uint voiceidx)
+{
+	s32 out = 0;
+	for (int n = 0; n < 4; n++)
+		out += (lanes.Coef[n][voiceidx] * lanes.PV[n][voiceidx]) >> 15;
+
+	return ApplyVolume(out, lanes.Envelope[voiceidx]);
+}
+
+static __forceinline __m128i MulShr32x4(__m128i a, __m128i b)
+{
+	// _mm_mul_epi32 only multiplies the even lanes, so do the odd ones shifted down and merge the high halves.
+	const __m128i even = _mm_srli_epi64(_mm_mul_epi32(a, b), 32);
+	const __m128i odd = _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_blend_epi16(even, odd, 0xCC);
+}
+
+// Second pass, four voices at a time.
+void MixVoiceLanes(VoiceMixLanes& lanes, VoiceMixSet& dest)
+{
+	__m128i dry_l = _mm_setzero_si128();
+	__m128i dry_r = _mm_setzero_si128();
+	__m128i wet_l = _mm_setzero_si128();
+	__m128i wet_r = _mm_setzero_si128();
+
+	for (uint voiceidx = 0; voiceidx < V_Core::NumVoices; voiceidx += 4)
+	{
+		const auto load = [voiceidx](const s32* lane) { return _mm_load_si128(reinterpret_cast<const __m128i*>(lane + voiceidx)); };
+
+		__m128i value = _mm_srai_epi32(_mm_mullo_epi32(load(lanes.Coef[0]), load(lanes.PV[0])), 15);
+		value = _mm_add_epi32(value, _mm_srai_epi32(_mm_mullo_epi32(load(lanes.Coef[1]), load(lanes.PV[1])), 15));
+		value = _mm_add_epi32(value, _mm_srai_epi32(_mm_mullo_epi32(load(lanes.Coef[2]), load(lanes.PV[2])), 15));
+		value = _mm_add_epi32(value, _mm_srai_epi32(_mm_mullo_epi32(load(lanes.Coef[3]), load(lanes.PV[3])), 15));
+
+		// Data is shifted up by 1 bit to give the output an effective 16 bit range, see ApplyVolume().
+		value = MulShr32x4(_mm_slli_epi32(value, 1), load(lanes.Envelope));
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes.Value + voiceidx), value);
+
+		const __m128i shifted = _mm_slli_epi32(value, 1);
+		const __m128i left = MulShr32x4(shifted, load(lanes.VolL));
+		const __m128i right = MulShr32x4(shifted, load(lanes.VolR));
+
+		// Note: Results from MixVoice are ranged at 16 bits.
+		dry_l = _mm_add_epi32(dry_l, _mm_and_si128(left, load(lanes.DryL)));
+		dry_r = _mm_add_epi32(dry_r, _mm_and_si128(right, load(lanes.DryR)));
+		wet_l = _mm_add_epi32(wet_l, _mm_and_si128(left, load(lanes.WetL)));
+		wet_r = _mm_add_epi32(wet_r, _mm_and_si128(right, load(lanes.WetR)));
 	}
 
-	// Write-back of raw voice data (post ADSR applied)
-	if (voiceidx == 1)
-		spu2M_WriteFast(((0 == coreidx) ? 0x400 : 0xc00) + OutPos, Value);
-	else if (voiceidx == 3)
-		spu2M_WriteFast(((0 == coreidx) ? 0x600 : 0xe00) + OutPos, Value);
+	dest.Dry.Left += HorizontalSum(dry_l);
+	dest.Dry.Right += HorizontalSum(dry_r);
+	dest.Wet.Left += HorizontalSum(wet_l);
+	dest.Wet.Right += HorizontalSum(wet_r);
+}
 
-	return voiceOut;
+// Per voice scalar version of MixVoiceLanes, which has to match it bit for bit.
+void MixVoiceLanes_reference(VoiceMixLanes& lanes, VoiceMixSet& dest)
+{
+	for (uint voiceidx = 0; voiceidx < V_Core::NumVoices; ++voiceidx)
+	{
+		const s32 value = GetPreparedValue(lanes, voiceidx);
+		lanes.Value[voiceidx] = value;
+
+		const s32 left = ApplyVolume(value, lanes.VolL[voiceidx]);
+		const s32 right = ApplyVolume(value, lanes.VolR[voiceidx]);
+		dest.Dry.Left += left & lanes.DryL[voiceidx];
+		dest.Dry.Right += right & lanes.DryR[voiceidx];
+		dest.Wet.Left += left & lanes.WetL[voiceidx];
+		dest.Wet.Right += right & lanes.WetR[voiceidx];
+	}
 }
 
 const VoiceMixSet VoiceMixSet::Empty((StereoOut32()), (StereoOut32())); // Don't use SteroOut32::Empty because C++ doesn't make any dep/order checks on global initializers.
@@ -508,17 +580,40 @@ const VoiceMixSet VoiceMixSet::Empty((StereoOut32()), (StereoOut32())); // Don't
 static __forceinline void MixCoreVoices(VoiceMixSet& dest, const uint coreidx)
 {
 	V_Core& thiscore(Cores[coreidx]);
+	VoiceMixLanes lanes;
+	u32 playing = 0;
 
 	for (uint voiceidx = 0; voiceidx < V_Core::NumVoices; ++voiceidx)
 	{
-		StereoOut32 VVal(MixVoice(coreidx, voiceidx));
+		if (PrepareVoice(lanes, coreidx, voiceidx))
+		{
+			playing |= 1u << voiceidx;
 
-		// Note: Results from MixVoice are ranged at 16 bits.
+			// The next voice's pitch reads this one's output, so it can't wait for the second pass.
+			if (voiceidx + 1 < V_Core::NumVoices && thiscore.Voices[voiceidx + 1].Modulated)
+				thiscore.Voices[voiceidx].OutX = GetPreparedValue(lanes, voiceidx);
+		}
 
-		dest.Dry.Left += VVal.Left & thiscore.VoiceGates[voiceidx].DryL;
-		dest.Dry.Right += VVal.Right & thiscore.VoiceGates[voiceidx].DryR;
-		dest.Wet.Left += VVal.Left & thiscore.VoiceGates[voiceidx].WetL;
-		dest.Wet.Right += VVal.Right & thiscore.VoiceGates[voiceidx].WetR;
+		// Write-back of raw voice data (post ADSR applied). Later voices may be playing from these
+		// addresses, so this has to happen now too.
+		if (voiceidx == 1)
+			spu2M_WriteFast(((0 == coreidx) ? 0x400 : 0xc00) + OutPos, GetPreparedValue(lanes, voiceidx));
+		else if (voiceidx == 3)
+			spu2M_WriteFast(((0 == coreidx) ? 0x600 : 0xe00) + OutPos, GetPreparedValue(lanes, voiceidx));
+	}
+
+	MixVoiceLanes(lanes, dest);
+
+	// Stopped voices keep their last output.
+	for (uint voiceidx = 0; voiceidx < V_Core::NumVoices; ++voiceidx)
+	{
+		if (!(playing & (1u << voiceidx)))
+			continue;
+
+		thiscore.Voices[voiceidx].OutX = lanes.Value[voiceidx];
+
+		if (IsDevBuild)
+			DebugCores[coreidx].Voices[voiceidx].displayPeak = std::max(DebugCores[coreidx].Voices[voiceidx].displayPeak, lanes.Value[voiceidx]);
 	}
 }
 
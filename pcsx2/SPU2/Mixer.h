@@ -18,3 +18,10 @@
 extern void Mix();
 extern s32 clamp_mix(s32 x);
 extern StereoOut32 clamp_mix(StereoOut32 sample);
+
+static __forceinline s32 HorizontalSum(__m128i v)
+{
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(v);
+}
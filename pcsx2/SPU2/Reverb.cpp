@@ -17,23 +17,6 @@
 #include "Global.h"
 #include <array>
 
-__forceinline s32 V_Core::RevbGetIndexer(s32 offset)
-{
-	u32 pos = ReverbX + offset;
-
-	// Fast and simple single step wrapping, made possible by the preparation of the
-	// effects buffer addresses.
-
-	if (pos > EffectsEndA)
-	{
-		pos -= EffectsEndA + 1;
-		pos += EffectsStartA;
-	}
-
-	assert(pos >= EffectsStartA && pos <= EffectsEndA);
-	return pos;
-}
-
 void V_Core::Reverb_AdvanceBuffer()
 {
 	if (RevBuffers.NeedsUpdated)
@@ -93,18 +76,58 @@ static constexpr std::array<s32, NUM_TAPS> filter_coefs = {
 	-1,
 };
 
+// The even taps, the odd ones are all zero apart from the middle.
+static constexpr u32 NUM_EVEN_TAPS = (NUM_TAPS >> 1) + 1;
+static constexpr std::array<s32, NUM_EVEN_TAPS> MakeEvenCoefs()
+{
+	std::array<s32, NUM_EVEN_TAPS> coefs = {};
+	for (u32 i = 0; i < NUM_EVEN_TAPS; i++)
+		coefs[i] = filter_coefs[i * 2];
+	return coefs;
+}
+alignas(16) static constexpr std::array<s32, NUM_EVEN_TAPS> even_coefs = MakeEvenCoefs();
+static_assert(NUM_EVEN_TAPS % 4 == 0);
+
+// The resampling buffers hold each sample twice, 64 entries apart, so any window of the ring can
+// be read without wrapping.
+static __forceinline void ReverbBufWrite(s32* buf, u32 pos, s32 value)
+{
+	buf[pos & 63] = value;
+	buf[(pos & 63) + 64] = value;
+}
+
+static __forceinline __m128i ReverbLoad(const s32* src)
+{
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+}
+
+// Products are summed in 32 bits like the scalar filter, so the result is the same in any order.
+static __forceinline s32 ReverbEvenFIR(const s32* window)
+{
+	__m128i acc = _mm_setzero_si128();
+	for (u32 i = 0; i < NUM_EVEN_TAPS; i += 4)
+	{
+		const __m128i taps = _mm_load_si128(reinterpret_cast<const __m128i*>(&even_coefs[i]));
+		acc = _mm_add_epi32(acc, _mm_mullo_epi32(ReverbLoad(window + i), taps));
+	}
+	return HorizontalSum(acc);
+}
+
 s32 __forceinline V_Core::ReverbDownsample(bool right)
 {
-	s32 out = 0;
+	const s32* window = &RevbDownBuf[right][(RevbSampleBufPos - NUM_TAPS) & 63];
 
-	// Skipping the 0 coefs.
-	for (u32 i = 0; i < NUM_TAPS; i += 2)
+	// Gather every other sample of the window, the last pair reads one past its end and drops it.
+	alignas(16) s32 even[NUM_EVEN_TAPS];
+	for (u32 i = 0; i < NUM_EVEN_TAPS; i += 4)
 	{
-		out += RevbDownBuf[right][((RevbSampleBufPos - NUM_TAPS) + i) & 63] * filter_coefs[i];
+		const __m128 lo = _mm_castsi128_ps(ReverbLoad(window + i * 2));
+		const __m128 hi = _mm_castsi128_ps(ReverbLoad(window + i * 2 + 4));
+		_mm_store_si128(reinterpret_cast<__m128i*>(&even[i]), _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0))));
 	}
 
-	// We also skipped the middle so add that in.
-	out += RevbDownBuf[right][((RevbSampleBufPos - NUM_TAPS) + 19) & 63] * filter_coefs[19];
+	// The middle tap is the only odd one.
+	s32 out = ReverbEvenFIR(even) + window[19] * filter_coefs[19];
 
 	out >>= 15;
 	out = std::clamp<s32>(out, INT16_MIN, INT16_MAX);
@@ -115,24 +138,18 @@ s32 __forceinline V_Core::ReverbDownsample(bool right)
 
 StereoOut32 __forceinline V_Core::ReverbUpsample(bool phase)
 {
-	s32 ls = 0, rs = 0;
+	s32 ls, rs;
 
+	const u32 start = ((RevbSampleBufPos - NUM_TAPS) >> 1) & 63;
 	if (phase)
 	{
-		ls += RevbUpBuf[0][(((RevbSampleBufPos - NUM_TAPS) >> 1) + 9) & 63] * filter_coefs[19];
-		rs += RevbUpBuf[1][(((RevbSampleBufPos - NUM_TAPS) >> 1) + 9) & 63] * filter_coefs[19];
+		ls = RevbUpBuf[0][start + 9] * filter_coefs[19];
+		rs = RevbUpBuf[1][start + 9] * filter_coefs[19];
 	}
 	else
 	{
-
-		for (u32 i = 0; i < (NUM_TAPS >> 1) + 1; i++)
-		{
-			ls += RevbUpBuf[0][(((RevbSampleBufPos - NUM_TAPS) >> 1) + i) & 63] * filter_coefs[i * 2];
-		}
-		for (u32 i = 0; i < (NUM_TAPS >> 1) + 1; i++)
-		{
-			rs += RevbUpBuf[1][(((RevbSampleBufPos - NUM_TAPS) >> 1) + i) & 63] * filter_coefs[i * 2];
-		}
+		ls = ReverbEvenFIR(&RevbUpBuf[0][start]);
+		rs = ReverbEvenFIR(&RevbUpBuf[1][start]);
 	}
 
 	ls >>= 14;
@@ -152,30 +169,66 @@ StereoOut32 V_Core::DoReverb(const StereoOut32& Input)
 		return StereoOut32::Empty;
 	}
 
-	RevbDownBuf[0][RevbSampleBufPos & 63] = Input.Left;
-	RevbDownBuf[1][RevbSampleBufPos & 63] = Input.Right;
+	ReverbBufWrite(RevbDownBuf[0], RevbSampleBufPos, Input.Left);
+	ReverbBufWrite(RevbDownBuf[1], RevbSampleBufPos, Input.Right);
 
 	bool R = Cycles & 1;
 
 	// Calculate the read/write addresses we'll be needing for this session of reverb.
+	// The last two lanes repeat same_src, so they can't raise an IRQ of their own.
 
-	const u32 same_src = RevbGetIndexer(R ? RevBuffers.SAME_R_SRC : RevBuffers.SAME_L_SRC);
-	const u32 same_dst = RevbGetIndexer(R ? RevBuffers.SAME_R_DST : RevBuffers.SAME_L_DST);
-	const u32 same_prv = RevbGetIndexer(R ? RevBuffers.SAME_R_PRV : RevBuffers.SAME_L_PRV);
+	alignas(16) u32 addr[16] = {
+		static_cast<u32>(R ? RevBuffers.SAME_R_SRC : RevBuffers.SAME_L_SRC),
+		static_cast<u32>(R ? RevBuffers.SAME_R_DST : RevBuffers.SAME_L_DST),
+		static_cast<u32>(R ? RevBuffers.SAME_R_PRV : RevBuffers.SAME_L_PRV),
 
-	const u32 diff_src = RevbGetIndexer(R ? RevBuffers.DIFF_L_SRC : RevBuffers.DIFF_R_SRC);
-	const u32 diff_dst = RevbGetIndexer(R ? RevBuffers.DIFF_R_DST : RevBuffers.DIFF_L_DST);
-	const u32 diff_prv = RevbGetIndexer(R ? RevBuffers.DIFF_R_PRV : RevBuffers.DIFF_L_PRV);
+		static_cast<u32>(R ? RevBuffers.DIFF_L_SRC : RevBuffers.DIFF_R_SRC),
+		static_cast<u32>(R ? RevBuffers.DIFF_R_DST : RevBuffers.DIFF_L_DST),
+		static_cast<u32>(R ? RevBuffers.DIFF_R_PRV : RevBuffers.DIFF_L_PRV),
 
-	const u32 comb1_src = RevbGetIndexer(R ? RevBuffers.COMB1_R_SRC : RevBuffers.COMB1_L_SRC);
-	const u32 comb2_src = RevbGetIndexer(R ? RevBuffers.COMB2_R_SRC : RevBuffers.COMB2_L_SRC);
-	const u32 comb3_src = RevbGetIndexer(R ? RevBuffers.COMB3_R_SRC : RevBuffers.COMB3_L_SRC);
-	const u32 comb4_src = RevbGetIndexer(R ? RevBuffers.COMB4_R_SRC : RevBuffers.COMB4_L_SRC);
+		static_cast<u32>(R ? RevBuffers.COMB1_R_SRC : RevBuffers.COMB1_L_SRC),
+		static_cast<u32>(R ? RevBuffers.COMB2_R_SRC : RevBuffers.COMB2_L_SRC),
+		static_cast<u32>(R ? RevBuffers.COMB3_R_SRC : RevBuffers.COMB3_L_SRC),
+		static_cast<u32>(R ? RevBuffers.COMB4_R_SRC : RevBuffers.COMB4_L_SRC),
 
-	const u32 apf1_src = RevbGetIndexer(R ? RevBuffers.APF1_R_SRC : RevBuffers.APF1_L_SRC);
-	const u32 apf1_dst = RevbGetIndexer(R ? RevBuffers.APF1_R_DST : RevBuffers.APF1_L_DST);
-	const u32 apf2_src = RevbGetIndexer(R ? RevBuffers.APF2_R_SRC : RevBuffers.APF2_L_SRC);
-	const u32 apf2_dst = RevbGetIndexer(R ? RevBuffers.APF2_R_DST : RevBuffers.APF2_L_DST);
+		static_cast<u32>(R ? RevBuffers.APF1_R_SRC : RevBuffers.APF1_L_SRC),
+		static_cast<u32>(R ? RevBuffers.APF1_R_DST : RevBuffers.APF1_L_DST),
+		static_cast<u32>(R ? RevBuffers.APF2_R_SRC : RevBuffers.APF2_L_SRC),
+		static_cast<u32>(R ? RevBuffers.APF2_R_DST : RevBuffers.APF2_L_DST),
+	};
+	addr[14] = addr[15] = addr[0];
+
+	// Fast and simple single step wrapping, made possible by the preparation of the
+	// effects buffer addresses.
+
+	const __m128i reverb_x = _mm_set1_epi32(ReverbX);
+	const __m128i end_a = _mm_set1_epi32(EffectsEndA);
+	const __m128i wrap = _mm_set1_epi32(EffectsStartA - (EffectsEndA + 1));
+	__m128i pos[4];
+	for (u32 i = 0; i < 4; i++)
+	{
+		const __m128i p = _mm_add_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(&addr[i * 4])), reverb_x);
+		const __m128i in_range = _mm_cmpeq_epi32(_mm_min_epu32(p, end_a), p);
+		pos[i] = _mm_add_epi32(p, _mm_andnot_si128(in_range, wrap));
+		_mm_store_si128(reinterpret_cast<__m128i*>(&addr[i * 4]), pos[i]);
+	}
+
+	const u32 same_src = addr[0];
+	const u32 same_dst = addr[1];
+	const u32 same_prv = addr[2];
+	const u32 diff_src = addr[3];
+	const u32 diff_dst = addr[4];
+	const u32 diff_prv = addr[5];
+	const u32 comb1_src = addr[6];
+	const u32 comb2_src = addr[7];
+	const u32 comb3_src = addr[8];
+	const u32 comb4_src = addr[9];
+	const u32 apf1_src = addr[10];
+	const u32 apf1_dst = addr[11];
+	const u32 apf2_src = addr[12];
+	const u32 apf2_dst = addr[13];
+
+	assert(same_src >= EffectsStartA && same_src <= EffectsEndA);
 
 	// -----------------------------------------
 	//          Optimized IRQ Testing !
@@ -190,15 +243,11 @@ StereoOut32 V_Core::DoReverb(const StereoOut32& Input)
 	{
 		if (Cores[i].IRQEnable && ((Cores[i].IRQA >= EffectsStartA) && (Cores[i].IRQA <= EffectsEndA)))
 		{
-			if ((Cores[i].IRQA == same_src) || (Cores[i].IRQA == diff_src) ||
-				(Cores[i].IRQA == same_dst) || (Cores[i].IRQA == diff_dst) ||
-				(Cores[i].IRQA == same_prv) || (Cores[i].IRQA == diff_prv) ||
-
-				(Cores[i].IRQA == comb1_src) || (Cores[i].IRQA == comb2_src) ||
-				(Cores[i].IRQA == comb3_src) || (Cores[i].IRQA == comb4_src) ||
-
-				(Cores[i].IRQA == apf1_dst) || (Cores[i].IRQA == apf1_src) ||
-				(Cores[i].IRQA == apf2_dst) || (Cores[i].IRQA == apf2_src))
+			const __m128i irqa = _mm_set1_epi32(Cores[i].IRQA);
+			const __m128i hit = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi32(pos[0], irqa), _mm_cmpeq_epi32(pos[1], irqa)),
+				_mm_or_si128(_mm_cmpeq_epi32(pos[2], irqa), _mm_cmpeq_epi32(pos[3], irqa)));
+			if (_mm_movemask_epi8(hit))
 			{
 				//printf("Core %d IRQ Called (Reverb). IRQA = %x\n",i,addr);
 				SetIrqCall(i);
@@ -233,7 +282,7 @@ StereoOut32 V_Core::DoReverb(const StereoOut32& Input)
 		_spu2mem[apf2_dst] = clamp_mix(apf2);
 	}
 
-	RevbUpBuf[R][(RevbSampleBufPos >> 1) & 63] = clamp_mix(out);
+	ReverbBufWrite(RevbUpBuf[R], RevbSampleBufPos >> 1, clamp_mix(out));
 
 	RevbSampleBufPos++;
 
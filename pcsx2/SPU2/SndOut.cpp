@@ -21,10 +21,13 @@
 #include "GS/GSVector.h"
 
 #include "common/Assertions.h"
+#include "common/Threading.h"
 #include "common/Timer.h"
 
 #include "SoundTouch.h"
 
+#include <atomic>
+
 const StereoOut32 StereoOut32::Empty(0, 0);
 
 static bool s_audio_capture_active = false;
@@ -120,7 +123,8 @@ namespace SndBuffer
 
 	// data prediction amount, used to "commit" data that hasn't
 	// finished timestretch processing.
-	static s32 s_predict_data = 0;
+	// Atomic since async mixing reads it from the EE thread while the output thread writes it.
+	static std::atomic<s32> s_predict_data{0};
 
 	// records last buffer status (fill %, range -100 to 100, with 0 being 50% full)
 	static float s_last_pct = 0;
@@ -131,6 +135,7 @@ namespace SndBuffer
 	static int s_ss_freeze = 0;
 
 	static std::unique_ptr<StereoOut16[]> s_staging_buffer;
+	static std::unique_ptr<StereoOut16[]> s_stretch_buffer;
 	static std::unique_ptr<float[]> s_float_buffer;
 
 	static int s_staging_progress = 0;
@@ -138,16 +143,64 @@ namespace SndBuffer
 	static std::unique_ptr<StereoOut16[]> s_output_buffer;
 	static s32 s_output_buffer_size = 0;
 
-	// TODO: Replace these with proper atomics.
-	alignas(4) static volatile s32 m_rpos = 0;
-	alignas(4) static volatile s32 m_wpos = 0;
+	// Single producer, single consumer: m_wpos is only stored by the writer, m_rpos only by the
+	// audio callback. The release stores publish the samples (or free space) behind them.
+	alignas(64) static std::atomic<s32> m_rpos{0};
+	alignas(64) static std::atomic<s32> m_wpos{0};
+
+	// Low latency buffer: the amount of buffered audio aimed for. It starts small, grows when the
+	// output underruns or overruns, and creeps back down after a while without either, as long as
+	// the most audio seen buffered still fits.
+	static constexpr s32 LOW_LATENCY_INITIAL_MS = 20;
+	static constexpr u32 LOW_LATENCY_SHRINK_WINDOWS = 8;
+	static std::atomic<s32> s_latency_target{0};
+	static std::atomic<u32> s_underrun_count{0};
+	static std::atomic<u32> s_overrun_count{0};
+	static s32 s_latency_min = 0;
+	static s32 s_latency_max = 0;
+
+	// Controller state, only touched by the audio callback.
+	static s32 s_latency_window_samples = 0;
+	static s32 s_latency_window_peak = 0;
+	static u32 s_latency_window_glitches = 0;
+	static u32 s_latency_clean_windows = 0;
+	static s32 s_latency_clean_peak = 0;
+
+	// Resampling stretch: small tempo changes are done by stepping through the samples at the tempo,
+	// which costs far less and adds no latency compared to SoundTouch.
+	static constexpr float RESAMPLE_STRETCH_MAX_DEVIATION = 0.05f;
+	static float s_stretch_tempo = 1.0f; // Tempo last picked by the stretcher.
+	static bool s_resampling = false;
+	static float s_resample_pos = 0.0f;
+	static StereoOut16 s_resample_prev;
+
+	// Packets handed from the EE thread to the output thread, when EmuConfig.SPU2.ThreadedOutput is set.
+	// Single producer (EE thread), single consumer (output thread), indices count packets.
+	static constexpr u32 OUTPUT_QUEUE_PACKETS = 32;
+	static std::unique_ptr<StereoOut16[]> s_output_queue;
+	alignas(64) static std::atomic<u32> s_output_queue_read{0};
+	alignas(64) static std::atomic<u32> s_output_queue_write{0};
+	static Threading::WorkSema s_output_sema;
+	static Threading::Thread s_output_thread;
+	static std::atomic_bool s_output_thread_shutdown{false};
+
+	static void StartOutputThread();
+	static void StopOutputThread();
+	static void FlushOutputThread();
+	static void OutputThreadEntryPoint();
+	static void QueuePacket(const StereoOut16* packet);
+	static void ProcessPacket(const StereoOut16* packet);
 
 	static bool CheckUnderrunStatus(int& nSamples, int& quietSampleCount);
+	static void InitLatencyTarget();
+	static void UpdateLatencyTarget(int nSamples);
+	static int GetOutputCapacity();
 
 	static void soundtouchInit();
 	static void soundtouchClearContents();
 	static void soundtouchCleanup();
-	static void timeStretchWrite();
+	static void timeStretchWrite(const StereoOut16* packet);
+	static void resampleStretchWrite(const StereoOut16* packet);
 	static void timeStretchUnderrun();
 #ifdef SPU2X_HANDLE_STRETCH_OVERRUNS
 	static s32 timeStretchOverrun();
@@ -157,10 +210,10 @@ namespace SndBuffer
 	static float GetStatusPct();
 	static void UpdateTempoChangeSoundTouch();
 
-	static void _WriteSamples(StereoOut16* bData, int nSamples);
-	static void _WriteSamples_Safe(StereoOut16* bData, int nSamples);
+	static void _WriteSamples(const StereoOut16* bData, int nSamples);
+	static void _WriteSamples_Safe(const StereoOut16* bData, int nSamples);
 
-	static void _WriteSamples_Internal(StereoOut16* bData, int nSamples);
+	static void _WriteSamples_Internal(const StereoOut16* bData, int nSamples);
 	static void _DropSamples_Internal(int nSamples);
 
 	static int _GetApproximateDataInBuffer();
@@ -190,7 +243,11 @@ bool SndBuffer::CheckUnderrunStatus(int& nSamples, int& quietSampleCount)
 	int data = _GetApproximateDataInBuffer();
 	if (s_underrun_freeze)
 	{
-		int toFill = s_output_buffer_size / ((EmuConfig.SPU2.SynchMode == Pcsx2Config::SPU2Options::SynchronizationMode::NoSync) ? 32 : 400); // TimeStretch and Async off?
+		int toFill;
+		if (EmuConfig.SPU2.LowLatencyBuffer)
+			toFill = s_latency_target.load(std::memory_order_relaxed) / 2;
+		else
+			toFill = s_output_buffer_size / ((EmuConfig.SPU2.SynchMode == Pcsx2Config::SPU2Options::SynchronizationMode::NoSync) ? 32 : 400); // TimeStretch and Async off?
 		toFill = GetAlignedBufferSize(toFill);
 
 		// toFill is now aligned to a SndOutPacket
@@ -212,6 +269,7 @@ bool SndBuffer::CheckUnderrunStatus(int& nSamples, int& quietSampleCount)
 		quietSampleCount = nSamples - data;
 		nSamples = data;
 		s_underrun_freeze = true;
+		s_underrun_count.fetch_add(1, std::memory_order_relaxed);
 
 		if (EmuConfig.SPU2.SynchMode == Pcsx2Config::SPU2Options::SynchronizationMode::TimeStretch) // TimeStrech on
 			timeStretchUnderrun();
@@ -222,32 +280,109 @@ bool SndBuffer::CheckUnderrunStatus(int& nSamples, int& quietSampleCount)
 	return true;
 }
 
+void SndBuffer::InitLatencyTarget()
+{
+	s_latency_min = GetAlignedBufferSize(Pcsx2Config::SPU2Options::MIN_LATENCY * SampleRate / 1000);
+	s_latency_max = std::max(GetAlignedBufferSize(EmuConfig.SPU2.Latency * SampleRate / 1000), s_latency_min);
+	s_latency_target.store(std::clamp(GetAlignedBufferSize(LOW_LATENCY_INITIAL_MS * SampleRate / 1000), s_latency_min, s_latency_max),
+		std::memory_order_relaxed);
+	s_underrun_count.store(0, std::memory_order_relaxed);
+	s_overrun_count.store(0, std::memory_order_relaxed);
+	s_latency_window_samples = 0;
+	s_latency_window_peak = 0;
+	s_latency_window_glitches = 0;
+	s_latency_clean_windows = 0;
+	s_latency_clean_peak = 0;
+}
+
+void SndBuffer::UpdateLatencyTarget(int nSamples)
+{
+	// Judge the target every quarter second of output.
+	s_latency_window_peak = std::max(s_latency_window_peak, _GetApproximateDataInBuffer());
+	s_latency_window_samples += nSamples;
+	if (s_latency_window_samples < SampleRate / 4)
+		return;
+	s_latency_window_samples = 0;
+
+	const u32 glitches = s_underrun_count.load(std::memory_order_relaxed) + s_overrun_count.load(std::memory_order_relaxed);
+	const bool glitched = (glitches != s_latency_window_glitches);
+	s_latency_window_glitches = glitches;
+	const s32 peak = s_latency_window_peak;
+	s_latency_window_peak = 0;
+
+	s32 target = s_latency_target.load(std::memory_order_relaxed);
+	if (glitched)
+	{
+		target = std::min(GetAlignedBufferSize(target + target / 2), s_latency_max);
+		s_latency_clean_windows = 0;
+		s_latency_clean_peak = 0;
+	}
+	else
+	{
+		s_latency_clean_peak = std::max(s_latency_clean_peak, peak);
+		if (++s_latency_clean_windows < LOW_LATENCY_SHRINK_WINDOWS)
+			return;
+
+		// Only shrink while the capacity, twice the target, still holds the fullest the buffer got.
+		const s32 shrunk = std::max(target - SndOutPacketSize, s_latency_min);
+		if ((s_latency_clean_peak + SndOutPacketSize) <= (shrunk * 2))
+			target = shrunk;
+		s_latency_clean_windows = 0;
+		s_latency_clean_peak = 0;
+	}
+
+	if (SPU2::MsgOverruns() && target != s_latency_target.load(std::memory_order_relaxed))
+		SPU2::ConLog(" * SPU2 > Latency target %d ms\n", target * 1000 / SampleRate);
+	s_latency_target.store(target, std::memory_order_relaxed);
+}
+
+int SndBuffer::GetOutputCapacity()
+{
+	// In low latency mode anything beyond twice the target is dropped rather than queued.
+	if (EmuConfig.SPU2.LowLatencyBuffer)
+		return std::min(s_latency_target.load(std::memory_order_relaxed) * 2, s_output_buffer_size);
+
+	return s_output_buffer_size;
+}
+
+SndBuffer::LatencyStats SndBuffer::GetLatencyStats()
+{
+	LatencyStats stats;
+	stats.buffered_samples = _GetApproximateDataInBuffer();
+	stats.target_samples = EmuConfig.SPU2.LowLatencyBuffer ? s_latency_target.load(std::memory_order_relaxed) : (s_output_buffer_size / 16);
+	stats.underruns = s_underrun_count.load(std::memory_order_relaxed);
+	stats.overruns = s_overrun_count.load(std::memory_order_relaxed);
+	return stats;
+}
+
 int SndBuffer::_GetApproximateDataInBuffer()
 {
 	// WARNING: not necessarily 100% up to date by the time it's used, but it will have to do.
-	return (m_wpos + s_output_buffer_size - m_rpos) % s_output_buffer_size;
+	return (m_wpos.load(std::memory_order_acquire) + s_output_buffer_size - m_rpos.load(std::memory_order_acquire)) % s_output_buffer_size;
 }
 
-void SndBuffer::_WriteSamples_Internal(StereoOut16* bData, int nSamples)
+void SndBuffer::_WriteSamples_Internal(const StereoOut16* bData, int nSamples)
 {
 	// WARNING: This assumes the write will NOT wrap around,
 	// and also assumes there's enough free space in the buffer.
 
-	std::memcpy(s_output_buffer.get() + m_wpos, bData, nSamples * sizeof(StereoOut16));
-	m_wpos = (m_wpos + nSamples) % s_output_buffer_size;
+	const s32 wpos = m_wpos.load(std::memory_order_relaxed);
+	std::memcpy(s_output_buffer.get() + wpos, bData, nSamples * sizeof(StereoOut16));
+	m_wpos.store((wpos + nSamples) % s_output_buffer_size, std::memory_order_release);
 }
 
 void SndBuffer::_DropSamples_Internal(int nSamples)
 {
-	m_rpos = (m_rpos + nSamples) % s_output_buffer_size;
+	m_rpos.store((m_rpos.load(std::memory_order_relaxed) + nSamples) % s_output_buffer_size, std::memory_order_release);
 }
 
-void SndBuffer::_WriteSamples_Safe(StereoOut16* bData, int nSamples)
+void SndBuffer::_WriteSamples_Safe(const StereoOut16* bData, int nSamples)
 {
 	// WARNING: This code assumes there's only ONE writing process.
-	if ((s_output_buffer_size - m_wpos) < nSamples)
+	const s32 wpos = m_wpos.load(std::memory_order_relaxed);
+	if ((s_output_buffer_size - wpos) < nSamples)
 	{
-		const int b1 = s_output_buffer_size - m_wpos;
+		const int b1 = s_output_buffer_size - wpos;
 		const int b2 = nSamples - b1;
 
 		_WriteSamples_Internal(bData, b1);
@@ -288,13 +423,17 @@ void SndBuffer::ReadSamples(T* bData, int nSamples)
 	//  This will cause one brief hiccup that can never exceed the user's
 	//  set buffer length in duration.
 
+	if (EmuConfig.SPU2.LowLatencyBuffer)
+		UpdateLatencyTarget(nSamples);
+
 	int quietSamples = 0;
 	if (CheckUnderrunStatus(nSamples, quietSamples))
 	{
 		pxAssume(nSamples <= SndOutPacketSize);
 
 		// WARNING: This code assumes there's only ONE reading process.
-		int b1 = s_output_buffer_size - m_rpos;
+		const s32 rpos = m_rpos.load(std::memory_order_relaxed);
+		int b1 = s_output_buffer_size - rpos;
 
 		if (b1 > nSamples)
 			b1 = nSamples;
@@ -305,7 +444,7 @@ void SndBuffer::ReadSamples(T* bData, int nSamples)
 		{
 			// First part
 			if (b1 > 0)
-				std::memcpy(bData, &s_output_buffer[m_rpos], sizeof(StereoOut16) * b1);
+				std::memcpy(bData, &s_output_buffer[rpos], sizeof(StereoOut16) * b1);
 
 			// Second part
 			if (b2 > 0)
@@ -315,7 +454,7 @@ void SndBuffer::ReadSamples(T* bData, int nSamples)
 		{
 			// First part
 			for (int i = 0; i < b1; i++)
-				bData[i].SetFrom(ApplyVolume(s_output_buffer[i + m_rpos], s_final_volume));
+				bData[i].SetFrom(ApplyVolume(s_output_buffer[i + rpos], s_final_volume));
 
 			// Second part
 			for (int i = 0; i < b2; i++)
@@ -341,7 +480,7 @@ template void SndBuffer::ReadSamples(Stereo51Out16Dpl*, int);
 template void SndBuffer::ReadSamples(Stereo51Out16DplII*, int);
 template void SndBuffer::ReadSamples(Stereo71Out16*, int);
 
-void SndBuffer::_WriteSamples(StereoOut16* bData, int nSamples)
+void SndBuffer::_WriteSamples(const StereoOut16* bData, int nSamples)
 {
 	s_predict_data = 0;
 
@@ -356,7 +495,7 @@ void SndBuffer::_WriteSamples(StereoOut16* bData, int nSamples)
 	//  The older portion of the buffer is discarded rather than incoming data,
 	//  so that the overall audio synchronization is better.
 
-	const int free = s_output_buffer_size - _GetApproximateDataInBuffer(); // -1, but the <= handles that
+	const int free = GetOutputCapacity() - _GetApproximateDataInBuffer(); // -1, but the <= handles that
 	if (free <= nSamples)
 	{
 // Disabled since the lock-free queue can't handle changing the read end from the write thread
@@ -388,6 +527,7 @@ void SndBuffer::_WriteSamples(StereoOut16* bData, int nSamples)
 		if (SPU2::MsgOverruns())
 			SPU2::ConLog(" * SPU2 > Overrun! 1 packet tossed)\n");
 		s_last_pct = 0.0; // normalize the timestretcher
+		s_overrun_count.fetch_add(1, std::memory_order_relaxed);
 
 		// Toss the packet because we overran the buffer.
 		return;
@@ -407,8 +547,8 @@ bool SndBuffer::Init(const char* modname)
 	// Buffer actually attempts to run ~50%, so allocate near double what
 	// the requested latency is:
 
-	m_rpos = 0;
-	m_wpos = 0;
+	m_rpos.store(0, std::memory_order_relaxed);
+	m_wpos.store(0, std::memory_order_relaxed);
 
 	const float latencyMS = EmuConfig.SPU2.Latency * 16;
 	s_output_buffer_size = GetAlignedBufferSize((int)(latencyMS * SampleRate / 1000.0f));
@@ -416,9 +556,11 @@ bool SndBuffer::Init(const char* modname)
 	s_underrun_freeze = false;
 
 	s_staging_buffer = std::make_unique<StereoOut16[]>(SndOutPacketSize);
+	s_stretch_buffer = std::make_unique<StereoOut16[]>(SndOutPacketSize);
 	s_float_buffer = std::make_unique<float[]>(SndOutPacketSize * 2);
 	s_staging_progress = 0;
 
+	InitLatencyTarget();
 	soundtouchInit(); // initializes the timestretching
 
 	// initialize module
@@ -428,11 +570,16 @@ bool SndBuffer::Init(const char* modname)
 		return false;
 	}
 
+	if (EmuConfig.SPU2.ThreadedOutput)
+		StartOutputThread();
+
 	return true;
 }
 
 void SndBuffer::Cleanup()
 {
+	StopOutputThread();
+
 	if (s_output_module)
 	{
 		s_output_module->Close();
@@ -443,18 +590,21 @@ void SndBuffer::Cleanup()
 
 	s_output_buffer.reset();
 	s_staging_buffer.reset();
+	s_stretch_buffer.reset();
 }
 
 void SndBuffer::ClearContents()
 {
+	FlushOutputThread();
 	soundtouchClearContents();
 	s_ss_freeze = 256; //Delays sound output for about 1 second.
 }
 
 void SndBuffer::ResetBuffers()
 {
-	m_rpos = 0;
-	m_wpos = 0;
+	FlushOutputThread();
+	m_rpos.store(0, std::memory_order_release);
+	m_wpos.store(0, std::memory_order_release);
 }
 
 void SPU2::SetOutputPaused(bool paused)
@@ -490,19 +640,105 @@ void SndBuffer::Write(StereoOut16 Sample)
 	if (s_audio_capture_active)
 		GSCapture::DeliverAudioPacket(reinterpret_cast<const s16*>(s_staging_buffer.get()));
 
+	if (s_output_thread.Joinable())
+		QueuePacket(s_staging_buffer.get());
+	else
+		ProcessPacket(s_staging_buffer.get());
+}
+
+void SndBuffer::ProcessPacket(const StereoOut16* packet)
+{
 	//Don't play anything directly after loading a savestate, avoids static killing your speakers.
 	if (s_ss_freeze > 0)
 	{
 		s_ss_freeze--;
-		std::memset(s_staging_buffer.get(), 0, sizeof(StereoOut16) * SndOutPacketSize);
 	}
 	else
 	{
 		if (EmuConfig.SPU2.SynchMode == Pcsx2Config::SPU2Options::SynchronizationMode::TimeStretch)
-			timeStretchWrite();
+			timeStretchWrite(packet);
 		else
-			_WriteSamples(s_staging_buffer.get(), SndOutPacketSize);
+			_WriteSamples(packet, SndOutPacketSize);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Output Thread
+//////////////////////////////////////////////////////////////////////////
+
+// Mixing stays on the EE thread, since it raises IRQs, sets ENDX and writes SPU RAM at exact
+// cycles. Only the finished packets are handed over, so time stretching and the copy into the
+// output buffer no longer stall emulation.
+//
+// Queueing register writes with their cycle and mixing on this thread wouldn't help: the IOP
+// reads ENDX, NAX, the IRQ status and the ADMA state back synchronously, and many games poll them
+// in tight loops, so nearly every read would have to wait for the mixer to catch up.
+
+void SndBuffer::StartOutputThread()
+{
+	if (s_output_thread.Joinable())
+		return;
+
+	s_output_queue = std::make_unique<StereoOut16[]>(OUTPUT_QUEUE_PACKETS * SndOutPacketSize);
+	s_output_queue_read.store(0, std::memory_order_relaxed);
+	s_output_queue_write.store(0, std::memory_order_relaxed);
+	s_output_thread_shutdown.store(false, std::memory_order_release);
+	s_output_sema.Reset();
+	s_output_thread.Start(OutputThreadEntryPoint);
+}
+
+void SndBuffer::StopOutputThread()
+{
+	if (!s_output_thread.Joinable())
+		return;
+
+	s_output_thread_shutdown.store(true, std::memory_order_release);
+	s_output_sema.NotifyOfWork();
+	s_output_thread.Join();
+	s_output_queue.reset();
+}
+
+void SndBuffer::FlushOutputThread()
+{
+	if (s_output_thread.Joinable())
+		s_output_sema.WaitForEmptyWithSpin();
+}
+
+void SndBuffer::QueuePacket(const StereoOut16* packet)
+{
+	const u32 write = s_output_queue_write.load(std::memory_order_relaxed);
+	if (write - s_output_queue_read.load(std::memory_order_acquire) == OUTPUT_QUEUE_PACKETS)
+	{
+		// The output thread is well behind, which only happens when the host is overloaded.
+		// Waiting keeps every packet, like the non-threaded path would.
+		s_output_sema.WaitForEmptyWithSpin();
+	}
+
+	std::memcpy(&s_output_queue[(write % OUTPUT_QUEUE_PACKETS) * SndOutPacketSize], packet,
+		sizeof(StereoOut16) * SndOutPacketSize);
+	s_output_queue_write.store(write + 1, std::memory_order_release);
+	s_output_sema.NotifyOfWork();
+}
+
+void SndBuffer::OutputThreadEntryPoint()
+{
+	Threading::SetNameOfCurrentThread("SPU2 Output");
+
+	for (;;)
+	{
+		s_output_sema.WaitForWork();
+		if (s_output_thread_shutdown.load(std::memory_order_acquire))
+			break;
+
+		u32 read = s_output_queue_read.load(std::memory_order_relaxed);
+		while (read != s_output_queue_write.load(std::memory_order_acquire))
+		{
+			ProcessPacket(&s_output_queue[(read % OUTPUT_QUEUE_PACKETS) * SndOutPacketSize]);
+			s_output_queue_read.store(++read, std::memory_order_release);
+		}
 	}
+
+	s_output_sema.Kill();
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -531,8 +767,9 @@ float SndBuffer::GetStatusPct()
 	//ConLog( "Data %d >>> driver: %d   predict: %d\n", m_data, drvempty, m_predictData );
 
 	const int data = _GetApproximateDataInBuffer();
-	float result = static_cast<float>(data + s_predict_data - drvempty) - (s_output_buffer_size / 16);
-	result /= (s_output_buffer_size / 16);
+	const int target = EmuConfig.SPU2.LowLatencyBuffer ? s_latency_target.load(std::memory_order_relaxed) : (s_output_buffer_size / 16);
+	float result = static_cast<float>(data + s_predict_data - drvempty) - target;
+	result /= target;
 	return result;
 }
 
@@ -616,7 +853,9 @@ static bool IsInRange(const T& val, const T& min, const T& max)
 void SndBuffer::UpdateTempoChangeSoundTouch()
 {
 #ifndef SPU2X_USE_OLD_STRETCHER
-	const long targetSamplesReservoir = 48 * EmuConfig.SPU2.Latency; //48000*SndOutLatencyMS/1000
+	const long targetSamplesReservoir = EmuConfig.SPU2.LowLatencyBuffer ?
+											s_latency_target.load(std::memory_order_relaxed) :
+											48 * EmuConfig.SPU2.Latency; //48000*SndOutLatencyMS/1000
 	//base aim at buffer filled %
 	float baseTargetFullness = static_cast<double>(targetSamplesReservoir); ///(double)m_size;//0.05;
 
@@ -704,6 +943,7 @@ void SndBuffer::UpdateTempoChangeSoundTouch()
 	}
 
 	pSoundTouch->setTempo(tempoAdjust);
+	s_stretch_tempo = tempoAdjust;
 	if (gRequestStretcherReset >= STRETCHER_RESET_THRESHOLD)
 		gRequestStretcherReset = 0;
 
@@ -963,8 +1203,33 @@ static void ConvertPacketToInt(StereoOut16* dst, const float* src, uint size)
 	}
 }
 
-void SndBuffer::timeStretchWrite()
+void SndBuffer::timeStretchWrite(const StereoOut16* packet)
 {
+	if (EmuConfig.SPU2.ResampleStretch && std::abs(s_stretch_tempo - 1.0f) <= RESAMPLE_STRETCH_MAX_DEVIATION)
+	{
+		if (!s_resampling)
+		{
+			// Play out what SoundTouch has ready, the rest of its window would come out late later on.
+			int tempProgress;
+			while (tempProgress = pSoundTouch->receiveSamples(s_float_buffer.get(), SndOutPacketSize),
+				tempProgress != 0)
+			{
+				ConvertPacketToInt(s_stretch_buffer.get(), s_float_buffer.get(), tempProgress);
+				_WriteSamples(s_stretch_buffer.get(), tempProgress);
+			}
+			pSoundTouch->clear();
+
+			s_resampling = true;
+			s_resample_pos = 1.0f;
+			s_resample_prev = packet[0];
+		}
+
+		resampleStretchWrite(packet);
+		UpdateTempoChangeSoundTouch();
+		return;
+	}
+	s_resampling = false;
+
 	// data prediction helps keep the tempo adjustments more accurate.
 	// The timestretcher returns packets in belated "clump" form.
 	// Meaning that most of the time we'll get nothing back, and then
@@ -972,7 +1237,7 @@ void SndBuffer::timeStretchWrite()
 	// data prediction to make the timestretcher more responsive.
 
 	PredictDataWrite((int)(SndOutPacketSize / s_eTempo));
-	ConvertPacketToFloat(s_staging_buffer.get(), s_float_buffer.get());
+	ConvertPacketToFloat(packet, s_float_buffer.get());
 
 	pSoundTouch->putSamples(s_float_buffer.get(), SndOutPacketSize);
 
@@ -983,13 +1248,47 @@ void SndBuffer::timeStretchWrite()
 		// Hint: It's assumed that pSoundTouch will return chunks of 128 bytes (it always does as
 		// long as the SSE optimizations are enabled), which means we can do our own SSE opts here.
 
-		ConvertPacketToInt(s_staging_buffer.get(), s_float_buffer.get(), tempProgress);
-		_WriteSamples(s_staging_buffer.get(), tempProgress);
+		ConvertPacketToInt(s_stretch_buffer.get(), s_float_buffer.get(), tempProgress);
+		_WriteSamples(s_stretch_buffer.get(), tempProgress);
 	}
 
 	UpdateTempoChangeSoundTouch();
 }
 
+void SndBuffer::resampleStretchWrite(const StereoOut16* packet)
+{
+	// Position 0 is the last sample of the previous packet and position i is packet[i - 1], so
+	// interpolation carries on across packets. A tempo above 1 steps faster and writes fewer samples.
+	s_predict_data = 0;
+
+	float pos = s_resample_pos;
+	int count = 0;
+	while (pos < static_cast<float>(SndOutPacketSize))
+	{
+		const int index = static_cast<int>(pos);
+		const float frac = pos - static_cast<float>(index);
+		const StereoOut16& a = (index == 0) ? s_resample_prev : packet[index - 1];
+		const StereoOut16& b = packet[index];
+		s_stretch_buffer[count++] = StereoOut16(
+			static_cast<s16>(a.Left + static_cast<int>(static_cast<float>(b.Left - a.Left) * frac)),
+			static_cast<s16>(a.Right + static_cast<int>(static_cast<float>(b.Right - a.Right) * frac)));
+
+		if (count == SndOutPacketSize)
+		{
+			_WriteSamples(s_stretch_buffer.get(), count);
+			count = 0;
+		}
+
+		pos += s_stretch_tempo;
+	}
+
+	s_resample_pos = pos - static_cast<float>(SndOutPacketSize);
+	s_resample_prev = packet[SndOutPacketSize - 1];
+
+	if (count > 0)
+		_WriteSamples(s_stretch_buffer.get(), count);
+}
+
 void SndBuffer::soundtouchInit()
 {
 	pSoundTouch = std::make_unique<soundtouch::SoundTouch>();
@@ -1011,6 +1310,8 @@ void SndBuffer::soundtouchInit()
 	s_eTempo = 1.0;
 	s_last_pct = 0;
 	s_last_emergency_adj = 0;
+	s_stretch_tempo = 1.0f;
+	s_resampling = false;
 
 	s_predict_data = 0;
 }
@@ -1028,6 +1329,8 @@ void SndBuffer::soundtouchClearContents()
 	s_eTempo = 1.0;
 	s_last_pct = 0;
 	s_last_emergency_adj = 0;
+	s_stretch_tempo = 1.0f;
+	s_resampling = false;
 
 	s_predict_data = 0;
 }
@@ -308,6 +308,16 @@ namespace SndBuffer
 	void ClearContents();
 	void ResetBuffers();
 
+	struct LatencyStats
+	{
+		s32 buffered_samples; // Samples waiting in the output buffer.
+		s32 target_samples; // Amount of buffered audio the output aims for.
+		u32 underruns; // Underruns since the buffer was initialized.
+		u32 overruns; // Writes dropped because the buffer was full, since it was initialized.
+	};
+
+	LatencyStats GetLatencyStats();
+
 	// Note: When using with 32 bit output buffers, the user of this function is responsible
 	// for shifting the values to where they need to be manually.  The fixed point depth of
 	// the sample output is determined by the SndOutVolumeShift, which is the number of bits
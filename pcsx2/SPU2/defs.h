@@ -422,8 +422,8 @@ struct V_Core
 	V_Reverb Revb;              // Reverb Registers
 	V_ReverbBuffers RevBuffers; // buffer pointers for reverb, pre-calculated and pre-clipped.
 
-	s32 RevbDownBuf[2][64]; // Downsample buffer for reverb, one for each channel
-	s32 RevbUpBuf[2][64]; // Upsample buffer for reverb, one for each channel
+	s32 RevbDownBuf[2][64 * 2]; // Downsample buffer for reverb, one for each channel, mirrored so the FIR window never wraps
+	s32 RevbUpBuf[2][64 * 2]; // Upsample buffer for reverb, one for each channel, mirrored so the FIR window never wraps
 	u32 RevbSampleBufPos;
 	u32 EffectsStartA;
 	u32 EffectsEndA;
@@ -497,7 +497,6 @@ struct V_Core
 	StereoOut32 Mix(const VoiceMixSet& inVoices, const StereoOut32& Input, const StereoOut32& Ext);
 	void Reverb_AdvanceBuffer();
 	StereoOut32 DoReverb(const StereoOut32& Input);
-	s32 RevbGetIndexer(s32 offset);
 
 	s32 ReverbDownsample(bool right);
 	StereoOut32 ReverbUpsample(bool phase);
@@ -550,6 +549,37 @@ struct V_Core
 	void FinishDMAwrite();
 };
 
+// Voices are mixed in two passes. The first runs the sequential part of each voice in voice order:
+// volume slides, pitch, fetching and decoding samples and the ADSR envelope, which is where all the
+// IRQ checks and SPU2 RAM accesses happen. The second does the interpolation and volume maths for
+// every voice of the core at once, four voices per SSE register, with the same integer operations
+// as MixVoiceLanes_reference so the results are identical.
+struct alignas(16) VoiceMixLanes
+{
+	// Gaussian coefficients and the samples they apply to, PV4 to PV1. Noise voices use a single
+	// coefficient of 0x8000, which passes the value through unchanged.
+	s32 Coef[4][V_Core::NumVoices];
+	s32 PV[4][V_Core::NumVoices];
+
+	// ADSR envelope after this sample's update, zero for voices which were already stopped.
+	s32 Envelope[V_Core::NumVoices];
+
+	s32 VolL[V_Core::NumVoices];
+	s32 VolR[V_Core::NumVoices];
+
+	s32 DryL[V_Core::NumVoices];
+	s32 DryR[V_Core::NumVoices];
+	s32 WetL[V_Core::NumVoices];
+	s32 WetR[V_Core::NumVoices];
+
+	s32 Value[V_Core::NumVoices];
+};
+
+/// Interpolates, applies the envelope and volumes and gates every voice in lanes, storing each voice's
+/// output in lanes.Value and adding the mixed result to dest.
+extern void MixVoiceLanes(VoiceMixLanes& lanes, VoiceMixSet& dest);
+extern void MixVoiceLanes_reference(VoiceMixLanes& lanes, VoiceMixSet& dest);
+
 extern V_Core Cores[2];
 extern V_SPDIF Spdif;
 
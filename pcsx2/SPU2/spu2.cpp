@@ -403,6 +403,8 @@ void SPU2::CheckForConfigChanges(const Pcsx2Config& old_config)
 	if (opts.Latency != oldopts.Latency ||
 		opts.OutputLatency != oldopts.OutputLatency ||
 		opts.OutputLatencyMinimal != oldopts.OutputLatencyMinimal ||
+		opts.ThreadedOutput != oldopts.ThreadedOutput ||
+		opts.LowLatencyBuffer != oldopts.LowLatencyBuffer ||
 		opts.OutputModule != oldopts.OutputModule ||
 		opts.BackendName != oldopts.BackendName ||
 		opts.DeviceName != oldopts.DeviceName ||
@@ -25,7 +25,7 @@ namespace SPU2Savestate
 
 	// versioning for saves.
 	// Increment this when changes to the savestate system are made.
-	static const u32 SAVE_VERSION = 0x000e;
+	static const u32 SAVE_VERSION = 0x000f;
 
 	static void wipe_the_cache()
 	{
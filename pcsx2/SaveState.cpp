@@ -22,6 +22,8 @@
 #include "common/SafeArray.inl"
 #include "common/ScopedGuard.h"
 #include "common/StringUtil.h"
+#include "common/ThreadPool.h"
+#include "common/Timer.h"
 #include "common/ZipHelpers.h"
 
 #include "ps2/BiosTools.h"
@@ -53,6 +55,7 @@
 
 #include <csetjmp>
 #include <png.h>
+#include <zstd.h>
 
 using namespace R5900;
 
@@ -340,6 +343,16 @@ std::string Exception::SaveStateLoadError::FormatDisplayMessage() const
 static const char* EntryFilename_StateVersion = "PCSX2 Savestate Version.id";
 static const char* EntryFilename_Screenshot = "Screenshot.png";
 static const char* EntryFilename_InternalStructures = "PCSX2 Internal Structures.dat";
+static const char* EntryFilename_IncrementalBase = "PCSX2 Incremental Base.id";
+static const char* EntryFilename_DeltaSuffix = ".delta";
+static const char* EntryFilename_ZstdSuffix = ".zst";
+
+// Entries at least this big are compressed up front in parallel, when SavestateParallelCompression is on.
+static constexpr size_t PARALLEL_COMPRESSION_MIN_SIZE = 256 * 1024;
+
+// Entries are split into chunks of this size, each compressed as an independent zstd frame on the pool.
+// Concatenated frames are still a valid zstd stream, and the loader decompresses the frames in parallel.
+static constexpr size_t PARALLEL_COMPRESSION_CHUNK_SIZE = 4 * 1024 * 1024;
 
 struct SysState_Component
 {
@@ -373,9 +386,9 @@ static void SysState_ComponentFreezeOutRoot(void* dest, SysState_Component comp)
 		throw std::runtime_error(std::string(" * ") + comp.name + std::string(": Error saving state!\n"));
 }
 
-static void SysState_ComponentFreezeIn(zip_file_t* zf, SysState_Component comp)
+static void SysState_ComponentFreezeIn(const u8* src, size_t src_size, SysState_Component comp)
 {
-	if (!zf)
+	if (!src)
 		return;
 
 	freezeData fP = { 0, nullptr };
@@ -387,7 +400,11 @@ static void SysState_ComponentFreezeIn(zip_file_t* zf, SysState_Component comp)
 	auto data = std::make_unique<u8[]>(fP.size);
 	fP.data = data.get();
 
-	if (zip_fread(zf, data.get(), fP.size) != static_cast<zip_int64_t>(fP.size) || comp.freeze(FreezeAction::Load, &fP) != 0)
+	if (src_size < static_cast<size_t>(fP.size))
+		throw std::runtime_error(std::string(" * ") + comp.name + std::string(": Error loading state!\n"));
+
+	std::memcpy(data.get(), src, fP.size);
+	if (comp.freeze(FreezeAction::Load, &fP) != 0)
 		throw std::runtime_error(std::string(" * ") + comp.name + std::string(": Error loading state!\n"));
 }
 
@@ -404,18 +421,9 @@ static void SysState_ComponentFreezeOut(SaveStateBase& writer, SysState_Componen
 	return;
 }
 
-static void SysState_ComponentFreezeInNew(zip_file_t* zf, const char* name, bool(*do_state_func)(StateWrapper&))
+static void SysState_ComponentFreezeInNew(const u8* data, size_t size, const char* name, bool(*do_state_func)(StateWrapper&))
 {
-	// TODO: We could decompress on the fly here for a little bit more speed.
-	std::vector<u8> data;
-	if (zf)
-	{
-		std::optional<std::vector<u8>> optdata(ReadBinaryFileInZip(zf));
-		if (optdata.has_value())
-			data = std::move(optdata.value());
-	}
-
-	StateWrapper::ReadOnlyMemoryStream stream(data.empty() ? nullptr : data.data(), data.size());
+	StateWrapper::ReadOnlyMemoryStream stream(size ? data : nullptr, size);
 	StateWrapper sw(&stream, StateWrapper::Mode::Read, g_SaveVersion);
 
 	// TODO: Get rid of the bloody exceptions.
@@ -453,7 +461,8 @@ public:
 	virtual ~BaseSavestateEntry() = default;
 
 	virtual const char* GetFilename() const = 0;
-	virtual void FreezeIn(zip_file_t* zf) const = 0;
+	// Data is null when an optional entry is missing from the state.
+	virtual void FreezeIn(const u8* data, size_t size) const = 0;
 	virtual void FreezeOut(SaveStateBase& writer) const = 0;
 	virtual bool IsRequired() const = 0;
 };
@@ -465,7 +474,7 @@ protected:
 	virtual ~MemorySavestateEntry() = default;
 
 public:
-	virtual void FreezeIn(zip_file_t* zf) const;
+	virtual void FreezeIn(const u8* data, size_t size) const;
 	virtual void FreezeOut(SaveStateBase& writer) const;
 	virtual bool IsRequired() const { return true; }
 
@@ -474,14 +483,17 @@ protected:
 	virtual u32 GetDataSize() const = 0;
 };
 
-void MemorySavestateEntry::FreezeIn(zip_file_t* zf) const
+void MemorySavestateEntry::FreezeIn(const u8* data, size_t size) const
 {
 	const u32 expectedSize = GetDataSize();
-	const s64 bytesRead = zip_fread(zf, GetDataPtr(), expectedSize);
-	if (bytesRead != static_cast<s64>(expectedSize))
+	const u32 bytesRead = static_cast<u32>(std::min<size_t>(size, expectedSize));
+	if (bytesRead > 0)
+		std::memcpy(GetDataPtr(), data, bytesRead);
+
+	if (bytesRead != expectedSize)
 	{
 		Console.WriteLn(Color_Yellow, " '%s' is incomplete (expected 0x%x bytes, loading only 0x%x bytes)",
-			GetFilename(), expectedSize, static_cast<u32>(bytesRead));
+			GetFilename(), expectedSize, bytesRead);
 	}
 }
 
@@ -508,10 +520,10 @@ public:
 	u8* GetDataPtr() const { return eeMem->Main; }
 	uint GetDataSize() const { return sizeof(eeMem->Main); }
 
-	virtual void FreezeIn(zip_file_t* zf) const
+	virtual void FreezeIn(const u8* data, size_t size) const
 	{
 		SysClearExecutionCache();
-		MemorySavestateEntry::FreezeIn(zf);
+		MemorySavestateEntry::FreezeIn(data, size);
 	}
 };
 
@@ -601,7 +613,7 @@ public:
 	virtual ~SavestateEntry_SPU2() = default;
 
 	const char* GetFilename() const { return "SPU2.bin"; }
-	void FreezeIn(zip_file_t* zf) const { return SysState_ComponentFreezeIn(zf, SPU2_); }
+	void FreezeIn(const u8* data, size_t size) const { return SysState_ComponentFreezeIn(data, size, SPU2_); }
 	void FreezeOut(SaveStateBase& writer) const { return SysState_ComponentFreezeOut(writer, SPU2_); }
 	bool IsRequired() const { return true; }
 };
@@ -612,7 +624,7 @@ public:
 	virtual ~SavestateEntry_USB() = default;
 
 	const char* GetFilename() const { return "USB.bin"; }
-	void FreezeIn(zip_file_t* zf) const { return SysState_ComponentFreezeInNew(zf, "USB", &USB::DoState); }
+	void FreezeIn(const u8* data, size_t size) const { return SysState_ComponentFreezeInNew(data, size, "USB", &USB::DoState); }
 	void FreezeOut(SaveStateBase& writer) const { return SysState_ComponentFreezeOutNew(writer, "USB", 16 * 1024, &USB::DoState); }
 	bool IsRequired() const { return false; }
 };
@@ -623,7 +635,7 @@ public:
 	virtual ~SavestateEntry_PAD() = default;
 
 	const char* GetFilename() const { return "PAD.bin"; }
-	void FreezeIn(zip_file_t* zf) const { return SysState_ComponentFreezeIn(zf, PAD_); }
+	void FreezeIn(const u8* data, size_t size) const { return SysState_ComponentFreezeIn(data, size, PAD_); }
 	void FreezeOut(SaveStateBase& writer) const { return SysState_ComponentFreezeOut(writer, PAD_); }
 	bool IsRequired() const { return true; }
 };
@@ -634,7 +646,7 @@ public:
 	virtual ~SavestateEntry_GS() = default;
 
 	const char* GetFilename() const { return "GS.bin"; }
-	void FreezeIn(zip_file_t* zf) const { return SysState_ComponentFreezeIn(zf, GS); }
+	void FreezeIn(const u8* data, size_t size) const { return SysState_ComponentFreezeIn(data, size, GS); }
 	void FreezeOut(SaveStateBase& writer) const { return SysState_ComponentFreezeOut(writer, GS); }
 	bool IsRequired() const { return true; }
 };
@@ -645,17 +657,13 @@ class SaveStateEntry_Achievements : public BaseSavestateEntry
 	virtual ~SaveStateEntry_Achievements() override = default;
 
 	const char* GetFilename() const override { return "Achievements.bin"; }
-	void FreezeIn(zip_file_t* zf) const override
+	void FreezeIn(const u8* data, size_t size) const override
 	{
 		if (!Achievements::IsActive())
 			return;
 
-		std::optional<std::vector<u8>> data;
-		if (zf)
-			data = ReadBinaryFileInZip(zf);
-
-		if (data.has_value() && !data->empty())
-			Achievements::LoadState(data->data(), data->size());
+		if (data && size > 0)
+			Achievements::LoadState(data, static_cast<u32>(size));
 		else
 			Achievements::LoadState(nullptr, 0);
 	}
@@ -705,6 +713,13 @@ static const std::unique_ptr<BaseSavestateEntry> SavestateEntries[] = {
 std::unique_ptr<ArchiveEntryList> SaveState_DownloadState()
 {
 	std::unique_ptr<ArchiveEntryList> destlist = std::make_unique<ArchiveEntryList>(new VmStateBuffer("Zippable Savestate"));
+	SaveState_DownloadState(destlist.get());
+	return destlist;
+}
+
+void SaveState_DownloadState(ArchiveEntryList* destlist)
+{
+	destlist->Clear();
 
 	memSavingState saveme(destlist->GetBuffer());
 	ArchiveEntry internals(EntryFilename_InternalStructures);
@@ -725,8 +740,6 @@ std::unique_ptr<ArchiveEntryList> SaveState_DownloadState()
 				.SetDataIndex(startpos)
 				.SetDataSize(saveme.GetCurrentPos() - startpos));
 	}
-
-	return destlist;
 }
 
 std::unique_ptr<SaveStateScreenshotData> SaveState_SaveScreenshot()
@@ -895,6 +908,87 @@ static bool SaveState_ReadScreenshot(zip_t* zf, u32* out_width, u32* out_height,
 	return true;
 }
 
+// Shared by saving and loading, so the workers are started once instead of for every state.
+static cb::ThreadPool& GetSaveStateThreadPool()
+{
+	static cb::ThreadPool pool(static_cast<int>(std::max(cb::ThreadPool::GetNumLogicalCores(), 1u)));
+	return pool;
+}
+
+// Compresses a chunk of an entry into a single zstd frame. Returns an empty vector on failure.
+static std::vector<u8> SaveState_CompressChunk(const u8* data, size_t size)
+{
+	std::vector<u8> buffer(ZSTD_compressBound(size));
+	// Level 0 picks the zstd default level.
+	const size_t compressed_size = ZSTD_compress(buffer.data(), buffer.size(), data, size, 0);
+	if (ZSTD_isError(compressed_size))
+	{
+		Console.Error("(SaveState) zstd compression failed: %s", ZSTD_getErrorName(compressed_size));
+		return {};
+	}
+
+	buffer.resize(compressed_size);
+	return buffer;
+}
+
+// Queues compression of each chunk of an entry on the pool.
+static std::vector<std::future<std::vector<u8>>> SaveState_ScheduleCompression(const u8* data, size_t size)
+{
+	cb::ThreadPool& pool = GetSaveStateThreadPool();
+	std::vector<std::future<std::vector<u8>>> chunks;
+	chunks.reserve((size + PARALLEL_COMPRESSION_CHUNK_SIZE - 1) / PARALLEL_COMPRESSION_CHUNK_SIZE);
+	for (size_t offset = 0; offset < size; offset += PARALLEL_COMPRESSION_CHUNK_SIZE)
+	{
+		const size_t chunk_size = std::min(size - offset, PARALLEL_COMPRESSION_CHUNK_SIZE);
+		chunks.push_back(pool.ScheduleAndGetFuture([data, offset, chunk_size]() {
+			return SaveState_CompressChunk(data + offset, chunk_size);
+		}));
+	}
+
+	return chunks;
+}
+
+// Joins the compressed chunks of an entry, in a malloc()ed buffer for libzip to take ownership of.
+static std::pair<void*, size_t> SaveState_JoinChunks(std::vector<std::future<std::vector<u8>>>& chunks)
+{
+	// Wait for every chunk even if one fails, they reference the entry's data.
+	std::vector<std::vector<u8>> frames;
+	frames.reserve(chunks.size());
+	size_t total_size = 0;
+	bool failed = false;
+	for (std::future<std::vector<u8>>& chunk : chunks)
+	{
+		frames.push_back(chunk.get());
+		failed = failed || frames.back().empty();
+		total_size += frames.back().size();
+	}
+
+	u8* buffer = failed ? nullptr : static_cast<u8*>(std::malloc(total_size));
+	if (!buffer)
+		return {};
+
+	u8* ptr = buffer;
+	for (const std::vector<u8>& frame : frames)
+	{
+		std::memcpy(ptr, frame.data(), frame.size());
+		ptr += frame.size();
+	}
+
+	return {buffer, total_size};
+}
+
+std::vector<u8> SaveState_CompressEntry(const void* data, size_t size)
+{
+	std::vector<std::future<std::vector<u8>>> chunks(SaveState_ScheduleCompression(static_cast<const u8*>(data), size));
+	const auto [buffer, compressed_size] = SaveState_JoinChunks(chunks);
+	if (!buffer)
+		return {};
+
+	std::vector<u8> ret(static_cast<const u8*>(buffer), static_cast<const u8*>(buffer) + compressed_size);
+	std::free(buffer);
+	return ret;
+}
+
 // --------------------------------------------------------------------------------------
 //  CompressThread_VmState
 // --------------------------------------------------------------------------------------
@@ -922,12 +1016,60 @@ static bool SaveState_AddToZip(zip_t* zf, ArchiveEntryList* srclist, SaveStateSc
 	}
 
 	const uint listlen = srclist->GetLength();
+
+	// libzip compresses entries one after another when the archive is closed. Instead, compress the large
+	// ones concurrently now, chunk by chunk, so a single big entry (main memory) doesn't end up on one thread.
+	// The pool is the only source of parallelism, there's one worker per logical core.
+	std::vector<std::vector<std::future<std::vector<u8>>>> precompressed(listlen);
+	ScopedGuard wait_for_chunks([&precompressed]() {
+		// The pool outlives this call, so don't let chunks still reading the entries run past a failure.
+		for (auto& chunks : precompressed)
+		{
+			for (std::future<std::vector<u8>>& chunk : chunks)
+			{
+				if (chunk.valid())
+					chunk.wait();
+			}
+		}
+	});
+	if (EmuConfig.SavestateParallelCompression)
+	{
+		for (uint i = 0; i < listlen; ++i)
+		{
+			const ArchiveEntry& entry = (*srclist)[i];
+			if (entry.GetDataSize() >= PARALLEL_COMPRESSION_MIN_SIZE)
+				precompressed[i] = SaveState_ScheduleCompression(srclist->GetPtr(entry.GetDataIndex()), entry.GetDataSize());
+		}
+	}
+
 	for (uint i = 0; i < listlen; ++i)
 	{
 		const ArchiveEntry& entry = (*srclist)[i];
 		if (!entry.GetDataSize())
 			continue;
 
+		if (!precompressed[i].empty())
+		{
+			const auto [buffer, size] = SaveState_JoinChunks(precompressed[i]);
+			zip_source_t* const zs = buffer ? zip_source_buffer(zf, buffer, size, 1) : nullptr;
+			if (!zs)
+			{
+				std::free(buffer);
+				return false;
+			}
+
+			const std::string name(entry.GetFilename() + EntryFilename_ZstdSuffix);
+			const s64 fi = zip_file_add(zf, name.c_str(), zs, ZIP_FL_ENC_UTF_8);
+			if (fi < 0)
+			{
+				zip_source_free(zs);
+				return false;
+			}
+
+			zip_set_file_compression(zf, fi, ZIP_CM_STORE, 0);
+			continue;
+		}
+
 		zip_source_t* const zs = zip_source_buffer(zf, srclist->GetPtr(entry.GetDataIndex()), entry.GetDataSize(), 0);
 		if (!zs)
 			return false;
@@ -978,6 +1120,272 @@ bool SaveState_ZipToDisk(std::unique_ptr<ArchiveEntryList> srclist, std::unique_
 	return true;
 }
 
+// --------------------------------------------------------------------------------------
+//  Incremental savestates
+// --------------------------------------------------------------------------------------
+// A delta state stores large entries as the pages which differ from a base state written
+// next to it, plus the id of that base. Dirty pages are found by comparing against a copy
+// of the base kept in memory, so the result is exact regardless of how memory was written
+// (DMA, recompiled code, or a state load in between), without fighting the recompilers
+// over page protection.
+
+static constexpr u32 DELTA_MAGIC = 0x4C445350; // PSDL
+static constexpr u32 DELTA_PAGE_SIZE = 4096;
+
+// Entries smaller than this are always stored in full, deltas wouldn't save anything.
+static constexpr size_t DELTA_MIN_ENTRY_SIZE = 256 * 1024;
+
+// Take a new base once a delta would hold more than this fraction of the tracked data.
+static constexpr size_t DELTA_REBASE_DIVISOR = 2;
+
+// Each base is a full copy of the large entries (~40MB), so only the most recently used slots keep one.
+static constexpr size_t MAX_INCREMENTAL_BASES = 4;
+
+struct DeltaHeader
+{
+	u32 magic;
+	u32 page_size;
+	u32 entry_size;
+	u32 page_count;
+};
+
+struct IncrementalBaseState
+{
+	std::string filename;
+	u64 id = 0;
+	std::vector<std::pair<std::string, std::vector<u8>>> entries;
+};
+
+// Most recently used first.
+static std::deque<IncrementalBaseState> s_incremental_bases;
+
+static size_t GetArchiveEntryListSize(const ArchiveEntryList& list)
+{
+	size_t size = 0;
+	for (size_t i = 0; i < list.GetLength(); i++)
+		size = std::max<size_t>(size, list[i].GetDataIndex() + list[i].GetDataSize());
+	return size;
+}
+
+static void AppendArchiveEntry(ArchiveEntryList* list, size_t* pos, std::string name, const void* data, size_t size)
+{
+	list->GetBuffer()->MakeRoomFor(static_cast<int>(*pos + size));
+	if (size > 0)
+		std::memcpy(list->GetPtr(static_cast<uint>(*pos)), data, size);
+	list->Add(ArchiveEntry(std::move(name)).SetDataIndex(*pos).SetDataSize(size));
+	*pos += size;
+}
+
+static std::vector<u8> MakeIncrementalBaseId(u64 id, const std::string& base_filename)
+{
+	std::vector<u8> data(sizeof(id) + base_filename.size());
+	std::memcpy(data.data(), &id, sizeof(id));
+	std::memcpy(data.data() + sizeof(id), base_filename.data(), base_filename.size());
+	return data;
+}
+
+static bool ParseIncrementalBaseId(const std::vector<u8>& data, u64* id, std::string* base_filename)
+{
+	if (data.size() < sizeof(u64))
+		return false;
+
+	std::memcpy(id, data.data(), sizeof(u64));
+	base_filename->assign(reinterpret_cast<const char*>(data.data()) + sizeof(u64), data.size() - sizeof(u64));
+	return true;
+}
+
+std::string SaveState_GetIncrementalBaseFileName(const std::string& filename)
+{
+	return filename + ".base";
+}
+
+void SaveState_ResetIncremental()
+{
+	s_incremental_bases.clear();
+}
+
+static IncrementalBaseState& GetIncrementalBase(const std::string& filename)
+{
+	auto it = std::find_if(s_incremental_bases.begin(), s_incremental_bases.end(),
+		[&filename](const IncrementalBaseState& base) { return base.filename == filename; });
+	if (it != s_incremental_bases.end())
+	{
+		if (it != s_incremental_bases.begin())
+		{
+			IncrementalBaseState base(std::move(*it));
+			s_incremental_bases.erase(it);
+			s_incremental_bases.push_front(std::move(base));
+		}
+	}
+	else
+	{
+		if (s_incremental_bases.size() == MAX_INCREMENTAL_BASES)
+			s_incremental_bases.pop_back();
+
+		s_incremental_bases.emplace_front();
+	}
+
+	return s_incremental_bases.front();
+}
+
+std::unique_ptr<ArchiveEntryList> SaveState_MakeIncremental(std::unique_ptr<ArchiveEntryList> srclist, const std::string& filename,
+	std::unique_ptr<ArchiveEntryList>* new_base)
+{
+	const std::string base_filename(SaveState_GetIncrementalBaseFileName(filename));
+	IncrementalBaseState& base = GetIncrementalBase(filename);
+
+	// Find the dirty pages of each large entry, as long as the base is still usable.
+	const uint listlen = static_cast<uint>(srclist->GetLength());
+	std::vector<std::vector<u32>> dirty_pages(listlen);
+	bool rebase = (base.filename != filename || !FileSystem::FileExists(base_filename.c_str()));
+	size_t tracked_bytes = 0;
+	size_t dirty_bytes = 0;
+	for (uint i = 0; i < listlen && !rebase; i++)
+	{
+		const ArchiveEntry& entry = (*srclist)[i];
+		if (entry.GetDataSize() < DELTA_MIN_ENTRY_SIZE)
+			continue;
+
+		auto it = std::find_if(base.entries.begin(), base.entries.end(),
+			[&entry](const auto& base_entry) { return base_entry.first == entry.GetFilename(); });
+		if (it == base.entries.end() || it->second.size() != entry.GetDataSize())
+		{
+			rebase = true;
+			break;
+		}
+
+		const u8* data = srclist->GetPtr(entry.GetDataIndex());
+		const size_t size = entry.GetDataSize();
+		for (size_t offset = 0; offset < size; offset += DELTA_PAGE_SIZE)
+		{
+			const size_t page_size = std::min<size_t>(DELTA_PAGE_SIZE, size - offset);
+			if (std::memcmp(data + offset, it->second.data() + offset, page_size) != 0)
+			{
+				dirty_pages[i].push_back(static_cast<u32>(offset / DELTA_PAGE_SIZE));
+				dirty_bytes += page_size;
+			}
+		}
+
+		tracked_bytes += size;
+	}
+
+	if (!rebase && dirty_bytes > (tracked_bytes / DELTA_REBASE_DIVISOR))
+	{
+		DevCon.WriteLn("(SaveState) %zu of %zu tracked bytes changed, taking a new base state.", dirty_bytes, tracked_bytes);
+		rebase = true;
+	}
+
+	if (rebase)
+	{
+		// Keep a copy of the large entries to compare against, and tag the full state with a fresh id.
+		base.filename = filename;
+		base.id = static_cast<u64>(Common::Timer::GetCurrentValue());
+		base.entries.clear();
+		for (uint i = 0; i < listlen; i++)
+		{
+			const ArchiveEntry& entry = (*srclist)[i];
+			if (entry.GetDataSize() < DELTA_MIN_ENTRY_SIZE)
+				continue;
+
+			const u8* data = srclist->GetPtr(entry.GetDataIndex());
+			base.entries.emplace_back(entry.GetFilename(), std::vector<u8>(data, data + entry.GetDataSize()));
+			dirty_pages[i].clear();
+		}
+
+		const std::vector<u8> id(MakeIncrementalBaseId(base.id, std::string()));
+		size_t pos = GetArchiveEntryListSize(*srclist);
+		AppendArchiveEntry(srclist.get(), &pos, EntryFilename_IncrementalBase, id.data(), id.size());
+	}
+
+	// Build the delta state: small entries in full, large entries as their dirty pages.
+	size_t delta_size = 0;
+	for (uint i = 0; i < listlen; i++)
+	{
+		const ArchiveEntry& entry = (*srclist)[i];
+		const size_t size = entry.GetDataSize();
+		if (size < DELTA_MIN_ENTRY_SIZE)
+			delta_size += size;
+		else
+			delta_size += sizeof(DeltaHeader) + dirty_pages[i].size() * (sizeof(u32) + DELTA_PAGE_SIZE);
+	}
+
+	std::unique_ptr<ArchiveEntryList> destlist = std::make_unique<ArchiveEntryList>(new VmStateBuffer("Incremental Savestate"));
+	destlist->GetBuffer()->ExactAlloc(static_cast<int>(delta_size + sizeof(u64) + Path::GetFileName(base_filename).size()));
+
+	size_t pos = 0;
+	for (uint i = 0; i < listlen; i++)
+	{
+		const ArchiveEntry& entry = (*srclist)[i];
+		const u8* data = srclist->GetPtr(entry.GetDataIndex());
+		const size_t size = entry.GetDataSize();
+		if (size < DELTA_MIN_ENTRY_SIZE)
+		{
+			AppendArchiveEntry(destlist.get(), &pos, entry.GetFilename(), data, size);
+			continue;
+		}
+
+		const std::vector<u32>& pages = dirty_pages[i];
+		std::vector<u8> delta(sizeof(DeltaHeader) + pages.size() * sizeof(u32));
+		const DeltaHeader hdr = {DELTA_MAGIC, DELTA_PAGE_SIZE, static_cast<u32>(size), static_cast<u32>(pages.size())};
+		std::memcpy(delta.data(), &hdr, sizeof(hdr));
+		if (!pages.empty())
+			std::memcpy(delta.data() + sizeof(hdr), pages.data(), pages.size() * sizeof(u32));
+		for (const u32 page : pages)
+		{
+			const size_t offset = static_cast<size_t>(page) * DELTA_PAGE_SIZE;
+			delta.insert(delta.end(), data + offset, data + offset + std::min<size_t>(DELTA_PAGE_SIZE, size - offset));
+		}
+
+		AppendArchiveEntry(destlist.get(), &pos, entry.GetFilename() + EntryFilename_DeltaSuffix, delta.data(), delta.size());
+	}
+
+	const std::vector<u8> id(MakeIncrementalBaseId(base.id, std::string(Path::GetFileName(base_filename))));
+	AppendArchiveEntry(destlist.get(), &pos, EntryFilename_IncrementalBase, id.data(), id.size());
+
+	DevCon.WriteLn("(SaveState) Incremental state for '%s': %zu bytes, %zu dirty of %zu tracked bytes%s.", filename.c_str(),
+		pos, dirty_bytes, tracked_bytes, rebase ? ", new base" : "");
+
+	if (rebase)
+		*new_base = std::move(srclist);
+
+	return destlist;
+}
+
+bool SaveState_ApplyDelta(std::vector<u8>* data, const std::vector<u8>& delta)
+{
+	DeltaHeader hdr;
+	if (delta.size() < sizeof(hdr))
+		return false;
+
+	std::memcpy(&hdr, delta.data(), sizeof(hdr));
+	if (hdr.magic != DELTA_MAGIC || hdr.page_size == 0 || hdr.entry_size != data->size() ||
+		delta.size() < (sizeof(hdr) + static_cast<size_t>(hdr.page_count) * sizeof(u32)))
+	{
+		return false;
+	}
+
+	const u8* page_data = delta.data() + sizeof(hdr) + static_cast<size_t>(hdr.page_count) * sizeof(u32);
+	const u8* const page_data_end = delta.data() + delta.size();
+	for (u32 i = 0; i < hdr.page_count; i++)
+	{
+		u32 page;
+		std::memcpy(&page, delta.data() + sizeof(hdr) + i * sizeof(u32), sizeof(page));
+
+		const size_t offset = static_cast<size_t>(page) * hdr.page_size;
+		if (offset >= data->size())
+			return false;
+
+		const size_t size = std::min<size_t>(hdr.page_size, data->size() - offset);
+		if (static_cast<size_t>(page_data_end - page_data) < size)
+			return false;
+
+		std::memcpy(data->data() + offset, page_data, size);
+		page_data += size;
+	}
+
+	return true;
+}
+
 bool SaveState_ReadScreenshot(const std::string& filename, u32* out_width, u32* out_height, std::vector<u32>* out_pixels)
 {
 	zip_error_t ze = {};
@@ -1016,12 +1424,26 @@ static void CheckVersion(const std::string& filename, zip_t* zf)
 			.SetDiagMsg(fmt::format("Savestate uses an unknown savestate version.\n(PCSX2 ver={:x}, state ver={:x})", g_SaveVersion, savever))
 			.SetUserMsg("Cannot load this savestate. The state is an unsupported version.\nOption 1: Download an older PCSX2 version from pcsx2.net and make a memcard save like on the physical PS2.\nOption 2: Delete the savestates.");}
 
-static zip_int64_t CheckFileExistsInState(zip_t* zf, const char* name, bool required)
+// Finds an entry, stored either as-is or as a zstd frame written by SaveState_AddToZip().
+static zip_int64_t LocateStateEntry(zip_t* zf, const std::string& name, bool* zstd)
+{
+	zip_int64_t index = zip_name_locate(zf, name.c_str(), /*ZIP_FL_NOCASE*/ 0);
+	*zstd = false;
+	if (index < 0)
+	{
+		index = zip_name_locate(zf, (name + EntryFilename_ZstdSuffix).c_str(), 0);
+		*zstd = (index >= 0);
+	}
+
+	return index;
+}
+
+static zip_int64_t CheckFileExistsInState(zip_t* zf, const char* name, bool required, bool* zstd)
 {
-	zip_int64_t index = zip_name_locate(zf, name, /*ZIP_FL_NOCASE*/ 0);
+	zip_int64_t index = LocateStateEntry(zf, name, zstd);
 	if (index >= 0)
 	{
-		DevCon.WriteLn(Color_Green, " ... found '%s'", name);
+		DevCon.WriteLn(Color_Green, " ... found '%s'%s", name, *zstd ? " (zstd)" : "");
 		return index;
 	}
 
@@ -1033,23 +1455,167 @@ static zip_int64_t CheckFileExistsInState(zip_t* zf, const char* name, bool requ
 	return index;
 }
 
-static bool LoadInternalStructuresState(zip_t* zf, s64 index)
+static bool LoadInternalStructuresState(const std::vector<u8>& data)
+{
+	if (data.size() > static_cast<size_t>(std::numeric_limits<int>::max()))
+		return false;
+
+	VmStateBuffer buffer(static_cast<int>(data.size()), "StateBuffer_UnzipFromDisk");
+	if (!data.empty())
+		std::memcpy(buffer.GetPtr(), data.data(), data.size());
+
+	memLoadingState(buffer).FreezeBios().FreezeInternals();
+	return true;
+}
+
+namespace
+{
+	struct StateEntryFrame
+	{
+		size_t src_offset;
+		size_t src_size;
+		size_t dst_offset;
+		size_t dst_size;
+	};
+} // namespace
+
+// Locates the zstd frames making up a compressed entry, and returns the total decompressed size.
+static bool FindStateEntryFrames(const std::vector<u8>& data, std::vector<StateEntryFrame>* frames, size_t* total_size)
+{
+	size_t src_offset = 0;
+	size_t dst_offset = 0;
+	while (src_offset < data.size())
+	{
+		const u8* src = data.data() + src_offset;
+		const size_t remaining = data.size() - src_offset;
+		const size_t src_size = ZSTD_findFrameCompressedSize(src, remaining);
+		const unsigned long long dst_size = ZSTD_getFrameContentSize(src, remaining);
+		if (ZSTD_isError(src_size) || dst_size == ZSTD_CONTENTSIZE_ERROR || dst_size == ZSTD_CONTENTSIZE_UNKNOWN ||
+			dst_size > static_cast<unsigned long long>(std::numeric_limits<int>::max()) - dst_offset)
+		{
+			return false;
+		}
+
+		frames->push_back({src_offset, src_size, dst_offset, static_cast<size_t>(dst_size)});
+		src_offset += src_size;
+		dst_offset += static_cast<size_t>(dst_size);
+	}
+
+	*total_size = dst_offset;
+	return !frames->empty();
+}
+
+static bool DecompressStateEntryFrame(const std::vector<u8>& data, const StateEntryFrame& frame, u8* dst)
+{
+	const size_t result = ZSTD_decompress(dst + frame.dst_offset, frame.dst_size, data.data() + frame.src_offset, frame.src_size);
+	return (!ZSTD_isError(result) && result == frame.dst_size);
+}
+
+static bool DecompressStateEntry(std::vector<u8>* data)
+{
+	std::vector<StateEntryFrame> frames;
+	size_t size;
+	if (!FindStateEntryFrames(*data, &frames, &size))
+		return false;
+
+	std::vector<u8> decompressed(size);
+	for (const StateEntryFrame& frame : frames)
+	{
+		if (!DecompressStateEntryFrame(*data, frame, decompressed.data()))
+			return false;
+	}
+
+	*data = std::move(decompressed);
+	return true;
+}
+
+bool SaveState_DecompressEntries(const std::vector<std::vector<u8>*>& entries)
+{
+	// Big entries are made up of several frames, which are decompressed independently.
+	Common::Timer timer;
+	std::vector<std::vector<u8>> decompressed(entries.size());
+	std::vector<std::vector<StateEntryFrame>> frames(entries.size());
+	size_t frame_count = 0;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		size_t size;
+		if (!FindStateEntryFrames(*entries[i], &frames[i], &size))
+			return false;
+
+		decompressed[i].resize(size);
+		frame_count += frames[i].size();
+	}
+
+	cb::ThreadPool& pool = GetSaveStateThreadPool();
+	std::vector<std::future<bool>> results;
+	results.reserve(frame_count);
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const std::vector<u8>* data = entries[i];
+		u8* dst = decompressed[i].data();
+		for (const StateEntryFrame& frame : frames[i])
+			results.push_back(pool.ScheduleAndGetFuture([data, &frame, dst]() { return DecompressStateEntryFrame(*data, frame, dst); }));
+	}
+
+	bool result = true;
+	for (std::future<bool>& frame_result : results)
+		result = frame_result.get() && result;
+
+	DevCon.WriteLn("(SaveState) Decompressed %zu entries (%zu frames) in %.2f ms", entries.size(), frame_count, timer.GetTimeMilliseconds());
+	if (!result)
+		return false;
+
+	for (size_t i = 0; i < entries.size(); i++)
+		*entries[i] = std::move(decompressed[i]);
+
+	return true;
+}
+
+static bool ReadStateEntry(zip_t* zf, s64 index, std::vector<u8>* data)
 {
 	zip_stat_t zst;
-	if (zip_stat_index(zf, index, 0, &zst) != 0 || zst.size > std::numeric_limits<int>::max())
+	if (zip_stat_index(zf, index, 0, &zst) != 0 || !(zst.valid & ZIP_STAT_SIZE))
 		return false;
 
-	// Load all the internal data
 	auto zff = zip_fopen_index_managed(zf, index, 0);
 	if (!zff)
 		return false;
 
-	VmStateBuffer buffer(static_cast<int>(zst.size), "StateBuffer_UnzipFromDisk"); // start with an 8 meg buffer to avoid frequent reallocation.
-	if (zip_fread(zff.get(), buffer.GetPtr(), buffer.GetSizeInBytes()) != buffer.GetSizeInBytes())
-		return false;
+	data->resize(static_cast<size_t>(zst.size));
+	return (zst.size == 0 || zip_fread(zff.get(), data->data(), zst.size) == static_cast<zip_int64_t>(zst.size));
+}
 
-	memLoadingState(buffer).FreezeBios().FreezeInternals();
-	return true;
+static std::unique_ptr<zip_t, void (*)(zip_t*)> OpenIncrementalBaseState(const std::string& filename, zip_t* zf)
+{
+	u64 id;
+	std::string base_name;
+	std::optional<std::vector<u8>> id_data(ReadBinaryFileInZip(zf, EntryFilename_IncrementalBase));
+	if (!id_data.has_value() || !ParseIncrementalBaseId(id_data.value(), &id, &base_name) || base_name.empty())
+		return std::unique_ptr<zip_t, void (*)(zip_t*)>(nullptr, [](zip_t*) {});
+
+	// When a new base is taken, the previous one is kept as a backup for the backup state.
+	const std::string base_filename(Path::Combine(Path::GetDirectory(filename), base_name));
+	for (const std::string& candidate : {base_filename, base_filename + ".backup"})
+	{
+		zip_error_t ze = {};
+		auto base_zf = zip_open_managed(candidate.c_str(), ZIP_RDONLY, &ze);
+		if (!base_zf)
+			continue;
+
+		u64 base_id;
+		std::string unused;
+		std::optional<std::vector<u8>> base_id_data(ReadBinaryFileInZip(base_zf.get(), EntryFilename_IncrementalBase));
+		if (!base_id_data.has_value() || !ParseIncrementalBaseId(base_id_data.value(), &base_id, &unused) || base_id != id)
+			continue;
+
+		DevCon.WriteLn(Color_Green, " ... found base state '%s'", candidate.c_str());
+		CheckVersion(candidate, base_zf.get());
+		return base_zf;
+	}
+
+	throw Exception::SaveStateLoadError(filename)
+		.SetDiagMsg(fmt::format("No base state matching id {:016x} found at '{}'.", id, base_filename))
+		.SetUserMsg("This savestate cannot be loaded because the base state it was saved against is missing or has been replaced.");
 }
 
 void SaveState_UnzipFromDisk(const std::string& filename)
@@ -1076,44 +1642,113 @@ void SaveState_UnzipFromDisk(const std::string& filename)
 	// look for version and screenshot information in the zip stream:
 	CheckVersion(filename, zf.get());
 
+	// incremental states only hold the pages which changed since their base state
+	auto base_zf = OpenIncrementalBaseState(filename, zf.get());
+
+	// One buffer per entry, plus the delta to apply on top for incremental states.
+	struct LoadedEntry
+	{
+		std::vector<u8> data;
+		std::vector<u8> delta;
+		s64 index = -1;
+		s64 delta_index = -1;
+		bool zstd = false;
+		bool delta_zstd = false;
+		zip_t* source = nullptr;
+	};
+	LoadedEntry internals;
+	LoadedEntry entries[std::size(SavestateEntries)];
+
 	// check that all parts are included
-	const s64 internal_index = CheckFileExistsInState(zf.get(), EntryFilename_InternalStructures, true);
-	s64 entryIndices[std::size(SavestateEntries)];
+	internals.index = CheckFileExistsInState(zf.get(), EntryFilename_InternalStructures, true, &internals.zstd);
+	internals.source = zf.get();
 
 	// Log any parts and pieces that are missing, and then generate an exception.
-	bool throwIt = (internal_index < 0);
+	bool throwIt = (internals.index < 0);
 	for (u32 i = 0; i < std::size(SavestateEntries); i++)
 	{
+		LoadedEntry& le = entries[i];
 		const bool required = SavestateEntries[i]->IsRequired();
-		entryIndices[i] = CheckFileExistsInState(zf.get(), SavestateEntries[i]->GetFilename(), required);
-		if (entryIndices[i] < 0 && required)
+		le.source = zf.get();
+		le.index = LocateStateEntry(zf.get(), SavestateEntries[i]->GetFilename(), &le.zstd);
+		if (le.index < 0 && base_zf)
+		{
+			const std::string delta_name(fmt::format("{}{}", SavestateEntries[i]->GetFilename(), EntryFilename_DeltaSuffix));
+			le.delta_index = LocateStateEntry(zf.get(), delta_name, &le.delta_zstd);
+			if (le.delta_index >= 0)
+			{
+				DevCon.WriteLn(Color_Green, " ... found '%s'", delta_name.c_str());
+				le.source = base_zf.get();
+				le.index = CheckFileExistsInState(base_zf.get(), SavestateEntries[i]->GetFilename(), true, &le.zstd);
+				if (le.index < 0)
+					throwIt = true;
+				continue;
+			}
+		}
+
+		le.index = CheckFileExistsInState(zf.get(), SavestateEntries[i]->GetFilename(), required, &le.zstd);
+		if (le.index < 0 && required)
 			throwIt = true;
 	}
 
+	// Read everything first, then decompress zstd entries in parallel. Applying the
+	// data to the components has to happen in order, on this thread.
+	std::vector<std::vector<u8>*> to_decompress;
+	if (!throwIt)
+	{
+		throwIt = !ReadStateEntry(zf.get(), internals.index, &internals.data) ||
+				  (internals.zstd && !DecompressStateEntry(&internals.data));
+	}
+
+	for (u32 i = 0; i < std::size(SavestateEntries) && !throwIt; i++)
+	{
+		LoadedEntry& le = entries[i];
+		if (le.index >= 0)
+		{
+			throwIt = !ReadStateEntry(le.source, le.index, &le.data);
+			if (le.zstd)
+				to_decompress.push_back(&le.data);
+		}
+		if (le.delta_index >= 0 && !throwIt)
+		{
+			throwIt = !ReadStateEntry(zf.get(), le.delta_index, &le.delta);
+			if (le.delta_zstd)
+				to_decompress.push_back(&le.delta);
+		}
+	}
+
+	if (!throwIt && !to_decompress.empty())
+	{
+		throwIt = !SaveState_DecompressEntries(to_decompress);
+		if (throwIt)
+			Console.Error("(SaveState) Failed to decompress zstd entries.");
+	}
+
 	if (!throwIt)
 	{
 		PreLoadPrep();
-		throwIt = !LoadInternalStructuresState(zf.get(), internal_index);
+		throwIt = !LoadInternalStructuresState(internals.data);
 	}
 
 	if (!throwIt)
 	{
 		for (u32 i = 0; i < std::size(SavestateEntries); ++i)
 		{
-			if (entryIndices[i] < 0)
-			{
-				SavestateEntries[i]->FreezeIn(nullptr);
-				continue;
-			}
-
-			auto zff = zip_fopen_index_managed(zf.get(), entryIndices[i], 0);
-			if (!zff)
+			LoadedEntry& le = entries[i];
+			if (le.delta_index >= 0 && !SaveState_ApplyDelta(&le.data, le.delta))
 			{
+				Console.Error("(SaveState) Failed to apply delta for '%s'", SavestateEntries[i]->GetFilename());
 				throwIt = true;
 				break;
 			}
 
-			SavestateEntries[i]->FreezeIn(zff.get());
+			if (le.index < 0)
+				SavestateEntries[i]->FreezeIn(nullptr, 0);
+			else
+				SavestateEntries[i]->FreezeIn(le.data.data(), le.data.size());
+
+			// done with it, don't hold onto every component until the end
+			std::vector<u8>().swap(le.data);
 		}
 	}
 
@@ -1126,3 +1761,36 @@ void SaveState_UnzipFromDisk(const std::string& filename)
 
 	PostLoadPrep();
 }
+
+void SaveState_LoadFromMemory(const ArchiveEntryList& srclist)
+{
+	// internal structures are always written first, see SaveState_DownloadState()
+	if (srclist.GetLength() == 0 || srclist[0].GetFilename() != EntryFilename_InternalStructures || srclist[0].GetDataIndex() != 0)
+	{
+		throw Exception::SaveStateLoadError()
+			.SetDiagMsg("Memory savestate does not start with the internal structures.");
+	}
+
+	PreLoadPrep();
+	memLoadingState(srclist.GetBuffer()).FreezeBios().FreezeInternals();
+
+	for (const std::unique_ptr<BaseSavestateEntry>& entry : SavestateEntries)
+	{
+		const ArchiveEntry* found = nullptr;
+		for (size_t i = 1; i < srclist.GetLength(); i++)
+		{
+			if (srclist[i].GetFilename() == entry->GetFilename())
+			{
+				found = &srclist[i];
+				break;
+			}
+		}
+
+		if (found && found->GetDataSize() > 0)
+			entry->FreezeIn(srclist.GetPtr(found->GetDataIndex()), found->GetDataSize());
+		else
+			entry->FreezeIn(nullptr, 0);
+	}
+
+	PostLoadPrep();
+}
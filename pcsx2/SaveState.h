@@ -36,7 +36,7 @@ enum class FreezeAction
 // [SAVEVERSION+]
 // This informs the auto updater that the users savestates will be invalidated.
 
-static const u32 g_SaveVersion = (0x9A35 << 16) | 0x0000;
+static const u32 g_SaveVersion = (0x9A36 << 16) | 0x0000;
 
 
 // the freezing data between submodules and core
@@ -63,10 +63,30 @@ class ArchiveEntryList;
 // Wrappers to generate a save state compatible across all frontends.
 // These functions assume that the caller has paused the core thread.
 extern std::unique_ptr<ArchiveEntryList> SaveState_DownloadState();
+extern void SaveState_DownloadState(ArchiveEntryList* destlist);
 extern std::unique_ptr<SaveStateScreenshotData> SaveState_SaveScreenshot();
 extern bool SaveState_ZipToDisk(std::unique_ptr<ArchiveEntryList> srclist, std::unique_ptr<SaveStateScreenshotData> screenshot, const char* filename);
 extern bool SaveState_ReadScreenshot(const std::string& filename, u32* out_width, u32* out_height, std::vector<u32>* out_pixels);
 extern void SaveState_UnzipFromDisk(const std::string& filename);
+extern void SaveState_LoadFromMemory(const ArchiveEntryList& srclist);
+
+// Incremental states. Converts a downloaded state into one which only holds the pages changed since the
+// last base taken for filename. When a new base is needed, it is returned in new_base, and must be zipped to
+// SaveState_GetIncrementalBaseFileName() for the returned state to load.
+extern std::unique_ptr<ArchiveEntryList> SaveState_MakeIncremental(std::unique_ptr<ArchiveEntryList> srclist,
+	const std::string& filename, std::unique_ptr<ArchiveEntryList>* new_base);
+extern std::string SaveState_GetIncrementalBaseFileName(const std::string& filename);
+extern void SaveState_ResetIncremental();
+
+// Large entries are stored as ".zst" entries, made of independent zstd frames so they can be compressed and
+// decompressed in parallel. Compression returns an empty vector on failure. Decompression replaces each entry
+// with its contents, and fails without modifying any entry if one of them isn't a valid set of frames.
+extern std::vector<u8> SaveState_CompressEntry(const void* data, size_t size);
+extern bool SaveState_DecompressEntries(const std::vector<std::vector<u8>*>& entries);
+
+// Applies a delta entry from an incremental state to the matching base entry. Returns false if the delta is
+// malformed or doesn't belong to an entry of this size, in which case data may be partially updated.
+extern bool SaveState_ApplyDelta(std::vector<u8>* data, const std::vector<u8>& delta);
 
 // --------------------------------------------------------------------------------------
 //  SaveStateBase class
@@ -324,6 +344,12 @@ public:
 		return *this;
 	}
 
+	// Drops the entries but keeps the buffer allocated, for reuse.
+	void Clear()
+	{
+		m_list.clear();
+	}
+
 	size_t GetLength() const
 	{
 		return m_list.size();
@@ -149,8 +149,18 @@ namespace HostMemoryMap
 	}
 } // namespace HostMemoryMap
 
+/// The code caches are laid out on CodeReserveAlignment boundaries, bigger huge pages would stop them being write protected.
+static HugePageMode GetCodeHugePageMode(HugePageMode huge_pages)
+{
+	if (huge_pages == HugePageMode::Explicit && HostSys::GetHugePageSize() > HostMemoryMap::CodeReserveAlignment)
+		return HugePageMode::Transparent;
+
+	return huge_pages;
+}
+
 /// Attempts to find a spot near static variables for the main memory
-static VirtualMemoryManagerPtr makeMemoryManager(const char* name, const char* file_mapping_name, size_t size, size_t offset_from_base)
+static VirtualMemoryManagerPtr makeMemoryManager(const char* name, const char* file_mapping_name, size_t size, size_t offset_from_base,
+	HugePageMode huge_pages)
 {
 	// Everything looks nicer when the start of all the sections is a nice round looking number.
 	// Also reduces the variation in the address due to small changes in code.
@@ -169,7 +179,7 @@ static VirtualMemoryManagerPtr makeMemoryManager(const char* name, const char* f
 			// VTLB will throw a fit if we try to put EE main memory here
 			continue;
 		}
-		auto mgr = std::make_shared<VirtualMemoryManager>(name, file_mapping_name, base, size, /*upper_bounds=*/0, /*strict=*/true);
+		auto mgr = std::make_shared<VirtualMemoryManager>(name, file_mapping_name, base, size, /*upper_bounds=*/0, /*strict=*/true, huge_pages);
 		if (mgr->IsOk())
 		{
 			return mgr;
@@ -182,17 +192,21 @@ static VirtualMemoryManagerPtr makeMemoryManager(const char* name, const char* f
 	{
 		pxAssertRel(0, "Failed to find a good place for the memory allocation, recompilers may fail");
 	}
-	return std::make_shared<VirtualMemoryManager>(name, file_mapping_name, 0, size);
+	return std::make_shared<VirtualMemoryManager>(name, file_mapping_name, 0, size, 0, false, huge_pages);
 }
 
 // --------------------------------------------------------------------------------------
 //  SysReserveVM  (implementations)
 // --------------------------------------------------------------------------------------
-SysMainMemory::SysMainMemory()
-	: m_mainMemory(makeMemoryManager("Main Memory Manager", "pcsx2", HostMemoryMap::MainSize, 0))
-	, m_codeMemory(makeMemoryManager("Code Memory Manager", nullptr, HostMemoryMap::CodeSize, HostMemoryMap::MainSize))
+SysMainMemory::SysMainMemory(HugePageMode huge_pages)
+	: m_mainMemory(makeMemoryManager("Main Memory Manager", "pcsx2", HostMemoryMap::MainSize, 0, huge_pages))
+	, m_codeMemory(makeMemoryManager("Code Memory Manager", nullptr, HostMemoryMap::CodeSize, HostMemoryMap::MainSize,
+		  GetCodeHugePageMode(huge_pages)))
 	, m_bumpAllocator(m_mainMemory, HostMemoryMap::bumpAllocatorOffset, HostMemoryMap::MainSize - HostMemoryMap::bumpAllocatorOffset)
 {
+	if (huge_pages == HugePageMode::Explicit && !m_codeMemory->IsHugePageBacked())
+		Console.Warning("Explicit huge pages are unavailable for the recompiler code caches, using transparent huge pages.");
+
 	uptr main_base = (uptr)MainMemory()->GetBase();
 	uptr code_base = (uptr)MainMemory()->GetBase();
 	HostMemoryMap::EEmem = main_base + HostMemoryMap::EEmemOffset;
@@ -63,7 +63,11 @@ namespace HostMemoryMap
 	//////////////////////////////////////////////////////////////////////////
 	// Code
 	//////////////////////////////////////////////////////////////////////////
-	static const u32 CodeSize = 0x13100000; // 305 mb
+	static const u32 CodeSize = 0x13200000; // 306 mb
+
+	// Every code cache starts on and spans whole multiples of this, so they can still be write protected
+	// individually when the code memory is backed by explicit huge pages of up to this size.
+	static const u32 CodeReserveAlignment = 0x00200000;
 
 	// EE recompiler code cache area (64mb)
 	static const u32 EErecOffset   = 0x00000000;
@@ -83,11 +87,11 @@ namespace HostMemoryMap
 	// microVU0 recompiler code cache area (64mb)
 	static const u32 mVU1recOffset = 0x0B000000;
 
-	// SSE-optimized VIF unpack functions (1mb)
+	// SSE-optimized VIF unpack functions (1mb, padded to 2mb)
 	static const u32 VIFUnpackRecOffset = 0x0F000000;
 
 	// Software Renderer JIT buffer (64mb)
-	static const u32 SWrecOffset = 0x0F100000;
+	static const u32 SWrecOffset = 0x0F200000;
 	static const u32 SWrecSize = 0x04000000;
 }
 
@@ -108,7 +112,8 @@ protected:
 	vuMemoryReserve m_vu;
 
 public:
-	SysMainMemory();
+	// Huge pages are chosen once, the reservations live as long as the process.
+	explicit SysMainMemory(HugePageMode huge_pages = HugePageMode::Disabled);
 	~SysMainMemory();
 
 	const VirtualMemoryManagerPtr& MainMemory() { return m_mainMemory; }
@@ -47,12 +47,15 @@
 #include "MemoryCardFile.h"
 #include "Patch.h"
 #include "PerformanceMetrics.h"
+#include "PINE.h"
 #include "R5900.h"
+#include "RewindBuffer.h"
 #include "SPU2/spu2.h"
 #include "DEV9/DEV9.h"
 #include "USB/USB.h"
 #include "PAD/Host/PAD.h"
 #include "Sio.h"
+#include "newVif.h"
 #include "ps2/BiosTools.h"
 #include "Recording/InputRecordingControls.h"
 
@@ -95,14 +98,15 @@ namespace VMManager
 	static void LoadPatches(const std::string& serial, u32 crc,
 		bool show_messages, bool show_messages_when_disabled);
 	static void UpdateRunningGame(bool resetting, bool game_starting);
+	static void UpdateDiscAccessTrace();
 
 	static std::string GetCurrentSaveStateFileName(s32 slot);
 	static bool DoLoadState(const char* filename);
 	static bool DoSaveState(const char* filename, s32 slot_for_message, bool zip_on_thread, bool backup_old_state);
-	static void ZipSaveState(std::unique_ptr<ArchiveEntryList> elist,
+	static void ZipSaveState(std::unique_ptr<ArchiveEntryList> elist, std::unique_ptr<ArchiveEntryList> base_elist,
 		std::unique_ptr<SaveStateScreenshotData> screenshot, std::string osd_key,
 		const char* filename, s32 slot_for_message);
-	static void ZipSaveStateOnThread(std::unique_ptr<ArchiveEntryList> elist,
+	static void ZipSaveStateOnThread(std::unique_ptr<ArchiveEntryList> elist, std::unique_ptr<ArchiveEntryList> base_elist,
 		std::unique_ptr<SaveStateScreenshotData> screenshot, std::string osd_key,
 		std::string filename, s32 slot_for_message);
 
@@ -130,6 +134,7 @@ static u32 s_game_crc;
 static u32 s_patches_crc;
 static std::string s_game_serial;
 static std::string s_game_name;
+static std::string s_game_version;
 static std::string s_elf_override;
 static std::string s_input_profile_name;
 static u32 s_active_game_fixes = 0;
@@ -246,6 +251,12 @@ std::string VMManager::GetGameName()
 	return s_game_name;
 }
 
+std::string VMManager::GetGameVersion()
+{
+	std::unique_lock lock(s_info_mutex);
+	return s_game_version;
+}
+
 bool VMManager::Internal::InitializeGlobals()
 {
 	// On Win32, we have a bunch of things which use COM (e.g. SDL, XAudio2, etc).
@@ -302,7 +313,17 @@ bool VMManager::Internal::InitializeMemory()
 {
 	pxAssert(!s_vm_memory && !s_cpu_provider_pack);
 
-	s_vm_memory = std::make_unique<SysMainMemory>();
+	// Memory is reserved before the settings are loaded, so the huge page mode is read directly.
+	const std::string huge_pages_name = Host::GetBaseStringSettingValue("EmuCore", "HugePages",
+		Pcsx2Config::HugePageModeNames[static_cast<int>(HugePageMode::Disabled)]);
+	HugePageMode huge_pages = HugePageMode::Disabled;
+	for (u32 i = 0; Pcsx2Config::HugePageModeNames[i]; i++)
+	{
+		if (huge_pages_name == Pcsx2Config::HugePageModeNames[i])
+			huge_pages = static_cast<HugePageMode>(i);
+	}
+
+	s_vm_memory = std::make_unique<SysMainMemory>(huge_pages);
 	s_cpu_provider_pack = std::make_unique<SysCpuProviderPack>();
 
 	return s_vm_memory->Allocate();
@@ -715,6 +736,7 @@ void VMManager::UpdateRunningGame(bool resetting, bool game_starting)
 		s_game_serial = std::move(new_serial);
 		s_game_crc = new_crc;
 		s_game_name.clear();
+		s_game_version = new_crc ? DiscVersion : std::string();
 
 		std::string memcardFilters;
 
@@ -741,6 +763,8 @@ void VMManager::UpdateRunningGame(bool resetting, bool game_starting)
 			AutoEject::ClearAll();
 	}
 
+	dVifSetBlockCacheGame(s_game_serial, s_game_crc);
+
 	Console.WriteLn(Color_StrongGreen, "Game Changed:");
 	Console.WriteLn(Color_StrongGreen, fmt::format("  Name: {}", s_game_name));
 	Console.WriteLn(Color_StrongGreen, fmt::format("  Serial: {}", s_game_serial));
@@ -766,6 +790,8 @@ void VMManager::UpdateRunningGame(bool resetting, bool game_starting)
 
 	GetMTGS().SendGameCRC(new_crc);
 
+	UpdateDiscAccessTrace();
+
 	Host::OnGameChanged(s_disc_path, s_elf_override, s_game_serial, s_game_name, s_game_crc);
 
 	MIPSAnalyst::ScanForFunctions(R5900SymbolMap, ElfTextRange.first, ElfTextRange.first + ElfTextRange.second, true);
@@ -1070,6 +1096,7 @@ bool VMManager::Initialize(VMBootParameters boot_params)
 	SetEmuThreadAffinities();
 
 	PerformanceMetrics::Clear();
+	RewindBuffer::Initialize();
 
 	// do we want to load state?
 	if (!GSDumpReplayer::IsReplayingDump() && !state_to_load.empty())
@@ -1096,6 +1123,7 @@ void VMManager::Shutdown(bool save_resume_state)
 	if (THREAD_VU1)
 		vu1Thread.WaitVU();
 	GetMTGS().WaitGS();
+	dVifSetBlockCacheGame(std::string(), 0);
 
 	if (!GSDumpReplayer::IsReplayingDump() && save_resume_state)
 	{
@@ -1122,6 +1150,7 @@ void VMManager::Shutdown(bool save_resume_state)
 		s_patches_crc = 0;
 		s_game_serial.clear();
 		s_game_name.clear();
+		s_game_version.clear();
 		Host::OnGameChanged(s_disc_path, s_elf_override, s_game_serial, s_game_name, 0);
 	}
 	s_active_game_fixes = 0;
@@ -1139,6 +1168,8 @@ void VMManager::Shutdown(bool save_resume_state)
 #endif
 
 	ForgetLoadedPatches();
+	SaveState_ResetIncremental();
+	RewindBuffer::Shutdown();
 	R3000A::ioman::reset();
 	vtlb_Shutdown();
 	USBclose();
@@ -1294,6 +1325,14 @@ bool VMManager::DoSaveState(const char* filename, s32 slot_for_message, bool zip
 		std::unique_ptr<ArchiveEntryList> elist(SaveState_DownloadState());
 		std::unique_ptr<SaveStateScreenshotData> screenshot(SaveState_SaveScreenshot());
 
+		std::unique_ptr<ArchiveEntryList> base_elist;
+		if (EmuConfig.SavestateIncremental)
+		{
+			// The previous base has to finish writing before we possibly replace it.
+			WaitForSaveStateFlush();
+			elist = SaveState_MakeIncremental(std::move(elist), filename, &base_elist);
+		}
+
 		if (FileSystem::FileExists(filename) && backup_old_state)
 		{
 			const std::string backup_filename(fmt::format("{}.backup", filename));
@@ -1303,6 +1342,11 @@ bool VMManager::DoSaveState(const char* filename, s32 slot_for_message, bool zip
 				Host::AddIconOSDMessage(std::move(osd_key), ICON_FA_EXCLAMATION_TRIANGLE,
 					fmt::format("Failed to back up old save state {}.", Path::GetFileName(filename)), Host::OSD_ERROR_DURATION);
 			}
+
+			// Keep the base the backup was saved against, the loader falls back to it.
+			const std::string base_filename(SaveState_GetIncrementalBaseFileName(filename));
+			if (base_elist && FileSystem::FileExists(base_filename.c_str()))
+				FileSystem::RenamePath(base_filename.c_str(), fmt::format("{}.backup", base_filename).c_str());
 		}
 
 		if (zip_on_thread)
@@ -1310,12 +1354,12 @@ bool VMManager::DoSaveState(const char* filename, s32 slot_for_message, bool zip
 			// lock order here is important; the thread could exit before we resume here.
 			std::unique_lock lock(s_save_state_threads_mutex);
 			s_save_state_threads.emplace_back(&VMManager::ZipSaveStateOnThread,
-				std::move(elist), std::move(screenshot), std::move(osd_key), std::string(filename),
+				std::move(elist), std::move(base_elist), std::move(screenshot), std::move(osd_key), std::string(filename),
 				slot_for_message);
 		}
 		else
 		{
-			ZipSaveState(std::move(elist), std::move(screenshot), std::move(osd_key), filename, slot_for_message);
+			ZipSaveState(std::move(elist), std::move(base_elist), std::move(screenshot), std::move(osd_key), filename, slot_for_message);
 		}
 
 		Host::OnSaveStateSaved(filename);
@@ -1329,13 +1373,15 @@ bool VMManager::DoSaveState(const char* filename, s32 slot_for_message, bool zip
 	}
 }
 
-void VMManager::ZipSaveState(std::unique_ptr<ArchiveEntryList> elist,
+void VMManager::ZipSaveState(std::unique_ptr<ArchiveEntryList> elist, std::unique_ptr<ArchiveEntryList> base_elist,
 	std::unique_ptr<SaveStateScreenshotData> screenshot, std::string osd_key,
 	const char* filename, s32 slot_for_message)
 {
 	Common::Timer timer;
 
-	if (SaveState_ZipToDisk(std::move(elist), std::move(screenshot), filename))
+	// Base goes first, an incremental state is useless without it.
+	if ((!base_elist || SaveState_ZipToDisk(std::move(base_elist), nullptr, SaveState_GetIncrementalBaseFileName(filename).c_str())) &&
+		SaveState_ZipToDisk(std::move(elist), std::move(screenshot), filename))
 	{
 		if (slot_for_message >= 0 && VMManager::HasValidVM())
 			Host::AddIconOSDMessage(std::move(osd_key), ICON_FA_SAVE, fmt::format("State saved to slot {}.", slot_for_message),
@@ -1350,10 +1396,10 @@ void VMManager::ZipSaveState(std::unique_ptr<ArchiveEntryList> elist,
 	DevCon.WriteLn("Zipping save state to '%s' took %.2f ms", filename, timer.GetTimeMilliseconds());
 }
 
-void VMManager::ZipSaveStateOnThread(std::unique_ptr<ArchiveEntryList> elist, std::unique_ptr<SaveStateScreenshotData> screenshot,
-	std::string osd_key, std::string filename, s32 slot_for_message)
+void VMManager::ZipSaveStateOnThread(std::unique_ptr<ArchiveEntryList> elist, std::unique_ptr<ArchiveEntryList> base_elist,
+	std::unique_ptr<SaveStateScreenshotData> screenshot, std::string osd_key, std::string filename, s32 slot_for_message)
 {
-	ZipSaveState(std::move(elist), std::move(screenshot), std::move(osd_key), filename.c_str(), slot_for_message);
+	ZipSaveState(std::move(elist), std::move(base_elist), std::move(screenshot), std::move(osd_key), filename.c_str(), slot_for_message);
 
 	// remove ourselves from the thread list. if we're joining, we might not be in there.
 	const auto this_id = std::this_thread::get_id();
@@ -1397,10 +1443,17 @@ u32 VMManager::DeleteSaveStates(const char* game_serial, u32 game_crc, bool also
 
 		if (also_backups)
 		{
-			filename += ".backup";
-			if (FileSystem::FileExists(filename.c_str()) && FileSystem::DeleteFilePath(filename.c_str()))
+			const std::string backup_filename(filename + ".backup");
+			if (FileSystem::FileExists(backup_filename.c_str()) && FileSystem::DeleteFilePath(backup_filename.c_str()))
 				deleted++;
 		}
+
+		// Bases of incremental states aren't counted, they're not states on their own.
+		const std::string base_filename(SaveState_GetIncrementalBaseFileName(filename));
+		if (FileSystem::FileExists(base_filename.c_str()))
+			FileSystem::DeleteFilePath(base_filename.c_str());
+		if (also_backups && FileSystem::FileExists((base_filename + ".backup").c_str()))
+			FileSystem::DeleteFilePath((base_filename + ".backup").c_str());
 	}
 
 	return deleted;
@@ -1445,6 +1498,40 @@ bool VMManager::LoadStateFromSlot(s32 slot)
 	return DoLoadState(filename.c_str());
 }
 
+bool VMManager::Rewind(u32 steps)
+{
+	if (GSDumpReplayer::IsReplayingDump() || !RewindBuffer::IsActive())
+		return false;
+
+#ifdef ENABLE_ACHIEVEMENTS
+	if (Achievements::ChallengeModeActive() &&
+		!Achievements::ConfirmChallengeModeDisable("Rewinding"))
+	{
+		return false;
+	}
+#endif
+
+	if (!RewindBuffer::Rewind(steps))
+	{
+		Host::AddIconOSDMessage("Rewind", ICON_FA_EXCLAMATION_TRIANGLE, "No rewind snapshots available.", Host::OSD_QUICK_DURATION);
+		return false;
+	}
+
+	UpdateRunningGame(false, false);
+	if (g_InputRecording.isActive())
+	{
+		g_InputRecording.handleLoadingSavestate();
+		GetMTGS().PresentCurrentFrame();
+	}
+
+	return true;
+}
+
+RewindBuffer::Stats VMManager::GetRewindStats()
+{
+	return RewindBuffer::GetStats();
+}
+
 bool VMManager::SaveState(const char* filename, bool zip_on_thread, bool backup_old_state)
 {
 	return DoSaveState(filename, -1, zip_on_thread, backup_old_state);
@@ -1666,6 +1753,9 @@ void VMManager::Internal::VSyncOnCPUThread()
 		// so we can either read from it, or overwrite it!
 		g_InputRecording.handleControllerDataUpdate();
 	}
+
+	RewindBuffer::OnVSync();
+	PINEServer::OnVSync();
 }
 
 void VMManager::CheckForCPUConfigChanges(const Pcsx2Config& old_config)
@@ -1801,18 +1891,29 @@ void VMManager::CheckForMemoryCardConfigChanges(const Pcsx2Config& old_config)
 	sioSetGameSerial(sioSerial);
 }
 
+void VMManager::UpdateDiscAccessTrace()
+{
+	// Only trace actual games, the BIOS doesn't touch the disc enough to be worth it.
+	DoCDVDsetAccessTraceSerial(s_game_crc ? s_game_serial : std::string());
+}
+
 void VMManager::CheckForConfigChanges(const Pcsx2Config& old_config)
 {
 	if (HasValidVM())
 	{
 		CheckForCPUConfigChanges(old_config);
 		CheckForFramerateConfigChanges(old_config);
+		if (EmuConfig.Rewind != old_config.Rewind)
+			RewindBuffer::UpdateConfig();
 		CheckForPatchConfigChanges(old_config);
 		SPU2::CheckForConfigChanges(old_config);
 		CheckForDEV9ConfigChanges(old_config);
 		CheckForMemoryCardConfigChanges(old_config);
 		USB::CheckForConfigChanges(old_config);
 
+		if (EmuConfig.CdvdPrefetchTrace != old_config.CdvdPrefetchTrace)
+			UpdateDiscAccessTrace();
+
 		if (EmuConfig.EnableCheats != old_config.EnableCheats ||
 			EmuConfig.EnableWideScreenPatches != old_config.EnableWideScreenPatches ||
 			EmuConfig.EnableNoInterlacingPatches != old_config.EnableNoInterlacingPatches)
@@ -26,6 +26,7 @@
 #include "common/Pcsx2Defs.h"
 
 #include "Config.h"
+#include "RewindBuffer.h"
 
 enum class CDVD_SourceType : uint8_t;
 
@@ -80,6 +81,9 @@ namespace VMManager
 	/// Returns the name of the disc/executable currently running.
 	std::string GetGameName();
 
+	/// Returns the software version of the disc currently running, from SYSTEM.CNF.
+	std::string GetGameVersion();
+
 	/// Loads global settings (i.e. EmuConfig).
 	void LoadSettings();
 
@@ -122,6 +126,13 @@ namespace VMManager
 	/// Loads state from the specified slot.
 	bool LoadStateFromSlot(s32 slot);
 
+	/// Restores the rewind snapshot the specified number of steps back, 1 being the most recent.
+	/// Fails if rewind is disabled or no snapshot has been taken yet.
+	bool Rewind(u32 steps = 1);
+
+	/// Returns the memory usage and per-snapshot cost of the rewind buffer.
+	RewindBuffer::Stats GetRewindStats();
+
 	/// Saves state to the specified filename.
 	bool SaveState(const char* filename, bool zip_on_thread = true, bool backup_old_state = false);
 
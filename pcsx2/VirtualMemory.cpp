@@ -29,7 +29,8 @@
 //  VirtualMemoryManager  (implementations)
 // --------------------------------------------------------------------------------------
 
-VirtualMemoryManager::VirtualMemoryManager(std::string name, const char* file_mapping_name, uptr base, size_t size, uptr upper_bounds, bool strict)
+VirtualMemoryManager::VirtualMemoryManager(std::string name, const char* file_mapping_name, uptr base, size_t size, uptr upper_bounds, bool strict,
+	HugePageMode huge_pages)
 	: m_name(std::move(name))
 	, m_file_handle(nullptr)
 	, m_baseptr(0)
@@ -67,14 +68,26 @@ VirtualMemoryManager::VirtualMemoryManager(std::string name, const char* file_ma
 	}
 	else
 	{
-		m_baseptr = static_cast<u8*>(HostSys::Mmap((void*)base, reserved_bytes, PageAccess_Any()));
+		const size_t huge_page_size = HostSys::GetHugePageSize();
+		if (huge_pages == HugePageMode::Explicit && huge_page_size != 0 && Common::IsAlignedPow2(base, huge_page_size))
+		{
+			m_baseptr = static_cast<u8*>(HostSys::MmapHugePages((void*)base, Common::AlignUpPow2(reserved_bytes, huge_page_size), PageAccess_Any()));
+			if (m_baseptr)
+				m_huge_page_size = huge_page_size;
+			else
+				DevCon.Warning("%s: explicit huge pages @ 0x%016" PRIXPTR " are unavailable.", m_name.c_str(), base);
+		}
+
+		if (!m_baseptr)
+			m_baseptr = static_cast<u8*>(HostSys::Mmap((void*)base, reserved_bytes, PageAccess_Any()));
 
 		if (!m_baseptr || (upper_bounds != 0 && (((uptr)m_baseptr + reserved_bytes) > upper_bounds)))
 		{
 			DevCon.Warning("%s: host memory @ 0x%016" PRIXPTR " -> 0x%016" PRIXPTR " is unavailable; attempting to map elsewhere...",
 				m_name.c_str(), base, base + size);
 
-			SafeSysMunmap(m_baseptr, reserved_bytes);
+			SafeSysMunmap(m_baseptr, GetMappedSize());
+			m_huge_page_size = 0;
 
 			if (base)
 			{
@@ -103,13 +116,19 @@ VirtualMemoryManager::VirtualMemoryManager(std::string name, const char* file_ma
 		}
 		else
 		{
-			SafeSysMunmap(m_baseptr, reserved_bytes);
+			SafeSysMunmap(m_baseptr, GetMappedSize());
+			m_huge_page_size = 0;
 		}
 	}
 
 	if (!m_baseptr)
 		return;
 
+	// Guest memory is protected at 4K granularity for SMC detection and is viewed through fastmem,
+	// so it can only use transparent huge pages, which the kernel splits where needed.
+	if (huge_pages != HugePageMode::Disabled && !m_huge_page_size && !HostSys::AdviseHugePages(m_baseptr, reserved_bytes))
+		DevCon.Warning("%s: transparent huge pages are not supported by the host.", m_name.c_str());
+
 	m_pageuse = new std::atomic<bool>[m_pages_reserved]();
 
 	std::string mbkb;
@@ -119,10 +138,19 @@ VirtualMemoryManager::VirtualMemoryManager(std::string name, const char* file_ma
 	else
 		mbkb = fmt::format("[{}kb]", reserved_bytes / 1024);
 
+	if (m_huge_page_size)
+		mbkb += fmt::format(" [{}kb pages]", m_huge_page_size / 1024);
+
 	DevCon.WriteLn(Color_Gray, "%-32s @ 0x%016" PRIXPTR " -> 0x%016" PRIXPTR " %s", m_name.c_str(),
 		m_baseptr, (uptr)m_baseptr + reserved_bytes, mbkb.c_str());
 }
 
+size_t VirtualMemoryManager::GetMappedSize() const
+{
+	const size_t reserved_bytes = m_pages_reserved * __pagesize;
+	return m_huge_page_size ? Common::AlignUpPow2(reserved_bytes, m_huge_page_size) : reserved_bytes;
+}
+
 VirtualMemoryManager::~VirtualMemoryManager()
 {
 	if (m_pageuse)
@@ -132,7 +160,7 @@ VirtualMemoryManager::~VirtualMemoryManager()
 		if (m_file_handle)
 			HostSys::UnmapSharedMemory((void*)m_baseptr, m_pages_reserved * __pagesize);
 		else
-			HostSys::Munmap(m_baseptr, m_pages_reserved * __pagesize);
+			HostSys::Munmap(m_baseptr, GetMappedSize());
 	}
 	if (m_file_handle)
 		HostSys::DestroySharedMemory(m_file_handle);
@@ -317,8 +345,14 @@ void RecompiledCodeReserve::_registerProfiler()
 
 void RecompiledCodeReserve::Assign(VirtualMemoryManagerPtr allocator, size_t offset, size_t size)
 {
-	// Anything passed to the memory allocator must be page aligned.
+	// Anything passed to the memory allocator must be page aligned. Protection is changed for the whole
+	// reserve, so with explicit huge pages it has to cover whole huge pages.
 	size = Common::PageAlign(size);
+	if (allocator->IsHugePageBacked())
+	{
+		pxAssertRel(Common::IsAlignedPow2(offset, allocator->GetHugePageSize()), "Code reserve is huge page aligned");
+		size = Common::AlignUpPow2(size, allocator->GetHugePageSize());
+	}
 
 	// Since the memory has already been allocated as part of the main memory map, this should never fail.
 	u8* base = allocator->Alloc(offset, size);
@@ -41,14 +41,25 @@ class VirtualMemoryManager
 	// reserved memory (in pages)
 	u32 m_pages_reserved;
 
+	// size of the explicit huge pages backing the reserve, zero for normal pages
+	size_t m_huge_page_size = 0;
+
+	size_t GetMappedSize() const;
+
 public:
 	// If upper_bounds is nonzero and the OS fails to allocate memory that is below it,
 	// calls to IsOk() will return false and Alloc() will always return null pointers
 	// strict indicates that the allocation should quietly fail if the memory can't be mapped at `base`
-	VirtualMemoryManager(std::string name, const char* file_mapping_name, uptr base, size_t size, uptr upper_bounds = 0, bool strict = false);
+	// huge_pages only applies explicit huge pages to private reservations, shared memory gets transparent ones
+	VirtualMemoryManager(std::string name, const char* file_mapping_name, uptr base, size_t size, uptr upper_bounds = 0, bool strict = false,
+		HugePageMode huge_pages = HugePageMode::Disabled);
 	~VirtualMemoryManager();
 
 	bool IsSharedMemory() const { return (m_file_handle != nullptr); }
+
+	// Explicit huge pages can only be protected as a whole, so allocations which change protection must be aligned to them.
+	bool IsHugePageBacked() const { return (m_huge_page_size != 0); }
+	size_t GetHugePageSize() const { return m_huge_page_size; }
 	void* GetFileHandle() const { return m_file_handle; }
 	u8* GetBase() const { return m_baseptr; }
 	u8* GetEnd() const { return (m_baseptr + m_pages_reserved * __pagesize); }
@@ -37,6 +37,7 @@
 #include "IopMem.h"
 #include "Host.h"
 #include "VMManager.h"
+#include "DebugTools/Breakpoints.h"
 
 #include "common/Align.h"
 #include "common/MemsetFast.inl"
@@ -97,6 +98,8 @@ static std::vector<u32> s_fastmem_virtual_mapping; // maps vaddr -> mainmem offs
 static std::unordered_multimap<u32, u32> s_fastmem_physical_mapping; // maps mainmem offset -> vaddr
 static std::unordered_map<uptr, LoadstoreBackpatchInfo> s_fastmem_backpatch_info;
 static std::unordered_set<u32> s_fastmem_faulting_pcs;
+static std::unordered_map<u32, u32> s_fastmem_watched_pages; // maps vaddr page -> MemCheckCondition of its memchecks
+static bool s_fastmem_watchpoints = false;
 
 vtlb_private::VTLBPhysical vtlb_private::VTLBPhysical::fromPointer(sptr ptr)
 {
@@ -830,6 +833,32 @@ static bool vtlb_GetMainMemoryOffset(u32 paddr, u32* mainmem_offset, u32* mainme
 	return vtlb_GetMainMemoryOffsetFromPtr(vm.raw(), mainmem_offset, mainmem_size, prot);
 }
 
+// Watched pages fault on every access which can hit one of their memchecks. Read checks need writes
+// to fault too, as pages can't be writable without being readable.
+static PageProtectionMode vtlb_GetWatchedProtection(u32 vaddr, PageProtectionMode prot)
+{
+	const auto it = s_fastmem_watched_pages.find(vaddr >> VTLB_PAGE_BITS);
+	if (it == s_fastmem_watched_pages.end())
+		return prot;
+
+	return (it->second & MEMCHECK_READ) ? PageAccess_None() : prot.Write(false);
+}
+
+static void vtlb_ProtectFastmemPage(u32 page)
+{
+	if (s_fastmem_virtual_mapping.empty() || s_fastmem_virtual_mapping[page] == NO_FASTMEM_MAPPING)
+		return;
+
+	const u32 mainmem_offset = s_fastmem_virtual_mapping[page];
+
+	// Code pages in EE RAM stay write protected for SMC detection.
+	const u32 eemem_offset = mainmem_offset - HostMemoryMap::EEmemOffset;
+	const bool writeable = (eemem_offset >= Ps2MemSize::MainRam || mmap_GetRamPageInfo(eemem_offset) != ProtMode_Write);
+	const u32 vaddr = page << VTLB_PAGE_BITS;
+	HostSys::MemProtect(s_fastmem_area->PagePointer(page), __pagesize,
+		vtlb_GetWatchedProtection(vaddr, PageProtectionMode().Read().Write(writeable)));
+}
+
 static void vtlb_CreateFastmemMapping(u32 vaddr, u32 mainmem_offset, const PageProtectionMode& mode)
 {
 	FASTMEM_LOG("Create fastmem mapping @ vaddr %08X mainmem %08X", vaddr, mainmem_offset);
@@ -877,6 +906,9 @@ static void vtlb_CreateFastmemMapping(u32 vaddr, u32 mainmem_offset, const PageP
 	}
 
 	s_fastmem_physical_mapping.emplace(mainmem_offset, vaddr);
+
+	if (s_fastmem_watched_pages.find(page) != s_fastmem_watched_pages.end())
+		HostSys::MemProtect(s_fastmem_area->PagePointer(page), __pagesize, vtlb_GetWatchedProtection(vaddr, mode));
 }
 
 static void vtlb_RemoveFastmemMapping(u32 vaddr)
@@ -999,7 +1031,7 @@ void vtlb_UpdateFastmemProtection(u32 paddr, u32 size, const PageProtectionMode&
 			FASTMEM_LOG("  valias %08X (size %u)", it->second, VTLB_PAGE_SIZE);
 
 			if (vtlb_IsHostAligned(it->second))
-				HostSys::MemProtect(s_fastmem_area->OffsetPointer(it->second), __pagesize, prot);
+				HostSys::MemProtect(s_fastmem_area->OffsetPointer(it->second), __pagesize, vtlb_GetWatchedProtection(it->second, prot));
 		}
 	}
 }
@@ -1022,6 +1054,66 @@ void vtlb_AddLoadStoreInfo(uptr code_address, u32 code_size, u32 guest_pc, u32 g
 	s_fastmem_backpatch_info.emplace(code_address, info);
 }
 
+bool vtlb_HasFastmemWatchpoints()
+{
+	return s_fastmem_watchpoints;
+}
+
+void vtlb_UpdateFastmemWatchpoints()
+{
+	std::unordered_map<u32, u32> old_pages = std::move(s_fastmem_watched_pages);
+	s_fastmem_watched_pages.clear();
+
+	// Page protection only works when guest pages are host pages.
+	const MemCheckIndex& index = CBreakPoints::GetMemCheckIndex(BREAKPOINT_EE);
+	s_fastmem_watchpoints = (CHECK_FASTMEM && EmuConfig.Debugger.PageProtectWatchpoints && !vtlb_MismatchedHostPageSize() &&
+							 !s_fastmem_virtual_mapping.empty() && !index.IsEmpty());
+	if (s_fastmem_watchpoints)
+	{
+		// Memchecks use standardized addresses, so watch every segment which standardizes to a watched page.
+		index.ForEachRange([](u32 start, u32 end, u32 cond) {
+			const u32 last = std::max(end, start + 1) - 1;
+			for (u32 page = start >> VTLB_PAGE_BITS; page <= (last >> VTLB_PAGE_BITS); page++)
+			{
+				const u32 page_addr = page << VTLB_PAGE_BITS;
+				for (u32 segment = 0; segment < 16; segment++)
+				{
+					const u32 vaddr = (page_addr & 0x0FFFFFFFu) | (segment << 28);
+					if (standardizeBreakpointAddress(vaddr) == page_addr)
+						s_fastmem_watched_pages[vaddr >> VTLB_PAGE_BITS] |= cond;
+				}
+			}
+		});
+
+		DevCon.WriteLn("(vtlb) Watching %zu fastmem pages for memchecks.", s_fastmem_watched_pages.size());
+	}
+
+	for (const auto& it : old_pages)
+	{
+		if (s_fastmem_watched_pages.find(it.first) == s_fastmem_watched_pages.end())
+			vtlb_ProtectFastmemPage(it.first);
+	}
+	for (const auto& it : s_fastmem_watched_pages)
+		vtlb_ProtectFastmemPage(it.first);
+}
+
+static void vtlb_CheckFastmemWatchpoint(u32 guest_addr, u32 size_in_bits, bool is_load)
+{
+	const u32 addr = standardizeBreakpointAddress(guest_addr);
+	const u32 result = CBreakPoints::GetMemCheckIndex(BREAKPOINT_EE).Find(addr, addr + size_in_bits / 8, !is_load);
+	if (result & MEMCHECK_LOG)
+		DevCon.WriteLn("Hit %s breakpoint @0x%x", is_load ? "load" : "store", addr);
+
+	if (result & MEMCHECK_BREAK)
+	{
+		// We can't leave the block from the fault handler, so stop at the end of it. The recompiled
+		// block checks this instruction itself, so later hits stop before the access.
+		CBreakPoints::SetBreakpointTriggered(true);
+		VMManager::SetPaused(true);
+		Cpu->ExitExecution();
+	}
+}
+
 bool vtlb_BackpatchLoadStore(uptr code_address, uptr fault_address)
 {
 	uptr fastmem_start = (uptr)vtlbdata.fastmem_base;
@@ -1035,6 +1127,9 @@ bool vtlb_BackpatchLoadStore(uptr code_address, uptr fault_address)
 
 	const LoadstoreBackpatchInfo& info = iter->second;
 	const u32 guest_addr = static_cast<u32>(fault_address - fastmem_start);
+	if (s_fastmem_watched_pages.find(guest_addr >> VTLB_PAGE_BITS) != s_fastmem_watched_pages.end())
+		vtlb_CheckFastmemWatchpoint(guest_addr, info.size_in_bits, info.is_load);
+
 	vtlb_DynBackpatchLoadStore(code_address, info.code_size, info.guest_pc, guest_addr,
 		info.gpr_bitmask, info.fpr_bitmask, info.address_register, info.data_register,
 		info.size_in_bits, info.is_signed, info.is_load, info.is_fpr);
@@ -1515,4 +1610,5 @@ void mmap_ResetBlockTracking()
 	if (eeMem)
 		HostSys::MemProtect(eeMem->Main, Ps2MemSize::MainRam, PageAccess_ReadWrite());
 	vtlb_UpdateFastmemProtection(0, Ps2MemSize::MainRam, PageAccess_ReadWrite());
+	vtlb_UpdateFastmemWatchpoints();
 }
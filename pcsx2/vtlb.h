@@ -92,6 +92,11 @@ extern void vtlb_AddLoadStoreInfo(uptr code_address, u32 code_size, u32 guest_pc
 extern void vtlb_DynBackpatchLoadStore(uptr code_address, u32 code_size, u32 guest_pc, u32 guest_addr, u32 gpr_bitmask, u32 fpr_bitmask, u8 address_register, u8 data_register, u8 size_in_bits, bool is_signed, bool is_load, bool is_fpr);
 extern bool vtlb_IsFaultingPC(u32 guest_pc);
 
+// Protects the fastmem pages covered by EE memchecks, so only the loads/stores which touch them fault,
+// get backpatched to the slow path and need checks in the recompiler.
+extern void vtlb_UpdateFastmemWatchpoints();
+extern bool vtlb_HasFastmemWatchpoints();
+
 //Memory functions
 
 template< typename DataType >
@@ -1593,6 +1593,25 @@ void dynarecMemLogcheck(u32 start, bool store)
 		DevCon.WriteLn("Hit load breakpoint @0x%x", start);
 }
 
+static void dynarecCheckMemAccess(u32 start, u32 end, bool store)
+{
+	const u32 result = CBreakPoints::GetMemCheckIndex(BREAKPOINT_EE).Find(start, end, store);
+	if (result & MEMCHECK_LOG)
+		dynarecMemLogcheck(start, store);
+	if (result & MEMCHECK_BREAK)
+		dynarecMemcheck();
+}
+
+static void dynarecCheckMemLoad(u32 start, u32 end)
+{
+	dynarecCheckMemAccess(start, end, false);
+}
+
+static void dynarecCheckMemStore(u32 start, u32 end)
+{
+	dynarecCheckMemAccess(start, end, true);
+}
+
 void recMemcheck(u32 op, u32 bits, bool store)
 {
 	iFlushCall(FLUSH_EVERYTHING | FLUSH_PC);
@@ -1611,41 +1630,7 @@ void recMemcheck(u32 op, u32 bits, bool store)
 
 	// ecx = access address
 	// edx = access address+size
-
-	auto checks = CBreakPoints::GetMemChecks(BREAKPOINT_EE);
-	for (size_t i = 0; i < checks.size(); i++)
-	{
-		if (checks[i].result == 0)
-			continue;
-		if ((checks[i].cond & MEMCHECK_WRITE) == 0 && store)
-			continue;
-		if ((checks[i].cond & MEMCHECK_READ) == 0 && !store)
-			continue;
-
-		// logic: memAddress < bpEnd && bpStart < memAddress+memSize
-
-		xMOV(eax, standardizeBreakpointAddress(checks[i].end));
-		xCMP(ecx, eax); // address < end
-		xForwardJGE8 next1; // if address >= end then goto next1
-
-		xMOV(eax, standardizeBreakpointAddress(checks[i].start));
-		xCMP(eax, edx); // start < address+size
-		xForwardJGE8 next2; // if start >= address+size then goto next2
-
-		// hit the breakpoint
-		if (checks[i].result & MEMCHECK_LOG)
-		{
-			xMOV(edx, store);
-			xFastCall((void*)dynarecMemLogcheck, ecx, edx);
-		}
-		if (checks[i].result & MEMCHECK_BREAK)
-		{
-			xFastCall((void*)dynarecMemcheck);
-		}
-
-		next1.SetTarget();
-		next2.SetTarget();
-	}
+	xFastCall(store ? (void*)dynarecCheckMemStore : (void*)dynarecCheckMemLoad, ecx, edx);
 }
 
 void encodeBreakpoint()
@@ -1657,6 +1642,37 @@ void encodeBreakpoint()
 	}
 }
 
+// With watchpoints on fastmem pages, loads/stores which touch a watched page fault and get backpatched,
+// so only those need to be recompiled with a check, in their own block like before.
+static int recIsMemcheckNeeded(u32 addr)
+{
+	const int needed = isMemcheckNeeded(addr);
+	if (needed == 0 || !vtlb_HasFastmemWatchpoints())
+		return needed;
+
+	// A load/store at addr, and one in the delay slot of a branch at addr, are both recompiled with pc = addr + 4.
+	return vtlb_IsFaultingPC(addr + 4) ? needed : 0;
+}
+
+static u32 recGetMemcheckBits(const OPCODE& opcode)
+{
+	switch (opcode.flags & MEMTYPE_MASK)
+	{
+		case MEMTYPE_BYTE:
+			return 8;
+		case MEMTYPE_HALF:
+			return 16;
+		case MEMTYPE_WORD:
+			return 32;
+		case MEMTYPE_DWORD:
+			return 64;
+		case MEMTYPE_QWORD:
+			return 128;
+		default:
+			return 0;
+	}
+}
+
 void encodeMemcheck()
 {
 	int needed = isMemcheckNeeded(pc);
@@ -1667,24 +1683,31 @@ void encodeMemcheck()
 	const OPCODE& opcode = GetInstruction(op);
 
 	bool store = (opcode.flags & IS_STORE) != 0;
-	switch (opcode.flags & MEMTYPE_MASK)
+	const u32 bits = recGetMemcheckBits(opcode);
+	if (bits == 0)
+		return;
+
+	if (vtlb_HasFastmemWatchpoints() && !vtlb_IsFaultingPC(pc + 4))
 	{
-		case MEMTYPE_BYTE:
-			recMemcheck(op, 8, store);
-			break;
-		case MEMTYPE_HALF:
-			recMemcheck(op, 16, store);
-			break;
-		case MEMTYPE_WORD:
-			recMemcheck(op, 32, store);
-			break;
-		case MEMTYPE_DWORD:
-			recMemcheck(op, 64, store);
-			break;
-		case MEMTYPE_QWORD:
-			recMemcheck(op, 128, store);
-			break;
+		// Constant addresses don't go through fastmem, so they're checked here, at compile time.
+		// The delay slot address can't be, since the branch may link to the base register.
+		const u32 rs = (op >> 21) & 0x1F;
+		if (!GPR_IS_CONST1(rs))
+			return;
+
+		if (needed == 1)
+		{
+			u32 addr = g_cpuConstRegs[rs].UL[0] + (s16)op;
+			if (bits == 128)
+				addr &= ~0x0F;
+
+			addr = standardizeBreakpointAddress(addr);
+			if (CBreakPoints::GetMemCheckIndex(BREAKPOINT_EE).Find(addr, addr + bits / 8, store) == MEMCHECK_IGNORE)
+				return;
+		}
 	}
+
+	recMemcheck(op, bits, store);
 }
 
 void recompileNextInstruction(bool delayslot, bool swapped_delay_slot)
@@ -2270,7 +2293,7 @@ static void recRecompile(const u32 startpc)
 
 	// compile breakpoints as individual blocks
 	int n1 = isBreakpointNeeded(i);
-	int n2 = isMemcheckNeeded(i);
+	int n2 = recIsMemcheckNeeded(i);
 	int n = std::max<int>(n1, n2);
 	if (n != 0)
 	{
@@ -2283,7 +2306,7 @@ static void recRecompile(const u32 startpc)
 		BASEBLOCK* pblock = PC_GETBLOCK(i);
 
 		// stop before breakpoints
-		if (isBreakpointNeeded(i) != 0 || isMemcheckNeeded(i) != 0)
+		if (isBreakpointNeeded(i) != 0 || recIsMemcheckNeeded(i) != 0)
 		{
 			s_nEndBlock = i;
 			break;
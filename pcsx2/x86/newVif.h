@@ -35,6 +35,7 @@ extern void  dVifReserve (int idx);
 extern void  dVifReset   (int idx);
 extern void  dVifClose   (int idx);
 extern void  dVifRelease (int idx);
+extern void  dVifSetBlockCacheGame(const std::string& serial, u32 crc);
 extern void  VifUnpackSSE_Init();
 extern void  VifUnpackSSE_Destroy();
 
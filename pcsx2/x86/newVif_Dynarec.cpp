@@ -20,12 +20,67 @@
 #include "PrecompiledHeader.h"
 #include "newVif_UnpackSSE.h"
 #include "MTVU.h"
+#include "common/FileSystem.h"
+#include "common/Path.h"
 #include "common/Perf.h"
 #include "common/StringUtil.h"
 #include "fmt/core.h"
+#include <unordered_set>
+
+// Block cache: the keys of every block a game compiled, saved when the game changes or the VM
+// shuts down, and compiled in one go at the first cache miss the next time the game runs.
+// Only keys are kept, the generated code embeds host addresses which change between sessions.
+static constexpr u32 BLOCK_CACHE_MAGIC = 0x42464956; // VIFB
+static constexpr u32 BLOCK_CACHE_VERSION = 1;
+static constexpr u32 MAX_CACHED_BLOCKS = 16384;
+
+struct BlockCacheHeader
+{
+	u32 magic;
+	u32 version;
+	u32 count[2];
+};
+
+struct BlockCacheKey
+{
+	u16 hash_key;
+	u16 pad;
+	u32 key0;
+	u32 key1;
+
+	bool operator==(const BlockCacheKey& rhs) const
+	{
+		return hash_key == rhs.hash_key && key0 == rhs.key0 && key1 == rhs.key1;
+	}
+};
+
+struct BlockCacheKeyHash
+{
+	size_t operator()(const BlockCacheKey& key) const
+	{
+		return std::hash<u64>()((static_cast<u64>(key.key0) << 32) | key.key1) ^ key.hash_key;
+	}
+};
+
+static std::string s_block_cache_path;
+static std::vector<BlockCacheKey> s_block_cache[2];
+static bool s_block_cache_pending[2] = {};
+
+static void LogBlockStats(int idx)
+{
+	const HashBucket::Stats stats = nVif[idx].vifBlocks.stats();
+	const u64 lookups = stats.hits + stats.misses;
+	if (lookups == 0)
+		return;
+
+	DevCon.WriteLn("nVif%d: %u blocks in %u cells, %llu hits, %llu misses, %.3f extra probes per lookup (max %u)",
+		idx, stats.blocks, stats.capacity, stats.hits, stats.misses,
+		static_cast<double>(stats.probes) / static_cast<double>(lookups), stats.max_probe);
+}
 
 static void recReset(int idx)
 {
+	LogBlockStats(idx);
 	nVif[idx].vifBlocks.reset();
 
 	nVif[idx].recReserve->Reset();
@@ -48,14 +103,113 @@ void dVifReset(int idx)
 	pxAssertDev(nVif[idx].recReserve, "Dynamic VIF recompiler reserve must be created prior to VIF use or reset!");
 
 	recReset(idx);
+	s_block_cache_pending[idx] = !s_block_cache[idx].empty();
 }
 
 void dVifClose(int idx)
 {
+	LogBlockStats(idx);
 	if (nVif[idx].recReserve)
 		nVif[idx].recReserve->Reset();
 }
 
+static void SaveBlockCache()
+{
+	if (s_block_cache_path.empty())
+		return;
+
+	std::vector<BlockCacheKey> keys[2];
+	for (int idx = 0; idx < 2; idx++)
+	{
+		// Blocks from the file which weren't needed this time are kept, they may be next time.
+		keys[idx] = s_block_cache[idx];
+		const std::unordered_set<BlockCacheKey, BlockCacheKeyHash> known(s_block_cache[idx].begin(), s_block_cache[idx].end());
+		nVif[idx].vifBlocks.for_each([&keys, &known, idx](const nVifBlock& block) {
+			if (keys[idx].size() >= MAX_CACHED_BLOCKS)
+				return;
+
+			const BlockCacheKey key = {block.hash_key, 0, block.key0, block.key1};
+			if (known.find(key) == known.end())
+				keys[idx].push_back(key);
+		});
+	}
+
+	if (keys[0].size() == s_block_cache[0].size() && keys[1].size() == s_block_cache[1].size())
+		return;
+
+	const BlockCacheHeader hdr = {BLOCK_CACHE_MAGIC, BLOCK_CACHE_VERSION,
+		{static_cast<u32>(keys[0].size()), static_cast<u32>(keys[1].size())}};
+	std::vector<u8> data(sizeof(hdr) + (keys[0].size() + keys[1].size()) * sizeof(BlockCacheKey));
+	std::memcpy(data.data(), &hdr, sizeof(hdr));
+	std::memcpy(data.data() + sizeof(hdr), keys[0].data(), keys[0].size() * sizeof(BlockCacheKey));
+	std::memcpy(data.data() + sizeof(hdr) + keys[0].size() * sizeof(BlockCacheKey), keys[1].data(),
+		keys[1].size() * sizeof(BlockCacheKey));
+
+	const std::string dir(Path::GetDirectory(s_block_cache_path));
+	if (!FileSystem::EnsureDirectoryExists(dir.c_str(), true) ||
+		!FileSystem::WriteBinaryFile(s_block_cache_path.c_str(), data.data(), data.size()))
+	{
+		Console.Error("(nVif) Failed to write block cache to '%s'", s_block_cache_path.c_str());
+	}
+}
+
+static void LoadBlockCache()
+{
+	s_block_cache[0].clear();
+	s_block_cache[1].clear();
+
+	std::optional<std::vector<u8>> data = FileSystem::ReadBinaryFile(s_block_cache_path.c_str());
+	if (!data.has_value() || data->size() < sizeof(BlockCacheHeader))
+		return;
+
+	BlockCacheHeader hdr;
+	std::memcpy(&hdr, data->data(), sizeof(hdr));
+	if (hdr.magic != BLOCK_CACHE_MAGIC || hdr.version != BLOCK_CACHE_VERSION ||
+		hdr.count[0] > MAX_CACHED_BLOCKS || hdr.count[1] > MAX_CACHED_BLOCKS ||
+		data->size() != sizeof(hdr) + (hdr.count[0] + hdr.count[1]) * sizeof(BlockCacheKey))
+	{
+		Console.Warning("(nVif) Ignoring invalid block cache '%s'", s_block_cache_path.c_str());
+		return;
+	}
+
+	const u8* ptr = data->data() + sizeof(hdr);
+	for (int idx = 0; idx < 2; idx++)
+	{
+		s_block_cache[idx].resize(hdr.count[idx]);
+		std::memcpy(s_block_cache[idx].data(), ptr, hdr.count[idx] * sizeof(BlockCacheKey));
+		ptr += hdr.count[idx] * sizeof(BlockCacheKey);
+	}
+
+	DevCon.WriteLn("(nVif) Loaded %u VIF0 and %u VIF1 unpack blocks from '%s'", hdr.count[0], hdr.count[1],
+		s_block_cache_path.c_str());
+}
+
+void dVifSetBlockCacheGame(const std::string& serial, u32 crc)
+{
+	// VIF1 blocks are compiled on the VU thread when it's enabled.
+	if (THREAD_VU1)
+		vu1Thread.WaitVU();
+
+	SaveBlockCache();
+
+	s_block_cache_path = (crc != 0) ?
+		Path::Combine(EmuFolders::Cache, Path::Combine("vif", fmt::format("{}_{:08X}.bin", Path::SanitizeFileName(serial), crc))) :
+		std::string();
+
+	if (!s_block_cache_path.empty())
+	{
+		LoadBlockCache();
+	}
+	else
+	{
+		s_block_cache[0].clear();
+		s_block_cache[1].clear();
+	}
+
+	s_block_cache_pending[0] = !s_block_cache[0].empty();
+	s_block_cache_pending[1] = !s_block_cache[1].empty();
+}
+
 void dVifRelease(int idx)
 {
 	dVifClose(idx);
@@ -68,6 +222,7 @@ VifUnpackSSE_Dynarec::VifUnpackSSE_Dynarec(const nVifStruct& vif_, const nVifBlo
 {
 	const int wl = vB.wl ? vB.wl : 256; //0 is taken as 256 (KH2)
 	isFill    = (vB.cl < wl);
+	useAVX2   = false;
 	usn       = (vB.upkType>>5) & 1;
 	doMask    = (vB.upkType>>4) & 1;
 	doMode    = vB.mode & 3;
@@ -80,6 +235,36 @@ __fi void makeMergeMask(u32& x)
 	x = ((x & 0x40) >> 6) | ((x & 0x10) >> 3) | (x & 4) | ((x & 1) << 3);
 }
 
+// vpermd indices giving col[n] in the low quadword and col[n+1] in the high one.
+alignas(32) static const u32 s_col_pair_index[4][8] =
+{
+	{0, 0, 0, 0, 1, 1, 1, 1},
+	{1, 1, 1, 1, 2, 2, 2, 2},
+	{2, 2, 2, 2, 3, 3, 3, 3},
+	{3, 3, 3, 3, 3, 3, 3, 3}
+};
+
+// Clears W of the low and/or high quadword, indexed by (high << 1) | low.
+alignas(32) static const u32 s_zero_w_pair[4][8] =
+{
+	{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+	{0xffffffff, 0xffffffff, 0xffffffff, 0x00000000, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+	{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0x00000000},
+	{0xffffffff, 0xffffffff, 0xffffffff, 0x00000000, 0xffffffff, 0xffffffff, 0xffffffff, 0x00000000}
+};
+
+// Lanes (bit 0 = x) whose 2-bit mask field equals type: 1 = row, 2 = col, 3 = write protect.
+static __fi u32 maskLanes(u32 m0, u32 type)
+{
+	u32 lanes = 0;
+	for (u32 i = 0; i < 4; i++)
+	{
+		if (((m0 >> (i * 2)) & 3) == type)
+			lanes |= 1u << i;
+	}
+	return lanes;
+}
+
 __fi void VifUnpackSSE_Dynarec::SetMasks(int cS) const
 {
 	const int idx = v.idx;
@@ -90,6 +275,26 @@ __fi void VifUnpackSSE_Dynarec::SetMasks(int cS) const
 	u32 m3 = ((m0 & 0xaaaaaaaa) >> 1) & ~m0; //all the upper bits, so our example 0x01010000 & 0xFCFDFEFF = 0x00010000 just the cols (shifted right for maskmerge)
 	u32 m2 = (m0 & 0x55555555) & (~m0 >> 1); // 0x1000100 & 0xFE7EFF7F = 0x00000100 Just the row
 
+	if (useAVX2)
+	{
+		// Same registers as below, with the upper half holding the value for the next quadword.
+		if ((m2 && doMask) || doMode)
+			xVBROADCASTI128(xRegisterSSE::GetYMMInstance(xmmRow.Id), ptr128[&vif.MaskRow]);
+		if (m3 && doMask)
+		{
+			xVMOVAPS(xmm1, ptr128[&vif.MaskCol]);
+			for (int i = 0; i < std::min(cS, 4); i++)
+			{
+				if (!((m3 >> (i * 8)) & 0xffff))
+					continue;
+
+				xVMOVAPS(ymm0, ptr[s_col_pair_index[i]]);
+				xVPERMD(xRegisterSSE::GetYMMInstance(xmmCol0.Id + i), ymm0, ymm1);
+			}
+		}
+		return;
+	}
+
 	if ((m2 && doMask) || doMode)
 	{
 		xMOVAPS(xmmRow, ptr128[&vif.MaskRow]);
@@ -173,6 +378,123 @@ void VifUnpackSSE_Dynarec::doMaskWrite(const xRegisterSSE& regX) const
 	xMOVAPS(ptr32[dstIndirect], regX);
 }
 
+bool VifUnpackSSE_Dynarec::CanUseAVX2(int upknum, int cycleSize) const
+{
+	// Pairs never straddle a cycle when the cycle size is even, so each one is a plain two
+	// quadword write. Difference/accumulate modes chain the row through every write, leave
+	// those to the one quadword path.
+	if (!x86caps.hasAVX2 || isFill || (cycleSize & 1) || doMode >= 2)
+		return false;
+
+	switch (upknum)
+	{
+		case 4: case 5: case 6:
+		case 8: case 9: case 10:
+		case 12: case 13: case 14:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+// Unpacks the next two quadwords into ymm0, low half first, with the same
+// results and UnpkLoopIteration updates as two passes through xUnpack().
+void VifUnpackSSE_Dynarec::xUnpackPairAVX2(int upknum)
+{
+	const int step = nVifT[upknum];
+
+	ModUnpack(upknum, false);
+	const bool zeroLow = IsLastWordZeroed(upknum);
+	ModUnpack(upknum, true);
+	ModUnpack(upknum, false);
+	const bool zeroHigh = IsLastWordZeroed(upknum);
+	ModUnpack(upknum, true);
+
+	switch (upknum)
+	{
+		// V2: both vectors come from one load, spread out as v1v0v1v0 | v3v2v3v2.
+		case 4:
+			xVMOVUPS(xmm1, ptr128[srcIndirect]);
+			xVPERMQ(ymm0, ymm1, 0x50);
+			break;
+		case 5:
+			if (usn) xVPMOVZX.WD(xmm1, ptr64[srcIndirect]);
+			else     xVPMOVSX.WD(xmm1, ptr64[srcIndirect]);
+			xVPERMQ(ymm0, ymm1, 0x50);
+			break;
+		case 6:
+			if (usn) xVPMOVZX.BD(xmm1, ptr32[srcIndirect]);
+			else     xVPMOVSX.BD(xmm1, ptr32[srcIndirect]);
+			xVPERMQ(ymm0, ymm1, 0x50);
+			break;
+
+		// V3: vectors aren't quadword sized, so each half is loaded on its own.
+		case 8:
+			xVMOVUPS(xmm0, ptr128[srcIndirect]);
+			xVINSERTI128(ymm0, ymm0, ptr128[srcIndirect + step], 1);
+			break;
+		case 9:
+			if (usn) { xVPMOVZX.WD(xmm0, ptr64[srcIndirect]); xVPMOVZX.WD(xmm1, ptr64[srcIndirect + step]); }
+			else     { xVPMOVSX.WD(xmm0, ptr64[srcIndirect]); xVPMOVSX.WD(xmm1, ptr64[srcIndirect + step]); }
+			xVINSERTI128(ymm0, ymm0, xmm1, 1);
+			break;
+		case 10:
+			if (usn) { xVPMOVZX.BD(xmm0, ptr32[srcIndirect]); xVPMOVZX.BD(xmm1, ptr32[srcIndirect + step]); }
+			else     { xVPMOVSX.BD(xmm0, ptr32[srcIndirect]); xVPMOVSX.BD(xmm1, ptr32[srcIndirect + step]); }
+			xVINSERTI128(ymm0, ymm0, xmm1, 1);
+			break;
+
+		// V4: one 256-bit load or extension.
+		case 12:
+			xVMOVUPS(ymm0, ptr[srcIndirect]);
+			break;
+		case 13:
+			if (usn) xVPMOVZX.WD(ymm0, ptr128[srcIndirect]);
+			else     xVPMOVSX.WD(ymm0, ptr128[srcIndirect]);
+			break;
+		case 14:
+			if (usn) xVPMOVZX.BD(ymm0, ptr64[srcIndirect]);
+			else     xVPMOVSX.BD(ymm0, ptr64[srcIndirect]);
+			break;
+
+		default:
+			pxFailRel(fmt::format("Vpu/Vif - Invalid AVX2 Unpack! [{}]", upknum).c_str());
+			break;
+	}
+
+	if (zeroLow || zeroHigh)
+		xVPAND(ymm0, ymm0, ptr[s_zero_w_pair[(zeroHigh << 1) | zeroLow]]);
+}
+
+// Two quadword version of doMaskWrite() for doMode 0/1. The row is added to every lane
+// first, the lanes which shouldn't have it are then replaced by the row/col/old data blends.
+void VifUnpackSSE_Dynarec::doMaskWritePairAVX2() const
+{
+	const int cc = std::min(vCL, 3);
+	const u32 mLow = (vB.mask >> (cc * 8)) & 0xff;
+	const u32 mHigh = (vB.mask >> (std::min(vCL + 1, 3) * 8)) & 0xff;
+
+	if (doMode)
+		xVPADDD(ymm0, ymm0, xRegisterSSE::GetYMMInstance(xmmRow.Id));
+
+	if (doMask)
+	{
+		const u32 row = maskLanes(mLow, 1) | (maskLanes(mHigh, 1) << 4);
+		const u32 col = maskLanes(mLow, 2) | (maskLanes(mHigh, 2) << 4);
+		const u32 prot = maskLanes(mLow, 3) | (maskLanes(mHigh, 3) << 4);
+
+		if (row)
+			xVPBLENDD(ymm0, ymm0, xRegisterSSE::GetYMMInstance(xmmRow.Id), row);
+		if (col)
+			xVPBLENDD(ymm0, ymm0, xRegisterSSE::GetYMMInstance(xmmCol0.Id + cc), col);
+		if (prot)
+			xVPBLENDD(ymm0, ymm0, ptr[dstIndirect], prot);
+	}
+
+	xVMOVUPS(ptr[dstIndirect], ymm0);
+}
+
 void VifUnpackSSE_Dynarec::writeBackRow() const
 {
 	const int idx = v.idx;
@@ -273,6 +595,8 @@ void VifUnpackSSE_Dynarec::CompileRoutine()
 
 	pxAssume(vCL == 0);
 
+	useAVX2 = CanUseAVX2(upkNum, cycleSize);
+
 	// Value passed determines # of col regs we need to load
 	SetMasks(isFill ? blockSize : cycleSize);
 
@@ -286,8 +610,26 @@ void VifUnpackSSE_Dynarec::CompileRoutine()
 			ShiftDisplacementWindow(srcIndirect, arg2reg); //Don't need to do this otherwise as we arent reading the source.
 
 
-		if (vCL < cycleSize)
+		if (useAVX2 && vCL < cycleSize && vNum >= 2)
 		{
+			xUnpackPairAVX2(upkNum);
+			if (IsUnmaskedOp()) xVMOVUPS(ptr[dstIndirect], ymm0);
+			else                doMaskWritePairAVX2();
+
+			dstIndirect += 32;
+			srcIndirect += vift * 2;
+
+			vNum -= 2;
+			vCL += 2;
+			if (vCL == blockSize)
+				vCL = 0;
+		}
+		else if (vCL < cycleSize)
+		{
+			// The odd quadword at the end of an AVX2 block goes through the SSE path.
+			if (useAVX2)
+				xVZEROUPPER();
+
 			ModUnpack(upkNum, false);
 			xUnpack(upkNum);
 			xMovDest();
@@ -323,6 +665,8 @@ void VifUnpackSSE_Dynarec::CompileRoutine()
 
 	if (doMode >= 2)
 		writeBackRow();
+	if (useAVX2)
+		xVZEROUPPER();
 	xRET();
 }
 
@@ -367,6 +711,28 @@ _vifT __fi nVifBlock* dVifCompile(nVifBlock& block, bool isFill)
 	return &block;
 }
 
+_vifT static void dVifPrecompile()
+{
+	s_block_cache_pending[idx] = false;
+
+	u32 compiled = 0;
+	for (const BlockCacheKey& key : s_block_cache[idx])
+	{
+		nVifBlock block = {};
+		block.hash_key = key.hash_key;
+		block.key0 = key.key0;
+		block.key1 = key.key1;
+		if (nVif[idx].vifBlocks.contains(block))
+			continue;
+
+		const uint wl = block.wl ? block.wl : 256;
+		dVifCompile<idx>(block, block.cl < wl);
+		compiled++;
+	}
+
+	DevCon.WriteLn("nVif%d: Precompiled %u unpack blocks", idx, compiled);
+}
+
 _vifT __fi void dVifUnpack(const u8* data, bool isFill)
 {
 
@@ -409,7 +775,14 @@ _vifT __fi void dVifUnpack(const u8* data, bool isFill)
 	nVifBlock* b = v.vifBlocks.find(block);
 	if (unlikely(b == nullptr))
 	{
-		b = dVifCompile<idx>(block, isFill);
+		if (s_block_cache_pending[idx])
+		{
+			dVifPrecompile<idx>();
+			b = v.vifBlocks.find(block);
+		}
+
+		if (!b)
+			b = dVifCompile<idx>(block, isFill);
 	}
 
 	{ // Execute the block
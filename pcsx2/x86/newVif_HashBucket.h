@@ -15,12 +15,13 @@
 
 #pragma once
 
-#include <array>
+#include <algorithm>
+#include <cstring>
 #include "fmt/core.h"
 #include "common/AlignedMalloc.h"
 
-// nVifBlock - Ordered for Hashing; the 'num' and 'upkType' fields are
-//             used as the hash bucket selector.
+// nVifBlock - Ordered for Hashing; the 'num' and 'upkType' fields form
+//             hash_key, and together with key0/key1 identify the block.
 union nVifBlock
 {
 	// Warning: order depends on the newVifDynaRec code
@@ -48,101 +49,166 @@ union nVifBlock
 
 }; // 16 bytes
 
-// 0x4000 is enough but 0x10000 allow
-// * to skip the compare value of the first double world in lookup
-// * to use a 16 bits move instead of an 'and' mask to compute the hashed key
-#define hSize 0x10000 // [usn*1:mask*1:upk*4:num*8] hash...
-
-// HashBucket is a container which uses a built-in hash function
-// to perform quick searches. It is designed around the nVifBlock structure
+// HashBucket is an open-addressed table of nVifBlocks, probed linearly from a hash of the
+// whole key (hash_key, key0 and key1). It keeps at most half of its cells used, so a lookup
+// usually touches one or two cells however many blocks share a num and unpack type.
 //
-// The hash function is determined by taking the first bytes of data and
-// performing a modulus the size of hSize. So the most diverse-data should
-// be in the first bytes of the struct. (hence why nVifBlock is specifically sorted)
+// A cell with startPtr == 0 is empty; blocks are never removed, only cleared all at once.
 class HashBucket
 {
+public:
+	struct Stats
+	{
+		u64 hits;
+		u64 misses;
+		u64 probes; // Extra cells visited by all lookups, beyond the first.
+		u32 max_probe; // Longest probe sequence seen.
+		u32 blocks;
+		u32 capacity;
+	};
+
 protected:
-	std::array<nVifBlock*, hSize> m_bucket;
+	static constexpr u32 INITIAL_CAPACITY = 1024;
 
-public:
-	HashBucket()
+	nVifBlock* m_table = nullptr;
+	u32 m_mask = 0;
+	u32 m_count = 0;
+	Stats m_stats = {};
+
+	static __fi u32 hash(const nVifBlock& dataPtr)
 	{
-		m_bucket.fill(nullptr);
+		u32 h = dataPtr.hash_key * 0x9E3779B1u;
+		h ^= dataPtr.key0 + 0x9E3779B9u + (h << 6) + (h >> 2);
+		h ^= dataPtr.key1 + 0x9E3779B9u + (h << 6) + (h >> 2);
+		return h ^ (h >> 15);
 	}
 
-	~HashBucket() { clear(); }
+	static __fi bool matches(const nVifBlock& a, const nVifBlock& b)
+	{
+		return a.key0 == b.key0 && a.key1 == b.key1 && a.hash_key == b.hash_key;
+	}
 
-	__fi nVifBlock* find(const nVifBlock& dataPtr)
+	void allocate(u32 capacity)
 	{
-		nVifBlock* chainpos = m_bucket[dataPtr.hash_key];
+		// Performance note: 64B align to reduce cache miss penalty in `find`
+		m_table = static_cast<nVifBlock*>(_aligned_malloc(sizeof(nVifBlock) * capacity, 64));
+		if (!m_table)
+			pxFailRel("Failed to allocate HashBucket table");
 
-		while (true)
-		{
-			if (chainpos->key0 == dataPtr.key0 && chainpos->key1 == dataPtr.key1)
-				return chainpos;
+		std::memset(m_table, 0, sizeof(nVifBlock) * capacity);
+		m_mask = capacity - 1;
+		m_count = 0;
+	}
 
-			if (chainpos->startPtr == 0)
-				return nullptr;
+	void insert(const nVifBlock& dataPtr)
+	{
+		u32 pos = hash(dataPtr) & m_mask;
+		while (m_table[pos].startPtr != 0)
+			pos = (pos + 1) & m_mask;
 
-			chainpos++;
-		}
+		std::memcpy(&m_table[pos], &dataPtr, sizeof(nVifBlock));
+		m_count++;
 	}
 
-	void add(const nVifBlock& dataPtr)
+	void grow()
 	{
-		u32 b = dataPtr.hash_key;
+		nVifBlock* old_table = m_table;
+		const u32 old_capacity = m_mask + 1;
+
+		allocate(old_capacity * 2);
+		for (u32 i = 0; i < old_capacity; i++)
+		{
+			if (old_table[i].startPtr != 0)
+				insert(old_table[i]);
+		}
 
-		u32 size = bucket_size(dataPtr);
+		_aligned_free(old_table);
+	}
 
-		// Warning there is an extra +1 due to the empty cell
-		// Performance note: 64B align to reduce cache miss penalty in `find`
-		if ((m_bucket[b] = (nVifBlock*)pcsx2_aligned_realloc(m_bucket[b], sizeof(nVifBlock) * (size + 2), 64, sizeof(nVifBlock) * (size + 1))) == NULL)
+public:
+	HashBucket() = default;
+	~HashBucket() { clear(); }
+
+	__fi nVifBlock* find(const nVifBlock& dataPtr)
+	{
+		u32 pos = hash(dataPtr) & m_mask;
+		for (u32 probe = 0;; probe++)
 		{
-			pxFailRel("Failed to allocate HashBucket Chain");
+			nVifBlock* cell = &m_table[pos];
+			if (cell->startPtr == 0 || matches(*cell, dataPtr))
+			{
+				m_stats.probes += probe;
+				m_stats.max_probe = std::max(m_stats.max_probe, probe);
+				if (cell->startPtr == 0)
+				{
+					m_stats.misses++;
+					return nullptr;
+				}
+
+				m_stats.hits++;
+				return cell;
+			}
+
+			pos = (pos + 1) & m_mask;
 		}
+	}
+
+	/// Same as find(), without counting towards the statistics.
+	bool contains(const nVifBlock& dataPtr) const
+	{
+		if (!m_table)
+			return false;
 
-		// Replace the empty cell by the new block and create a new empty cell
-		memcpy(&m_bucket[b][size++], &dataPtr, sizeof(nVifBlock));
-		memset(&m_bucket[b][size], 0, sizeof(nVifBlock));
+		for (u32 pos = hash(dataPtr) & m_mask; m_table[pos].startPtr != 0; pos = (pos + 1) & m_mask)
+		{
+			if (matches(m_table[pos], dataPtr))
+				return true;
+		}
 
-		if (size > 3)
-			DevCon.Warning("recVifUnpk: Bucket 0x%04x has %d micro-programs", b, size);
+		return false;
 	}
 
-	u32 bucket_size(const nVifBlock& dataPtr)
+	void add(const nVifBlock& dataPtr)
 	{
-		nVifBlock* chainpos = m_bucket[dataPtr.hash_key];
+		if ((m_count + 1) * 2 > (m_mask + 1))
+			grow();
 
-		u32 size = 0;
+		insert(dataPtr);
+	}
+
+	/// Calls func for every block in the table, in no particular order.
+	template <typename F>
+	void for_each(const F& func) const
+	{
+		if (!m_table)
+			return;
 
-		while (chainpos->startPtr != 0)
+		for (u32 i = 0; i <= m_mask; i++)
 		{
-			size++;
-			chainpos++;
+			if (m_table[i].startPtr != 0)
+				func(m_table[i]);
 		}
+	}
 
-		return size;
+	Stats stats() const
+	{
+		Stats ret = m_stats;
+		ret.blocks = m_count;
+		ret.capacity = m_table ? (m_mask + 1) : 0;
+		return ret;
 	}
 
 	void clear()
 	{
-		for (auto& bucket : m_bucket)
-			safe_aligned_free(bucket);
+		safe_aligned_free(m_table);
+		m_mask = 0;
+		m_count = 0;
 	}
 
 	void reset()
 	{
 		clear();
-
-		// Allocate an empty cell for all buckets
-		for (auto& bucket : m_bucket)
-		{
-			if ((bucket = (nVifBlock*)_aligned_malloc(sizeof(nVifBlock), 16)) == nullptr)
-			{
-				pxFailRel("Failed to allocate HashBucket Chain on reset");
-			}
-
-			memset(bucket, 0, sizeof(nVifBlock));
-		}
+		allocate(INITIAL_CAPACITY);
+		m_stats = {};
 	}
 };
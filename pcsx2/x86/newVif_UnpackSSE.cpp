@@ -62,6 +62,32 @@ void VifUnpackSSE_Base::xMovDest() const
 	else                { doMaskWrite(destReg); }
 }
 
+bool VifUnpackSSE_Base::IsLastWordZeroed(int upknum) const
+{
+	switch (upknum)
+	{
+		case 4: // V2_32
+			return IsAligned;
+
+		case 8: // V3_32
+		case 10: // V3_8
+			return UnpkLoopIteration != IsAligned;
+
+		case 9: // V3_16
+		{
+			//With V3-16, it takes the first vector from the next position as the W vector
+			//However - IF the end of this iteration of the unpack falls on a quadword boundary, W becomes 0
+			//IsAligned is the position through the current QW in the vif packet
+			//Iteration counts where we are in the packet.
+			const int result = (((UnpkLoopIteration / 4) + 1 + (4 - IsAligned)) & 0x3);
+			return (UnpkLoopIteration & 0x1) == 0 && result == 0;
+		}
+
+		default:
+			return false;
+	}
+}
+
 void VifUnpackSSE_Base::xShiftR(const xRegisterSSE& regX, int n) const
 {
 	if (usn) { xPSRL.D(regX, n); }
@@ -155,13 +181,13 @@ void VifUnpackSSE_Base::xUPK_V2_32() const
 	{
 		xMOV128(workReg, ptr32[srcIndirect]);
 		xPSHUF.D(destReg, workReg, 0x44); //v1v0v1v0
-		if (IsAligned)
+		if (IsLastWordZeroed(4))
 			xAND.PS(destReg, ptr128[SSEXYZWMask[0]]); //zero last word - tested on ps2
 	}
 	else
 	{
 		xPSHUF.D(destReg, workReg, 0xEE); //v3v2v3v2
-		if (IsAligned)
+		if (IsLastWordZeroed(4))
 			xAND.PS(destReg, ptr128[SSEXYZWMask[0]]); //zero last word - tested on ps2
 	}
 }
@@ -198,7 +224,7 @@ void VifUnpackSSE_Base::xUPK_V3_32() const
 {
 
 	xMOV128(destReg, ptr128[srcIndirect]);
-	if (UnpkLoopIteration != IsAligned)
+	if (IsLastWordZeroed(8))
 		xAND.PS(destReg, ptr128[SSEXYZWMask[0]]);
 }
 
@@ -207,13 +233,7 @@ void VifUnpackSSE_Base::xUPK_V3_16() const
 
 	xPMOVXX16(destReg);
 
-	//With V3-16, it takes the first vector from the next position as the W vector
-	//However - IF the end of this iteration of the unpack falls on a quadword boundary, W becomes 0
-	//IsAligned is the position through the current QW in the vif packet
-	//Iteration counts where we are in the packet.
-	int result = (((UnpkLoopIteration / 4) + 1 + (4 - IsAligned)) & 0x3);
-
-	if ((UnpkLoopIteration & 0x1) == 0 && result == 0)
+	if (IsLastWordZeroed(9))
 	{
 		xAND.PS(destReg, ptr128[SSEXYZWMask[0]]); //zero last word on QW boundary if whole 32bit word is used - tested on ps2
 	}
@@ -223,7 +243,7 @@ void VifUnpackSSE_Base::xUPK_V3_8() const
 {
 
 	xPMOVXX8(destReg);
-	if (UnpkLoopIteration != IsAligned)
+	if (IsLastWordZeroed(10))
 		xAND.PS(destReg, ptr128[SSEXYZWMask[0]]);
 }
 
@@ -55,6 +55,9 @@ public:
 protected:
 	virtual void doMaskWrite(const xRegisterSSE& regX) const = 0;
 
+	// V2/V3 unpacks which clear W for the current UnpkLoopIteration.
+	bool IsLastWordZeroed(int upknum) const;
+
 	virtual void xShiftR(const xRegisterSSE& regX, int n) const;
 	virtual void xPMOVXX8(const xRegisterSSE& regX) const;
 	virtual void xPMOVXX16(const xRegisterSSE& regX) const;
@@ -106,6 +109,7 @@ class VifUnpackSSE_Dynarec : public VifUnpackSSE_Base
 
 public:
 	bool isFill;
+	bool useAVX2; // V2/V3/V4 written two quadwords at a time with 256-bit ops
 	int  doMode; // two bit value representing... something!
 
 protected:
@@ -120,8 +124,9 @@ public:
 		, v(src.v)
 		, vB(src.vB)
 	{
-		isFill = src.isFill;
-		vCL    = src.vCL;
+		isFill  = src.isFill;
+		useAVX2 = src.useAVX2;
+		vCL     = src.vCL;
 	}
 
 	virtual ~VifUnpackSSE_Dynarec() = default;
@@ -137,6 +142,10 @@ protected:
 	void SetMasks(int cS) const;
 	void writeBackRow() const;
 
+	bool CanUseAVX2(int upknum, int cycleSize) const;
+	void xUnpackPairAVX2(int upknum);
+	void doMaskWritePairAVX2() const;
+
 	static VifUnpackSSE_Dynarec FillingWrite(const VifUnpackSSE_Dynarec& src)
 	{
 		VifUnpackSSE_Dynarec fillingWrite(src);
@@ -274,6 +274,37 @@ TEST(CodegenTests, AVX256Test)
 	CODEGEN_TEST(xVMOVMSKPD(eax, ymm1), "c5 fd 50 c1");
 }
 
+TEST(CodegenTests, AVX2Test)
+{
+	CODEGEN_TEST(xVPMOVSX.BD(ymm0, xmm1), "c4 e2 7d 21 c1");
+	CODEGEN_TEST(xVPMOVSX.BD(ymm0, ptr64[rsi]), "c4 e2 7d 21 06");
+	CODEGEN_TEST(xVPMOVSX.WD(ymm0, ptr128[rdi+0x10]), "c4 e2 7d 23 47 10");
+	CODEGEN_TEST(xVPMOVZX.BD(ymm1, ptr64[rax]), "c4 e2 7d 31 08");
+	CODEGEN_TEST(xVPMOVZX.WD(xmm1, ptr64[rsi+6]), "c4 e2 79 33 4e 06");
+	CODEGEN_TEST(xVPMOVZX.WD(ymm2, xmm3), "c4 e2 7d 33 d3");
+	CODEGEN_TEST(xVPMOVSX.BD(ymm9, ptr64[r8+4]), "c4 42 7d 21 48 04");
+	CODEGEN_TEST(xVPMOVSX.BD(ymm1, ptr64[r9*4+rsi+8]), "c4 a2 7d 21 4c 8e 08");
+
+	CODEGEN_TEST(xVPBLENDD(ymm0, ymm1, ymm2, 0x11), "c4 e3 75 02 c2 11");
+	CODEGEN_TEST(xVPBLENDD(ymm0, ymm0, ptr[rdi+0x20], 0x88), "c4 e3 7d 02 47 20 88");
+	CODEGEN_TEST(xVPBLENDD(ymm8, ymm9, ymm10, 0xf0), "c4 43 35 02 c2 f0");
+	CODEGEN_TEST(xVPBLENDD(ymm0, ymm0, ptr[base], 0x11), "c4 e3 7d 02 05 f6 ff ff ff 11");
+
+	CODEGEN_TEST(xVPERMD(ymm3, ymm0, ymm1), "c4 e2 7d 36 d9");
+	CODEGEN_TEST(xVPERMD(ymm12, ymm8, ymm9), "c4 42 3d 36 e1");
+	CODEGEN_TEST(xVPERMQ(ymm0, ymm1, 0x50), "c4 e3 fd 00 c1 50");
+	CODEGEN_TEST(xVPERMQ(ymm10, ymm11, 0xd8), "c4 43 fd 00 d3 d8");
+
+	CODEGEN_TEST(xVINSERTI128(ymm0, ymm0, xmm1, 1), "c4 e3 7d 38 c1 01");
+	CODEGEN_TEST(xVINSERTI128(ymm0, ymm0, ptr128[rsi+12], 1), "c4 e3 7d 38 46 0c 01");
+	CODEGEN_TEST(xVINSERTI128(ymm9, ymm10, xmm11, 0), "c4 43 2d 38 cb 00");
+	CODEGEN_TEST(xVBROADCASTI128(ymm6, ptr128[rdi]), "c4 e2 7d 5a 37");
+	CODEGEN_TEST(xVBROADCASTI128(ymm6, ptr128[r8+0x10]), "c4 c2 7d 5a 70 10");
+
+	CODEGEN_TEST(xVPADDD(ymm0, ymm0, ymm6), "c5 fd fe c6");
+	CODEGEN_TEST(xVPADDD(xmm0, xmm1, xmm2), "c5 f1 fe c2");
+}
+
 TEST(CodegenTests, Extended8BitTest)
 {
 	CODEGEN_TEST(xSETL(al), "0f 9c c0");
@@ -0,0 +1,91 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/DebugTools/Breakpoints.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+static MemCheck MakeCheck(BreakPointCpu cpu, u32 start, u32 end, MemCheckCondition cond, MemCheckResult result)
+{
+	MemCheck check;
+	check.cpu = cpu;
+	check.start = start;
+	check.end = end;
+	check.cond = cond;
+	check.result = result;
+	return check;
+}
+
+TEST(MemCheckIndex, MatchesAccessType)
+{
+	MemCheckIndex index;
+	index.Build({
+		MakeCheck(BREAKPOINT_EE, 0x1000, 0x1010, MEMCHECK_READ, MEMCHECK_LOG),
+		MakeCheck(BREAKPOINT_EE, 0x1008, 0x1100, MEMCHECK_WRITE, MEMCHECK_BREAK),
+		MakeCheck(BREAKPOINT_EE, 0x2000, 0x2004, MEMCHECK_READWRITE, MEMCHECK_IGNORE),
+		MakeCheck(BREAKPOINT_IOP, 0x1000, 0x2000, MEMCHECK_READWRITE, MEMCHECK_BOTH),
+	}, BREAKPOINT_EE);
+
+	EXPECT_EQ(index.Find(0x1000, 0x1004, false), MEMCHECK_LOG);
+	EXPECT_EQ(index.Find(0x1000, 0x1004, true), MEMCHECK_IGNORE);
+	EXPECT_EQ(index.Find(0x100C, 0x1010, true), MEMCHECK_BREAK);
+	EXPECT_EQ(index.Find(0x1000, 0x1010, true), MEMCHECK_BREAK);
+	EXPECT_EQ(index.Find(0x0FFC, 0x1000, false), MEMCHECK_IGNORE);
+	EXPECT_EQ(index.Find(0x1100, 0x1104, true), MEMCHECK_IGNORE);
+	EXPECT_EQ(index.Find(0x2000, 0x2004, false), MEMCHECK_IGNORE);
+}
+
+TEST(MemCheckIndex, StandardizesEEAddresses)
+{
+	MemCheckIndex index;
+	index.Build({MakeCheck(BREAKPOINT_EE, 0x80100000, 0x80100010, MEMCHECK_READWRITE, MEMCHECK_BREAK)}, BREAKPOINT_EE);
+
+	EXPECT_EQ(index.Find(0x00100000, 0x00100004, false), MEMCHECK_BREAK);
+	EXPECT_EQ(index.Find(0x00100010, 0x00100014, false), MEMCHECK_IGNORE);
+}
+
+TEST(MemCheckIndex, AgreesWithLinearScan)
+{
+	std::mt19937 rng(1234);
+	std::vector<MemCheck> checks;
+	for (int i = 0; i < 200; i++)
+	{
+		const u32 start = rng() % 0x10000;
+		const u32 end = start + 1 + (rng() % ((i % 10 == 0) ? 0x4000 : 0x40));
+		checks.push_back(MakeCheck(BREAKPOINT_IOP, start, end, static_cast<MemCheckCondition>(1 + rng() % 3),
+			static_cast<MemCheckResult>(1 + rng() % 3)));
+	}
+
+	MemCheckIndex index;
+	index.Build(checks, BREAKPOINT_IOP);
+
+	for (int i = 0; i < 10000; i++)
+	{
+		const u32 start = rng() % 0x14000;
+		const u32 end = start + (1u << (rng() % 5));
+		const bool write = (rng() & 1) != 0;
+
+		u32 expected = MEMCHECK_IGNORE;
+		for (const MemCheck& check : checks)
+		{
+			if (start < check.end && check.start < end && (check.cond & (write ? MEMCHECK_WRITE : MEMCHECK_READ)))
+				expected |= check.result;
+		}
+
+		ASSERT_EQ(index.Find(start, end, write), expected) << "access " << start << "-" << end;
+	}
+}
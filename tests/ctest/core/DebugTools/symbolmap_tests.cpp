@@ -0,0 +1,104 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/DebugTools/SymbolMap.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+static constexpr u32 INVALID_ADDRESS = SymbolMap::INVALID_ADDRESS;
+
+static void ExpectSameSymbols(SymbolMap& lhs, SymbolMap& rhs, u32 end)
+{
+	for (u32 address = 0; address < end; address += 2)
+	{
+		EXPECT_EQ(lhs.GetSymbolType(address), rhs.GetSymbolType(address)) << address;
+		EXPECT_EQ(lhs.GetFunctionStart(address), rhs.GetFunctionStart(address)) << address;
+		EXPECT_EQ(lhs.GetDataStart(address), rhs.GetDataStart(address)) << address;
+		EXPECT_EQ(lhs.GetLabelString(address), rhs.GetLabelString(address)) << address;
+		EXPECT_EQ(lhs.GetDescription(address), rhs.GetDescription(address)) << address;
+		EXPECT_EQ(lhs.GetNextSymbolAddress(address, (SymbolType)(ST_FUNCTION | ST_DATA)),
+			rhs.GetNextSymbolAddress(address, (SymbolType)(ST_FUNCTION | ST_DATA))) << address;
+	}
+}
+
+TEST(SymbolMap, LookupsFollowChanges)
+{
+	SymbolMap map;
+	EXPECT_TRUE(map.IsEmpty());
+
+	map.AddFunction("func", 0x1000, 0x100);
+	map.AddData(0x2000, 0x10, DATATYPE_WORD);
+	map.UpdateActiveSymbols();
+
+	EXPECT_FALSE(map.IsEmpty());
+	EXPECT_EQ(map.GetFunctionStart(0x10FF), 0x1000u);
+	EXPECT_EQ(map.GetFunctionStart(0x1100), INVALID_ADDRESS);
+	EXPECT_EQ(map.GetDataType(0x2000), DATATYPE_WORD);
+	EXPECT_EQ(map.GetDescription(0x1080), "func");
+
+	map.SetLabelName("renamed", 0x1000);
+	EXPECT_EQ(map.GetLabelString(0x1000), "renamed");
+
+	map.RemoveFunction(0x1000, true);
+	EXPECT_EQ(map.GetFunctionStart(0x1080), INVALID_ADDRESS);
+	EXPECT_EQ(map.GetLabelString(0x1000), "");
+
+	map.Clear();
+	EXPECT_TRUE(map.IsEmpty());
+}
+
+TEST(SymbolMap, ImportMatchesIndividualAdds)
+{
+	// Enough symbols to take the parallel path, with duplicate addresses to check which entry wins.
+	std::mt19937 rng(1234);
+	std::vector<SymbolImportEntry> symbols;
+	for (u32 i = 0; i < 40000; i++)
+	{
+		const u32 address = (rng() % 0x20000) * 4;
+		const u32 size = 4 + (rng() % 16) * 4;
+		switch (rng() % 3)
+		{
+			case 0:
+				symbols.push_back({"func_" + std::to_string(i), address, size, ST_FUNCTION, DATATYPE_NONE});
+				break;
+			case 1:
+				symbols.push_back({"label_" + std::to_string(i), address, 1, ST_NONE, DATATYPE_NONE});
+				break;
+			default:
+				symbols.push_back({std::string(), address, size, ST_DATA, DATATYPE_WORD});
+				break;
+		}
+	}
+
+	SymbolMap expected;
+	for (const SymbolImportEntry& entry : symbols)
+	{
+		if (entry.type == ST_FUNCTION)
+			expected.AddFunction(entry.name.c_str(), entry.address, entry.size, 0);
+		else if (entry.type == ST_DATA)
+			expected.AddData(entry.address, entry.size, entry.dataType, 0);
+		else
+			expected.AddLabel(entry.name.c_str(), entry.address, 0);
+	}
+	expected.UpdateActiveSymbols();
+
+	SymbolMap imported;
+	imported.ImportSymbols(symbols, 0);
+
+	ExpectSameSymbols(expected, imported, 0x80000);
+}
@@ -0,0 +1,252 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/IPU/IPU_MultiISA.h"
+#include "pcsx2/IPU/yuv2rgb.h"
+#include "pcsx2/GS/MultiISA.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <random>
+
+#ifdef MULTI_ISA_UNSHARED_COMPILATION
+
+enum class TestISA
+{
+	isa_sse4,
+	isa_avx,
+	isa_avx2,
+	isa_native,
+};
+
+static bool CheckCapabilities(TestISA required_caps)
+{
+	x86caps.Identify();
+	if (required_caps == TestISA::isa_avx && !x86caps.hasAVX)
+		return false;
+	if (required_caps == TestISA::isa_avx2 && !x86caps.hasAVX2)
+		return false;
+
+	return true;
+}
+
+#define MULTI_ISA_STRINGIZE_(x) #x
+#define MULTI_ISA_STRINGIZE(x) MULTI_ISA_STRINGIZE_(x)
+
+#define MULTI_ISA_CONCAT_(a, b) a##b
+#define MULTI_ISA_CONCAT(a, b) MULTI_ISA_CONCAT_(a, b)
+
+#define MULTI_ISA_TEST(group, name) TEST(MULTI_ISA_CONCAT(MULTI_ISA_CONCAT(MULTI_ISA_UNSHARED_COMPILATION, _), group), name)
+#define SKIP_IF_UNSUPPORTED() \
+	if (!CheckCapabilities(TestISA::MULTI_ISA_UNSHARED_COMPILATION)) { \
+		GTEST_SKIP() << "Host CPU does not support " MULTI_ISA_STRINGIZE(MULTI_ISA_UNSHARED_COMPILATION); \
+	}
+
+#else
+
+#define MULTI_ISA_TEST(group, name) TEST(group, name)
+#define SKIP_IF_UNSUPPORTED()
+
+#endif
+
+MULTI_ISA_UNSHARED_START
+
+static constexpr int NUM_ITERATIONS = 20000;
+
+static void FillRandom(std::mt19937& rng, void* data, size_t size)
+{
+	u8* bytes = static_cast<u8*>(data);
+	for (size_t i = 0; i < size; i++)
+		bytes[i] = static_cast<u8>(rng());
+}
+
+/// Converts chroma rows [first, last) with the reference, then thresholds and signs them like the scalar code did.
+static void CSCReference(int sgn, int first, int last)
+{
+	yuv2rgb_reference(first, last);
+
+	for (int y = first * 2; y < last * 2; y++)
+	{
+		for (int x = 0; x < 16; x++)
+		{
+			u8* p = &decoder.rgb32.c[y][x].r;
+			if (g_ipu_thresh[0] > 0 && p[0] < g_ipu_thresh[0] && p[1] < g_ipu_thresh[0] && p[2] < g_ipu_thresh[0])
+				*reinterpret_cast<u32*>(p) = 0;
+			else if (g_ipu_thresh[1] > 0 && p[0] < g_ipu_thresh[1] && p[1] < g_ipu_thresh[1] && p[2] < g_ipu_thresh[1])
+				p[3] = 0x40;
+
+			if (sgn)
+				*reinterpret_cast<u32*>(p) ^= 0x808080;
+		}
+	}
+}
+
+/// Picks a chroma row range, mostly the whole macroblock like a plain CSC.
+static void RandomRows(std::mt19937& rng, int max, int* first, int* last)
+{
+	if (rng() % 2)
+	{
+		*first = 0;
+		*last = max;
+		return;
+	}
+
+	*first = rng() % max;
+	*last = *first + 1 + rng() % (max - *first);
+}
+
+MULTI_ISA_TEST(IPUKernelTest, IDCTMatchesReference)
+{
+	SKIP_IF_UNSUPPORTED();
+
+	std::mt19937 rng(1);
+	for (int iter = 0; iter < NUM_ITERATIONS; iter++)
+	{
+		alignas(16) s16 block[64];
+		alignas(16) s16 expected[64];
+
+		// Legal dequantised coefficients, the full 16-bit range, and sparse blocks whose rows hit the DC only path.
+		for (int i = 0; i < 64; i++)
+		{
+			switch (iter % 3)
+			{
+				case 0:
+					block[i] = static_cast<s16>(static_cast<int>(rng() % 4096) - 2048);
+					break;
+				case 1:
+					block[i] = static_cast<s16>(rng());
+					break;
+				default:
+					block[i] = (rng() % 8 == 0) ? static_cast<s16>(static_cast<int>(rng() % 4096) - 2048) : 0;
+					break;
+			}
+		}
+
+		std::memcpy(expected, block, sizeof(block));
+		IDCT_Block_reference(expected);
+		IDCT_Block(block);
+
+		ASSERT_EQ(std::memcmp(block, expected, sizeof(block)), 0) << "iteration " << iter;
+	}
+}
+
+MULTI_ISA_TEST(IPUKernelTest, YUV2RGBMatchesReference)
+{
+	SKIP_IF_UNSUPPORTED();
+
+	std::mt19937 rng(2);
+	for (int iter = 0; iter < NUM_ITERATIONS; iter++)
+	{
+		int first, last;
+		RandomRows(rng, 8, &first, &last);
+		FillRandom(rng, &decoder.mb8, sizeof(decoder.mb8));
+
+		// Rows outside the range have to be left alone, so start from the same garbage each time.
+		alignas(32) macroblock_rgb32 initial, expected;
+		FillRandom(rng, &initial, sizeof(initial));
+
+		decoder.rgb32 = initial;
+		yuv2rgb_reference(first, last);
+		expected = decoder.rgb32;
+
+		decoder.rgb32 = initial;
+		yuv2rgb_sse2(first, last);
+		ASSERT_EQ(std::memcmp(&decoder.rgb32, &expected, sizeof(expected)), 0) << "SSE2, rows " << first << "-" << last;
+
+#if _M_SSE >= 0x501
+		decoder.rgb32 = initial;
+		yuv2rgb_avx2(first, last);
+		ASSERT_EQ(std::memcmp(&decoder.rgb32, &expected, sizeof(expected)), 0) << "AVX2, rows " << first << "-" << last;
+#endif
+	}
+}
+
+MULTI_ISA_TEST(IPUKernelTest, CSCMatchesReference)
+{
+	SKIP_IF_UNSUPPORTED();
+
+	const u16 old_thresh[2] = {g_ipu_thresh[0], g_ipu_thresh[1]};
+
+	std::mt19937 rng(3);
+	for (int iter = 0; iter < NUM_ITERATIONS; iter++)
+	{
+		int first, last;
+		RandomRows(rng, 8, &first, &last);
+		FillRandom(rng, &decoder.mb8, sizeof(decoder.mb8));
+
+		// Thresholds are 9 bits, so they can be above every channel value.
+		const int sgn = rng() % 2;
+		g_ipu_thresh[0] = (rng() % 3 == 0) ? 0 : (rng() % 0x200);
+		g_ipu_thresh[1] = (rng() % 3 == 0) ? 0 : (rng() % 0x200);
+
+		alignas(32) macroblock_rgb32 initial, expected;
+		FillRandom(rng, &initial, sizeof(initial));
+
+		decoder.rgb32 = initial;
+		CSCReference(sgn, first, last);
+		expected = decoder.rgb32;
+
+		decoder.rgb32 = initial;
+		ipu_csc(decoder.mb8, decoder.rgb32, sgn, first, last);
+		ASSERT_EQ(std::memcmp(&decoder.rgb32, &expected, sizeof(expected)), 0)
+			<< "rows " << first << "-" << last << " sgn " << sgn << " thresh " << g_ipu_thresh[0] << "/" << g_ipu_thresh[1];
+	}
+
+	g_ipu_thresh[0] = old_thresh[0];
+	g_ipu_thresh[1] = old_thresh[1];
+}
+
+MULTI_ISA_TEST(IPUKernelTest, DitherMatchesReference)
+{
+	SKIP_IF_UNSUPPORTED();
+
+	std::mt19937 rng(4);
+	for (int iter = 0; iter < NUM_ITERATIONS; iter++)
+	{
+		int first_row, last_row;
+		RandomRows(rng, 16, &first_row, &last_row);
+		const int dte = rng() % 2;
+
+		// Alpha is only ever 0x40 or 0x80 coming out of the CSC, but anything else has to convert too.
+		alignas(32) macroblock_rgb32 rgb32;
+		FillRandom(rng, &rgb32, sizeof(rgb32));
+		for (int i = 0; i < 16; i++)
+		{
+			for (int j = 0; j < 16; j++)
+			{
+				if (rng() % 4 != 0)
+					rgb32.c[i][j].a = (rng() % 2) ? 0x40 : 0x80;
+			}
+		}
+
+		alignas(32) macroblock_rgb16 initial, expected, actual;
+		FillRandom(rng, &initial, sizeof(initial));
+
+		expected = initial;
+		ipu_dither_reference(rgb32, expected, dte, first_row, last_row);
+
+		actual = initial;
+		ipu_dither_sse2(rgb32, actual, dte, first_row, last_row);
+		ASSERT_EQ(std::memcmp(&actual, &expected, sizeof(expected)), 0) << "SSE2, rows " << first_row << "-" << last_row << " dte " << dte;
+
+#if _M_SSE >= 0x501
+		actual = initial;
+		ipu_dither_avx2(rgb32, actual, dte, first_row, last_row);
+		ASSERT_EQ(std::memcmp(&actual, &expected, sizeof(expected)), 0) << "AVX2, rows " << first_row << "-" << last_row << " dte " << dte;
+#endif
+	}
+}
+
+MULTI_ISA_UNSHARED_END
@@ -0,0 +1,143 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/Recording/InputRecordingFile.h"
+#include "pcsx2/Recording/InputRecordingFileInternal.h"
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+static constexpr u32 BYTES_PER_FRAME = 36;
+
+static std::array<u8, 18> MakeInput(u32 frame, u32 port)
+{
+	// Mostly idle with a button held now and then and a slowly moving stick, like real input
+	std::array<u8, 18> data;
+	data.fill(0);
+	data[0] = ((frame / 40) % 3 == 0) ? 0xEF : 0xFF;
+	data[1] = ((frame / 7) % 5 == 0) ? 0xBF : 0xFF;
+	data[2] = 127;
+	data[3] = 127;
+	data[4] = static_cast<u8>(127 + (frame / 16) % 64 - port);
+	data[5] = 127;
+	data[12] = (data[1] == 0xBF) ? 255 : 0;
+	return data;
+}
+
+static std::array<u8, 18> ToBytes(const PadData& data)
+{
+	return {data.m_compactPressFlagsGroupOne, data.m_compactPressFlagsGroupTwo,
+		std::get<0>(data.m_rightAnalog), std::get<1>(data.m_rightAnalog),
+		std::get<0>(data.m_leftAnalog), std::get<1>(data.m_leftAnalog),
+		std::get<1>(data.m_right), std::get<1>(data.m_left), std::get<1>(data.m_up), std::get<1>(data.m_down),
+		std::get<1>(data.m_triangle), std::get<1>(data.m_circle), std::get<1>(data.m_cross), std::get<1>(data.m_square),
+		std::get<1>(data.m_l1), std::get<1>(data.m_r1), std::get<1>(data.m_l2), std::get<1>(data.m_r2)};
+}
+
+TEST(InputRecordingFile, BlockRoundTrip)
+{
+	std::mt19937 rng(3);
+	for (u32 frameCount : {1u, 2u, 129u, 1024u})
+	{
+		std::vector<u8> frames(frameCount * BYTES_PER_FRAME);
+		for (u32 frame = 0; frame < frameCount; frame++)
+		{
+			const std::array<u8, 18> input = MakeInput(frame, 0);
+			std::copy(input.begin(), input.end(), &frames[frame * BYTES_PER_FRAME]);
+			// Noise in one port so literal runs get exercised too
+			for (u32 i = 18; i < BYTES_PER_FRAME; i++)
+				frames[frame * BYTES_PER_FRAME + i] = static_cast<u8>(rng());
+		}
+
+		std::vector<u8> encoded;
+		InputRecordingBlock::encode(frames.data(), frameCount, BYTES_PER_FRAME, &encoded);
+
+		std::vector<u8> decoded(frames.size());
+		ASSERT_TRUE(InputRecordingBlock::decode(encoded.data(), encoded.size(), frameCount, BYTES_PER_FRAME, decoded.data())) << frameCount;
+		EXPECT_EQ(frames, decoded) << frameCount;
+
+		if (!encoded.empty())
+			EXPECT_FALSE(InputRecordingBlock::decode(encoded.data(), encoded.size() - 1, frameCount, BYTES_PER_FRAME, decoded.data())) << frameCount;
+	}
+}
+
+TEST(InputRecordingFile, IdleInputCompresses)
+{
+	std::vector<u8> frames(1024 * BYTES_PER_FRAME);
+	for (u32 frame = 0; frame < 1024; frame++)
+	{
+		for (u32 port = 0; port < 2; port++)
+		{
+			const std::array<u8, 18> input = MakeInput(frame, port);
+			std::copy(input.begin(), input.end(), &frames[frame * BYTES_PER_FRAME + port * 18]);
+		}
+	}
+
+	std::vector<u8> encoded;
+	InputRecordingBlock::encode(frames.data(), 1024, BYTES_PER_FRAME, &encoded);
+	EXPECT_LT(encoded.size(), frames.size() / 8);
+}
+
+TEST(InputRecordingFile, ReadBackAfterReopen)
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "pcsx2_input_recording_test.p2m2").string();
+	constexpr u32 FRAMES = 3000;
+
+	{
+		InputRecordingFile file;
+		ASSERT_TRUE(file.openNew(path, false));
+		file.setAuthor("test");
+		ASSERT_TRUE(file.writeHeader());
+		for (u32 frame = 0; frame < FRAMES; frame++)
+		{
+			for (u32 port = 0; port < 2; port++)
+				ASSERT_TRUE(file.writePadData(frame, PadData(port, 0, MakeInput(frame, port))));
+			file.setTotalFrames(frame + 1);
+		}
+
+		// Re-record a stretch in an earlier block
+		for (u32 frame = 100; frame < 200; frame++)
+			ASSERT_TRUE(file.writePadData(frame, PadData(0, 0, MakeInput(frame + 1, 0))));
+		file.incrementUndoCount();
+		EXPECT_TRUE(file.close());
+	}
+
+	InputRecordingFile file;
+	ASSERT_TRUE(file.openExisting(path));
+	EXPECT_EQ(file.getTotalFrames(), FRAMES);
+	EXPECT_EQ(file.getUndoCount(), 1u);
+	EXPECT_STREQ(file.getAuthor(), "test");
+
+	// Out of order, to exercise the index
+	for (u32 frame : {2999u, 0u, 1500u, 150u, 1023u, 1024u})
+	{
+		for (u32 port = 0; port < 2; port++)
+		{
+			const std::optional<PadData> data = file.readPadData(frame, port, 0);
+			ASSERT_TRUE(data.has_value()) << frame;
+			const u32 expected = (port == 0 && frame >= 100 && frame < 200) ? frame + 1 : frame;
+			EXPECT_EQ(ToBytes(*data), MakeInput(expected, port)) << frame;
+		}
+	}
+	EXPECT_FALSE(file.readPadData(FRAMES, 0, 0).has_value());
+	EXPECT_EQ(file.bulkReadPadData(0, FRAMES, 1).size(), FRAMES);
+	file.close();
+
+	std::remove(path.c_str());
+}
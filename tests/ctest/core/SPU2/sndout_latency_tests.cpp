@@ -0,0 +1,148 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/Config.h"
+#include "pcsx2/SPU2/Global.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	// Drives the SPU2 output buffer against the null backend from a single thread. The emulator side
+	// writes a frame of samples at once, the device side reads packets at a steady rate, and marked
+	// samples are timed in device samples from when they were written to when they were played.
+	class LatencyHarness
+	{
+	public:
+		static constexpr s16 MARKER = 0x7000;
+		static constexpr u64 MARKER_INTERVAL = 4800;
+		static constexpr int PACKETS_PER_FRAME = 12;
+
+		explicit LatencyHarness(Pcsx2Config::SPU2Options::SynchronizationMode mode)
+			: m_old_options(EmuConfig.SPU2)
+		{
+			EmuConfig.SPU2.SynchMode = mode;
+			EmuConfig.SPU2.LowLatencyBuffer = true;
+			EmuConfig.SPU2.ThreadedOutput = false;
+			EmuConfig.SPU2.Latency = 100;
+			m_initialized = SndBuffer::Init("nullout");
+		}
+
+		~LatencyHarness()
+		{
+			SndBuffer::Cleanup();
+			EmuConfig.SPU2 = m_old_options;
+		}
+
+		bool IsInitialized() const { return m_initialized; }
+		u64 GetMaxLatency() const { return m_max_latency; }
+		u64 GetMarkersSeen() const { return m_markers_seen; }
+
+		/// Runs one emulated frame, skipping the emulator's output when stalled.
+		void RunFrame(bool stalled = false)
+		{
+			if (!stalled)
+			{
+				for (int i = 0; i < PACKETS_PER_FRAME * SndOutPacketSize; i++, m_written++)
+				{
+					// The marker's sequence number goes in the right channel, so dropped packets don't
+					// throw off the measurement.
+					if ((m_written % MARKER_INTERVAL) == 0)
+					{
+						SndBuffer::Write(StereoOut16(MARKER, static_cast<s16>(m_marker_times.size())));
+						m_marker_times.push_back(m_read);
+					}
+					else
+						SndBuffer::Write(StereoOut16());
+				}
+			}
+
+			for (int i = 0; i < PACKETS_PER_FRAME; i++)
+				ReadPacket();
+		}
+
+	private:
+		void ReadPacket()
+		{
+			StereoOut16 packet[SndOutPacketSize];
+			SndBuffer::ReadSamples(packet, SndOutPacketSize);
+
+			for (int i = 0; i < SndOutPacketSize; i++, m_read++)
+			{
+				if (packet[i].Left != MARKER)
+					continue;
+
+				const u64 written = m_marker_times[static_cast<u16>(packet[i].Right)];
+				m_max_latency = std::max(m_max_latency, m_read - written);
+				m_markers_seen++;
+			}
+		}
+
+		Pcsx2Config::SPU2Options m_old_options;
+		bool m_initialized = false;
+		std::vector<u64> m_marker_times;
+		u64 m_written = 0;
+		u64 m_read = 0;
+		u64 m_max_latency = 0;
+		u64 m_markers_seen = 0;
+	};
+} // namespace
+
+TEST(SndOutLatency, SteadyOutputStaysWithinTarget)
+{
+	LatencyHarness harness(Pcsx2Config::SPU2Options::SynchronizationMode::NoSync);
+	ASSERT_TRUE(harness.IsInitialized());
+
+	// 30 seconds of audio.
+	const int frames = 30 * SampleRate / (LatencyHarness::PACKETS_PER_FRAME * SndOutPacketSize);
+	for (int i = 0; i < frames; i++)
+		harness.RunFrame();
+
+	const SndBuffer::LatencyStats stats = SndBuffer::GetLatencyStats();
+	EXPECT_GT(harness.GetMarkersSeen(), 0u);
+	EXPECT_EQ(stats.underruns, 0u);
+	EXPECT_EQ(stats.overruns, 0u);
+
+	// Nothing beyond twice the target is ever buffered, plus the frame the device is reading through.
+	EXPECT_LE(harness.GetMaxLatency(),
+		static_cast<u64>(stats.target_samples * 2 + LatencyHarness::PACKETS_PER_FRAME * SndOutPacketSize));
+}
+
+TEST(SndOutLatency, UnderrunsRaiseTargetWhichDecaysAfterwards)
+{
+	LatencyHarness harness(Pcsx2Config::SPU2Options::SynchronizationMode::NoSync);
+	ASSERT_TRUE(harness.IsInitialized());
+
+	const s32 initial_target = SndBuffer::GetLatencyStats().target_samples;
+	const int frames_per_second = SampleRate / (LatencyHarness::PACKETS_PER_FRAME * SndOutPacketSize);
+
+	// Stall the emulator every tenth frame for five seconds.
+	for (int i = 0; i < 5 * frames_per_second; i++)
+		harness.RunFrame((i % 10) == 9);
+
+	const SndBuffer::LatencyStats stalled = SndBuffer::GetLatencyStats();
+	EXPECT_GT(stalled.underruns, 0u);
+	EXPECT_GT(stalled.target_samples, initial_target);
+
+	// A minute of steady output should bring it back down.
+	for (int i = 0; i < 60 * frames_per_second; i++)
+		harness.RunFrame();
+
+	const SndBuffer::LatencyStats steady = SndBuffer::GetLatencyStats();
+	EXPECT_LT(steady.target_samples, stalled.target_samples);
+	EXPECT_EQ(steady.underruns, stalled.underruns);
+}
@@ -0,0 +1,184 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/MemoryCardFile.h"
+#include "pcsx2/MemoryCardFolder.h"
+#include "common/FileSystem.h"
+#include "common/Path.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+namespace
+{
+	static constexpr u32 PAGE_SIZE = FolderMemoryCard::PageSize;
+	static constexpr u32 PAGE_SIZE_RAW = FolderMemoryCard::PageSizeRaw;
+	static constexpr u32 CLUSTER_SIZE = FolderMemoryCard::ClusterSize;
+	static constexpr u32 TOTAL_PAGES = FolderMemoryCard::TotalPages;
+
+	static constexpr u32 FILE_PAGES = 8;
+	static constexpr const char* SAVE_DIR = "BASLUS-12345";
+	static constexpr const char* SAVE_FILE = "data.bin";
+
+	/// Writes the superblock of a freshly formatted 8MB card, the folder card builds everything else from the host files.
+	static bool WriteFormattedSuperblock(const std::string& path)
+	{
+		superblock sb;
+		std::memset(&sb, 0xFF, sizeof(sb));
+		std::memcpy(sb.magic, "Sony PS2 Memory Card Format ", sizeof(sb.magic));
+		std::memcpy(sb.version, "1.2.0.0\0\0\0\0\0", sizeof(sb.version));
+		sb.page_len = PAGE_SIZE;
+		sb.pages_per_cluster = 2;
+		sb.pages_per_block = 16;
+		sb.unused = 0xFF00;
+		sb.clusters_per_card = 8192;
+		sb.alloc_offset = 41;
+		sb.alloc_end = 8135;
+		sb.rootdir_cluster = 0;
+		sb.backup_block1 = 1023;
+		sb.backup_block2 = 1022;
+		std::memset(sb.ifc_list, 0, sizeof(sb.ifc_list));
+		sb.ifc_list[0] = 8;
+		sb.card_type = 2;
+		sb.card_flags = 0x52;
+
+		std::vector<u8> block(FolderMemoryCard::BlockSize, 0xFF);
+		std::memcpy(block.data(), &sb, sizeof(sb));
+		return FileSystem::WriteBinaryFile(path.c_str(), block.data(), block.size());
+	}
+
+	/// Fills a page of the save file with a pattern unique to the page and generation.
+	static void FillPage(u8* page, u32 index, u32 generation)
+	{
+		for (u32 i = 0; i < PAGE_SIZE; i++)
+			page[i] = static_cast<u8>(i * 7 + index * 31 + generation * 101);
+		std::snprintf(reinterpret_cast<char*>(page), 16, "PAGE%02u GEN%02u", index, generation);
+	}
+
+	class FolderMemoryCardTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			m_dir = (std::filesystem::temp_directory_path() / "pcsx2_folder_memcard_test").string();
+			std::error_code ec;
+			std::filesystem::remove_all(m_dir, ec);
+			ASSERT_TRUE(FileSystem::CreateDirectoryPath(Path::Combine(m_dir, SAVE_DIR).c_str(), true));
+			ASSERT_TRUE(WriteFormattedSuperblock(Path::Combine(m_dir, "_pcsx2_superblock")));
+
+			m_file_data.resize(FILE_PAGES * PAGE_SIZE);
+			for (u32 i = 0; i < FILE_PAGES; i++)
+				FillPage(&m_file_data[i * PAGE_SIZE], i, 0);
+			ASSERT_TRUE(FileSystem::WriteBinaryFile(GetSaveFilePath().c_str(), m_file_data.data(), m_file_data.size()));
+
+			m_card = std::make_unique<FolderMemoryCard>();
+			m_card->SetSlot(0);
+
+			Pcsx2Config::McdOptions options;
+			options.Enabled = true;
+			options.Type = MemoryCardType::Folder;
+			m_card->Open(m_dir, options, 0, false, std::string());
+		}
+
+		void TearDown() override
+		{
+			if (m_card)
+				m_card->Close(false);
+			m_card.reset();
+
+			std::error_code ec;
+			std::filesystem::remove_all(m_dir, ec);
+		}
+
+		std::string GetSaveFilePath() const
+		{
+			return Path::Combine(Path::Combine(m_dir, SAVE_DIR), SAVE_FILE);
+		}
+
+		/// Finds the card page holding the specified page of the save file.
+		u32 FindFilePage(u32 index)
+		{
+			char marker[16];
+			std::snprintf(marker, sizeof(marker), "PAGE%02u GEN%02u", index, 0u);
+			for (u32 page = 0; page < TOTAL_PAGES; page++)
+			{
+				u8 data[PAGE_SIZE];
+				m_card->Read(data, page * PAGE_SIZE_RAW, sizeof(data));
+				if (std::memcmp(data, marker, std::strlen(marker) + 1) == 0)
+					return page;
+			}
+
+			return TOTAL_PAGES;
+		}
+
+		std::string m_dir;
+		std::vector<u8> m_file_data;
+		std::unique_ptr<FolderMemoryCard> m_card;
+	};
+} // namespace
+
+// The flush runs on its own thread, so check it writes what the game changed and nothing else.
+TEST_F(FolderMemoryCardTest, BackgroundFlushWritesDirtyPages)
+{
+	ASSERT_TRUE(m_card->IsPresent());
+
+	const u32 first_page = FindFilePage(0);
+	const u32 last_page = FindFilePage(FILE_PAGES - 1);
+	ASSERT_LT(first_page, TOTAL_PAGES);
+	ASSERT_LT(last_page, TOTAL_PAGES);
+
+	// Change two pages in different clusters, like a game saving.
+	for (const auto& [file_page, card_page] : {std::make_pair(0u, first_page), std::make_pair(FILE_PAGES - 1, last_page)})
+	{
+		u8* data = &m_file_data[file_page * PAGE_SIZE];
+		FillPage(data, file_page, 1);
+		m_card->Save(data, card_page * PAGE_SIZE_RAW, PAGE_SIZE);
+	}
+
+	// The flush starts a couple of frames after the last write, and finishes on a later frame.
+	for (int frame = 0; frame < FolderMemoryCard::FramesAfterWriteUntilFlush; frame++)
+		m_card->NextFrame();
+
+	const auto start = std::chrono::steady_clock::now();
+	while (m_card->GetFlushStats().flushCount == 0 && (std::chrono::steady_clock::now() - start) < std::chrono::seconds(10))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		m_card->NextFrame();
+	}
+
+	const FolderMemoryCard::FlushStats& stats = m_card->GetFlushStats();
+	ASSERT_EQ(stats.flushCount, 1u);
+	EXPECT_EQ(stats.lastFilesWritten, 1u);
+	EXPECT_GE(stats.lastBytesWritten, 2u * PAGE_SIZE);
+	EXPECT_LE(stats.lastBytesWritten, 2u * CLUSTER_SIZE);
+	EXPECT_EQ(stats.totalBytesWritten, stats.lastBytesWritten);
+
+	std::optional<std::vector<u8>> written(FileSystem::ReadBinaryFile(GetSaveFilePath().c_str()));
+	ASSERT_TRUE(written.has_value());
+	EXPECT_EQ(written.value(), m_file_data);
+
+	// Reads are served from the written file again, and nothing is left to flush.
+	u8 data[PAGE_SIZE];
+	m_card->Read(data, last_page * PAGE_SIZE_RAW, sizeof(data));
+	EXPECT_EQ(std::memcmp(data, &m_file_data[(FILE_PAGES - 1) * PAGE_SIZE], sizeof(data)), 0);
+
+	for (int frame = 0; frame < 4; frame++)
+		m_card->NextFrame();
+	EXPECT_EQ(m_card->GetFlushStats().flushCount, 1u);
+}
@@ -0,0 +1,132 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/Config.h"
+#include "pcsx2/RewindBuffer.h"
+#include "pcsx2/RewindBufferInternal.h"
+#include "pcsx2/SaveState.h"
+#include "common/SafeArray.inl"
+#include <gtest/gtest.h>
+#include <cstring>
+
+namespace
+{
+	// Stands in for the VM: the state is a few pages with the current frame number in the middle one.
+	static constexpr u32 STATE_SIZE = 3 * 4096;
+	static constexpr u32 FRAME_OFFSET = 4096;
+
+	static u32 s_current_frame = 0;
+	static u32 s_restored_frame = 0;
+
+	static void CaptureState(ArchiveEntryList* list)
+	{
+		list->Clear();
+		list->GetBuffer()->MakeRoomFor(STATE_SIZE);
+		std::memset(list->GetPtr(0), 0, STATE_SIZE);
+		std::memcpy(list->GetPtr(FRAME_OFFSET), &s_current_frame, sizeof(s_current_frame));
+		list->Add(ArchiveEntry("State").SetDataIndex(0).SetDataSize(STATE_SIZE));
+	}
+
+	static void RestoreState(const ArchiveEntryList& list)
+	{
+		ASSERT_EQ(list.GetLength(), 1u);
+		std::memcpy(&s_restored_frame, list.GetPtr(FRAME_OFFSET), sizeof(s_restored_frame));
+		s_current_frame = s_restored_frame;
+	}
+
+	class RewindBufferTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			m_old_options = EmuConfig.Rewind;
+			EmuConfig.Rewind.Enabled = true;
+			EmuConfig.Rewind.Frequency = 1;
+			EmuConfig.Rewind.BufferSizeMB = 16;
+			RewindBuffer::SetStateFunctions(CaptureState, RestoreState);
+			RewindBuffer::Initialize();
+		}
+
+		void TearDown() override
+		{
+			RewindBuffer::Shutdown();
+			RewindBuffer::SetStateFunctions(nullptr, nullptr);
+			EmuConfig.Rewind = m_old_options;
+		}
+
+		/// Runs the specified number of frames, taking a snapshot on every one.
+		static void RunFrames(u32 count)
+		{
+			for (u32 i = 0; i < count; i++)
+			{
+				s_current_frame++;
+				RewindBuffer::OnVSync();
+			}
+		}
+
+		Pcsx2Config::RewindOptions m_old_options;
+	};
+} // namespace
+
+TEST_F(RewindBufferTest, RepeatedSingleStepsWalkBack)
+{
+	s_current_frame = 0;
+	RunFrames(5);
+	s_current_frame++;
+
+	ASSERT_TRUE(RewindBuffer::Rewind(1));
+	EXPECT_EQ(s_restored_frame, 5u);
+
+	ASSERT_TRUE(RewindBuffer::Rewind(1));
+	EXPECT_EQ(s_restored_frame, 4u);
+
+	ASSERT_TRUE(RewindBuffer::Rewind(1));
+	EXPECT_EQ(s_restored_frame, 3u);
+}
+
+TEST_F(RewindBufferTest, MultipleStepsAndExhaustion)
+{
+	s_current_frame = 0;
+	RunFrames(5);
+
+	ASSERT_TRUE(RewindBuffer::Rewind(3));
+	EXPECT_EQ(s_restored_frame, 3u);
+
+	ASSERT_TRUE(RewindBuffer::Rewind(2));
+	EXPECT_EQ(s_restored_frame, 1u);
+
+	EXPECT_FALSE(RewindBuffer::Rewind(1));
+}
+
+TEST_F(RewindBufferTest, SnapshotsAfterRewindFollowTheRestoredState)
+{
+	s_current_frame = 0;
+	RunFrames(5);
+
+	ASSERT_TRUE(RewindBuffer::Rewind(2));
+	EXPECT_EQ(s_restored_frame, 4u);
+
+	// Frames 5 and 6 are played again, differently, on top of frames 1-3.
+	s_current_frame = 50;
+	RunFrames(2);
+
+	ASSERT_TRUE(RewindBuffer::Rewind(1));
+	EXPECT_EQ(s_restored_frame, 52u);
+	ASSERT_TRUE(RewindBuffer::Rewind(1));
+	EXPECT_EQ(s_restored_frame, 51u);
+	ASSERT_TRUE(RewindBuffer::Rewind(1));
+	EXPECT_EQ(s_restored_frame, 3u);
+}
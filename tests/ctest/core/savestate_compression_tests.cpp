@@ -0,0 +1,108 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/SaveState.h"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace
+{
+	// Must match the chunk size in SaveState.cpp, so the sizes below land on and around frame boundaries.
+	static constexpr size_t FRAME_SIZE = 4 * 1024 * 1024;
+
+	/// Half random, half runs of repeated bytes, so both incompressible and compressible data are covered.
+	static std::vector<u8> MakeEntry(size_t size, u32 seed)
+	{
+		std::mt19937 rng(seed);
+		std::vector<u8> data(size);
+		for (size_t i = 0; i < size; i++)
+			data[i] = ((i / 4096) % 2) ? static_cast<u8>(rng()) : static_cast<u8>(i / 4096);
+		return data;
+	}
+} // namespace
+
+TEST(SaveStateCompressionTest, RoundTripSizes)
+{
+	static constexpr size_t sizes[] = {
+		1, 1000, 256 * 1024,
+		FRAME_SIZE - 1, FRAME_SIZE, FRAME_SIZE + 1,
+		2 * FRAME_SIZE, 32 * 1024 * 1024 + 1,
+	};
+
+	for (const size_t size : sizes)
+	{
+		const std::vector<u8> original(MakeEntry(size, static_cast<u32>(size)));
+		std::vector<u8> data(SaveState_CompressEntry(original.data(), original.size()));
+		ASSERT_FALSE(data.empty()) << "size " << size;
+
+		ASSERT_TRUE(SaveState_DecompressEntries({&data})) << "size " << size;
+		EXPECT_EQ(data, original) << "size " << size;
+	}
+}
+
+TEST(SaveStateCompressionTest, RoundTripMultipleEntries)
+{
+	const std::vector<u8> large(MakeEntry(3 * FRAME_SIZE + 123, 1));
+	const std::vector<u8> small(MakeEntry(300 * 1024, 2));
+	const std::vector<u8> tiny(MakeEntry(10, 3));
+
+	std::vector<u8> large_data(SaveState_CompressEntry(large.data(), large.size()));
+	std::vector<u8> small_data(SaveState_CompressEntry(small.data(), small.size()));
+	std::vector<u8> tiny_data(SaveState_CompressEntry(tiny.data(), tiny.size()));
+
+	ASSERT_TRUE(SaveState_DecompressEntries({&large_data, &small_data, &tiny_data}));
+	EXPECT_EQ(large_data, large);
+	EXPECT_EQ(small_data, small);
+	EXPECT_EQ(tiny_data, tiny);
+}
+
+TEST(SaveStateCompressionTest, TruncatedFrameRejected)
+{
+	const std::vector<u8> original(MakeEntry(2 * FRAME_SIZE + 1000, 4));
+	const std::vector<u8> compressed(SaveState_CompressEntry(original.data(), original.size()));
+	ASSERT_GT(compressed.size(), 16u);
+
+	// Cut short in the last frame, in the middle, and inside the first frame's header.
+	for (const size_t size : {compressed.size() - 1, compressed.size() / 2, size_t(4)})
+	{
+		std::vector<u8> data(compressed.begin(), compressed.begin() + size);
+		const std::vector<u8> truncated(data);
+		EXPECT_FALSE(SaveState_DecompressEntries({&data})) << "truncated to " << size;
+		EXPECT_EQ(data, truncated);
+	}
+
+	// Trailing bytes which aren't a frame.
+	std::vector<u8> data(compressed);
+	data.insert(data.end(), 16, 0xAA);
+	EXPECT_FALSE(SaveState_DecompressEntries({&data}));
+
+	// An empty entry has no frames at all.
+	std::vector<u8> empty;
+	EXPECT_FALSE(SaveState_DecompressEntries({&empty}));
+}
+
+TEST(SaveStateCompressionTest, FailureLeavesOtherEntriesAlone)
+{
+	const std::vector<u8> good(MakeEntry(FRAME_SIZE + 1, 5));
+	const std::vector<u8> good_compressed(SaveState_CompressEntry(good.data(), good.size()));
+	const std::vector<u8> bad_original(MakeEntry(1000, 6));
+	const std::vector<u8> bad_compressed(SaveState_CompressEntry(bad_original.data(), bad_original.size()));
+
+	std::vector<u8> good_data(good_compressed);
+	std::vector<u8> bad_data(bad_compressed.begin(), bad_compressed.end() - 1);
+	EXPECT_FALSE(SaveState_DecompressEntries({&good_data, &bad_data}));
+	EXPECT_EQ(good_data, good_compressed);
+}
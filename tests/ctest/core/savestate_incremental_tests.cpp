@@ -0,0 +1,226 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/SaveState.h"
+#include "common/FileSystem.h"
+#include "common/SafeArray.inl"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+namespace
+{
+	// Large enough to be stored as a delta, and not a whole number of pages so the short last page is covered.
+	static constexpr size_t LARGE_SIZE = 1024 * 1024 + 1000;
+	static constexpr size_t SMALL_SIZE = 1000;
+	static constexpr size_t PAGE_SIZE = 4096;
+
+	static constexpr const char* LARGE_NAME = "eeMemory.bin";
+	static constexpr const char* SMALL_NAME = "Small.bin";
+	static constexpr const char* DELTA_NAME = "eeMemory.bin.delta";
+
+	struct TestState
+	{
+		std::vector<u8> large;
+		std::vector<u8> small;
+	};
+
+	static std::unique_ptr<ArchiveEntryList> MakeList(const TestState& state)
+	{
+		std::unique_ptr<ArchiveEntryList> list = std::make_unique<ArchiveEntryList>(new VmStateBuffer("Test State"));
+		list->GetBuffer()->MakeRoomFor(static_cast<int>(state.large.size() + state.small.size()));
+		std::memcpy(list->GetPtr(0), state.large.data(), state.large.size());
+		std::memcpy(list->GetPtr(static_cast<uint>(state.large.size())), state.small.data(), state.small.size());
+		list->Add(ArchiveEntry(LARGE_NAME).SetDataIndex(0).SetDataSize(state.large.size()));
+		list->Add(ArchiveEntry(SMALL_NAME).SetDataIndex(state.large.size()).SetDataSize(state.small.size()));
+		return list;
+	}
+
+	static const ArchiveEntry* FindEntry(const ArchiveEntryList& list, const char* name)
+	{
+		for (size_t i = 0; i < list.GetLength(); i++)
+		{
+			if (list[i].GetFilename() == name)
+				return &list[i];
+		}
+
+		return nullptr;
+	}
+
+	static std::vector<u8> GetEntryData(const ArchiveEntryList& list, const char* name)
+	{
+		const ArchiveEntry* entry = FindEntry(list, name);
+		if (!entry)
+			return {};
+
+		const u8* data = list.GetPtr(static_cast<uint>(entry->GetDataIndex()));
+		return std::vector<u8>(data, data + entry->GetDataSize());
+	}
+
+	class SaveStateIncrementalTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			SaveState_ResetIncremental();
+
+			m_dir = (std::filesystem::temp_directory_path() / "pcsx2_incremental_state_test").string();
+			std::filesystem::create_directories(m_dir);
+
+			std::mt19937 rng(1);
+			m_state.large.resize(LARGE_SIZE);
+			m_state.small.resize(SMALL_SIZE);
+			for (u8& value : m_state.large)
+				value = static_cast<u8>(rng());
+			for (u8& value : m_state.small)
+				value = static_cast<u8>(rng());
+		}
+
+		void TearDown() override
+		{
+			SaveState_ResetIncremental();
+
+			std::error_code ec;
+			std::filesystem::remove_all(m_dir, ec);
+		}
+
+		std::string GetStatePath(const char* name) const
+		{
+			return (std::filesystem::path(m_dir) / name).string();
+		}
+
+		/// Makes an incremental state, writing out a placeholder base file when a new base is taken.
+		static std::unique_ptr<ArchiveEntryList> Save(const TestState& state, const std::string& filename, bool* rebased)
+		{
+			std::unique_ptr<ArchiveEntryList> new_base;
+			std::unique_ptr<ArchiveEntryList> delta(SaveState_MakeIncremental(MakeList(state), filename, &new_base));
+			*rebased = static_cast<bool>(new_base);
+			if (new_base)
+			{
+				const u8 placeholder = 0;
+				FileSystem::WriteBinaryFile(SaveState_GetIncrementalBaseFileName(filename).c_str(), &placeholder, sizeof(placeholder));
+			}
+
+			return delta;
+		}
+
+		std::string m_dir;
+		TestState m_state;
+	};
+} // namespace
+
+TEST_F(SaveStateIncrementalTest, DeltaRoundTrip)
+{
+	const std::string filename(GetStatePath("RoundTrip.p2s"));
+
+	bool rebased;
+	std::unique_ptr<ArchiveEntryList> first(Save(m_state, filename, &rebased));
+	ASSERT_TRUE(rebased);
+
+	// Nothing changed since the base, so the delta holds no pages and applies as a no-op.
+	std::vector<u8> data(m_state.large);
+	ASSERT_TRUE(SaveState_ApplyDelta(&data, GetEntryData(*first, DELTA_NAME)));
+	EXPECT_EQ(data, m_state.large);
+
+	// Touch the first page, one in the middle, and the short last page.
+	TestState modified(m_state);
+	modified.large[10] ^= 0xFF;
+	modified.large[100 * PAGE_SIZE + 123] ^= 0xFF;
+	modified.large[LARGE_SIZE - 1] ^= 0xFF;
+	modified.small[0] ^= 0xFF;
+
+	std::unique_ptr<ArchiveEntryList> second(Save(modified, filename, &rebased));
+	ASSERT_FALSE(rebased);
+	EXPECT_EQ(FindEntry(*second, LARGE_NAME), nullptr);
+	EXPECT_EQ(GetEntryData(*second, SMALL_NAME), modified.small);
+
+	const std::vector<u8> delta(GetEntryData(*second, DELTA_NAME));
+	ASSERT_FALSE(delta.empty());
+	EXPECT_LT(delta.size(), 4 * PAGE_SIZE);
+
+	data = m_state.large;
+	ASSERT_TRUE(SaveState_ApplyDelta(&data, delta));
+	EXPECT_EQ(data, modified.large);
+}
+
+TEST_F(SaveStateIncrementalTest, CorruptDeltaRejected)
+{
+	const std::string filename(GetStatePath("Corrupt.p2s"));
+
+	bool rebased;
+	Save(m_state, filename, &rebased);
+	ASSERT_TRUE(rebased);
+
+	TestState modified(m_state);
+	modified.large[5 * PAGE_SIZE] ^= 0xFF;
+	modified.large[LARGE_SIZE - 1] ^= 0xFF;
+	std::unique_ptr<ArchiveEntryList> state(Save(modified, filename, &rebased));
+	ASSERT_FALSE(rebased);
+
+	const std::vector<u8> delta(GetEntryData(*state, DELTA_NAME));
+	ASSERT_GT(delta.size(), 16u);
+
+	// Header is magic, page size, entry size, page count, followed by the page indices.
+	const auto corrupt = [&delta](size_t offset, u32 value) {
+		std::vector<u8> copy(delta);
+		std::memcpy(copy.data() + offset, &value, sizeof(value));
+		return copy;
+	};
+
+	std::vector<u8> data(m_state.large);
+	EXPECT_FALSE(SaveState_ApplyDelta(&data, corrupt(0, 0x12345678))) << "bad magic";
+	EXPECT_FALSE(SaveState_ApplyDelta(&data, corrupt(4, 0))) << "zero page size";
+	EXPECT_FALSE(SaveState_ApplyDelta(&data, corrupt(8, LARGE_SIZE + 1))) << "wrong entry size";
+	EXPECT_FALSE(SaveState_ApplyDelta(&data, corrupt(12, 0x10000000))) << "page count past the end";
+	EXPECT_FALSE(SaveState_ApplyDelta(&data, corrupt(16, LARGE_SIZE / PAGE_SIZE + 1))) << "page index out of range";
+	EXPECT_FALSE(SaveState_ApplyDelta(&data, std::vector<u8>(delta.begin(), delta.begin() + 8))) << "truncated header";
+	EXPECT_FALSE(SaveState_ApplyDelta(&data, std::vector<u8>(delta.begin(), delta.end() - 1))) << "truncated page data";
+
+	// Deltas only apply to an entry of the size they were made from.
+	std::vector<u8> short_data(m_state.large.begin(), m_state.large.end() - 1);
+	EXPECT_FALSE(SaveState_ApplyDelta(&short_data, delta));
+
+	data = m_state.large;
+	ASSERT_TRUE(SaveState_ApplyDelta(&data, delta));
+	EXPECT_EQ(data, modified.large);
+}
+
+TEST_F(SaveStateIncrementalTest, BasePerSlot)
+{
+	const std::string slot1(GetStatePath("Slot1.p2s"));
+	const std::string slot2(GetStatePath("Slot2.p2s"));
+
+	TestState other(m_state);
+	for (size_t i = 0; i < LARGE_SIZE; i += PAGE_SIZE)
+		other.large[i] ^= 0xFF;
+
+	bool rebased;
+	Save(m_state, slot1, &rebased);
+	EXPECT_TRUE(rebased);
+	Save(other, slot2, &rebased);
+	EXPECT_TRUE(rebased);
+
+	// Alternating between slots keeps deltaing against each slot's own base.
+	Save(m_state, slot1, &rebased);
+	EXPECT_FALSE(rebased);
+	Save(other, slot2, &rebased);
+	EXPECT_FALSE(rebased);
+
+	// A state which differs in every page takes a new base rather than storing a delta bigger than it.
+	Save(other, slot1, &rebased);
+	EXPECT_TRUE(rebased);
+}
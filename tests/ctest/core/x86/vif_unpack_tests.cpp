@@ -0,0 +1,130 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/x86/newVif_UnpackSSE.h"
+#include "common/General.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <random>
+
+namespace
+{
+	static constexpr size_t CODE_SIZE = 64 * 1024;
+	static constexpr int NUM_BLOCKS = 4000;
+
+	// Everything but V4-5, which never takes the AVX2 path, and S unpacks, which aren't paired.
+	static constexpr u8 s_unpack_types[] = {0x4, 0x5, 0x6, 0x8, 0x9, 0xA, 0xC, 0xD, 0xE};
+
+	class VifUnpackTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			x86caps.Identify();
+			if (!x86caps.hasAVX2)
+				GTEST_SKIP() << "Host CPU does not support AVX2";
+
+			m_code = static_cast<u8*>(HostSys::Mmap(nullptr, CODE_SIZE, PageAccess_Any()));
+			ASSERT_NE(m_code, nullptr);
+			nVif[1].idx = 1;
+		}
+
+		void TearDown() override
+		{
+			if (m_code)
+				HostSys::Munmap(m_code, CODE_SIZE);
+
+			x86caps.Identify();
+		}
+
+		/// Compiles the block at ptr, with or without AVX2, and returns the end of the code.
+		static u8* Compile(const nVifBlock& block, bool avx2, u8* ptr)
+		{
+			x86caps.hasAVX2 = avx2;
+			xSetPtr(ptr);
+			VifUnpackSSE_Dynarec(nVif[1], block).CompileRoutine();
+			return xGetPtr();
+		}
+
+		u8* m_code = nullptr;
+	};
+} // namespace
+
+// The AVX2 unpacks have to write exactly what the SSE ones do, including untouched and masked data.
+TEST_F(VifUnpackTest, AVX2MatchesSSE)
+{
+	alignas(32) static u8 src[8192];
+	alignas(32) static u8 dest_sse[16 * 1024];
+	alignas(32) static u8 dest_avx2[16 * 1024];
+
+	std::mt19937 rng(1);
+	int wide_blocks = 0;
+	for (int i = 0; i < NUM_BLOCKS; i++)
+	{
+		const bool usn = rng() & 1;
+		const bool mask = rng() & 1;
+
+		nVifBlock block = {};
+		block.upkType = s_unpack_types[rng() % std::size(s_unpack_types)] | (mask << 4) | (usn << 5);
+		block.num = (rng() % 8 == 0) ? 0 : (rng() % 40 + 1);
+		block.mode = rng() % 4;
+		block.mask = mask ? static_cast<u32>(rng()) : 0;
+		block.aligned = rng() % 4;
+
+		// Only skipping writes is compiled here, filling needs data from the VIF registers.
+		block.cl = rng() % 4 + 1;
+		block.wl = rng() % (block.cl + 1);
+		if (block.wl == 0)
+			block.cl = block.wl = 4;
+
+		u8* const sse_code = m_code;
+		u8* const avx2_code = Compile(block, false, sse_code);
+		u8* const end = Compile(block, true, avx2_code);
+		ASSERT_LE(end, m_code + CODE_SIZE);
+		if ((avx2_code - sse_code) != (end - avx2_code) || std::memcmp(sse_code, avx2_code, end - avx2_code) != 0)
+			wide_blocks++;
+
+		for (u8& value : src)
+			value = static_cast<u8>(rng());
+		for (size_t j = 0; j < sizeof(dest_sse); j++)
+			dest_sse[j] = dest_avx2[j] = static_cast<u8>(rng());
+
+		u128 row, col;
+		for (int j = 0; j < 4; j++)
+		{
+			row._u32[j] = rng();
+			col._u32[j] = rng();
+		}
+
+		vif1.MaskRow = row;
+		vif1.MaskCol = col;
+		reinterpret_cast<nVifrecCall>(sse_code)(reinterpret_cast<uptr>(dest_sse), reinterpret_cast<uptr>(src));
+		const u128 sse_row = vif1.MaskRow;
+
+		vif1.MaskRow = row;
+		reinterpret_cast<nVifrecCall>(avx2_code)(reinterpret_cast<uptr>(dest_avx2), reinterpret_cast<uptr>(src));
+		const u128 avx2_row = vif1.MaskRow;
+
+		ASSERT_EQ(std::memcmp(dest_sse, dest_avx2, sizeof(dest_sse)), 0)
+			<< "upkType " << static_cast<int>(block.upkType) << " num " << static_cast<int>(block.num)
+			<< " mode " << static_cast<int>(block.mode) << " cl " << static_cast<int>(block.cl)
+			<< " wl " << static_cast<int>(block.wl) << " mask " << block.mask;
+		ASSERT_EQ(std::memcmp(&sse_row, &avx2_row, sizeof(u128)), 0);
+	}
+
+	// Make sure the comparison actually exercised the AVX2 code.
+	EXPECT_GT(wide_blocks, 0);
+}